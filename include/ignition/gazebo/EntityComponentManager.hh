@@ -27,11 +27,13 @@
 #include <string>
 #include <typeinfo>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <ignition/common/Console.hh>
+#include <ignition/math/Pose3.hh>
 #include <ignition/math/graph/Graph.hh>
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/Export.hh"
@@ -97,6 +99,24 @@ namespace ignition
       /// update step.
       public: void RequestRemoveEntities();
 
+      /// \brief Start a batch of entity and component creations and entity
+      /// removal requests. Until the batch ends, views aren't updated for
+      /// each new component, but once per changed entity when the batch
+      /// ends, and views whose components were reallocated are only
+      /// invalidated once. Components can be accessed as usual during a
+      /// batch, and views are brought up to date whenever one is used.
+      ///
+      /// Batches can be nested, only the outermost EndBatch applies them.
+      /// Use this when creating many entities at once, e.g. when spawning
+      /// models.
+      /// \sa EndBatch
+      public: void BeginBatch();
+
+      /// \brief End a batch started with BeginBatch, updating the views for
+      /// all the entities changed during the batch.
+      /// \sa BeginBatch
+      public: void EndBatch();
+
       /// \brief Get whether an Entity exists.
       /// \param[in] _entity Entity to confirm.
       /// \return True if the Entity exists.
@@ -120,6 +140,75 @@ namespace ignition
       /// \return True if successful. Will fail if entities don't exist.
       public: bool SetParentEntity(const Entity _child, const Entity _parent);
 
+      /// \brief Copy all entities and components of another entity component
+      /// manager into this one. Entities get new IDs in the order they were
+      /// created in _ecm, so entities created in a staging manager get the
+      /// same IDs as if they had been created directly in this one. The
+      /// parent-child relationships between them are kept, but component
+      /// data is copied as is, so components holding entity IDs, such as
+      /// components::ParentEntity, must be updated by the caller.
+      /// \param[in] _ecm Entity component manager to merge into this one.
+      /// \return Map from the entity IDs in _ecm to the new entity IDs.
+      public: std::unordered_map<Entity, Entity> Merge(
+                  const EntityComponentManager &_ecm);
+
+      /// \brief Append a binary snapshot of all entities and components to a
+      /// string. After the table of entities and their parents, components
+      /// are laid out in columns, one per component type, holding the
+      /// entities which have the component followed by their data. Component
+      /// data is serialized in binary when supported, see
+      /// components::BaseComponent::SerializeBinary, and as text otherwise.
+      /// \param[out] _out String to append the snapshot to.
+      /// \sa LoadSnapshot
+      public: void Snapshot(std::string &_out) const;
+
+      /// \brief Create the entities and components held by a snapshot
+      /// generated with Snapshot. Entities keep their IDs, so this only
+      /// works on a manager without entities.
+      /// \param[in] _data Start of the snapshot. It's only read during the
+      /// call, so it can point to a memory mapped file.
+      /// \param[in] _size Size of the snapshot in bytes.
+      /// \return True if the manager was empty and the snapshot was valid.
+      /// If the snapshot is invalid, including component data which can't
+      /// be decoded and component types which aren't registered in this
+      /// process, the manager is left unchanged.
+      public: bool LoadSnapshot(const char *_data, const std::size_t _size);
+
+      /// \brief Keep the current entities and components, which Reset
+      /// restores. Any previous reset point is replaced. The entities and
+      /// component ids are recorded right away, while component data is
+      /// kept by a copy-on-write snapshot of each storage, so only storages
+      /// which are modified afterwards are copied, when they're first
+      /// modified. Component pointers obtained before this call must not be
+      /// written through afterwards.
+      /// \sa Reset
+      public: void SetResetPoint();
+
+      /// \brief Get whether there's a reset point.
+      /// \return True if SetResetPoint has been called.
+      public: bool HasResetPoint() const;
+
+      /// \brief Restore all entities and components to the reset point,
+      /// without recreating the ones which still exist, so their IDs and
+      /// component addresses stay valid:
+      ///  * Components are overwritten in place and marked as changed.
+      ///  * Entities created since the reset point are requested to be
+      ///    removed.
+      ///  * Entities removed since the reset point are created again with
+      ///    their original IDs, and so are removed components.
+      ///  * Components created since the reset point on entities which
+      ///    existed then are kept as they are, since systems create some of
+      ///    them once to request data, such as components::JointPosition.
+      ///  * The entity counter is rewound, so entities created after the
+      ///    reset get the same IDs as after the reset point. IDs of entities
+      ///    which are still waiting to be removed are skipped.
+      ///
+      /// This should be called when there are no pending entity removals,
+      /// see ProcessRemoveEntityRequests.
+      /// \return False if there's no reset point.
+      /// \sa SetResetPoint
+      public: bool Reset();
+
       /// \brief Get whether a component type has ever been created.
       /// \param[in] _typeId ID of the component type to check.
       /// \return True if the provided _typeId has been created.
@@ -171,6 +260,16 @@ namespace ignition
       public: template<typename ComponentTypeT>
               bool RemoveComponent(Entity _entity);
 
+      /// \brief Remove all the components of several entities in one pass.
+      /// Each component storage is locked once and each view is updated once
+      /// per entity, which is much faster than calling RemoveComponent for
+      /// every component when tearing down large models or levels. The
+      /// entities themselves are not removed.
+      /// \param[in] _entities The entities whose components will be removed.
+      /// \return Number of components removed.
+      public: std::size_t RemoveComponents(
+                  const std::vector<Entity> &_entities);
+
       /// \brief Rebuild all the views. This could be an expensive
       /// operation.
       public: void RebuildViews();
@@ -394,6 +493,51 @@ namespace ignition
                   bool(const Entity &_entity,
                        ComponentTypeTs *...)>>::type _f);
 
+      /// \brief Get all entities which contain given component types, as well
+      /// as the mutable components, and call a function for each of them in
+      /// parallel. The entities are split into chunks which run on a pool of
+      /// worker threads shared by the whole process, and this call blocks
+      /// until all of them are done. The order in which entities are visited
+      /// is unspecified.
+      ///
+      /// The function runs concurrently for different entities, so it must
+      /// follow these rules:
+      /// * It may read and modify the components passed to it, which belong
+      ///   to the current entity only.
+      /// * It may read other components through the const API of the entity
+      ///   component manager, but must not modify them.
+      /// * It must not create or remove entities or components, nor call
+      ///   SetChanged. Collect those changes and apply them once ParallelEach
+      ///   returns.
+      /// * It must not throw.
+      ///
+      /// The entity component manager is in a read-only phase while the
+      /// function runs, so component lookups don't lock.
+      /// \param[in] _f Function to be called for each matching entity. The
+      /// function parameters are all the desired component types, in the
+      /// order they're listed on the template.
+      /// \tparam ComponentTypeTs All the desired mutable component types.
+      /// \warning This function should not be called outside of System's
+      /// PreUpdate or Update callbacks.
+      public: template<typename ...ComponentTypeTs>
+              void ParallelEach(typename identity<std::function<
+                  void(const Entity &_entity,
+                       ComponentTypeTs *...)>>::type _f);
+
+      /// \brief Get all entities which contain given component types, as well
+      /// as the components, and call a function for each of them in parallel.
+      /// See the mutable version for the rules the function must follow.
+      /// \param[in] _f Function to be called for each matching entity. The
+      /// function parameters are all the desired component types, in the
+      /// order they're listed on the template.
+      /// \tparam ComponentTypeTs All the desired component types.
+      /// \warning This function should not be called outside of System's
+      /// PreUpdate, Update, or PostUpdate callbacks.
+      public: template<typename ...ComponentTypeTs>
+              void ParallelEach(typename identity<std::function<
+                  void(const Entity &_entity,
+                       const ComponentTypeTs *...)>>::type _f) const;
+
       /// \brief Call a function for each parameter in a pack.
       /// \param[in] _f Function to be called.
       /// \param[in] _components Parameters which should be passed to the
@@ -550,13 +694,112 @@ namespace ignition
       /// responsibility of the caller to timestamp it before use.
       public: void ChangedState(msgs::SerializedStateMap &_state) const;
 
+      /// \brief Get a message with the changes made since a previous
+      /// version of the manager, such as the version of the last state
+      /// acknowledged by a receiver.
+      ///
+      /// This includes:
+      /// * Components created or marked as changed after that version
+      /// * Entities and components removed after that version
+      /// * Entities which are going to be removed
+      ///
+      /// Applying the message with SetState on top of the state at
+      /// _sinceVersion brings the receiver up to date. Changes are logged in
+      /// version order, so this takes time proportional to the number of
+      /// changes since _sinceVersion, not to the number of components.
+      /// \detail The header of the message will not be populated, other than
+      /// the serialization format. It is the responsibility of the caller to
+      /// timestamp it before use.
+      /// \param[out] _state Serialized changes.
+      /// \param[in] _sinceVersion A version previously returned by Version().
+      /// \return False if changes made after _sinceVersion have been
+      /// forgotten, in which case _state is left untouched and the receiver
+      /// needs a full state instead. This is the case for changes made
+      /// before versions started being logged, see Version.
+      /// \sa Version
+      public: bool DeltaState(msgs::SerializedStateMap &_state,
+                  const uint64_t _sinceVersion) const;
+
+      /// \brief Get the version of the manager. It increases every time a
+      /// component is created, removed or marked as changed through
+      /// SetChanged, and every time an entity is removed. Components modified
+      /// without calling SetChanged don't change the version.
+      ///
+      /// The changes needed by DeltaState and ComponentVersion are only
+      /// logged from the first call to Version, ComponentVersion or
+      /// DeltaState on, so managers which never use them don't pay for it.
+      /// \return The version of the most recent change.
+      public: uint64_t Version() const;
+
+      /// \brief Get the version of a component, which is the version of the
+      /// manager right after the component was last created or marked as
+      /// changed.
+      /// \param[in] _entity Entity that contains the component.
+      /// \param[in] _typeId Component type ID.
+      /// \return The version, or 0 if the entity doesn't have the component
+      /// or it hasn't changed since versions started being logged.
+      /// \sa Version
+      public: uint64_t ComponentVersion(const Entity _entity,
+                  const ComponentTypeId _typeId) const;
+
+      /// \brief Get the pose of an entity in the world frame, composing the
+      /// components::Pose of the entity and its ancestors, following
+      /// components::ParentEntity up to the first ancestor without a pose.
+      ///
+      /// World poses are cached per entity, together with the pose and
+      /// parent they were composed from. Creating, removing or marking a
+      /// pose or parent component as changed through SetChanged invalidates
+      /// the entity's entry, and its descendants are recomputed the next
+      /// time they're queried, so only moved subtrees are recomputed. Pose
+      /// changes made without calling SetChanged are detected by comparing
+      /// the cached poses the first time an entity is queried after the end
+      /// of the step, see InvalidateWorldPoses. Use gazebo::worldPose for a
+      /// pose which always reflects such changes within the same step.
+      /// \param[in] _entity The entity.
+      /// \return The world pose, or nullopt if the entity doesn't have a
+      /// pose component.
+      public: std::optional<math::Pose3d> WorldPose(
+                  const Entity _entity) const;
+
+      /// \brief Set whether serialized state maps produced by State,
+      /// ChangedState and DeltaState use the compact binary serialization of
+      /// components, for the components which support it. See
+      /// components::BaseComponent::SerializeBinary. Other components use
+      /// their regular serialization. Messages are tagged in their header,
+      /// and SetState handles both formats. Binary messages can't be read by
+      /// older versions, so this is off by default.
+      /// \param[in] _binary True to use binary serialization.
+      public: void SetBinarySerialization(const bool _binary);
+
+      /// \brief Get whether binary serialization is used for serialized
+      /// state maps.
+      /// \return True if binary serialization is used.
+      /// \sa SetBinarySerialization
+      public: bool BinarySerialization() const;
+
+      /// \brief Set the number of worker threads used by State to serialize
+      /// entities in parallel. The threads are created once and kept for the
+      /// lifetime of the manager. The calling thread also serializes
+      /// entities, so with 0 worker threads State runs serially.
+      /// This must not be called while State is running.
+      /// \param[in] _threadCount Number of worker threads.
+      public: void SetStateThreadCount(const unsigned int _threadCount);
+
+      /// \brief Get the number of worker threads used by State. Unless set
+      /// with SetStateThreadCount, the threads are shared with the rest of
+      /// the process, and there is one less than the hardware concurrency.
+      /// \return The number of worker threads.
+      /// \sa SetStateThreadCount
+      public: unsigned int StateThreadCount() const;
+
       /// \brief Set the absolute state of the ECM from a serialized message.
       /// Entities / components that are in the new state but not in the old
       /// one will be created.
       /// Entities / components that are marked as removed will be removed, but
       /// they won't be removed if they're not present in the state.
-      /// \detail The header of the message will not be handled, it is the
-      /// responsibility of the caller to use the timestamp.
+      /// \detail The header of the message will not be handled, other than
+      /// the serialization format. It is the responsibility of the caller to
+      /// use the timestamp.
       /// \param[in] _stateMsg Message containing state to be set.
       public: void SetState(const msgs::SerializedStateMap &_stateMsg);
 
@@ -598,6 +841,32 @@ namespace ignition
       /// \brief Mark all components as not changed.
       protected: void SetAllComponentsUnchanged();
 
+      /// \brief Make the next query of each cached world pose check it
+      /// against the entity's pose and parent again, so pose changes which
+      /// weren't marked through SetChanged are seen. Entries which still
+      /// match are kept. This is called at the end of every simulation
+      /// step, including steps which skip SetAllComponentsUnchanged.
+      /// \sa WorldPose
+      protected: void InvalidateWorldPoses();
+
+      /// \brief Start or end a read-only phase. During a read-only phase,
+      /// such as while systems run PostUpdate in parallel, entities and
+      /// components must not be created or removed, and requests to do so
+      /// are rejected with an error. Component data may still be modified,
+      /// and marked with SetChanged, by systems which declared it through
+      /// ISystemComponentAccess. In exchange, views and component storages
+      /// can be read from several threads without locking. Views are
+      /// compacted and their component pointers refreshed when the phase
+      /// starts.
+      /// \param[in] _readOnly True to start a read-only phase, false to end
+      /// it.
+      protected: void SetReadOnly(const bool _readOnly);
+
+      /// \brief Get whether the manager is in a read-only phase.
+      /// \return True during a read-only phase.
+      /// \sa SetReadOnly
+      protected: bool IsReadOnly() const;
+
       /// \brief Get whether an Entity exists and is new.
       ///
       /// Entities are considered new in the time between their creation and a
@@ -626,7 +895,8 @@ namespace ignition
       /// \param[in] _entity The entity that will be associated with
       /// the component.
       /// \param[in] _componentTypeId Id of the component type.
-      /// \param[in] _data Data used to construct the component.
+      /// \param[in] _data Data used to construct the component. If null, the
+      /// component is default constructed.
       /// \return Key that uniquely identifies the component.
       private: ComponentKey CreateComponentImplementation(
                    const Entity _entity,
@@ -665,29 +935,23 @@ namespace ignition
       private: components::BaseComponent *ComponentImplementation(
                    const ComponentKey &_key);
 
-      /// \brief End of the AddComponentToView recursion. This function is
-      /// called when Rest is empty.
-      /// \param[in, out] _view The FirstComponent will be added to the
-      /// _view.
-      /// \param[in] _entity The entity.
-      private: template<typename FirstComponent,
-                        typename ...RemainingComponents,
-                        typename std::enable_if<
-                          sizeof...(RemainingComponents) == 0, int>::type = 0>
-          void AddComponentsToView(detail::View &_view,
-               const Entity _entity) const;
-
-      /// \brief Recursively add components to a view. This function is
-      /// called when Rest is NOT empty.
-      /// \param[in, out] _view The FirstComponent will be added to the
-      /// _view.
-      /// \param[in] _entity The entity.
-      private: template<typename FirstComponent,
-                        typename ...RemainingComponents,
-                        typename std::enable_if<
-                          sizeof...(RemainingComponents) != 0, int>::type = 0>
-          void AddComponentsToView(detail::View &_view,
-              const Entity _entity) const;
+      /// \brief Get a component to be cached by a view. Views hand out
+      /// mutable components even when they're populated from const
+      /// functions, so the component's storage is prepared for writing.
+      /// \param[in] _key A key that uniquely identifies a component.
+      /// \return The component associated with the key, or nullptr if the
+      /// component could not be found.
+      private: components::BaseComponent *ViewComponentImplementation(
+                   const ComponentKey &_key) const;
+
+      /// \brief Add all the entities that match a set of component types, and
+      /// their components, to a view. Entities are gathered per archetype,
+      /// that is, per set of component types, so the cost is proportional to
+      /// the number of matching entities.
+      /// \param[in, out] _view The view to populate.
+      /// \param[in] _types Component types that entities must have.
+      private: void PopulateView(detail::View &_view,
+          const std::set<ComponentTypeId> &_types) const;
 
       /// \brief Find a View that matches the set of ComponentTypeIds. If
       /// a match is not found, then a new view is created.
@@ -715,10 +979,30 @@ namespace ignition
           AddView(const std::set<ComponentTypeId> &_types,
               detail::View &&_view) const;
 
-      /// \brief Update views that contain the provided entity.
+      /// \brief Update views that contain the provided entity. During a
+      /// batch, the update is postponed until the batch is applied.
       /// \param[in] _entity The entity.
       private: void UpdateViews(const Entity _entity);
 
+      /// \brief Implementation of UpdateViews, which updates the views
+      /// right away.
+      /// \param[in] _entity The entity.
+      private: void UpdateViewsImplementation(const Entity _entity) const;
+
+      /// \brief Update the views for the entities changed so far in a batch,
+      /// and invalidate the components of views whose storages grew.
+      /// \sa BeginBatch
+      private: void ApplyBatch() const;
+
+      /// \brief Implementation of ParallelEach. Splits a range of view rows
+      /// into chunks and runs them on the shared thread pool, within a
+      /// read-only phase.
+      /// \param[in] _count Number of rows.
+      /// \param[in] _f Function called with the beginning and end of each
+      /// chunk of rows.
+      private: void ParallelRows(std::size_t _count,
+          const std::function<void(std::size_t, std::size_t)> &_f) const;
+
       /// \brief Get a component ID based on an entity and the component's type.
       /// \param[in] _entity The entity.
       /// \param[in] _type Component type ID.
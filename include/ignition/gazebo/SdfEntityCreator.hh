@@ -18,6 +18,7 @@
 #define IGNITION_GAZEBO_CREATEREMOVE_HH_
 
 #include <memory>
+#include <vector>
 
 #include <sdf/Actor.hh>
 #include <sdf/Collision.hh>
@@ -98,6 +99,41 @@ namespace ignition
       /// \return Model entity.
       public: Entity CreateEntities(const sdf::Model *_model);
 
+      /// \brief Create all entities that exist in several sdf::Model objects
+      /// and load their plugins. The models are converted to entities and
+      /// components in parallel, each into its own staging entity component
+      /// manager, see StageModel. They are then merged in order, and the
+      /// plugins of each model are loaded before the next model is merged.
+      /// So plugins see the same entities, and entities get the same IDs,
+      /// as if the models were created one at a time.
+      /// \param[in] _models SDF model objects.
+      /// \return Model entities, in the same order as _models.
+      public: std::vector<Entity> CreateEntities(
+                  const std::vector<const sdf::Model *> &_models);
+
+      /// \brief A model converted to entities and components by StageModel,
+      /// which hasn't been added to any entity component manager yet.
+      public: class StagedModel;
+
+      /// \brief Convert a model to entities and components in a staging
+      /// entity component manager of its own. This doesn't touch the
+      /// entity component manager or event manager of any creator, so it can
+      /// be called from any thread while simulation runs, as long as _model
+      /// isn't modified.
+      /// \param[in] _model SDF model object.
+      /// \return The staged model, to be passed to CreateEntities.
+      /// \sa CreateEntities(const StagedModel &)
+      public: static std::shared_ptr<StagedModel> StageModel(
+                  const sdf::Model *_model);
+
+      /// \brief Add the entities of a staged model and load their plugins.
+      /// Entities get the same IDs as if the model was created directly with
+      /// CreateEntities(const sdf::Model *).
+      /// \param[in] _staged Model returned by StageModel. Each call adds a
+      /// new copy of it.
+      /// \return Model entity.
+      public: Entity CreateEntities(const StagedModel &_staged);
+
       /// \brief Create all entities that exist in the sdf::Actor object and
       /// load their plugins.
       /// \param[in] _actor SDF actor object.
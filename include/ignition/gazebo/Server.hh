@@ -17,10 +17,13 @@
 #ifndef IGNITION_GAZEBO_SERVER_HH_
 #define IGNITION_GAZEBO_SERVER_HH_
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 #include <ignition/gazebo/config.hh>
 #include <ignition/gazebo/EntityComponentManager.hh>
 #include <ignition/gazebo/Export.hh>
@@ -154,6 +157,43 @@ namespace ignition
       /// not being initialized, or if the server is already running.
       public: bool RunOnce(const bool _paused = true);
 
+      /// \brief Function which writes the observation of a world, see
+      /// StepWorlds.
+      /// \param[in] _worldIndex Index of the world.
+      /// \param[in] _ecm The world's entity component manager, after the
+      /// steps.
+      /// \param[out] _observation Start of the world's observation, with room
+      /// for the observation size passed to StepWorlds.
+      public: using ObserveCallback = std::function<void(
+                  const unsigned int _worldIndex,
+                  const EntityComponentManager &_ecm,
+                  double *_observation)>;
+
+      /// \brief Step all worlds unpaused, in lockstep, on the process' shared
+      /// thread pool. Each step is started as soon as all worlds finished the
+      /// previous one, without pacing steps to the update period. This is a
+      /// blocking call, meant for vectorized environments, see
+      /// ServerConfig::SetWorldCopies.
+      /// \param[in] _steps Number of steps.
+      /// \return False if the server is already running.
+      public: bool StepWorlds(const uint64_t _steps = 1);
+
+      /// \brief Step all worlds unpaused, in lockstep, and then observe all
+      /// of them in parallel. Observations are written into a contiguous
+      /// buffer, with one row of _observationSize values per world, in
+      /// world order.
+      /// \param[in] _steps Number of steps. 0 to only observe.
+      /// \param[in] _observationSize Number of values observed per world.
+      /// \param[in] _observe Function which writes the observation of a
+      /// world. It's called concurrently for different worlds.
+      /// \param[out] _observations Resized to hold all the observations.
+      /// Reusing the same buffer across calls avoids reallocating it.
+      /// \return False if the server is already running.
+      public: bool StepWorlds(const uint64_t _steps,
+                  const std::size_t _observationSize,
+                  const ObserveCallback &_observe,
+                  std::vector<double> &_observations);
+
       /// \brief Get whether the server is running. The server can have zero
       /// or more simulation worlds, each of which may or may not be
       /// running. See Running(const unsigned int) to get the running status
@@ -181,6 +221,14 @@ namespace ignition
       public: bool SetPaused(const bool _paused,
                   const unsigned int _worldIndex = 0) const;
 
+      /// \brief Reset a world to its state right after it was loaded,
+      /// without reloading its entities or systems. The reset happens at the
+      /// end of the current step, and rewinds time to zero.
+      /// \param[in] _worldIndex Index of the world to reset.
+      /// \return True if the world referenced by _worldIndex exists, false
+      /// otherwise.
+      public: bool Reset(const unsigned int _worldIndex = 0) const;
+
       /// \brief Get whether a world simulation instance is paused.
       /// When paused is true, then simulation for the world is not stepping
       /// forward.
@@ -229,6 +277,20 @@ namespace ignition
                   const std::shared_ptr<System> &_system,
                   const unsigned int _worldIndex = 0);
 
+      /// \brief Save a snapshot of a fully initialized world, which can be
+      /// restored with ServerConfig::SetSnapshotPath to skip parsing SDF,
+      /// fetching resources and creating entities on startup. The snapshot
+      /// holds the world's SDF, all entities and components, and the systems
+      /// loaded from SDF, which are loaded and configured again on restore.
+      /// The internal state of systems, such as physics engines, is rebuilt
+      /// from the restored entities. The server must not be running when
+      /// calling this.
+      /// \param[in] _path Path of the snapshot file, which is overwritten.
+      /// \param[in] _worldIndex Index of the world to save.
+      /// \return True if the snapshot was saved.
+      public: bool SaveSnapshot(const std::string &_path,
+                  const unsigned int _worldIndex = 0);
+
       /// \brief Get an Entity based on a name.
       /// \details If multiple entities with the same name exist, the first
       /// entity found will be returned.
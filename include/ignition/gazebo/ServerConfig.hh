@@ -139,6 +139,31 @@ namespace ignition
         private: std::unique_ptr<ServerConfig::PluginInfoPrivate> dataPtr;
       };
 
+      /// \brief Strategies to pace simulation steps so that they match the
+      /// update period. See SetPacing.
+      public: enum class PacingStrategy
+      {
+        /// \brief Sleep until the update period has passed since the start
+        /// of the previous step, correcting for the average oversleep.
+        Sleep = 0,
+
+        /// \brief Sleep until shortly before the deadline, then spin until
+        /// it's reached. This has the least jitter, at the cost of keeping a
+        /// core busy for part of each step.
+        HybridSpin = 1,
+
+        /// \brief Sleep until an absolute deadline, using clock_nanosleep
+        /// where available. This doesn't accumulate the error of computing
+        /// relative durations.
+        AbsoluteDeadline = 2,
+
+        /// \brief Keep a fixed schedule of one step per update period, and
+        /// run late steps back to back to catch up after slow steps. How far
+        /// behind simulation may get before the schedule is reset is bounded
+        /// by SetMaxCatchUpSteps. Waiting is the same as HybridSpin.
+        CatchUp = 3
+      };
+
       /// \brief Constructor
       public: ServerConfig();
 
@@ -228,6 +253,23 @@ namespace ignition
       /// \sa SetNetworkRole(const std::string &_role)
       public: std::string NetworkRole() const;
 
+      /// \brief Set whether a distributed simulation primary pipelines its
+      /// steps with the secondaries. When pipelined, the primary doesn't
+      /// wait for the secondaries to finish a step before running its own
+      /// systems. Instead, it applies the states from the previous step while
+      /// the secondaries compute the current one, so the primary's systems
+      /// see the secondaries' performers one step late. This is only used
+      /// by the primary, and it's off by default.
+      /// \param[in] _pipelined True to pipeline steps.
+      /// \sa SetNetworkRole(const std::string &_role)
+      public: void SetNetworkPipelined(bool _pipelined);
+
+      /// \brief Get whether a distributed simulation primary pipelines its
+      /// steps with the secondaries.
+      /// \return True if steps are pipelined.
+      /// \sa SetNetworkPipelined(bool _pipelined)
+      public: bool NetworkPipelined() const;
+
       /// \brief Get whether the server is recording states
       /// \return True if the server is set to record states
       public: bool UseLogRecord() const;
@@ -299,6 +341,147 @@ namespace ignition
       /// \param[in] _seed The seed.
       public: void SetSeed(unsigned int _seed);
 
+      /// \brief Set the number of worker threads used to update systems.
+      /// They run PostUpdate, as well as PreUpdate and Update for systems
+      /// which declare their component access. The thread stepping the
+      /// simulation also updates systems, so with 0 worker threads all
+      /// systems are updated serially.
+      /// \param[in] _threads Number of worker threads.
+      public: void SetSystemThreadCount(unsigned int _threads);
+
+      /// \brief Get the number of worker threads used to update systems.
+      /// \return The number of worker threads, or nullopt if it hasn't been
+      /// set, in which case one thread less than the hardware concurrency is
+      /// used.
+      /// \sa SetSystemThreadCount
+      public: std::optional<unsigned int> SystemThreadCount() const;
+
+      /// \brief Set the number of worker threads used to serialize the
+      /// state of the world, for example by the scene broadcaster and when
+      /// recording logs. The thread requesting the state also does work, so
+      /// with 0 worker threads states are serialized serially.
+      /// \param[in] _threads Number of worker threads.
+      /// \sa EntityComponentManager::SetStateThreadCount
+      public: void SetStateThreadCount(unsigned int _threads);
+
+      /// \brief Get the number of worker threads used to serialize states.
+      /// \return The number of worker threads, or nullopt if it hasn't been
+      /// set, in which case the threads are shared with the rest of the
+      /// process.
+      /// \sa SetStateThreadCount
+      public: std::optional<unsigned int> StateThreadCount() const;
+
+      /// \brief Set whether serialized states, such as the ones published
+      /// by the scene broadcaster and recorded to logs, use compact binary
+      /// serialization for the components that support it. Binary states
+      /// are faster to produce and consume, but can't be read by older
+      /// versions. Defaults to false.
+      /// \param[in] _binary True to use binary serialization.
+      /// \sa EntityComponentManager::SetBinarySerialization
+      public: void SetBinaryStateSerialization(bool _binary);
+
+      /// \brief Get whether serialized states use binary serialization.
+      /// \return True if binary serialization is used.
+      /// \sa SetBinaryStateSerialization
+      public: bool BinaryStateSerialization() const;
+
+      /// \brief Set the strategy used to pace simulation steps to the update
+      /// rate. Defaults to PacingStrategy::Sleep.
+      /// \param[in] _strategy Pacing strategy.
+      public: void SetPacing(PacingStrategy _strategy);
+
+      /// \brief Get the strategy used to pace simulation steps.
+      /// \return The pacing strategy.
+      /// \sa SetPacing
+      public: PacingStrategy Pacing() const;
+
+      /// \brief Set the maximum number of steps that the CatchUp pacing
+      /// strategy runs back to back to catch up with its schedule. If
+      /// simulation falls further behind, the schedule restarts from the
+      /// current time and the missed steps are dropped. Defaults to 10.
+      /// \param[in] _steps Maximum number of steps to catch up.
+      public: void SetMaxCatchUpSteps(unsigned int _steps);
+
+      /// \brief Get the maximum number of steps to catch up.
+      /// \return The maximum number of steps.
+      /// \sa SetMaxCatchUpSteps
+      public: unsigned int MaxCatchUpSteps() const;
+
+      /// \brief Set the number of steps over which housekeeping is spread
+      /// while simulation is running, for throughput when running headless
+      /// as fast as possible. With a batch of K steps, publishing stats and
+      /// clock, processing world control messages, updating levels, adding
+      /// pending systems and marking components as unchanged happen once
+      /// every K steps instead of every step. Newly created and removed
+      /// entities are still processed on the step after they appear.
+      ///
+      /// As a consequence, component changes are reported to systems for
+      /// the remainder of the batch, and control messages, such as pause
+      /// requests, take effect up to K - 1 steps later. Steps are never
+      /// batched while paused, nor in distributed simulation. Defaults to 1,
+      /// which is no batching.
+      /// \param[in] _steps Number of steps per batch. 0 is the same as 1.
+      public: void SetStepBatchSize(unsigned int _steps);
+
+      /// \brief Get the number of steps over which housekeeping is spread.
+      /// \return Number of steps per batch.
+      /// \sa SetStepBatchSize
+      public: unsigned int StepBatchSize() const;
+
+      /// \brief Set the path of a world snapshot to restore, instead of
+      /// loading the SDF file or string. The snapshot is saved with
+      /// Server::SaveSnapshot, and it holds the world's entities and the
+      /// systems loaded from SDF, so restoring it skips parsing the original
+      /// SDF, fetching resources and creating entities. Snapshots aren't
+      /// restored when using levels, in which case the world is loaded from
+      /// the SDF stored in the snapshot.
+      /// \param[in] _path Path of the snapshot. Empty to load SDF.
+      public: void SetSnapshotPath(const std::string &_path);
+
+      /// \brief Get the path of the world snapshot to restore.
+      /// \return Path of the snapshot, empty if SDF is loaded instead.
+      /// \sa SetSnapshotPath
+      public: const std::string &SnapshotPath() const;
+
+      /// \brief Set the number of copies of the first world to simulate, for
+      /// vectorized environments. Copies are independent worlds which share
+      /// the process, its loaded resources and the shared thread pool. They
+      /// run in lockstep, each step is only started once all copies finished
+      /// the previous one, see Server::StepWorlds. Copy `i`, for `i > 0`, is
+      /// named after the first world with the `_i` suffix, and the copies
+      /// come after the worlds in the SDF. Copies aren't supported with
+      /// distributed simulation. Defaults to 1, which is no copies.
+      /// \param[in] _copies Number of copies, including the original world.
+      /// 0 is the same as 1.
+      public: void SetWorldCopies(unsigned int _copies);
+
+      /// \brief Get the number of copies of the first world to simulate.
+      /// \return Number of copies, including the original world.
+      /// \sa SetWorldCopies
+      public: unsigned int WorldCopies() const;
+
+      /// \brief Set how long each step may spend adding the models of levels
+      /// which became active, to stream levels in the background instead of
+      /// loading them synchronously. With a budget, models are converted to
+      /// entities and components on a background thread, including models of
+      /// levels which performers are heading towards, so they're usually
+      /// ready by the time their level becomes active. Each step then adds
+      /// ready models until the budget runs out, and at least one. Levels
+      /// may therefore be active a few steps before all their models exist.
+      /// Streaming isn't supported with distributed simulation, where
+      /// entity IDs must match across processes. Defaults to zero, which
+      /// loads levels synchronously.
+      /// \param[in] _budget Time per step, zero to load synchronously.
+      /// \sa SetUseLevels
+      public: void SetLevelStreamingBudget(
+                  const std::chrono::steady_clock::duration &_budget);
+
+      /// \brief Get how long each step may spend adding streamed models.
+      /// \return Time per step, zero if levels are loaded synchronously.
+      /// \sa SetLevelStreamingBudget
+      public: std::chrono::steady_clock::duration
+              LevelStreamingBudget() const;
+
       /// \brief Get the update period duration.
       /// \return The desired update period, or nullopt if
       /// an UpdateRate has not been set.
@@ -18,6 +18,7 @@
 #define IGNITION_GAZEBO_SYSTEM_HH_
 
 #include <memory>
+#include <set>
 
 #include <ignition/gazebo/config.hh>
 #include <ignition/gazebo/EntityComponentManager.hh>
@@ -114,12 +115,62 @@ namespace ignition
                                   EntityComponentManager &_ecm) = 0;
     };
 
+    /// \class ISystemComponentAccess ISystem.hh ignition/gazebo/System.hh
+    /// \brief Interface for a system that declares which component types it
+    /// accesses during PreUpdate and Update.
+    ///
+    /// By default, systems run one at a time, in the order they were added.
+    /// Systems that implement this interface may instead run concurrently
+    /// with other such systems in the same phase, as long as neither of them
+    /// writes a component type that the other reads or writes. In exchange,
+    /// while running PreUpdate and Update, the system must:
+    ///  * Only access the component types it declared.
+    ///  * Only modify the data of component types declared as written. This
+    ///    includes marking them as changed with
+    ///    EntityComponentManager::SetChanged.
+    ///  * Not create or remove entities or components.
+    ///
+    /// Systems that need to change the structure of the world, for example to
+    /// create a missing command component, shouldn't implement this
+    /// interface, or should opt out by returning false from ComponentAccess.
+    class ISystemComponentAccess {
+      /// \brief Get the component types accessed by the system. This is
+      /// called once, after Configure, when the system is added to the
+      /// simulation.
+      /// \param[out] _reads Component types which the system only reads.
+      /// \param[out] _writes Component types which the system modifies.
+      /// \return True if the system follows the rules above. If false, the
+      /// system runs by itself, like systems which don't implement this
+      /// interface.
+      public: virtual bool ComponentAccess(
+                  std::set<ComponentTypeId> &_reads,
+                  std::set<ComponentTypeId> &_writes) = 0;
+    };
+
     /// \class ISystemPostUpdate ISystem.hh ignition/gazebo/System.hh
     /// \brief Interface for a system that uses the PostUpdate phase
     class ISystemPostUpdate{
       public: virtual void PostUpdate(const UpdateInfo &_info,
                                       const EntityComponentManager &_ecm) = 0;
     };
+
+    /// \class ISystemReset ISystem.hh ignition/gazebo/System.hh
+    /// \brief Interface for a system that supports resetting the world
+    /// without being reloaded.
+    ///
+    /// Reset is called after the world's entities and components have been
+    /// restored to their state right after loading, see
+    /// EntityComponentManager::Reset, and before the next PreUpdate. Systems
+    /// should restore any internal state they keep, such as the state of a
+    /// physics engine, so it matches the restored components.
+    class ISystemReset {
+      /// \brief Reset the system.
+      /// \param[in] _info Simulation info after the reset, at time zero.
+      /// \param[in] _ecm The EntityComponentManager of the given simulation
+      /// instance, already restored.
+      public: virtual void Reset(const UpdateInfo &_info,
+                                 EntityComponentManager &_ecm) = 0;
+    };
   }
   }
 }
@@ -18,12 +18,17 @@
 #define IGNITION_GAZEBO_COMPONENTS_COMPONENT_HH_
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <sstream>
+#include <type_traits>
 #include <utility>
 
 #include <ignition/common/Console.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Quaternion.hh>
+#include <ignition/math/Vector3.hh>
 
 #include <ignition/gazebo/config.hh>
 #include <ignition/gazebo/Export.hh>
@@ -198,6 +203,221 @@ namespace serializers
   };
 }
 
+namespace serializers
+{
+  /// \brief Compact binary serialization of component data, used by
+  /// components::BaseComponent::SerializeBinary. Unlike the stream based
+  /// serializers, it doesn't format numbers as text, so it's faster and
+  /// produces fewer bytes.
+  ///
+  /// It's supported for arithmetic types, enums, `std::string` and
+  /// ignition::math's `Vector3`, `Quaternion` and `Pose3`, which is
+  /// signaled by `kSupported`. Other types can be supported by specializing
+  /// this class as follows:
+  /// \code
+  ///     template <> class BinarySerializer<MyType>
+  ///     {
+  ///       public: static constexpr bool kSupported = true;
+  ///       public: static void Serialize(std::string &_out,
+  ///                                     const MyType &_data);
+  ///       public: static bool Deserialize(const char *&_in,
+  ///                                       const char *_end, MyType &_data);
+  ///     };
+  /// \endcode
+  ///
+  /// Numbers are written in the byte order of the host, so data can only be
+  /// exchanged between hosts with the same endianness.
+  /// \tparam DataType Type of the data to serialize.
+  template <typename DataType, typename Enable = void>
+  class BinarySerializer
+  {
+    /// \brief Whether the data type can be serialized in binary.
+    public: static constexpr bool kSupported = false;
+  };
+
+  /// \brief Binary serialization of arithmetic types and enums.
+  template <typename DataType>
+  class BinarySerializer<DataType, std::enable_if_t<
+      std::is_arithmetic<DataType>::value || std::is_enum<DataType>::value>>
+  {
+    /// \brief Whether the data type can be serialized in binary.
+    public: static constexpr bool kSupported = true;
+
+    /// \brief Serialization
+    /// \param[out] _out String to append the data to.
+    /// \param[in] _data Data to serialize.
+    public: static void Serialize(std::string &_out, const DataType &_data)
+    {
+      _out.append(reinterpret_cast<const char *>(&_data), sizeof(DataType));
+    }
+
+    /// \brief Deserialization
+    /// \param[in, out] _in Position to read from, which is advanced past the
+    /// data.
+    /// \param[in] _end End of the buffer.
+    /// \param[out] _data Deserialized data.
+    /// \return False if the buffer is too short.
+    public: static bool Deserialize(const char *&_in, const char *_end,
+                                    DataType &_data)
+    {
+      if (_end - _in < static_cast<std::ptrdiff_t>(sizeof(DataType)))
+        return false;
+      std::memcpy(&_data, _in, sizeof(DataType));
+      _in += sizeof(DataType);
+      return true;
+    }
+  };
+
+  /// \brief Binary serialization of strings, as their size followed by
+  /// their characters.
+  template <>
+  class BinarySerializer<std::string>
+  {
+    /// \brief Whether the data type can be serialized in binary.
+    public: static constexpr bool kSupported = true;
+
+    /// \brief Serialization
+    /// \param[out] _out String to append the data to.
+    /// \param[in] _data Data to serialize.
+    public: static void Serialize(std::string &_out, const std::string &_data)
+    {
+      BinarySerializer<uint64_t>::Serialize(_out, _data.size());
+      _out.append(_data);
+    }
+
+    /// \brief Deserialization
+    /// \param[in, out] _in Position to read from, which is advanced past the
+    /// data.
+    /// \param[in] _end End of the buffer.
+    /// \param[out] _data Deserialized data.
+    /// \return False if the buffer is too short.
+    public: static bool Deserialize(const char *&_in, const char *_end,
+                                    std::string &_data)
+    {
+      uint64_t size;
+      if (!BinarySerializer<uint64_t>::Deserialize(_in, _end, size) ||
+          static_cast<uint64_t>(_end - _in) < size)
+      {
+        return false;
+      }
+      _data.assign(_in, size);
+      _in += size;
+      return true;
+    }
+  };
+
+  /// \brief Binary serialization of 3D vectors.
+  template <typename T>
+  class BinarySerializer<math::Vector3<T>>
+  {
+    /// \brief Whether the data type can be serialized in binary.
+    public: static constexpr bool kSupported = true;
+
+    /// \brief Serialization
+    /// \param[out] _out String to append the data to.
+    /// \param[in] _data Data to serialize.
+    public: static void Serialize(std::string &_out,
+                                  const math::Vector3<T> &_data)
+    {
+      const T values[3]{_data.X(), _data.Y(), _data.Z()};
+      _out.append(reinterpret_cast<const char *>(values), sizeof(values));
+    }
+
+    /// \brief Deserialization
+    /// \param[in, out] _in Position to read from, which is advanced past the
+    /// data.
+    /// \param[in] _end End of the buffer.
+    /// \param[out] _data Deserialized data.
+    /// \return False if the buffer is too short.
+    public: static bool Deserialize(const char *&_in, const char *_end,
+                                    math::Vector3<T> &_data)
+    {
+      T values[3];
+      if (_end - _in < static_cast<std::ptrdiff_t>(sizeof(values)))
+        return false;
+      std::memcpy(values, _in, sizeof(values));
+      _in += sizeof(values);
+      _data.Set(values[0], values[1], values[2]);
+      return true;
+    }
+  };
+
+  /// \brief Binary serialization of quaternions.
+  template <typename T>
+  class BinarySerializer<math::Quaternion<T>>
+  {
+    /// \brief Whether the data type can be serialized in binary.
+    public: static constexpr bool kSupported = true;
+
+    /// \brief Serialization
+    /// \param[out] _out String to append the data to.
+    /// \param[in] _data Data to serialize.
+    public: static void Serialize(std::string &_out,
+                                  const math::Quaternion<T> &_data)
+    {
+      const T values[4]{_data.W(), _data.X(), _data.Y(), _data.Z()};
+      _out.append(reinterpret_cast<const char *>(values), sizeof(values));
+    }
+
+    /// \brief Deserialization
+    /// \param[in, out] _in Position to read from, which is advanced past the
+    /// data.
+    /// \param[in] _end End of the buffer.
+    /// \param[out] _data Deserialized data.
+    /// \return False if the buffer is too short.
+    public: static bool Deserialize(const char *&_in, const char *_end,
+                                    math::Quaternion<T> &_data)
+    {
+      T values[4];
+      if (_end - _in < static_cast<std::ptrdiff_t>(sizeof(values)))
+        return false;
+      std::memcpy(values, _in, sizeof(values));
+      _in += sizeof(values);
+      _data.Set(values[0], values[1], values[2], values[3]);
+      return true;
+    }
+  };
+
+  /// \brief Binary serialization of poses, as their position followed by
+  /// their orientation.
+  template <typename T>
+  class BinarySerializer<math::Pose3<T>>
+  {
+    /// \brief Whether the data type can be serialized in binary.
+    public: static constexpr bool kSupported = true;
+
+    /// \brief Serialization
+    /// \param[out] _out String to append the data to.
+    /// \param[in] _data Data to serialize.
+    public: static void Serialize(std::string &_out,
+                                  const math::Pose3<T> &_data)
+    {
+      BinarySerializer<math::Vector3<T>>::Serialize(_out, _data.Pos());
+      BinarySerializer<math::Quaternion<T>>::Serialize(_out, _data.Rot());
+    }
+
+    /// \brief Deserialization
+    /// \param[in, out] _in Position to read from, which is advanced past the
+    /// data.
+    /// \param[in] _end End of the buffer.
+    /// \param[out] _data Deserialized data.
+    /// \return False if the buffer is too short.
+    public: static bool Deserialize(const char *&_in, const char *_end,
+                                    math::Pose3<T> &_data)
+    {
+      math::Vector3<T> pos;
+      math::Quaternion<T> rot;
+      if (!BinarySerializer<math::Vector3<T>>::Deserialize(_in, _end, pos) ||
+          !BinarySerializer<math::Quaternion<T>>::Deserialize(_in, _end, rot))
+      {
+        return false;
+      }
+      _data.Set(pos, rot);
+      return true;
+    }
+  };
+}
+
 namespace components
 {
   /// \brief Convenient type to be used by components that don't wrap any data.
@@ -270,6 +490,28 @@ namespace components
       }
     };
 
+    /// \brief Append a compact binary version of the component to a string.
+    /// This is faster and smaller than Serialize, but it's only supported by
+    /// some components, see serializers::BinarySerializer. By default, it
+    /// appends nothing and returns false.
+    /// \param[out] _out String to append to.
+    /// \return True if the component supports binary serialization. If
+    /// false, Serialize must be used instead.
+    public: virtual bool SerializeBinary(std::string &/*_out*/) const
+    {
+      return false;
+    }
+
+    /// \brief Fill a component based on data generated by SerializeBinary.
+    /// By default, it does nothing and returns false.
+    /// \param[in] _in Serialized data.
+    /// \return True if the component supports binary serialization and
+    /// _in held valid data.
+    public: virtual bool DeserializeBinary(const std::string &/*_in*/)
+    {
+      return false;
+    }
+
     /// \brief Returns the unique ID for the component's type.
     /// The ID is derived from the name that is manually chosen during the
     /// Factory registration and is guaranteed to be the same across compilers
@@ -347,6 +589,12 @@ namespace components
     // Documentation inherited
     public: void Deserialize(std::istream &_in) override;
 
+    // Documentation inherited
+    public: bool SerializeBinary(std::string &_out) const override;
+
+    // Documentation inherited
+    public: bool DeserializeBinary(const std::string &_in) override;
+
     /// \brief Get the mutable component data. This function will be
     /// deprecated in Gazebo 3, replaced by const DataType &Data() const.
     /// Use void SetData(const DataType &) to modify data.
@@ -414,6 +662,12 @@ namespace components
     // Documentation inherited
     public: void Deserialize(std::istream &_in) override;
 
+    // Documentation inherited
+    public: bool SerializeBinary(std::string &_out) const override;
+
+    // Documentation inherited
+    public: bool DeserializeBinary(const std::string &_in) override;
+
     /// \brief Unique ID for this component type. This is set through the
     /// Factory registration.
     public: inline static ComponentTypeId typeId{0};
@@ -487,6 +741,49 @@ namespace components
     Serializer::Deserialize(_in, this->Data());
   }
 
+  //////////////////////////////////////////////////
+  template <typename DataType, typename Identifier, typename Serializer>
+  bool Component<DataType, Identifier, Serializer>::SerializeBinary(
+      std::string &_out) const
+  {
+    // Components with a custom serializer keep their own format.
+    if constexpr (
+        std::is_same<Serializer,
+                     serializers::DefaultSerializer<DataType>>::value &&
+        serializers::BinarySerializer<DataType>::kSupported)
+    {
+      serializers::BinarySerializer<DataType>::Serialize(_out, this->Data());
+      return true;
+    }
+    else
+    {
+      static_cast<void>(_out);
+      return false;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  template <typename DataType, typename Identifier, typename Serializer>
+  bool Component<DataType, Identifier, Serializer>::DeserializeBinary(
+      const std::string &_in)
+  {
+    if constexpr (
+        std::is_same<Serializer,
+                     serializers::DefaultSerializer<DataType>>::value &&
+        serializers::BinarySerializer<DataType>::kSupported)
+    {
+      const char *begin = _in.data();
+      const char *end = begin + _in.size();
+      return serializers::BinarySerializer<DataType>::Deserialize(
+          begin, end, this->Data()) && begin == end;
+    }
+    else
+    {
+      static_cast<void>(_in);
+      return false;
+    }
+  }
+
   //////////////////////////////////////////////////
   template <typename DataType, typename Identifier, typename Serializer>
   ComponentTypeId Component<DataType, Identifier, Serializer>::TypeId() const
@@ -532,6 +829,23 @@ namespace components
   {
     Serializer::Deserialize(_in);
   }
+
+  //////////////////////////////////////////////////
+  template <typename Identifier, typename Serializer>
+  bool Component<NoData, Identifier, Serializer>::SerializeBinary(
+      std::string &/*_out*/) const
+  {
+    // The presence of the component is all there is to it.
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  template <typename Identifier, typename Serializer>
+  bool Component<NoData, Identifier, Serializer>::DeserializeBinary(
+      const std::string &_in)
+  {
+    return _in.empty();
+  }
 }
 }
 }
@@ -17,7 +17,12 @@
 #ifndef IGNITION_GAZEBO_DETAIL_COMPONENTSTORAGEBASE_HH_
 #define IGNITION_GAZEBO_DETAIL_COMPONENTSTORAGEBASE_HH_
 
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "ignition/gazebo/components/Component.hh"
@@ -50,11 +55,32 @@ namespace ignition
       public: virtual std::pair<ComponentId, bool> Create(
                   const components::BaseComponent *_data) = 0;
 
+      /// \brief Create a new default constructed component, which can then
+      /// be filled in place, without creating and copying a temporary.
+      /// \return Id of the new component, and whether the components array
+      /// was expanded.
+      public: virtual std::pair<ComponentId, bool> CreateDefault() = 0;
+
+      /// \brief Overwrite an existing component with a copy of the provided
+      /// data. The component keeps its id and address.
+      /// \param[in] _id Id of the component to overwrite.
+      /// \param[in] _data Component of the same type to copy.
+      /// \return True if the component exists.
+      public: virtual bool Assign(const ComponentId _id,
+                  const components::BaseComponent *_data) = 0;
+
       /// \brief Remove a component based on an id.
       /// \param[in] _id Id of the component to remove.
       /// \return True if the component was removed.
       public: virtual bool Remove(const ComponentId _id) = 0;
 
+      /// \brief Remove several components at once. This locks the storage
+      /// only once.
+      /// \param[in] _ids Ids of the components to remove.
+      /// \return Number of components removed.
+      public: virtual std::size_t Remove(
+                  const std::vector<ComponentId> &_ids) = 0;
+
       /// \brief Remove all components
       public: virtual void RemoveAll() = 0;
 
@@ -76,8 +102,86 @@ namespace ignition
       /// \return First component or nullptr if there are no components.
       public: virtual components::BaseComponent *First() = 0;
 
+      /// \brief Copy the storage, keeping the component ids.
+      /// \return The copy.
+      public: virtual std::unique_ptr<ComponentStorageBase> Clone() const = 0;
+
+      /// \brief Start a copy-on-write snapshot of the components, replacing
+      /// any previous one. The components are only copied right before the
+      /// storage is first modified or hands out a mutable component, so
+      /// storages which are only read are never copied. Mutable pointers
+      /// obtained before the snapshot started must not be written through.
+      /// \sa SnapshotComponent
+      public: void StartSnapshot()
+      {
+        std::lock_guard<std::mutex> lock(this->snapshotMutex);
+        this->snapshot.reset();
+        this->snapshotPending.store(true, std::memory_order_release);
+      }
+
+      /// \brief Get whether the components were copied for the snapshot,
+      /// that is, whether they may have changed since it started.
+      /// \return True if the snapshot holds a copy.
+      public: bool SnapshotCopied() const
+      {
+        return !this->snapshotPending.load(std::memory_order_acquire) &&
+            nullptr != this->snapshot;
+      }
+
+      /// \brief Get a component as it was when the snapshot started.
+      /// \param[in] _id Id of the component.
+      /// \return The component, or nullptr if it didn't exist then, or if
+      /// there's no snapshot.
+      public: const components::BaseComponent *SnapshotComponent(
+                  const ComponentId _id) const
+      {
+        if (this->snapshotPending.load(std::memory_order_acquire))
+          return this->Component(_id);
+        if (nullptr == this->snapshot)
+          return nullptr;
+        return this->snapshot->Component(_id);
+      }
+
+      /// \brief Set whether the storage is in a read-only phase. Components
+      /// must not be created or removed during a read-only phase, which lets
+      /// concurrent readers access components without locking.
+      /// \param[in] _readOnly True to start a read-only phase, false to end
+      /// it.
+      public: void SetReadOnly(const bool _readOnly)
+      {
+        this->readOnly.store(_readOnly, std::memory_order_release);
+      }
+
+      /// \brief Copy the components for a pending snapshot. This must be
+      /// called before the storage is modified, or hands out a mutable
+      /// component, and without holding `mutex`.
+      protected: void PrepareWrite()
+      {
+        if (!this->snapshotPending.load(std::memory_order_acquire))
+          return;
+
+        std::lock_guard<std::mutex> lock(this->snapshotMutex);
+        if (!this->snapshotPending.load(std::memory_order_relaxed))
+          return;
+        this->snapshot = this->Clone();
+        this->snapshotPending.store(false, std::memory_order_release);
+      }
+
       /// \brief Mutex used to prevent data corruption.
       protected: mutable std::mutex mutex;
+
+      /// \brief True during a read-only phase.
+      protected: std::atomic<bool> readOnly{false};
+
+      /// \brief True from StartSnapshot until the components are copied.
+      private: std::atomic<bool> snapshotPending{false};
+
+      /// \brief Protects the snapshot from threads which write to the
+      /// storage concurrently during a read-only phase.
+      private: std::mutex snapshotMutex;
+
+      /// \brief Copy of the storage taken for the snapshot.
+      private: std::unique_ptr<const ComponentStorageBase> snapshot;
     };
 
     /// \brief Templated implementation of component storage.
@@ -104,62 +208,128 @@ namespace ignition
       // Documentation inherited.
       public: bool Remove(const ComponentId _id) final
       {
+        this->PrepareWrite();
         std::lock_guard<std::mutex> lock(this->mutex);
+        return this->RemoveImplementation(_id);
+      }
 
-        // Get an iterator to the component that should be removed.
-        auto iter = this->idMap.find(_id);
-
-        // Make sure the component exists.
-        if (iter != this->idMap.end())
+      // Documentation inherited.
+      public: std::size_t Remove(const std::vector<ComponentId> &_ids) final
+      {
+        this->PrepareWrite();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::size_t count{0};
+        for (const ComponentId id : _ids)
         {
-          // Handle the case where there are more components than the
-          // component to be removed
-          if (this->components.size() > 1)
-          {
-            // Swap the component to be removed with the component at the
-            // back of the vector.
-            std::swap(this->components[iter->second],
-                      this->components.back());
-
-            // After the swap, we have to fix all the id mappings.
-            for (auto idIter =this->idMap.begin();
-                idIter != this->idMap.end(); ++idIter)
-            {
-              if (static_cast<unsigned int>(idIter->second) ==
-                  this->components.size()-1)
-              {
-                idIter->second = iter->second;
-              }
-            }
-          }
-
-          // Remove the component.
-          this->components.pop_back();
-
-          // Remove the id mapping.
-          this->idMap.erase(iter);
-          return true;
+          if (this->RemoveImplementation(id))
+            ++count;
         }
-        return false;
+        return count;
       }
 
       // Documentation inherited.
       public: void RemoveAll() final
       {
+        this->PrepareWrite();
         this->idCounter = 0;
         this->idMap.clear();
+        this->ids.clear();
         this->components.clear();
       }
 
       // Documentation inherited.
       public: std::pair<ComponentId, bool> Create(
                   const components::BaseComponent *_data) final
+      {
+        // Copy the component
+        return this->CreateImplementation(
+            *static_cast<const ComponentTypeT *>(_data));
+      }
+
+      // Documentation inherited.
+      public: std::pair<ComponentId, bool> CreateDefault() final
+      {
+        return this->CreateImplementation();
+      }
+
+      // Documentation inherited.
+      public: bool Assign(const ComponentId _id,
+                  const components::BaseComponent *_data) final
+      {
+        auto comp = static_cast<ComponentTypeT *>(this->Component(_id));
+        if (nullptr == comp)
+          return false;
+
+        *comp = *static_cast<const ComponentTypeT *>(_data);
+        return true;
+      }
+
+      // Documentation inherited.
+      public: const components::BaseComponent *Component(
+                  const ComponentId _id) const final
+      {
+        // Reading doesn't copy the components for a pending snapshot.
+        auto self = const_cast<ComponentStorage<ComponentTypeT> *>(this);
+        if (this->readOnly.load(std::memory_order_acquire))
+          return self->ComponentImplementation(_id);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return self->ComponentImplementation(_id);
+      }
+
+      public: components::BaseComponent *Component(const ComponentId _id) final
+      {
+        this->PrepareWrite();
+
+        // Nothing moves during a read-only phase, so reads don't need to
+        // lock.
+        if (this->readOnly.load(std::memory_order_acquire))
+          return this->ComponentImplementation(_id);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->ComponentImplementation(_id);
+      }
+
+      // Documentation inherited.
+      public: components::BaseComponent *First() final
+      {
+        this->PrepareWrite();
+        if (this->readOnly.load(std::memory_order_acquire))
+          return this->FirstImplementation();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->FirstImplementation();
+      }
+
+      // Documentation inherited.
+      public: std::unique_ptr<ComponentStorageBase> Clone() const final
+      {
+        auto copy = std::make_unique<ComponentStorage<ComponentTypeT>>();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        copy->idCounter = this->idCounter;
+        copy->idMap = this->idMap;
+        copy->ids = this->ids;
+        copy->components = this->components;
+        return copy;
+      }
+
+      /// \brief Implementation of Create and CreateDefault, which
+      /// constructs the component directly in the storage.
+      /// \param[in] _args Arguments to the component's constructor.
+      /// \return Id of the new component, and whether the components array
+      /// was expanded.
+      private: template <typename... Args>
+               std::pair<ComponentId, bool> CreateImplementation(
+                   Args &&... _args)
       {
         ComponentId result;  // = kComponentIdInvalid;
         bool expanded = false;
         if (this->components.size() == this->components.capacity())
         {
-          this->components.reserve(this->components.capacity() + 100);
+          // Grow geometrically, so creating many components reallocates,
+          // and invalidates views, only a few times.
+          this->components.reserve(
+              std::max<std::size_t>(100u, 2u * this->components.capacity()));
           expanded = true;
         }
 
@@ -168,26 +338,57 @@ namespace ignition
         // cppcheck-suppress postfixOperator
         result = this->idCounter++;
         this->idMap[result] = this->components.size();
-        // Copy the component
-        this->components.push_back(std::move(
-              ComponentTypeT(*static_cast<const ComponentTypeT *>(_data))));
+        this->ids.push_back(result);
+        this->components.emplace_back(std::forward<Args>(_args)...);
 
         return {result, expanded};
       }
 
-      // Documentation inherited.
-      public: const components::BaseComponent *Component(
-                  const ComponentId _id) const final
+      /// \brief Implementation of Remove, without locking. The component
+      /// at the back of the vector is moved into the removed component's
+      /// slot, and the reverse index tells which id to update, so removal
+      /// takes constant time.
+      /// \param[in] _id Id of the component to remove.
+      /// \return True if the component was removed.
+      private: bool RemoveImplementation(const ComponentId _id)
       {
-        return static_cast<const components::BaseComponent *>(
-            const_cast<ComponentStorage<ComponentTypeT> *>(
-              this)->Component(_id));
+        // Get an iterator to the component that should be removed.
+        auto iter = this->idMap.find(_id);
+
+        // Make sure the component exists.
+        if (iter == this->idMap.end())
+          return false;
+
+        const int slot = iter->second;
+        const int last = static_cast<int>(this->components.size()) - 1;
+
+        // Move the component at the back of the vector into the slot of the
+        // component to be removed, and fix the id mapping of the moved
+        // component.
+        if (slot != last)
+        {
+          this->components[slot] = std::move(this->components.back());
+          const ComponentId movedId = this->ids.back();
+          this->ids[slot] = movedId;
+          this->idMap[movedId] = slot;
+        }
+
+        // Remove the component.
+        this->components.pop_back();
+        this->ids.pop_back();
+
+        // Remove the id mapping.
+        this->idMap.erase(_id);
+        return true;
       }
 
-      public: components::BaseComponent *Component(const ComponentId _id) final
+      /// \brief Implementation of Component, without locking.
+      /// \param[in] _id Id of the component to get.
+      /// \return A pointer to the component, or nullptr if the component
+      /// could not be found.
+      private: components::BaseComponent *ComponentImplementation(
+                   const ComponentId _id)
       {
-        std::lock_guard<std::mutex> lock(this->mutex);
-
         auto iter = this->idMap.find(_id);
 
         if (iter != this->idMap.end())
@@ -198,10 +399,10 @@ namespace ignition
         return nullptr;
       }
 
-      // Documentation inherited.
-      public: components::BaseComponent *First() final
+      /// \brief Implementation of First, without locking.
+      /// \return First component or nullptr if there are no components.
+      private: components::BaseComponent *FirstImplementation()
       {
-        std::lock_guard<std::mutex> lock(this->mutex);
         if (!this->components.empty())
           return static_cast<components::BaseComponent *>(&this->components[0]);
         return nullptr;
@@ -212,7 +413,11 @@ namespace ignition
       private: ComponentId idCounter = 0;
 
       /// \brief Map of ComponentId to Components (see the components vector).
-      private: std::map<ComponentId, int> idMap;
+      private: std::unordered_map<ComponentId, int> idMap;
+
+      /// \brief Id of the component in each slot of the components vector.
+      /// This is the reverse of idMap.
+      private: std::vector<ComponentId> ids;
 
       /// \brief Sequential storage of components.
       public: std::vector<ComponentTypeT> components;
@@ -192,12 +192,16 @@ Entity EntityComponentManager::EntityByComponents(
     const ComponentTypeTs &..._desiredComponents) const
 {
   // Get all entities which have components of the desired types
-  const auto &view = this->FindView<ComponentTypeTs...>();
+  auto &view = this->FindView<ComponentTypeTs...>();
+  view.Prepare(this);
 
   // Iterate over entities
   Entity result{kNullEntity};
   for (const Entity entity : view.entities)
   {
+    if (entity == kNullEntity)
+      continue;
+
     bool different{false};
 
     // Iterate over desired components, comparing each of them to the
@@ -230,12 +234,16 @@ std::vector<Entity> EntityComponentManager::EntitiesByComponents(
     const ComponentTypeTs &..._desiredComponents) const
 {
   // Get all entities which have components of the desired types
-  const auto &view = this->FindView<ComponentTypeTs...>();
+  auto &view = this->FindView<ComponentTypeTs...>();
+  view.Prepare(this);
 
   // Iterate over entities
   std::vector<Entity> result;
   for (const Entity entity : view.entities)
   {
+    if (entity == kNullEntity)
+      continue;
+
     bool different{false};
 
     // Iterate over desired components, comparing each of them to the
@@ -267,7 +275,8 @@ std::vector<Entity> EntityComponentManager::ChildrenByComponents(Entity _parent,
      const ComponentTypeTs &..._desiredComponents) const
 {
   // Get all entities which have components of the desired types
-  const auto &view = this->FindView<ComponentTypeTs...>();
+  auto &view = this->FindView<ComponentTypeTs...>();
+  view.Prepare(this);
 
   // Get all entities which are immediate children of the given parent
   auto children = this->Entities().AdjacentsFrom(_parent);
@@ -276,6 +285,9 @@ std::vector<Entity> EntityComponentManager::ChildrenByComponents(Entity _parent,
   std::vector<Entity> result;
   for (const Entity entity : view.entities)
   {
+    if (entity == kNullEntity)
+      continue;
+
     if (children.find(entity) == children.end())
     {
       continue;
@@ -365,13 +377,7 @@ void EntityComponentManager::Each(typename identity<std::function<
 
   // Iterate over the entities in the view, and invoke the callback
   // function.
-  for (const Entity entity : view.entities)
-  {
-    if (!_f(entity, view.Component<ComponentTypeTs>(entity, this)...))
-    {
-      break;
-    }
-  }
+  view.Iterate<ComponentTypeTs...>(_f, this);
 }
 
 //////////////////////////////////////////////////
@@ -385,13 +391,43 @@ void EntityComponentManager::Each(typename identity<std::function<
 
   // Iterate over the entities in the view, and invoke the callback
   // function.
-  for (const Entity entity : view.entities)
-  {
-    if (!_f(entity, view.Component<ComponentTypeTs>(entity, this)...))
-    {
-      break;
-    }
-  }
+  view.Iterate<ComponentTypeTs...>(_f, this);
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::ParallelEach(typename identity<std::function<
+    void(const Entity &_entity, ComponentTypeTs *...)>>::type _f)
+{
+  // Get the view. This will create a new view if one does not already
+  // exist.
+  detail::View &view = this->FindView<ComponentTypeTs...>();
+  view.Prepare(this);
+
+  // Split the rows of the view across the worker threads.
+  this->ParallelRows(view.entities.size(),
+      [&](std::size_t _begin, std::size_t _end)
+      {
+        view.IterateRows<ComponentTypeTs...>(_f, _begin, _end);
+      });
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::ParallelEach(typename identity<std::function<
+    void(const Entity &_entity, const ComponentTypeTs *...)>>::type _f) const
+{
+  // Get the view. This will create a new view if one does not already
+  // exist.
+  detail::View &view = this->FindView<ComponentTypeTs...>();
+  view.Prepare(this);
+
+  // Split the rows of the view across the worker threads.
+  this->ParallelRows(view.entities.size(),
+      [&](std::size_t _begin, std::size_t _end)
+      {
+        view.IterateRows<ComponentTypeTs...>(_f, _begin, _end);
+      });
 }
 
 //////////////////////////////////////////////////
@@ -414,13 +450,8 @@ void EntityComponentManager::EachNew(typename identity<std::function<
   // Iterate over the entities in the view and in the newly created
   // entities list, and invoke the callback
   // function.
-  for (const Entity entity : view.newEntities)
-  {
-    if (!_f(entity, view.Component<ComponentTypeTs>(entity, this)...))
-    {
-      break;
-    }
-  }
+  view.Iterate<ComponentTypeTs...>(_f, this,
+      detail::View::RowFilter::NEW);
 }
 
 //////////////////////////////////////////////////
@@ -435,13 +466,8 @@ void EntityComponentManager::EachNew(typename identity<std::function<
   // Iterate over the entities in the view and in the newly created
   // entities list, and invoke the callback
   // function.
-  for (const Entity entity : view.newEntities)
-  {
-    if (!_f(entity, view.Component<ComponentTypeTs>(entity, this)...))
-    {
-      break;
-    }
-  }
+  view.Iterate<ComponentTypeTs...>(_f, this,
+      detail::View::RowFilter::NEW);
 }
 
 //////////////////////////////////////////////////
@@ -456,63 +482,8 @@ void EntityComponentManager::EachRemoved(typename identity<std::function<
   // Iterate over the entities in the view and in the newly created
   // entities list, and invoke the callback
   // function.
-  for (const Entity entity : view.toRemoveEntities)
-  {
-    if (!_f(entity, view.Component<ComponentTypeTs>(entity, this)...))
-    {
-      break;
-    }
-  }
-}
-
-//////////////////////////////////////////////////
-template<typename FirstComponent,
-         typename ...RemainingComponents,
-         typename std::enable_if<
-           sizeof...(RemainingComponents) == 0, int>::type>
-void EntityComponentManager::AddComponentsToView(detail::View &_view,
-    const Entity _entity) const
-{
-  const ComponentTypeId typeId = FirstComponent::typeId;
-
-  const ComponentId compId =
-      this->EntityComponentIdFromType(_entity, typeId);
-  if (compId >= 0)
-  {
-    // Add the component to the view.
-    _view.AddComponent(_entity, typeId, compId);
-  }
-  else
-  {
-    ignerr << "Entity[" << _entity << "] has no component of type["
-      << typeId << "]. This should never happen.\n";
-  }
-}
-
-//////////////////////////////////////////////////
-template<typename FirstComponent,
-         typename ...RemainingComponents,
-         typename std::enable_if<
-           sizeof...(RemainingComponents) != 0, int>::type>
-void EntityComponentManager::AddComponentsToView(detail::View &_view,
-    const Entity _entity) const
-{
-  const ComponentTypeId typeId = FirstComponent::typeId;
-  const ComponentId compId =
-      this->EntityComponentIdFromType(_entity, typeId);
-  if (compId >= 0)
-  {
-    // Add the component to the view.
-    _view.AddComponent(_entity, typeId, compId);
-  }
-  else
-  {
-    ignerr << "Entity[" << _entity << "] has no component of type["
-      << typeId << "]. This should never happen.\n";
-  }
-
-  // Add the remaining components to the view.
-  this->AddComponentsToView<RemainingComponents...>(_view, _entity);
+  view.Iterate<ComponentTypeTs...>(_f, this,
+      detail::View::RowFilter::TO_REMOVE);
 }
 
 //////////////////////////////////////////////////
@@ -526,27 +497,10 @@ detail::View &EntityComponentManager::FindView() const
   // Find the view. If the view doesn't exist, then create a new view.
   if (!this->FindView(types, viewIter))
   {
-    detail::View view;
+    detail::View view(types);
     // Add all the entities that match the component types to the
     // view.
-    for (const auto &vertex : this->Entities().Vertices())
-    {
-      Entity entity = vertex.first;
-      if (this->EntityMatches(entity, types))
-      {
-        view.AddEntity(entity, this->IsNewEntity(entity));
-        // If there is a request to delete this entity, update the view as
-        // well
-        if (this->IsMarkedForRemoval(entity))
-        {
-          view.AddEntityToRemoved(entity);
-        }
-
-        // Store pointers to all the components. This recursively adds
-        // all the ComponentTypeTs that belong to the entity to the view.
-        this->AddComponentsToView<ComponentTypeTs...>(view, entity);
-      }
-    }
+    this->PopulateView(view, types);
 
     // Store the view.
     return this->AddView(types, std::move(view))->second;
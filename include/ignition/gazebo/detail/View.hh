@@ -17,10 +17,11 @@
 #ifndef IGNITION_GAZEBO_DETAIL_VIEW_HH_
 #define IGNITION_GAZEBO_DETAIL_VIEW_HH_
 
-#include <map>
+#include <array>
 #include <set>
-#include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "ignition/gazebo/components/Component.hh"
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/Export.hh"
@@ -45,35 +46,106 @@ using ComponentTypeKey = std::set<ComponentTypeId>;
 /// use a cache to improve performance. The assumption is that entities
 /// and the types of components assigned to entities change infrequently
 /// compared to the frequency of queries performed by systems.
+///
+/// The view is stored as dense rows, one per entity, sorted by entity id.
+/// Each row holds the component ids and a cached pointer to each of the
+/// view's components, so iterating a view is a linear scan which doesn't
+/// touch the component storages. A sparse index maps entities to rows.
+/// Removed rows are left empty and compacted the next time the view is
+/// iterated, so entities can be removed while the view is being iterated.
 class IGNITION_GAZEBO_VISIBLE View
 {
-  /// Get a pointer to a component for an entity based on a component type.
-  /// \param[in] _entity The entity.
+  /// \brief Which rows of a view to iterate.
+  public: enum class RowFilter
+  {
+    /// \brief All entities in the view.
+    ALL,
+
+    /// \brief Entities which are new to the entity component manager.
+    NEW,
+
+    /// \brief Entities which are marked for removal.
+    TO_REMOVE
+  };
+
+  /// \brief Constructor
+  /// \param[in] _types Component types of this view.
+  public: explicit View(const ComponentTypeKey &_types = ComponentTypeKey());
+
+  /// \brief Call a function for each row of the view which passes a filter.
+  /// Rows are visited by index, so entities and components can be added
+  /// and removed by the function. Cached component pointers are refreshed
+  /// if a component storage moved its data during the iteration.
+  /// \param[in] _f Function to call with the entity and a pointer to each
+  /// component. Iteration stops when it returns false.
   /// \param[in] _ecm Pointer to the entity component manager.
-  /// \return Pointer to the component.
-  public: template<typename ComponentTypeT>
-          const ComponentTypeT *Component(const Entity _entity,
-              const EntityComponentManager *_ecm) const
+  /// \param[in] _filter Which rows to visit.
+  public: template<typename ...ComponentTypeTs, typename FunctionT>
+          void Iterate(FunctionT &_f, const EntityComponentManager *_ecm,
+              const RowFilter _filter = RowFilter::ALL)
   {
-    ComponentTypeId typeId = ComponentTypeT::typeId;
-    return static_cast<const ComponentTypeT *>(
-        this->ComponentImplementation(_entity, typeId, _ecm));
+    if ((_filter == RowFilter::NEW && this->newCount == 0) ||
+        (_filter == RowFilter::TO_REMOVE && this->toRemoveCount == 0))
+    {
+      return;
+    }
+
+    const std::array<std::size_t, sizeof...(ComponentTypeTs)> columns{
+        {this->Column(ComponentTypeTs::typeId)...}};
+
+    IterationScope scope(*this, _ecm);
+    for (std::size_t row = 0; row < this->entities.size(); ++row)
+    {
+      if (this->entities[row] == kNullEntity ||
+          (_filter == RowFilter::NEW && !this->newRows[row]) ||
+          (_filter == RowFilter::TO_REMOVE && !this->toRemoveRows[row]))
+      {
+        continue;
+      }
+
+      if (this->stale)
+        this->RefreshComponents(_ecm);
+
+      if (!this->Invoke<ComponentTypeTs...>(_f, row, columns,
+            std::index_sequence_for<ComponentTypeTs...>()))
+      {
+        break;
+      }
+    }
   }
 
-  /// Get a pointer to a component for an entity based on a component type.
-  /// \param[in] _entity The entity.
-  /// \param[in] _ecm Pointer to the entity component manager.
-  /// \return Pointer to the component.
-  public: template<typename ComponentTypeT>
-          ComponentTypeT *Component(const Entity _entity,
-              const EntityComponentManager *_ecm)
+  /// \brief Call a function for each entity within a range of rows. Unlike
+  /// Iterate, this doesn't prepare the view nor refresh component pointers,
+  /// so the view must not change while the rows are visited. This is used to
+  /// iterate disjoint ranges of rows from several threads.
+  /// \param[in] _f Function to call with the entity and a pointer to each
+  /// component.
+  /// \param[in] _begin First row.
+  /// \param[in] _end One past the last row.
+  public: template<typename ...ComponentTypeTs, typename FunctionT>
+          void IterateRows(FunctionT &_f, const std::size_t _begin,
+              const std::size_t _end) const
   {
-    ComponentTypeId typeId = ComponentTypeT::typeId;
-    return static_cast<ComponentTypeT *>(
-        const_cast<components::BaseComponent *>(
-          this->ComponentImplementation(_entity, typeId, _ecm)));
+    const std::array<std::size_t, sizeof...(ComponentTypeTs)> columns{
+        {this->Column(ComponentTypeTs::typeId)...}};
+
+    for (std::size_t row = _begin; row < _end; ++row)
+    {
+      if (this->entities[row] == kNullEntity)
+        continue;
+
+      this->Invoke<ComponentTypeTs...>(_f, row, columns,
+          std::index_sequence_for<ComponentTypeTs...>());
+    }
   }
 
+  /// \brief Compact and sort the rows, and refresh the cached component
+  /// pointers if needed. Rows are not moved while the view is being
+  /// iterated, or while the entity component manager is in a read-only
+  /// phase, since views are prepared when that phase starts.
+  /// \param[in] _ecm Pointer to the entity component manager.
+  public: void Prepare(const EntityComponentManager *_ecm);
+
   /// \brief Add an entity to the view.
   /// \param[in] _entity The entity to add.
   /// \param[in] _new Whether to add the entity to the list of new entities.
@@ -100,35 +172,136 @@ class IGNITION_GAZEBO_VISIBLE View
   /// \param[in] _entity The entity.
   /// \param[in] _compTypeId Component type id.
   /// \param[in] _compId Component id.
+  /// \param[in] _comp Pointer to the component data.
   public: void AddComponent(const Entity _entity,
                             const ComponentTypeId _compTypeId,
-                            const ComponentId _compId);
-
-  /// \brief Implementation of the Component accessor.
-  /// \param[in] _entity The entity.
-  /// \param[in] _typeId Type id of the component.
-  /// \param[in] _ecm Pointer to the EntityComponentManager.
-  /// \return Pointer to the component, or nullptr if not found.
-  private: const components::BaseComponent *ComponentImplementation(
-               const Entity _entity,
-               ComponentTypeId _typeId,
-               const EntityComponentManager *_ecm) const;
+                            const ComponentId _compId,
+                            const components::BaseComponent *_comp);
 
   /// \brief Clear the list of new entities
   public: void ClearNewEntities();
 
-  /// \brief All the entities that belong to this view.
-  public: std::set<Entity> entities;
+  /// \brief Remove all entities from the view.
+  public: void Reset();
+
+  /// \brief Mark the cached component pointers as invalid. This should be
+  /// called whenever a component storage used by this view moves its data.
+  public: void InvalidateComponents();
+
+  /// \brief Whether the view has the given component type.
+  /// \param[in] _typeId Component type id.
+  /// \return True if the component type is part of the view.
+  public: bool HasComponentType(const ComponentTypeId _typeId) const;
+
+  /// \brief Get the column of a component type in a row.
+  /// \param[in] _typeId Component type id.
+  /// \return Column index, or the number of component types if the type
+  /// is not part of this view.
+  private: std::size_t Column(const ComponentTypeId _typeId) const;
+
+  /// \brief Call a function with the entity and components of a row.
+  /// \param[in] _f Function to call.
+  /// \param[in] _row Row index.
+  /// \param[in] _columns Column of each of the component types.
+  /// \return Return value of the function.
+  private: template<typename ...ComponentTypeTs, typename FunctionT,
+                    std::size_t ...Is>
+           decltype(auto) Invoke(FunctionT &_f, const std::size_t _row,
+               const std::array<std::size_t, sizeof...(ComponentTypeTs)>
+               &_columns, std::index_sequence<Is...>) const
+  {
+    const std::size_t offset = _row * this->types.size();
+    return _f(this->entities[_row], static_cast<ComponentTypeTs *>(
+        this->componentPtrs[offset + _columns[Is]])...);
+  }
+
+  /// \brief Look up the component pointers of all rows again.
+  /// \param[in] _ecm Pointer to the entity component manager.
+  private: void RefreshComponents(const EntityComponentManager *_ecm);
+
+  /// \brief Remove empty rows and sort the rows by entity.
+  private: void Compact();
+
+  /// \brief Prepare the view and track the start of an iteration.
+  /// Iterations aren't tracked during a read-only phase, when several
+  /// threads may iterate the view at once.
+  /// \param[in] _ecm Pointer to the entity component manager.
+  /// \return True if the iteration is tracked and EndIteration must be
+  /// called.
+  private: bool BeginIteration(const EntityComponentManager *_ecm);
+
+  /// \brief Track the end of an iteration.
+  private: void EndIteration();
+
+  /// \brief Helper that tracks iterations in progress, so rows aren't
+  /// moved by a nested iteration.
+  private: class IterationScope
+  {
+    /// \brief Constructor, prepares the view for iteration.
+    /// \param[in] _view View being iterated.
+    /// \param[in] _ecm Pointer to the entity component manager.
+    public: IterationScope(View &_view, const EntityComponentManager *_ecm)
+            : view(_view), tracked(_view.BeginIteration(_ecm))
+    {
+    }
+
+    /// \brief Destructor
+    public: ~IterationScope()
+    {
+      if (this->tracked)
+        this->view.EndIteration();
+    }
+
+    /// \brief View being iterated.
+    private: View &view;
+
+    /// \brief Whether the iteration is tracked by the view.
+    private: bool tracked;
+  };
+
+  /// \brief Component types of this view, sorted. This is the column
+  /// order of each row.
+  public: std::vector<ComponentTypeId> types;
+
+  /// \brief Entity of each row. Removed rows hold kNullEntity until the
+  /// view is compacted.
+  public: std::vector<Entity> entities;
+
+  /// \brief Whether the entity of each row is newly created.
+  public: std::vector<bool> newRows;
+
+  /// \brief Whether the entity of each row is about to be removed.
+  public: std::vector<bool> toRemoveRows;
+
+  /// \brief Component ids, one per row and component type.
+  public: std::vector<ComponentId> componentIds;
+
+  /// \brief Cached component pointers, one per row and component type.
+  public: std::vector<components::BaseComponent *> componentPtrs;
+
+  /// \brief Row of each entity in the view.
+  public: std::unordered_map<Entity, std::size_t> entityRows;
+
+  /// \brief Number of rows of newly created entities.
+  private: std::size_t newCount{0};
+
+  /// \brief Number of rows of entities about to be removed.
+  private: std::size_t toRemoveCount{0};
+
+  /// \brief Number of removed rows which haven't been compacted.
+  private: std::size_t emptyCount{0};
+
+  /// \brief Largest entity added since the last compaction.
+  private: Entity maxEntity{kNullEntity};
 
-  /// \brief List of newly created entities
-  public: std::set<Entity> newEntities;
+  /// \brief True if rows were added out of entity order.
+  private: bool unsorted{false};
 
-  /// \brief List of entities about to be removed
-  public: std::set<Entity> toRemoveEntities;
+  /// \brief True if the cached component pointers may be invalid.
+  private: bool stale{false};
 
-  /// \brief All of the components for each entity.
-  public: std::map<std::pair<Entity, ComponentTypeId>,
-          ComponentId> components;
+  /// \brief Number of iterations in progress.
+  private: int iterationDepth{0};
 };
 /// \endcond
 }
@@ -549,3 +549,85 @@ TEST_F(ComponentTest, TypeName)
     EXPECT_EQ("123456", comp.typeName);
   }
 }
+
+//////////////////////////////////////////////////
+TEST_F(ComponentTest, BinarySerialization)
+{
+  // Arithmetic types
+  {
+    using Custom = components::Component<double, class CustomTag>;
+    Custom comp(-1.0 / 3.0);
+
+    std::string data;
+    EXPECT_TRUE(comp.SerializeBinary(data));
+    EXPECT_EQ(sizeof(double), data.size());
+
+    Custom other;
+    EXPECT_TRUE(other.DeserializeBinary(data));
+    EXPECT_EQ(comp.Data(), other.Data());
+
+    // Size mismatch
+    EXPECT_FALSE(other.DeserializeBinary(data.substr(1)));
+    EXPECT_FALSE(other.DeserializeBinary(data + "x"));
+  }
+
+  // Strings
+  {
+    using Custom = components::Component<std::string, class CustomTag>;
+    Custom comp(std::string("two words\nand\0null", 18));
+
+    std::string data;
+    EXPECT_TRUE(comp.SerializeBinary(data));
+
+    Custom other;
+    EXPECT_TRUE(other.DeserializeBinary(data));
+    EXPECT_EQ(comp.Data(), other.Data());
+    EXPECT_FALSE(other.DeserializeBinary(data.substr(0, data.size() - 1)));
+  }
+
+  // Poses
+  {
+    using Custom = components::Component<math::Pose3d, class CustomTag>;
+    Custom comp(math::Pose3d(1.1, 2.2, 3.3, 0.1, 0.2, 0.3));
+
+    std::string data;
+    EXPECT_TRUE(comp.SerializeBinary(data));
+    EXPECT_EQ(7 * sizeof(double), data.size());
+
+    Custom other;
+    EXPECT_TRUE(other.DeserializeBinary(data));
+    EXPECT_EQ(comp.Data(), other.Data());
+  }
+
+  // Component without data
+  {
+    using Custom = components::Component<components::NoData, class CustomTag>;
+    Custom comp;
+
+    std::string data;
+    EXPECT_TRUE(comp.SerializeBinary(data));
+    EXPECT_TRUE(data.empty());
+    EXPECT_TRUE(comp.DeserializeBinary(data));
+    EXPECT_FALSE(comp.DeserializeBinary("x"));
+  }
+
+  // Types without binary serialization
+  {
+    using Custom = components::Component<msgs::Int32, class CustomTag>;
+    Custom comp;
+
+    std::string data;
+    EXPECT_FALSE(comp.SerializeBinary(data));
+    EXPECT_FALSE(comp.DeserializeBinary(data));
+  }
+
+  // Custom serializers are always used
+  {
+    using Custom = components::Component<std::string, class CustomTag,
+        serializers::StringSerializer>;
+    Custom comp("string");
+
+    std::string data;
+    EXPECT_FALSE(comp.SerializeBinary(data));
+  }
+}
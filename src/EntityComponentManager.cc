@@ -15,8 +15,18 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
+#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -25,11 +35,211 @@
 #include <ignition/math/graph/GraphAlgorithms.hh>
 #include "ignition/gazebo/components/Component.hh"
 #include "ignition/gazebo/components/Factory.hh"
+#include "ignition/gazebo/components/ParentEntity.hh"
+#include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
 
+#include "ThreadPool.hh"
+
 using namespace ignition;
 using namespace gazebo;
 
+/// \brief An archetype groups all the entities that have exactly the same
+/// set of component types. The entities are stored in a dense array, and the
+/// ids of their components are stored in parallel arrays, one column per
+/// component type. This lets views be populated by matching a signature once
+/// per archetype and then walking its rows linearly, instead of looking up
+/// every component of every entity.
+class Archetype
+{
+  /// \brief Get the column that holds the component ids of a type.
+  /// \param[in] _typeId Component type, which must belong to the archetype.
+  /// \return Component ids, parallel to `entities`.
+  public: const std::vector<ComponentId> &Column(
+              const ComponentTypeId _typeId) const
+  {
+    return this->columns[std::distance(this->types.begin(),
+        this->types.find(_typeId))];
+  }
+
+  /// \brief Check whether this archetype has all the given component types.
+  /// \param[in] _types Component types to check.
+  /// \return True if all of _types belong to the archetype.
+  public: bool Matches(const detail::ComponentTypeKey &_types) const
+  {
+    return std::includes(this->types.begin(), this->types.end(),
+        _types.begin(), _types.end());
+  }
+
+  /// \brief Component types shared by all entities in this archetype.
+  public: detail::ComponentTypeKey types;
+
+  /// \brief All the entities in this archetype.
+  public: std::vector<Entity> entities;
+
+  /// \brief Component ids, with one column per type in `types` (in the same
+  /// order), and one row per entity in `entities`.
+  public: std::vector<std::vector<ComponentId>> columns;
+};
+
+/// \brief Removal of an entity or a component, which is kept so that it can
+/// be included in DeltaState.
+struct Removal
+{
+  /// \brief Version of the manager right after the removal.
+  uint64_t version;
+
+  /// \brief Entity which was removed, or whose component was removed.
+  Entity entity;
+
+  /// \brief Type of the removed component, or kComponentTypeIdInvalid if
+  /// the whole entity was removed.
+  ComponentTypeId type;
+};
+
+/// \brief Creation or change of a component, which is kept so that
+/// DeltaState can find the components changed since a version without
+/// visiting all of them.
+struct Change
+{
+  /// \brief Version of the manager right after the change.
+  uint64_t version;
+
+  /// \brief Entity which contains the component.
+  Entity entity;
+
+  /// \brief Type of the component.
+  ComponentTypeId type;
+};
+
+/// \brief Entities and component ids restored by
+/// EntityComponentManager::Reset. Component data is kept by a snapshot of
+/// each storage, see ComponentStorageBase::StartSnapshot.
+struct ResetPoint
+{
+  /// \brief Parent of each entity, or kNullEntity.
+  std::unordered_map<Entity, Entity> parents;
+
+  /// \brief Components of each entity. The key is the entity, and the value
+  /// maps component types to ids.
+  std::unordered_map<Entity,
+      std::unordered_map<ComponentTypeId, ComponentId>> entityComponents;
+
+  /// \brief Value of the entity counter.
+  uint64_t entityCount{0};
+};
+
+/// \brief World pose of an entity cached by
+/// EntityComponentManager::WorldPose, with what it was computed from.
+struct WorldPoseEntry
+{
+  /// \brief Pose in the world frame.
+  math::Pose3d world;
+
+  /// \brief Pose relative to the parent, which the world pose was composed
+  /// from.
+  math::Pose3d local;
+
+  /// \brief Parent the world pose was composed with, or kNullEntity if the
+  /// entity was a root.
+  Entity parent{kNullEntity};
+
+  /// \brief Stamp of the parent's entry when the world pose was composed.
+  uint64_t parentStamp{0};
+
+  /// \brief Stamp of this entry, renewed whenever its world pose is
+  /// recomputed, so descendants can tell that theirs are stale.
+  uint64_t stamp{0};
+
+  /// \brief Pose step in which the entry was last checked against the
+  /// entity's pose and parent.
+  uint64_t validatedStep{0};
+};
+
+/// \brief Hash function for a pair of entity and component type.
+struct EntityTypeHash
+{
+  /// \brief Hash a pair of entity and component type.
+  /// \param[in] _key Entity and component type.
+  /// \return The hash.
+  std::size_t operator()(const std::pair<Entity, ComponentTypeId> &_key) const
+  {
+    return std::hash<Entity>()(_key.first) * 31u +
+        std::hash<ComponentTypeId>()(_key.second);
+  }
+};
+
+/// \brief Maximum number of removals kept for DeltaState.
+static const std::size_t kMaxRemovals{10000};
+
+/// \brief Number of changes which are kept for DeltaState before compacting
+/// them, on top of one per component.
+static const std::size_t kMinStaleChanges{1024};
+
+/// \brief Key of the header entry holding the serialization format of a
+/// serialized state map.
+static const char kSerializationKey[] = "serialization";
+
+/// \brief Header value of serialized state maps with binary components.
+static const char kBinarySerialization[] = "binary";
+
+/// \brief Version of the layout written by EntityComponentManager::Snapshot.
+static const uint32_t kSnapshotVersion{1};
+
+/// \brief Append a fixed size value to a snapshot.
+/// \param[out] _out Snapshot to append to.
+/// \param[in] _value Value to append.
+template <typename T>
+static void appendSnapshotValue(std::string &_out, const T &_value)
+{
+  _out.append(reinterpret_cast<const char *>(&_value), sizeof(T));
+}
+
+/// \brief Reads a snapshot sequentially, checking that reads don't go past
+/// its end.
+class SnapshotReader
+{
+  /// \brief Constructor
+  /// \param[in] _data Start of the snapshot.
+  /// \param[in] _size Size of the snapshot in bytes.
+  public: SnapshotReader(const char *_data, const std::size_t _size)
+    : data(_data), end(_data + _size)
+  {
+  }
+
+  /// \brief Read a fixed size value.
+  /// \param[out] _value Value read.
+  /// \return False if the snapshot is too short.
+  public: template <typename T>
+  bool Read(T &_value)
+  {
+    const char *bytes = this->Take(sizeof(T));
+    if (nullptr == bytes)
+      return false;
+    std::memcpy(&_value, bytes, sizeof(T));
+    return true;
+  }
+
+  /// \brief Skip over a number of bytes.
+  /// \param[in] _size Number of bytes.
+  /// \return Start of the skipped bytes, or null if the snapshot is too
+  /// short.
+  public: const char *Take(const uint64_t _size)
+  {
+    if (static_cast<uint64_t>(this->end - this->data) < _size)
+      return nullptr;
+    const char *result = this->data;
+    this->data += _size;
+    return result;
+  }
+
+  /// \brief Next byte to read.
+  private: const char *data;
+
+  /// \brief End of the snapshot.
+  private: const char *end;
+};
+
 class ignition::gazebo::EntityComponentManagerPrivate
 {
   /// \brief Implementation of the CreateEntity function, which takes a specific
@@ -51,8 +261,14 @@ class ignition::gazebo::EntityComponentManagerPrivate
   public: bool CreateComponentStorage(const ComponentTypeId _typeId);
 
   /// \brief Allots the work for multiple threads prior to running
-  /// `AddEntityToMessage`.
-  public: void CalculateStateThreadLoad();
+  /// `AddEntityToMessage`. Must be called with stateThreadLoadMutex locked.
+  /// \param[in] _chunkCount Maximum number of chunks to split the entities
+  /// into.
+  public: void CalculateStateThreadLoad(const std::size_t _chunkCount);
+
+  /// \brief Get the pool used to serialize the state.
+  /// \return The pool set with SetStateThreadCount, or the shared pool.
+  public: ThreadPool &StatePool() const;
 
   /// \brief Create a message for the removed components
   /// \param[in] _entity Entity with the removed components
@@ -78,6 +294,84 @@ class ignition::gazebo::EntityComponentManagerPrivate
   /// \param[in] _entity Entity that has component newly modified
   public: void AddModifiedComponent(const Entity &_entity);
 
+  /// \brief Move an entity to the archetype that matches its current set of
+  /// component types. This must be called whenever a component type is added
+  /// to or removed from an entity.
+  /// \param[in] _entity Entity whose set of component types changed.
+  public: void UpdateArchetype(const Entity _entity);
+
+  /// \brief Remove an entity from the archetype it belongs to, if any.
+  /// \param[in] _entity Entity to remove.
+  public: void RemoveFromArchetype(const Entity _entity);
+
+  /// \brief Invalidate the cached component pointers of all views that
+  /// contain a component type. This must be called whenever the storage of
+  /// that component type moves its data.
+  /// \param[in] _typeId Component type whose storage changed.
+  public: void InvalidateViews(const ComponentTypeId _typeId);
+
+  /// \brief Start or end a read-only phase.
+  /// \param[in] _readOnly True to start a read-only phase, false to end it.
+  /// \param[in] _ecm The entity component manager which owns this data.
+  /// \sa EntityComponentManager::SetReadOnly
+  public: void SetReadOnly(const bool _readOnly,
+      const EntityComponentManager *_ecm);
+
+  /// \brief Check that entities and components can be created or removed,
+  /// which isn't the case during a read-only phase. Otherwise, print an
+  /// error, and assert in debug builds, since other threads may be reading
+  /// the storages without locking.
+  /// \param[in] _request Description of the rejected request.
+  /// \return False during a read-only phase.
+  public: bool CheckWritable(const std::string &_request) const;
+
+  /// \brief Increase the version of the manager, and assign it to a
+  /// component if versions are logged. Must be called with
+  /// changedComponentsMutex locked.
+  /// \param[in] _entity Entity that contains the component.
+  /// \param[in] _typeId Type of the component.
+  public: void UpdateVersion(const Entity _entity,
+      const ComponentTypeId _typeId);
+
+  /// \brief Increase the version of the manager and, if versions are
+  /// logged, record a removal so that it's included in DeltaState. Must be
+  /// called with changedComponentsMutex locked.
+  /// \param[in] _entity Entity which was removed, or whose component was
+  /// removed.
+  /// \param[in] _typeId Type of the removed component, or
+  /// kComponentTypeIdInvalid if the whole entity was removed. In that case,
+  /// this must be called before the entity's components are forgotten.
+  public: void RecordRemoval(const Entity _entity,
+      const ComponentTypeId _typeId);
+
+  /// \brief Start logging versions, if they aren't logged yet. Changes made
+  /// before are forgotten, so deltas from earlier versions aren't possible.
+  /// Must be called with changedComponentsMutex locked.
+  public: void StartVersionLog();
+
+  /// \brief Forget the cached world pose of an entity whose pose or parent
+  /// changed. The entity's descendants are recomputed too, the next time
+  /// they're queried.
+  /// \param[in] _entity The entity.
+  public: void InvalidateWorldPose(const Entity _entity);
+
+  /// \brief Serialize a component into a message, using binary
+  /// serialization if it's enabled and supported by the component.
+  /// \param[in] _component Component to serialize.
+  /// \param[out] _msg Message to fill.
+  public: void SerializeComponent(const components::BaseComponent &_component,
+      msgs::SerializedComponent &_msg) const;
+
+  /// \brief Tag a message with the serialization format in use.
+  /// \param[out] _msg Message to tag.
+  public: void SetSerializationHeader(msgs::SerializedStateMap &_msg) const;
+
+  /// \brief Remove components from their storages, one storage at a time,
+  /// and invalidate the views that use them.
+  /// \param[in] _ids Ids of the components to remove, per component type.
+  public: void RemoveFromStorages(const std::unordered_map<ComponentTypeId,
+      std::vector<ComponentId>> &_ids);
+
   /// \brief Map of component storage classes. The key is a component
   /// type id, and the value is a pointer to the component storage.
   public: std::unordered_map<ComponentTypeId,
@@ -128,6 +422,33 @@ class ignition::gazebo::EntityComponentManagerPrivate
           std::unordered_map<ComponentTypeId, ComponentId>>::iterator>
             entityComponentIterators;
 
+  /// \brief Number of chunks `entityComponentIterators` was calculated for.
+  public: std::size_t entityComponentChunkCount{0};
+
+  /// \brief Protects `entityComponentIterators` from concurrent calls to
+  /// `State`, such as from systems updated in parallel during PostUpdate.
+  public: std::mutex stateThreadLoadMutex;
+
+  /// \brief Pool used to serialize the state, set through
+  /// SetStateThreadCount. If null, the shared pool is used.
+  public: std::unique_ptr<ThreadPool> statePool;
+
+  /// \brief All archetypes that have been seen so far. Archetypes are never
+  /// removed, except when all entities are removed, so their indices are
+  /// stable.
+  public: std::vector<Archetype> archetypes;
+
+  /// \brief Index of each archetype in `archetypes`, keyed by its component
+  /// types.
+  public: std::map<detail::ComponentTypeKey, std::size_t> archetypeIndices;
+
+  /// \brief The archetype each entity belongs to. The key is the entity, and
+  /// the value is a pair of the archetype index and the entity's row within
+  /// the archetype. Entities without components don't belong to any
+  /// archetype.
+  public: std::unordered_map<Entity, std::pair<std::size_t, std::size_t>>
+          entityArchetypes;
+
   /// \brief A mutex to protect newly created entities.
   public: std::mutex entityCreatedMutex;
 
@@ -137,12 +458,78 @@ class ignition::gazebo::EntityComponentManagerPrivate
   /// \brief A mutex to protect from concurrent writes to views
   public: mutable std::mutex viewsMutex;
 
+  /// \brief Cached world pose of each entity.
+  /// \sa EntityComponentManager::WorldPose
+  public: std::unordered_map<Entity, WorldPoseEntry> worldPoses;
+
+  /// \brief Last stamp given to an entry of worldPoses.
+  public: uint64_t worldPoseStamp{0};
+
+  /// \brief Entries of worldPoses validated in an older step must be
+  /// checked again before they're used.
+  /// \sa EntityComponentManager::InvalidateWorldPoses
+  public: std::atomic<uint64_t> poseStep{1};
+
+  /// \brief Protects worldPoses. Validated entries are read under a shared
+  /// lock, so systems querying world poses concurrently don't wait for each
+  /// other.
+  public: mutable std::shared_mutex worldPosesMutex;
+
+  /// \brief Number of nested batches in progress.
+  /// \sa EntityComponentManager::BeginBatch
+  public: unsigned int batchDepth{0};
+
+  /// \brief Entities whose views must be updated when the batch is
+  /// applied. Ordered, so views receive entities in creation order.
+  public: std::set<Entity> batchEntities;
+
+  /// \brief Component types whose storage grew during the batch.
+  public: std::set<ComponentTypeId> batchGrownTypes;
+
   /// \brief A mutex to protect removed components
   public: mutable std::mutex removedComponentsMutex;
 
+  /// \brief A mutex to protect the sets of changed components and
+  /// modifiedComponents from systems which call SetChanged concurrently.
+  /// It also protects the versions and removals.
+  public: mutable std::mutex changedComponentsMutex;
+
+  /// \brief Version of the most recent change.
+  public: uint64_t version{0};
+
+  /// \brief True once versions are logged, which is only needed by
+  /// DeltaState and ComponentVersion. They're logged from the first call to
+  /// Version, ComponentVersion or DeltaState on, so managers which never
+  /// serialize deltas don't pay for it on every change.
+  public: bool versionLog{false};
+
+  /// \brief Version of each component, see ComponentVersion.
+  public: std::unordered_map<std::pair<Entity, ComponentTypeId>, uint64_t,
+          EntityTypeHash> componentVersions;
+
+  /// \brief Changes ordered by version, oldest first. A component may
+  /// appear several times, only the entry matching its current version in
+  /// componentVersions is valid. Stale entries are compacted once they
+  /// outnumber the components.
+  public: std::deque<Change> changes;
+
+  /// \brief The most recent removals, oldest first.
+  public: std::deque<Removal> removals;
+
+  /// \brief Removals up to this version have been dropped from removals,
+  /// so deltas from earlier versions can't be computed.
+  public: uint64_t forgottenVersion{0};
+
+  /// \brief Whether serialized state maps use binary serialization.
+  public: std::atomic<bool> binarySerialization{false};
+
   /// \brief The set of all views.
   public: mutable std::map<detail::ComponentTypeKey, detail::View> views;
 
+  /// \brief True during a read-only phase.
+  /// \sa EntityComponentManager::SetReadOnly
+  public: std::atomic<bool> readOnly{false};
+
   /// \brief Cache of previously queried descendants. The key is the parent
   /// entity for which descendants were queried, and the value are all its
   /// descendants.
@@ -152,10 +539,18 @@ class ignition::gazebo::EntityComponentManagerPrivate
   /// \brief Keep track of entities already used to ensure uniqueness.
   public: uint64_t entityCount{0};
 
+  /// \brief Value of entityCount before Reset rewound it. Entities up to
+  /// this ID may still exist, waiting to be removed.
+  public: uint64_t rewoundEntityCount{0};
+
   /// \brief Unordered multimap of removed components. The key is the entity to
   /// which belongs the component, and the value is the component being
   /// removed.
   std::unordered_multimap<Entity, ComponentKey> removedComponents;
+
+  /// \brief Entities and components restored by Reset, null until
+  /// SetResetPoint is called.
+  public: std::unique_ptr<ResetPoint> resetPoint;
 };
 
 //////////////////////////////////////////////////
@@ -178,6 +573,10 @@ Entity EntityComponentManager::CreateEntity()
 {
   Entity entity = ++this->dataPtr->entityCount;
 
+  // After a reset, skip the IDs of entities which haven't been removed yet
+  while (entity <= this->dataPtr->rewoundEntityCount && this->HasEntity(entity))
+    entity = ++this->dataPtr->entityCount;
+
   if (entity == std::numeric_limits<uint64_t>::max())
   {
     ignwarn << "Reached maximum number of entities [" << entity << "]"
@@ -240,6 +639,12 @@ void EntityComponentManagerPrivate::InsertEntityRecursive(Entity _entity,
 void EntityComponentManager::RequestRemoveEntity(Entity _entity,
     bool _recursive)
 {
+  if (!this->dataPtr->CheckWritable(
+      "remove entity [" + std::to_string(_entity) + "]"))
+  {
+    return;
+  }
+
   // Store the to-be-removed entities in a temporary set so we can call
   // UpdateViews on each of them
   std::unordered_set<Entity> tmpToRemoveEntities;
@@ -267,6 +672,9 @@ void EntityComponentManager::RequestRemoveEntity(Entity _entity,
 /////////////////////////////////////////////////
 void EntityComponentManager::RequestRemoveEntities()
 {
+  if (!this->dataPtr->CheckWritable("remove all entities"))
+    return;
+
   {
     std::lock_guard<std::mutex> lock(this->dataPtr->entityRemoveMutex);
     this->dataPtr->removeAllEntities = true;
@@ -288,6 +696,26 @@ void EntityComponentManager::ProcessRemoveEntityRequests()
     this->dataPtr->entityComponents.clear();
     this->dataPtr->toRemoveEntities.clear();
     this->dataPtr->entityComponentsDirty = true;
+    this->dataPtr->archetypes.clear();
+    this->dataPtr->archetypeIndices.clear();
+    this->dataPtr->entityArchetypes.clear();
+
+    // Removals aren't recorded one by one, so deltas from before this point
+    // are not possible.
+    {
+      std::lock_guard<std::mutex> lockChanged(
+          this->dataPtr->changedComponentsMutex);
+      this->dataPtr->forgottenVersion = ++this->dataPtr->version;
+      this->dataPtr->componentVersions.clear();
+      this->dataPtr->changes.clear();
+      this->dataPtr->removals.clear();
+    }
+
+    {
+      std::unique_lock<std::shared_mutex> lockPoses(
+          this->dataPtr->worldPosesMutex);
+      this->dataPtr->worldPoses.clear();
+    }
 
     for (std::pair<const ComponentTypeId,
         std::unique_ptr<ComponentStorageBase>> &comp: this->dataPtr->components)
@@ -301,6 +729,13 @@ void EntityComponentManager::ProcessRemoveEntityRequests()
   else
   {
     IGN_PROFILE("Remove");
+    // Components to remove, grouped by type so each storage is visited
+    // once.
+    std::unordered_map<ComponentTypeId, std::vector<ComponentId>> removedIds;
+
+    std::lock_guard<std::mutex> lockChanged(
+        this->dataPtr->changedComponentsMutex);
+
     // Otherwise iterate through the list of entities to remove.
     for (const Entity entity : this->dataPtr->toRemoveEntities)
     {
@@ -310,19 +745,19 @@ void EntityComponentManager::ProcessRemoveEntityRequests()
 
       // Remove from graph
       this->dataPtr->entities.RemoveVertex(entity);
+      this->dataPtr->RecordRemoval(entity, kComponentTypeIdInvalid);
 
       auto entityIter = this->dataPtr->entityComponents.find(entity);
       // Remove the components, if any.
       if (entityIter != this->dataPtr->entityComponents.end())
       {
         for (const auto &key : entityIter->second)
-        {
-          this->dataPtr->components.at(key.first)->Remove(key.second);
-        }
+          removedIds[key.first].push_back(key.second);
 
         // Remove the entry in the entityComponent map
         this->dataPtr->entityComponents.erase(entity);
         this->dataPtr->entityComponentsDirty = true;
+        this->dataPtr->RemoveFromArchetype(entity);
       }
 
       // Remove the entity from views.
@@ -333,6 +768,8 @@ void EntityComponentManager::ProcessRemoveEntityRequests()
     }
     // Clear the set of entities to remove.
     this->dataPtr->toRemoveEntities.clear();
+
+    this->dataPtr->RemoveFromStorages(removedIds);
   }
 
   // Reset descendants cache
@@ -357,11 +794,24 @@ bool EntityComponentManager::RemoveComponent(
   if (!this->EntityHasComponent(_entity, _key))
     return false;
 
+  if (!this->dataPtr->CheckWritable("remove component of type [" +
+      std::to_string(_key.first) + "] from entity [" +
+      std::to_string(_entity) + "]"))
+  {
+    return false;
+  }
+
   this->dataPtr->components.at(_key.first)->Remove(_key.second);
+  this->dataPtr->InvalidateViews(_key.first);
   this->dataPtr->entityComponents[_entity].erase(_key.first);
-  this->dataPtr->oneTimeChangedComponents.erase(_key);
-  this->dataPtr->periodicChangedComponents.erase(_key);
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
+    this->dataPtr->oneTimeChangedComponents.erase(_key);
+    this->dataPtr->periodicChangedComponents.erase(_key);
+    this->dataPtr->RecordRemoval(_entity, _key.first);
+  }
   this->dataPtr->entityComponentsDirty = true;
+  this->dataPtr->UpdateArchetype(_entity);
 
   this->UpdateViews(_entity);
 
@@ -376,6 +826,64 @@ bool EntityComponentManager::RemoveComponent(
   return true;
 }
 
+/////////////////////////////////////////////////
+std::size_t EntityComponentManager::RemoveComponents(
+    const std::vector<Entity> &_entities)
+{
+  IGN_PROFILE("EntityComponentManager::RemoveComponents");
+
+  if (!this->dataPtr->CheckWritable("remove components of " +
+      std::to_string(_entities.size()) + " entities"))
+  {
+    return 0;
+  }
+
+  std::unordered_map<ComponentTypeId, std::vector<ComponentId>> removedIds;
+  std::vector<Entity> changedEntities;
+  std::size_t count{0};
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->removedComponentsMutex);
+    std::lock_guard<std::mutex> lockChanged(
+        this->dataPtr->changedComponentsMutex);
+    for (const Entity entity : _entities)
+    {
+      auto entityIter = this->dataPtr->entityComponents.find(entity);
+      if (entityIter == this->dataPtr->entityComponents.end() ||
+          entityIter->second.empty())
+      {
+        continue;
+      }
+
+      for (const auto &comp : entityIter->second)
+      {
+        ComponentKey key{comp.first, comp.second};
+        removedIds[key.first].push_back(key.second);
+        this->dataPtr->oneTimeChangedComponents.erase(key);
+        this->dataPtr->periodicChangedComponents.erase(key);
+        this->dataPtr->removedComponents.insert(std::make_pair(entity, key));
+        this->dataPtr->RecordRemoval(entity, key.first);
+        ++count;
+      }
+
+      entityIter->second.clear();
+      this->dataPtr->RemoveFromArchetype(entity);
+      this->dataPtr->AddModifiedComponent(entity);
+      changedEntities.push_back(entity);
+    }
+  }
+
+  if (changedEntities.empty())
+    return 0;
+
+  this->dataPtr->entityComponentsDirty = true;
+  this->dataPtr->RemoveFromStorages(removedIds);
+
+  for (const Entity entity : changedEntities)
+    this->UpdateViews(entity);
+
+  return count;
+}
+
 /////////////////////////////////////////////////
 bool EntityComponentManager::EntityHasComponent(const Entity _entity,
     const ComponentKey &_key) const
@@ -439,6 +947,7 @@ ComponentState EntityComponentManager::ComponentState(const Entity _entity,
 
   ComponentKey key{_typeId, typeKey->second};
 
+  std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
   if (this->dataPtr->oneTimeChangedComponents.find(key) !=
       this->dataPtr->oneTimeChangedComponents.end())
   {
@@ -516,6 +1025,9 @@ bool EntityComponentManager::SetParentEntity(const Entity _child,
     this->dataPtr->entities.RemoveEdge(edge);
   }
 
+  // Reset descendants cache
+  this->dataPtr->descendantCache.clear();
+
   // Leave parent-less
   if (_parent == kNullEntity)
   {
@@ -527,6 +1039,291 @@ bool EntityComponentManager::SetParentEntity(const Entity _child,
   return (math::graph::kNullId != edge.Id());
 }
 
+/////////////////////////////////////////////////
+std::unordered_map<Entity, Entity> EntityComponentManager::Merge(
+    const EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("EntityComponentManager::Merge");
+
+  this->BeginBatch();
+
+  std::vector<Entity> entities;
+  entities.reserve(_ecm.dataPtr->entities.Vertices().size());
+  for (const auto &vertex : _ecm.dataPtr->entities.Vertices())
+    entities.push_back(vertex.first);
+  std::sort(entities.begin(), entities.end());
+
+  std::unordered_map<Entity, Entity> newEntities;
+  newEntities.reserve(entities.size());
+  for (const Entity entity : entities)
+    newEntities[entity] = this->CreateEntity();
+
+  for (const Entity entity : entities)
+  {
+    const Entity newEntity = newEntities[entity];
+
+    auto ecIter = _ecm.dataPtr->entityComponents.find(entity);
+    if (ecIter != _ecm.dataPtr->entityComponents.end())
+    {
+      for (const auto &type : ecIter->second)
+      {
+        this->CreateComponentImplementation(newEntity, type.first,
+            _ecm.ComponentImplementation(entity, type.first));
+      }
+    }
+
+    auto parentIter = newEntities.find(_ecm.ParentEntity(entity));
+    if (parentIter != newEntities.end())
+      this->SetParentEntity(newEntity, parentIter->second);
+  }
+
+  this->EndBatch();
+  return newEntities;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManager::Snapshot(std::string &_out) const
+{
+  IGN_PROFILE("EntityComponentManager::Snapshot");
+
+  appendSnapshotValue(_out, kSnapshotVersion);
+
+  // Entities and their parents, in creation order
+  std::vector<Entity> entities;
+  entities.reserve(this->dataPtr->entities.Vertices().size());
+  for (const auto &vertex : this->dataPtr->entities.Vertices())
+    entities.push_back(vertex.first);
+  std::sort(entities.begin(), entities.end());
+
+  appendSnapshotValue<uint64_t>(_out, entities.size());
+  for (const Entity entity : entities)
+  {
+    appendSnapshotValue<uint64_t>(_out, entity);
+    appendSnapshotValue<uint64_t>(_out, this->ParentEntity(entity));
+  }
+
+  // One column per component type
+  std::map<ComponentTypeId, std::vector<Entity>> columns;
+  for (const Entity entity : entities)
+  {
+    auto ecIter = this->dataPtr->entityComponents.find(entity);
+    if (ecIter == this->dataPtr->entityComponents.end())
+      continue;
+
+    for (const auto &type : ecIter->second)
+      columns[type.first].push_back(entity);
+  }
+
+  appendSnapshotValue<uint64_t>(_out, columns.size());
+
+  std::ostringstream ostr;
+  const auto defaultFlags = ostr.flags();
+  std::string blob;
+  std::vector<uint64_t> offsets;
+  for (const auto &column : columns)
+  {
+    const ComponentTypeId typeId = column.first;
+    const auto &columnEntities = column.second;
+
+    // Binary serialization is supported by all or none of the components of
+    // a type, so check it once per column.
+    std::string probe;
+    const bool binary = this->ComponentImplementation(columnEntities.front(),
+        typeId)->SerializeBinary(probe);
+
+    blob.clear();
+    offsets.clear();
+    offsets.push_back(0);
+    for (const Entity entity : columnEntities)
+    {
+      auto comp = this->ComponentImplementation(entity, typeId);
+      if (binary)
+      {
+        comp->SerializeBinary(blob);
+      }
+      else
+      {
+        ostr.str("");
+        ostr.clear();
+        ostr.flags(defaultFlags);
+        comp->Serialize(ostr);
+        blob += ostr.str();
+      }
+      offsets.push_back(blob.size());
+    }
+
+    appendSnapshotValue<uint64_t>(_out, typeId);
+    appendSnapshotValue<uint64_t>(_out, columnEntities.size());
+    appendSnapshotValue<uint8_t>(_out, binary ? 1 : 0);
+    _out.append(reinterpret_cast<const char *>(columnEntities.data()),
+        columnEntities.size() * sizeof(Entity));
+    _out.append(reinterpret_cast<const char *>(offsets.data()),
+        offsets.size() * sizeof(uint64_t));
+    _out += blob;
+  }
+}
+
+/////////////////////////////////////////////////
+bool EntityComponentManager::LoadSnapshot(const char *_data,
+    const std::size_t _size)
+{
+  IGN_PROFILE("EntityComponentManager::LoadSnapshot");
+
+  if (this->EntityCount() > 0)
+  {
+    ignerr << "Can't load a snapshot into an entity component manager which "
+           << "already has entities." << std::endl;
+    return false;
+  }
+
+  SnapshotReader reader(_data, _size);
+
+  uint32_t version{0};
+  if (!reader.Read(version) || version != kSnapshotVersion)
+  {
+    ignerr << "Unsupported snapshot version [" << version << "], expected ["
+           << kSnapshotVersion << "]." << std::endl;
+    return false;
+  }
+
+  auto invalid = []()
+  {
+    ignerr << "Snapshot is truncated or corrupted." << std::endl;
+    return false;
+  };
+
+  // Decode the whole snapshot before touching the manager, so an invalid
+  // snapshot leaves it empty.
+  uint64_t entityCount{0};
+  if (!reader.Read(entityCount))
+    return invalid();
+
+  std::vector<std::pair<Entity, Entity>> entities;
+  std::unordered_set<Entity> entitySet;
+  for (uint64_t i = 0; i < entityCount; ++i)
+  {
+    Entity entity{kNullEntity};
+    Entity parent{kNullEntity};
+    if (!reader.Read(entity) || !reader.Read(parent) ||
+        entity == kNullEntity || !entitySet.insert(entity).second)
+    {
+      return invalid();
+    }
+    entities.emplace_back(entity, parent);
+  }
+
+  for (const auto &[entity, parent] : entities)
+  {
+    if (parent != kNullEntity && entitySet.find(parent) == entitySet.end())
+      return invalid();
+  }
+
+  uint64_t columnCount{0};
+  if (!reader.Read(columnCount))
+    return invalid();
+
+  // A single stream and buffer are reused for all components.
+  std::istringstream istr;
+  const auto defaultFlags = istr.flags();
+  std::string compData;
+  std::vector<std::pair<Entity,
+      std::unique_ptr<components::BaseComponent>>> comps;
+  for (uint64_t c = 0; c < columnCount; ++c)
+  {
+    uint64_t typeId{0};
+    uint64_t count{0};
+    uint8_t binary{0};
+    if (!reader.Read(typeId) || !reader.Read(count) || !reader.Read(binary) ||
+        count > entityCount)
+    {
+      return invalid();
+    }
+
+    const char *entityData = reader.Take(count * sizeof(Entity));
+    const char *offsetData = reader.Take((count + 1) * sizeof(uint64_t));
+    if (nullptr == entityData || nullptr == offsetData)
+      return invalid();
+
+    uint64_t blobSize{0};
+    std::memcpy(&blobSize, offsetData + count * sizeof(uint64_t),
+        sizeof(uint64_t));
+    const char *blob = reader.Take(blobSize);
+    if (nullptr == blob)
+      return invalid();
+
+    // Skipping the column would restore a world which is missing some of
+    // its components, so reject the snapshot instead.
+    if (!components::Factory::Instance()->HasType(typeId))
+    {
+      ignerr << "Component type [" << typeId << "] has not been registered "
+             << "in this process, so the snapshot can't be loaded."
+             << std::endl;
+      return false;
+    }
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+      Entity entity;
+      uint64_t begin;
+      uint64_t end;
+      std::memcpy(&entity, entityData + i * sizeof(Entity), sizeof(Entity));
+      std::memcpy(&begin, offsetData + i * sizeof(uint64_t),
+          sizeof(uint64_t));
+      std::memcpy(&end, offsetData + (i + 1) * sizeof(uint64_t),
+          sizeof(uint64_t));
+      if (begin > end || end > blobSize ||
+          entitySet.find(entity) == entitySet.end())
+      {
+        return invalid();
+      }
+
+      auto comp = components::Factory::Instance()->New(typeId);
+      if (nullptr == comp)
+      {
+        ignerr << "Failed to create component of type [" << typeId
+               << "] from the snapshot." << std::endl;
+        return false;
+      }
+
+      compData.assign(blob + begin, end - begin);
+      if (binary)
+      {
+        // Binary data can't be read as text, so the snapshot is unusable if
+        // this type no longer supports it.
+        if (!comp->DeserializeBinary(compData))
+          return invalid();
+      }
+      else
+      {
+        istr.clear();
+        istr.flags(defaultFlags);
+        istr.str(compData);
+        comp->Deserialize(istr);
+      }
+      comps.emplace_back(entity, std::move(comp));
+    }
+  }
+
+  // Create all entities before connecting them, since parents may have been
+  // created after their children.
+  for (const auto &[entity, parent] : entities)
+  {
+    this->dataPtr->CreateEntityImplementation(entity);
+    this->dataPtr->entityCount = std::max(this->dataPtr->entityCount, entity);
+  }
+
+  for (const auto &[entity, parent] : entities)
+  {
+    if (parent != kNullEntity)
+      this->SetParentEntity(entity, parent);
+  }
+
+  for (const auto &[entity, comp] : comps)
+    this->CreateComponentImplementation(entity, comp->TypeId(), comp.get());
+
+  return true;
+}
+
 /////////////////////////////////////////////////
 ComponentKey EntityComponentManager::CreateComponentImplementation(
     const Entity _entity, const ComponentTypeId _componentTypeId,
@@ -541,6 +1338,13 @@ ComponentKey EntityComponentManager::CreateComponentImplementation(
     return ComponentKey();
   }
 
+  if (!this->dataPtr->CheckWritable("create component of type [" +
+      std::to_string(_componentTypeId) + "] for entity [" +
+      std::to_string(_entity) + "]"))
+  {
+    return ComponentKey();
+  }
+
   // If type hasn't been instantiated yet, create a storage for it
   if (!this->HasComponentType(_componentTypeId))
   {
@@ -556,20 +1360,33 @@ ComponentKey EntityComponentManager::CreateComponentImplementation(
   this->dataPtr->AddModifiedComponent(_entity);
 
   // Instantiate the new component.
-  std::pair<ComponentId, bool> componentIdPair =
-    this->dataPtr->components[_componentTypeId]->Create(_data);
+  auto &storage = this->dataPtr->components[_componentTypeId];
+  std::pair<ComponentId, bool> componentIdPair = nullptr == _data ?
+      storage->CreateDefault() : storage->Create(_data);
 
   ComponentKey componentKey{_componentTypeId, componentIdPair.first};
 
   this->dataPtr->entityComponents[_entity].insert(
       {_componentTypeId, componentIdPair.first});
-  this->dataPtr->oneTimeChangedComponents.insert(componentKey);
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
+    this->dataPtr->oneTimeChangedComponents.insert(componentKey);
+    this->dataPtr->UpdateVersion(_entity, _componentTypeId);
+  }
   this->dataPtr->entityComponentsDirty = true;
+  this->dataPtr->UpdateArchetype(_entity);
 
+  // The storage reallocated, so the component pointers cached by views
+  // are no longer valid.
   if (componentIdPair.second)
-    this->RebuildViews();
-  else
-    this->UpdateViews(_entity);
+  {
+    if (this->dataPtr->batchDepth > 0)
+      this->dataPtr->batchGrownTypes.insert(_componentTypeId);
+    else
+      this->dataPtr->InvalidateViews(_componentTypeId);
+  }
+
+  this->UpdateViews(_entity);
 
   return componentKey;
 }
@@ -672,6 +1489,134 @@ components::BaseComponent *EntityComponentManager::ComponentImplementation(
   return nullptr;
 }
 
+/////////////////////////////////////////////////
+components::BaseComponent
+    *EntityComponentManager::ViewComponentImplementation(
+    const ComponentKey &_key) const
+{
+  auto iter = this->dataPtr->components.find(_key.first);
+  if (iter == this->dataPtr->components.end())
+    return nullptr;
+  return iter->second->Component(_key.second);
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManager::SetResetPoint()
+{
+  IGN_PROFILE("EntityComponentManager::SetResetPoint");
+
+  auto resetPoint = std::make_unique<ResetPoint>();
+  resetPoint->entityCount = this->dataPtr->entityCount;
+  for (const auto &vertex : this->dataPtr->entities.Vertices())
+  {
+    const Entity entity = vertex.first;
+    if (this->IsMarkedForRemoval(entity))
+      continue;
+
+    resetPoint->parents[entity] = this->ParentEntity(entity);
+    auto ecIter = this->dataPtr->entityComponents.find(entity);
+    if (ecIter != this->dataPtr->entityComponents.end())
+      resetPoint->entityComponents[entity] = ecIter->second;
+  }
+
+  for (auto &storage : this->dataPtr->components)
+    storage.second->StartSnapshot();
+
+  // Views cache mutable components, which must be fetched again so that
+  // writing to them copies their storage first.
+  for (auto &view : this->dataPtr->views)
+    view.second.InvalidateComponents();
+
+  this->dataPtr->resetPoint = std::move(resetPoint);
+}
+
+/////////////////////////////////////////////////
+bool EntityComponentManager::HasResetPoint() const
+{
+  return nullptr != this->dataPtr->resetPoint;
+}
+
+/////////////////////////////////////////////////
+bool EntityComponentManager::Reset()
+{
+  IGN_PROFILE("EntityComponentManager::Reset");
+
+  if (nullptr == this->dataPtr->resetPoint)
+    return false;
+
+  const ResetPoint &resetPoint = *this->dataPtr->resetPoint;
+
+  this->BeginBatch();
+
+  // Remove entities created since the reset point. Systems are notified
+  // through the usual removal path.
+  std::vector<Entity> created;
+  for (const auto &vertex : this->dataPtr->entities.Vertices())
+  {
+    if (resetPoint.parents.find(vertex.first) == resetPoint.parents.end())
+      created.push_back(vertex.first);
+  }
+  for (const Entity entity : created)
+    this->RequestRemoveEntity(entity, false);
+
+  // Create the entities removed since the reset point before connecting
+  // them, since parents may have been removed after their children.
+  for (const auto &parent : resetPoint.parents)
+  {
+    if (!this->HasEntity(parent.first))
+      this->dataPtr->CreateEntityImplementation(parent.first);
+  }
+
+  for (const auto &parent : resetPoint.parents)
+  {
+    const Entity entity = parent.first;
+    if (this->ParentEntity(entity) != parent.second)
+      this->SetParentEntity(entity, parent.second);
+
+    // Components created since the reset point are kept.
+    auto ecIter = resetPoint.entityComponents.find(entity);
+    if (ecIter == resetPoint.entityComponents.end())
+      continue;
+
+    for (const auto &type : ecIter->second)
+    {
+      ComponentStorageBase &storage = *this->dataPtr->components.at(
+          type.first);
+
+      // Storages which weren't copied haven't been modified, so their
+      // components are still the same.
+      const ComponentId id =
+          this->EntityComponentIdFromType(entity, type.first);
+      if (id == type.second && !storage.SnapshotCopied())
+        continue;
+
+      auto data = storage.SnapshotComponent(type.second);
+      if (nullptr == data)
+        continue;
+
+      if (id == kComponentIdInvalid)
+      {
+        this->CreateComponentImplementation(entity, type.first, data);
+        continue;
+      }
+
+      // Systems may write to components without marking them as changed,
+      // so all the components of copied storages are restored, not only the
+      // ones with newer versions.
+      storage.Assign(id, data);
+      this->SetChanged(entity, type.first, ComponentState::OneTimeChange);
+    }
+  }
+
+  this->EndBatch();
+
+  // Entities created from now on get the same IDs as after the reset point
+  this->dataPtr->rewoundEntityCount = std::max(
+      this->dataPtr->rewoundEntityCount, this->dataPtr->entityCount);
+  this->dataPtr->entityCount = resetPoint.entityCount;
+  return true;
+}
+
 /////////////////////////////////////////////////
 bool EntityComponentManager::HasComponentType(
     const ComponentTypeId _typeId) const
@@ -722,6 +1667,9 @@ const EntityGraph &EntityComponentManager::Entities() const
 bool EntityComponentManager::FindView(const std::set<ComponentTypeId> &_types,
     std::map<detail::ComponentTypeKey, detail::View>::iterator &_iter) const
 {
+  // Views must be up to date before they're used, even during a batch.
+  this->ApplyBatch();
+
   std::lock_guard<std::mutex> lockViews(this->dataPtr->viewsMutex);
   _iter = this->dataPtr->views.find(_types);
   return _iter != this->dataPtr->views.end();
@@ -739,14 +1687,79 @@ std::map<detail::ComponentTypeKey, detail::View>::iterator
       std::make_pair(_types, std::move(_view))).first;
 }
 
+//////////////////////////////////////////////////
+void EntityComponentManager::BeginBatch()
+{
+  ++this->dataPtr->batchDepth;
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::EndBatch()
+{
+  if (this->dataPtr->batchDepth == 0)
+  {
+    ignwarn << "Trying to end a batch which wasn't started." << std::endl;
+    return;
+  }
+
+  if (--this->dataPtr->batchDepth == 0)
+    this->ApplyBatch();
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::ApplyBatch() const
+{
+  if (this->dataPtr->batchEntities.empty() &&
+      this->dataPtr->batchGrownTypes.empty())
+  {
+    return;
+  }
+
+  IGN_PROFILE("EntityComponentManager::ApplyBatch");
+
+  for (const ComponentTypeId typeId : this->dataPtr->batchGrownTypes)
+    this->dataPtr->InvalidateViews(typeId);
+  this->dataPtr->batchGrownTypes.clear();
+
+  for (const Entity entity : this->dataPtr->batchEntities)
+    this->UpdateViewsImplementation(entity);
+  this->dataPtr->batchEntities.clear();
+}
+
 //////////////////////////////////////////////////
 void EntityComponentManager::UpdateViews(const Entity _entity)
+{
+  if (this->dataPtr->batchDepth > 0)
+  {
+    this->dataPtr->batchEntities.insert(_entity);
+    return;
+  }
+
+  this->UpdateViewsImplementation(_entity);
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::UpdateViewsImplementation(
+    const Entity _entity) const
 {
   IGN_PROFILE("EntityComponentManager::UpdateViews");
+
+  // The entity's archetype tells which views it belongs to, and holds the
+  // ids of all its components.
+  const Archetype *archetype{nullptr};
+  std::size_t row{0};
+  auto archIter = this->dataPtr->entityArchetypes.find(_entity);
+  if (archIter != this->dataPtr->entityArchetypes.end())
+  {
+    archetype = &this->dataPtr->archetypes[archIter->second.first];
+    row = archIter->second.second;
+  }
+
   for (auto &view : this->dataPtr->views)
   {
     // Add/update the entity if it matches the view.
-    if (this->EntityMatches(_entity, view.first))
+    if (nullptr != archetype && !view.first.empty() &&
+        archetype->Matches(view.first))
     {
       view.second.AddEntity(_entity, this->IsNewEntity(_entity));
       // If there is a request to delete this entity, update the view as
@@ -757,8 +1770,17 @@ void EntityComponentManager::UpdateViews(const Entity _entity)
       }
       for (const ComponentTypeId &compTypeId : view.first)
       {
-        view.second.AddComponent(_entity, compTypeId,
-            this->EntityComponentIdFromType(_entity, compTypeId));
+        const ComponentId compId = archetype->Column(compTypeId)[row];
+        view.second.AddComponent(_entity, compTypeId, compId,
+            this->ViewComponentImplementation({compTypeId, compId}));
+      }
+    }
+    else if (view.first.empty() && this->EntityMatches(_entity, view.first))
+    {
+      view.second.AddEntity(_entity, this->IsNewEntity(_entity));
+      if (this->IsMarkedForRemoval(_entity))
+      {
+        view.second.AddEntityToRemoved(_entity);
       }
     }
     else
@@ -774,35 +1796,112 @@ void EntityComponentManager::RebuildViews()
   IGN_PROFILE("EntityComponentManager::RebuildViews");
   for (auto &view : this->dataPtr->views)
   {
-    view.second.entities.clear();
-    view.second.components.clear();
+    view.second.Reset();
     // Add all the entities that match the component types to the
     // view.
+    this->PopulateView(view.second, view.first);
+  }
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::PopulateView(detail::View &_view,
+    const std::set<ComponentTypeId> &_types) const
+{
+  IGN_PROFILE("EntityComponentManager::PopulateView");
+
+  // A view without component types matches every entity that has
+  // components, which isn't captured by archetypes.
+  if (_types.empty())
+  {
     for (const auto &vertex : this->dataPtr->entities.Vertices())
     {
       Entity entity = vertex.first;
-      if (this->EntityMatches(entity, view.first))
+      if (this->EntityMatches(entity, _types))
       {
-        view.second.AddEntity(entity, this->IsNewEntity(entity));
-        // If there is a request to delete this entity, update the view as
-        // well
+        _view.AddEntity(entity, this->IsNewEntity(entity));
         if (this->IsMarkedForRemoval(entity))
-        {
-          view.second.AddEntityToRemoved(entity);
-        }
-        // Store pointers to all the components. This recursively adds
-        // all the ComponentTypeTs that belong to the entity to the view.
-        for (const ComponentTypeId &compTypeId : view.first)
-        {
-          view.second.AddComponent(entity, compTypeId,
-              this->EntityComponentIdFromType(
-                entity, compTypeId));
-        }
+          _view.AddEntityToRemoved(entity);
       }
     }
+    return;
+  }
+
+  // All the entities in a matching archetype match the view. Gather them
+  // and add them in entity order, so the view is ready to be iterated.
+  struct Match
+  {
+    Entity entity;
+    const Archetype *archetype;
+    std::size_t row;
+  };
+  std::vector<Match> matches;
+
+  for (const Archetype &archetype : this->dataPtr->archetypes)
+  {
+    if (archetype.entities.empty() || !archetype.Matches(_types))
+      continue;
+
+    for (std::size_t row = 0; row < archetype.entities.size(); ++row)
+      matches.push_back({archetype.entities[row], &archetype, row});
+  }
+
+  std::sort(matches.begin(), matches.end(),
+      [](const Match &_a, const Match &_b)
+      {
+        return _a.entity < _b.entity;
+      });
+
+  for (const Match &match : matches)
+  {
+    _view.AddEntity(match.entity, this->IsNewEntity(match.entity));
+    // If there is a request to delete this entity, update the view as
+    // well
+    if (this->IsMarkedForRemoval(match.entity))
+    {
+      _view.AddEntityToRemoved(match.entity);
+    }
+
+    for (const ComponentTypeId &compTypeId : _types)
+    {
+      const ComponentId compId =
+          match.archetype->Column(compTypeId)[match.row];
+      _view.AddComponent(match.entity, compTypeId, compId,
+          this->ViewComponentImplementation({compTypeId, compId}));
+    }
   }
 }
 
+//////////////////////////////////////////////////
+void EntityComponentManager::SetReadOnly(const bool _readOnly)
+{
+  this->dataPtr->SetReadOnly(_readOnly, this);
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::ParallelRows(std::size_t _count,
+    const std::function<void(std::size_t, std::size_t)> &_f) const
+{
+  IGN_PROFILE("EntityComponentManager::ParallelRows");
+
+  // Nothing can be created or removed while the rows are visited, so
+  // components can be looked up without locking. The phase may have been
+  // started already, for example during PostUpdate.
+  const bool startPhase = !this->IsReadOnly();
+  if (startPhase)
+    this->dataPtr->SetReadOnly(true, this);
+
+  ThreadPool::Shared().ParallelFor(_count, 0, _f);
+
+  if (startPhase)
+    this->dataPtr->SetReadOnly(false, this);
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::IsReadOnly() const
+{
+  return this->dataPtr->readOnly.load(std::memory_order_acquire);
+}
+
 //////////////////////////////////////////////////
 void EntityComponentManagerPrivate::SetRemovedComponentsMsgs(Entity &_entity,
     msgs::SerializedEntity *_entityMsg,
@@ -1017,9 +2116,7 @@ void EntityComponentManager::AddEntityToMessage(msgs::SerializedStateMap &_msg,
     }
 
     // Serialize and store the message
-    std::ostringstream ostr;
-    compBase->Serialize(ostr);
-    compIter->second.set_component(ostr.str());
+    this->dataPtr->SerializeComponent(*compBase, compIter->second);
   }
 
   // Add a component to the message and set it to be removed if the component
@@ -1057,6 +2154,8 @@ ignition::msgs::SerializedState EntityComponentManager::ChangedState() const
 void EntityComponentManager::ChangedState(
     ignition::msgs::SerializedStateMap &_state) const
 {
+  this->dataPtr->SetSerializationHeader(_state);
+
   // New entities
   for (const auto &entity : this->dataPtr->newlyCreatedEntities)
   {
@@ -1077,51 +2176,63 @@ void EntityComponentManager::ChangedState(
 }
 
 //////////////////////////////////////////////////
-void EntityComponentManagerPrivate::CalculateStateThreadLoad()
+void EntityComponentManagerPrivate::CalculateStateThreadLoad(
+    const std::size_t _chunkCount)
 {
-  // If the entity component vector is dirty, we need to recalculate the
-  // threads and each threads work load
-  if (!this->entityComponentsDirty)
+  // If the entity component vector is dirty, or the number of threads
+  // changed, we need to recalculate each thread's work load
+  if (!this->entityComponentsDirty &&
+      this->entityComponentChunkCount == _chunkCount)
+  {
     return;
+  }
 
   this->entityComponentsDirty = false;
+  this->entityComponentChunkCount = _chunkCount;
   this->entityComponentIterators.clear();
   auto startIt = this->entityComponents.begin();
-  int numComponents = this->entityComponents.size();
+  std::size_t numComponents = this->entityComponents.size();
 
-  // Set the number of threads to spawn to the min of the calculated thread
-  // count or max threads that the hardware supports
-  int maxThreads = std::thread::hardware_concurrency();
-  uint64_t numThreads = std::min(numComponents, maxThreads);
+  // Use at most one chunk per entity
+  std::size_t numChunks = std::max<std::size_t>(1u,
+      std::min(numComponents, _chunkCount));
 
-  int componentsPerThread = static_cast<int>(std::ceil(
-    static_cast<double>(numComponents) / numThreads));
+  std::size_t componentsPerChunk = (numComponents + numChunks - 1) /
+      numChunks;
 
-  igndbg << "Updated state thread iterators: " << numThreads
-         << " threads processing around " << componentsPerThread
+  igndbg << "Updated state thread iterators: " << numChunks
+         << " chunks processing around " << componentsPerChunk
          << " components each." << std::endl;
 
   // Push back the starting iterator
   this->entityComponentIterators.push_back(startIt);
-  for (uint64_t i = 0; i < numThreads; ++i)
+  for (std::size_t i = 0; i < numChunks; ++i)
   {
     // If we have added all of the components to the iterator vector, we are
     // done so push back the end iterator
-    numComponents -= componentsPerThread;
-    if (numComponents <= 0)
+    if (numComponents <= componentsPerChunk)
     {
       this->entityComponentIterators.push_back(
           this->entityComponents.end());
       break;
     }
+    numComponents -= componentsPerChunk;
 
     // Get the iterator to the next starting group of components
-    auto nextIt = std::next(startIt, componentsPerThread);
+    auto nextIt = std::next(startIt, componentsPerChunk);
     this->entityComponentIterators.push_back(nextIt);
     startIt = nextIt;
   }
 }
 
+//////////////////////////////////////////////////
+ThreadPool &EntityComponentManagerPrivate::StatePool() const
+{
+  if (nullptr != this->statePool)
+    return *this->statePool;
+  return ThreadPool::Shared();
+}
+
 //////////////////////////////////////////////////
 ignition::msgs::SerializedState EntityComponentManager::State(
     const std::unordered_set<Entity> &_entities,
@@ -1149,46 +2260,76 @@ void EntityComponentManager::State(
     const std::unordered_set<ComponentTypeId> &_types,
     bool _full) const
 {
-  std::mutex stateMapMutex;
-  std::vector<std::thread> workers;
+  IGN_PROFILE("EntityComponentManager::State Map");
+  this->dataPtr->SetSerializationHeader(_state);
+
+  ThreadPool &pool = this->dataPtr->StatePool();
 
-  this->dataPtr->CalculateStateThreadLoad();
+  // Copy the chunks so that concurrent calls don't need to wait for each
+  // other while serializing.
+  std::vector<std::unordered_map<Entity,
+      std::unordered_map<ComponentTypeId, ComponentId>>::iterator> chunks;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->stateThreadLoadMutex);
+    this->dataPtr->CalculateStateThreadLoad(pool.ThreadCount() + 1u);
+    chunks = this->dataPtr->entityComponentIterators;
+  }
 
-  auto functor = [&](auto itStart, auto itEnd)
+  auto serialize = [&](auto itStart, auto itEnd,
+      msgs::SerializedStateMap &_out)
   {
-    msgs::SerializedStateMap threadMap;
     while (itStart != itEnd)
     {
       auto entity = (*itStart).first;
       if (_entities.empty() || _entities.find(entity) != _entities.end())
       {
-        this->AddEntityToMessage(threadMap, entity, _types, _full);
+        this->AddEntityToMessage(_out, entity, _types, _full);
       }
       itStart++;
     }
-    std::lock_guard<std::mutex> lock(stateMapMutex);
-
-    for (const auto &entity : threadMap.entities())
-    {
-      (*_state.mutable_entities())[static_cast<uint64_t>(entity.first)] =
-          entity.second;
-    }
   };
 
-  // Spawn workers
-  uint64_t numThreads = this->dataPtr->entityComponentIterators.size() - 1;
-  for (uint64_t i = 0; i < numThreads; i++)
+  const std::size_t numChunks = chunks.size() - 1;
+  if (numChunks <= 1u)
+  {
+    if (numChunks == 1u)
+      serialize(chunks[0], chunks[1], _state);
+    return;
+  }
+
+  // Each chunk is serialized into its own map, so workers don't need to
+  // lock, and the maps are merged once all of them are done.
+  std::vector<msgs::SerializedStateMap> chunkMaps(numChunks);
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve(numChunks);
+  for (std::size_t i = 0; i < numChunks; ++i)
   {
-    workers.push_back(std::thread(functor,
-        this->dataPtr->entityComponentIterators[i],
-        this->dataPtr->entityComponentIterators[i+1]));
+    tasks.push_back([&, i]()
+    {
+      serialize(chunks[i], chunks[i + 1], chunkMaps[i]);
+    });
   }
+  pool.Run(tasks);
 
-  // Wait for each thread to finish processing its components
-  std::for_each(workers.begin(), workers.end(), [](std::thread &_t)
+  auto &entities = *_state.mutable_entities();
+  for (auto &chunkMap : chunkMaps)
   {
-    _t.join();
-  });
+    for (auto &entity : *chunkMap.mutable_entities())
+      entities[entity.first].Swap(&entity.second);
+  }
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::SetStateThreadCount(
+    const unsigned int _threadCount)
+{
+  this->dataPtr->statePool = std::make_unique<ThreadPool>(_threadCount);
+}
+
+//////////////////////////////////////////////////
+unsigned int EntityComponentManager::StateThreadCount() const
+{
+  return this->dataPtr->StatePool().ThreadCount();
 }
 
 //////////////////////////////////////////////////
@@ -1302,6 +2443,35 @@ void EntityComponentManager::SetState(
     const ignition::msgs::SerializedStateMap &_stateMsg)
 {
   IGN_PROFILE("EntityComponentManager::SetState Map");
+
+  // Components may be serialized in binary, see SetBinarySerialization.
+  bool binary{false};
+  for (const auto &data : _stateMsg.header().data())
+  {
+    if (data.key() == kSerializationKey && data.value_size() > 0 &&
+        data.value(0) == kBinarySerialization)
+    {
+      binary = true;
+    }
+  }
+
+  // Components which don't support binary serialization are always
+  // serialized as text. A single stream is reused for all of them, since
+  // constructing streams is expensive.
+  std::istringstream istr;
+  const auto defaultFlags = istr.flags();
+  auto deserialize = [binary, &istr, defaultFlags](
+      components::BaseComponent *_comp, const std::string &_data)
+  {
+    if (binary && _comp->DeserializeBinary(_data))
+      return;
+
+    istr.clear();
+    istr.flags(defaultFlags);
+    istr.str(_data);
+    _comp->Deserialize(istr);
+  };
+
   // Create / remove / update entities
   for (const auto &iter : _stateMsg.entities())
   {
@@ -1355,30 +2525,26 @@ void EntityComponentManager::SetState(
       components::BaseComponent *comp =
         this->ComponentImplementation(entity, compIter.first);
 
-      // Create if new
+      // Create if new. The component is default constructed in its storage
+      // and deserialized in place, instead of going through a temporary.
       if (nullptr == comp)
       {
-        // Create component
-        auto newComp = components::Factory::Instance()->New(compMsg.type());
+        auto key = this->CreateComponentImplementation(entity, type, nullptr);
+        comp = this->ComponentImplementation(key);
 
-        if (nullptr == newComp)
+        if (nullptr == comp)
         {
           ignerr << "Failed to create component of type [" << compMsg.type()
             << "]" << std::endl;
           continue;
         }
 
-        std::istringstream istr(compMsg.component());
-        newComp->Deserialize(istr);
-
-        this->CreateComponentImplementation(entity,
-            newComp->TypeId(), newComp.get());
+        deserialize(comp, compMsg.component());
       }
       // Update component value
       else
       {
-        std::istringstream istr(compMsg.component());
-        comp->Deserialize(istr);
+        deserialize(comp, compMsg.component());
         this->SetChanged(entity, compIter.first,
             _stateMsg.has_one_time_component_changes() ?
             ComponentState::OneTimeChange :
@@ -1419,6 +2585,15 @@ void EntityComponentManager::SetAllComponentsUnchanged()
   this->dataPtr->periodicChangedComponents.clear();
   this->dataPtr->oneTimeChangedComponents.clear();
   this->dataPtr->modifiedComponents.clear();
+
+  // Catch pose changes which weren't marked through SetChanged
+  this->InvalidateWorldPoses();
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::InvalidateWorldPoses()
+{
+  ++this->dataPtr->poseStep;
 }
 
 /////////////////////////////////////////////////
@@ -1437,6 +2612,7 @@ void EntityComponentManager::SetChanged(
 
   ComponentKey key{_type, typeIter->second};
 
+  std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
   if (_c == ComponentState::PeriodicChange)
   {
     this->dataPtr->periodicChangedComponents.insert(key);
@@ -1453,6 +2629,9 @@ void EntityComponentManager::SetChanged(
     this->dataPtr->oneTimeChangedComponents.erase(key);
   }
 
+  if (_c != ComponentState::NoChange)
+    this->dataPtr->UpdateVersion(_entity, _type);
+
   this->dataPtr->AddModifiedComponent(_entity);
 }
 
@@ -1487,6 +2666,341 @@ void EntityComponentManager::SetEntityCreateOffset(uint64_t _offset)
   this->dataPtr->entityCount = _offset;
 }
 
+//////////////////////////////////////////////////
+bool EntityComponentManager::DeltaState(msgs::SerializedStateMap &_state,
+    const uint64_t _sinceVersion) const
+{
+  IGN_PROFILE("EntityComponentManager::DeltaState");
+  // Same lock order as ProcessRemoveEntityRequests
+  std::lock_guard<std::mutex> lockRemove(this->dataPtr->entityRemoveMutex);
+  std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
+
+  this->dataPtr->StartVersionLog();
+  if (_sinceVersion < this->dataPtr->forgottenVersion)
+    return false;
+
+  auto entityMsg = [&_state](const Entity _entity)
+      -> msgs::SerializedEntityMap &
+  {
+    auto &entities = *_state.mutable_entities();
+    auto entIter = entities.find(_entity);
+    if (entIter == entities.end())
+    {
+      msgs::SerializedEntityMap ent;
+      ent.set_id(_entity);
+      entIter = entities.insert({static_cast<uint64_t>(_entity), ent}).first;
+    }
+    return entIter->second;
+  };
+
+  // Removals, oldest first
+  auto removalIter = std::upper_bound(this->dataPtr->removals.begin(),
+      this->dataPtr->removals.end(), _sinceVersion,
+      [](const uint64_t _version, const Removal &_removal)
+      {
+        return _version < _removal.version;
+      });
+  for (; removalIter != this->dataPtr->removals.end(); ++removalIter)
+  {
+    auto &ent = entityMsg(removalIter->entity);
+    if (removalIter->type == kComponentTypeIdInvalid)
+    {
+      ent.set_remove(true);
+      continue;
+    }
+
+    msgs::SerializedComponent cmp;
+    cmp.set_type(removalIter->type);
+    cmp.set_remove(true);
+    (*ent.mutable_components())[static_cast<int64_t>(removalIter->type)] =
+        cmp;
+  }
+
+  // Entities which will be removed on the next update
+  for (const Entity entity : this->dataPtr->toRemoveEntities)
+    entityMsg(entity).set_remove(true);
+
+  // Components created or changed since the version. If a component was
+  // removed and created again, this replaces its removal.
+  auto changeIter = std::upper_bound(this->dataPtr->changes.begin(),
+      this->dataPtr->changes.end(), _sinceVersion,
+      [](const uint64_t _version, const Change &_change)
+      {
+        return _version < _change.version;
+      });
+  for (; changeIter != this->dataPtr->changes.end(); ++changeIter)
+  {
+    const Entity entity = changeIter->entity;
+    const ComponentTypeId type = changeIter->type;
+
+    // Skip components which changed again later, or were removed
+    auto versionIter = this->dataPtr->componentVersions.find({entity, type});
+    if (versionIter == this->dataPtr->componentVersions.end() ||
+        versionIter->second != changeIter->version)
+    {
+      continue;
+    }
+
+    const components::BaseComponent *compBase =
+        this->ComponentImplementation(entity, type);
+    if (nullptr == compBase)
+      continue;
+
+    msgs::SerializedComponent cmp;
+    cmp.set_type(type);
+    this->dataPtr->SerializeComponent(*compBase, cmp);
+    (*entityMsg(entity).mutable_components())[static_cast<int64_t>(type)] =
+        cmp;
+  }
+
+  this->dataPtr->SetSerializationHeader(_state);
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t EntityComponentManager::Version() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
+  this->dataPtr->StartVersionLog();
+  return this->dataPtr->version;
+}
+
+//////////////////////////////////////////////////
+uint64_t EntityComponentManager::ComponentVersion(const Entity _entity,
+    const ComponentTypeId _typeId) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->changedComponentsMutex);
+  this->dataPtr->StartVersionLog();
+  auto iter = this->dataPtr->componentVersions.find({_entity, _typeId});
+  if (iter == this->dataPtr->componentVersions.end())
+    return 0;
+  return iter->second;
+}
+
+//////////////////////////////////////////////////
+std::optional<math::Pose3d> EntityComponentManager::WorldPose(
+    const Entity _entity) const
+{
+  auto poseComp = this->Component<components::Pose>(_entity);
+  if (nullptr == poseComp)
+    return std::nullopt;
+
+  auto &cache = this->dataPtr->worldPoses;
+  const uint64_t step = this->dataPtr->poseStep;
+
+  {
+    std::shared_lock<std::shared_mutex> lock(this->dataPtr->worldPosesMutex);
+    auto iter = cache.find(_entity);
+    if (iter != cache.end() && iter->second.validatedStep == step)
+      return iter->second.world;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->worldPosesMutex);
+
+  // Get the parent which the pose is composed with, if it has a pose
+  auto parentOf = [this](const Entity _child)
+  {
+    auto parentComp = this->Component<components::ParentEntity>(_child);
+    if (nullptr == parentComp ||
+        nullptr == this->Component<components::Pose>(parentComp->Data()))
+    {
+      return kNullEntity;
+    }
+    return parentComp->Data();
+  };
+
+  // Walk up to the closest ancestor validated in this step, or to the root
+  std::vector<Entity> chain;
+  for (Entity entity = _entity; entity != kNullEntity;
+       entity = parentOf(entity))
+  {
+    auto iter = cache.find(entity);
+    if (iter != cache.end() && iter->second.validatedStep == step)
+      break;
+    chain.push_back(entity);
+  }
+
+  // Then validate entries back down, parents first. An entry is only
+  // recomputed if the entity's pose or parent changed, or if its parent's
+  // world pose was recomputed since, so only moved subtrees are recomputed.
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+  {
+    const Entity entity = *it;
+    const math::Pose3d &local =
+        this->Component<components::Pose>(entity)->Data();
+    const Entity parent = parentOf(entity);
+    const WorldPoseEntry *parentEntry =
+        parent == kNullEntity ? nullptr : &cache[parent];
+    const uint64_t parentStamp =
+        nullptr == parentEntry ? 0u : parentEntry->stamp;
+
+    WorldPoseEntry &entry = cache[entity];
+    if (entry.stamp == 0u || entry.parent != parent ||
+        entry.parentStamp != parentStamp || entry.local != local)
+    {
+      entry.local = local;
+      entry.parent = parent;
+      entry.parentStamp = parentStamp;
+      entry.world = nullptr == parentEntry ? local :
+          local + parentEntry->world;
+      entry.stamp = ++this->dataPtr->worldPoseStamp;
+    }
+    entry.validatedStep = step;
+  }
+  return cache[_entity].world;
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::SetBinarySerialization(const bool _binary)
+{
+  this->dataPtr->binarySerialization = _binary;
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::BinarySerialization() const
+{
+  return this->dataPtr->binarySerialization;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::UpdateVersion(const Entity _entity,
+    const ComponentTypeId _typeId)
+{
+  if (_typeId == components::Pose::typeId ||
+      _typeId == components::ParentEntity::typeId)
+  {
+    this->InvalidateWorldPose(_entity);
+  }
+
+  ++this->version;
+  if (!this->versionLog)
+    return;
+
+  this->componentVersions[{_entity, _typeId}] = this->version;
+  this->changes.push_back({this->version, _entity, _typeId});
+
+  // Drop the entries of components which changed again or were removed,
+  // once there are enough of them to make it worth it.
+  if (this->changes.size() >
+      2 * this->componentVersions.size() + kMinStaleChanges)
+  {
+    auto stale = [this](const Change &_change)
+    {
+      auto iter = this->componentVersions.find(
+          {_change.entity, _change.type});
+      return iter == this->componentVersions.end() ||
+          iter->second != _change.version;
+    };
+    this->changes.erase(std::remove_if(this->changes.begin(),
+        this->changes.end(), stale), this->changes.end());
+  }
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::RecordRemoval(const Entity _entity,
+    const ComponentTypeId _typeId)
+{
+  ++this->version;
+
+  if (_typeId == kComponentTypeIdInvalid ||
+      _typeId == components::Pose::typeId ||
+      _typeId == components::ParentEntity::typeId)
+  {
+    this->InvalidateWorldPose(_entity);
+  }
+
+  if (!this->versionLog)
+    return;
+
+  if (_typeId == kComponentTypeIdInvalid)
+  {
+    auto iter = this->entityComponents.find(_entity);
+    if (iter != this->entityComponents.end())
+    {
+      for (const auto &comp : iter->second)
+        this->componentVersions.erase({_entity, comp.first});
+    }
+  }
+  else
+  {
+    this->componentVersions.erase({_entity, _typeId});
+  }
+
+  this->removals.push_back({this->version, _entity, _typeId});
+
+  // Forget the oldest removals, deltas from before them aren't possible
+  // anymore.
+  while (this->removals.size() > kMaxRemovals)
+  {
+    this->forgottenVersion = this->removals.front().version;
+    this->removals.pop_front();
+  }
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::StartVersionLog()
+{
+  if (this->versionLog)
+    return;
+
+  this->versionLog = true;
+  this->forgottenVersion = this->version;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::InvalidateWorldPose(const Entity _entity)
+{
+  std::unique_lock<std::shared_mutex> lock(this->worldPosesMutex);
+  auto iter = this->worldPoses.find(_entity);
+  if (iter == this->worldPoses.end())
+    return;
+
+  // Descendants validated in this step would use their entries without
+  // checking them again, so start a new step. The others see that this
+  // entry's stamp changed once it's recomputed.
+  if (iter->second.validatedStep == this->poseStep)
+    ++this->poseStep;
+  this->worldPoses.erase(iter);
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::SerializeComponent(
+    const components::BaseComponent &_component,
+    msgs::SerializedComponent &_msg) const
+{
+  if (this->binarySerialization)
+  {
+    std::string data;
+    if (_component.SerializeBinary(data))
+    {
+      _msg.set_component(std::move(data));
+      return;
+    }
+  }
+
+  std::ostringstream ostr;
+  _component.Serialize(ostr);
+  _msg.set_component(ostr.str());
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::SetSerializationHeader(
+    msgs::SerializedStateMap &_msg) const
+{
+  if (!this->binarySerialization)
+    return;
+
+  for (const auto &data : _msg.header().data())
+  {
+    if (data.key() == kSerializationKey)
+      return;
+  }
+
+  auto data = _msg.mutable_header()->add_data();
+  data->set_key(kSerializationKey);
+  data->add_value(kBinarySerialization);
+}
+
 /////////////////////////////////////////////////
 void EntityComponentManagerPrivate::AddModifiedComponent(const Entity &_entity)
 {
@@ -1502,3 +3016,123 @@ void EntityComponentManagerPrivate::AddModifiedComponent(const Entity &_entity)
 
   this->modifiedComponents.insert(_entity);
 }
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::UpdateArchetype(const Entity _entity)
+{
+  this->RemoveFromArchetype(_entity);
+
+  auto ecIter = this->entityComponents.find(_entity);
+  if (ecIter == this->entityComponents.end() || ecIter->second.empty())
+    return;
+
+  detail::ComponentTypeKey types;
+  for (const auto &comp : ecIter->second)
+    types.insert(comp.first);
+
+  auto indexIter = this->archetypeIndices.find(types);
+  if (indexIter == this->archetypeIndices.end())
+  {
+    Archetype archetype;
+    archetype.types = types;
+    archetype.columns.resize(types.size());
+    this->archetypes.push_back(std::move(archetype));
+    indexIter = this->archetypeIndices.insert(
+        {types, this->archetypes.size() - 1}).first;
+  }
+
+  Archetype &archetype = this->archetypes[indexIter->second];
+  this->entityArchetypes[_entity] =
+      {indexIter->second, archetype.entities.size()};
+  archetype.entities.push_back(_entity);
+
+  std::size_t column{0};
+  for (const ComponentTypeId &type : archetype.types)
+  {
+    archetype.columns[column++].push_back(ecIter->second.at(type));
+  }
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::RemoveFromArchetype(const Entity _entity)
+{
+  auto iter = this->entityArchetypes.find(_entity);
+  if (iter == this->entityArchetypes.end())
+    return;
+
+  Archetype &archetype = this->archetypes[iter->second.first];
+  const std::size_t row = iter->second.second;
+  const std::size_t last = archetype.entities.size() - 1;
+
+  // Swap the last row into the removed one, so rows stay dense.
+  if (row != last)
+  {
+    const Entity moved = archetype.entities[last];
+    archetype.entities[row] = moved;
+    for (auto &column : archetype.columns)
+      column[row] = column[last];
+    this->entityArchetypes[moved].second = row;
+  }
+
+  archetype.entities.pop_back();
+  for (auto &column : archetype.columns)
+    column.pop_back();
+
+  this->entityArchetypes.erase(iter);
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::InvalidateViews(
+    const ComponentTypeId _typeId)
+{
+  for (auto &view : this->views)
+  {
+    if (view.first.find(_typeId) != view.first.end())
+      view.second.InvalidateComponents();
+  }
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::SetReadOnly(const bool _readOnly,
+    const EntityComponentManager *_ecm)
+{
+  IGN_PROFILE("EntityComponentManager::SetReadOnly");
+
+  if (_readOnly)
+  {
+    // Get the views ready while still single threaded, so they can be
+    // iterated concurrently without being modified.
+    for (auto &view : this->views)
+      view.second.Prepare(_ecm);
+  }
+
+  for (auto &comp : this->components)
+    comp.second->SetReadOnly(_readOnly);
+
+  this->readOnly.store(_readOnly, std::memory_order_release);
+}
+
+/////////////////////////////////////////////////
+bool EntityComponentManagerPrivate::CheckWritable(
+    const std::string &_request) const
+{
+  if (!this->readOnly.load(std::memory_order_acquire))
+    return true;
+
+  ignerr << "Trying to " << _request << " during a read-only phase, such as "
+         << "PostUpdate. The request will be ignored." << std::endl;
+  assert(false && "Entities and components can't be created or removed "
+      "during a read-only phase");
+  return false;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::RemoveFromStorages(
+    const std::unordered_map<ComponentTypeId, std::vector<ComponentId>> &_ids)
+{
+  for (const auto &typeIds : _ids)
+  {
+    this->components.at(typeIds.first)->Remove(typeIds.second);
+    this->InvalidateViews(typeIds.first);
+  }
+}
@@ -17,12 +17,17 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstring>
+#include <thread>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
 #include <ignition/math/Pose3.hh>
 #include <ignition/math/Rand.hh>
 
 #include "ignition/gazebo/components/Factory.hh"
+#include "ignition/gazebo/components/ParentEntity.hh"
 #include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
 #include "ignition/gazebo/config.hh"
@@ -96,6 +101,14 @@ class EntityCompMgrTest : public EntityComponentManager
   {
     this->ClearRemovedComponents();
   }
+  public: void RunSetReadOnly(const bool _readOnly)
+  {
+    this->SetReadOnly(_readOnly);
+  }
+  public: bool ReadOnly() const
+  {
+    return this->IsReadOnly();
+  }
 };
 
 class EntityComponentManagerFixture : public ::testing::TestWithParam<int>
@@ -2576,6 +2589,1242 @@ TEST_P(EntityComponentManagerFixture, RemovedComponentsSyncBetweenServerAndGUI)
   }
 }
 
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ArchetypeViews)
+{
+  // Create entities with different sets of component types, so they are
+  // spread across several archetypes.
+  std::vector<Entity> entities;
+  for (int i = 0; i < 30; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    if (i % 2 == 0)
+      manager.CreateComponent<Even>(entity, Even());
+    else
+      manager.CreateComponent<Odd>(entity, Odd());
+    if (i % 3 == 0)
+      manager.CreateComponent<DoubleComponent>(entity, DoubleComponent(i));
+    entities.push_back(entity);
+  }
+
+  auto countAndCheck = [&](auto _count)
+  {
+    int intCount{0};
+    manager.Each<IntComponent>(
+        [&](const Entity &_entity, const IntComponent *_int)->bool
+        {
+          EXPECT_EQ(entities[_int->Data()], _entity);
+          ++intCount;
+          return true;
+        });
+
+    int evenCount{0};
+    manager.Each<IntComponent, Even>(
+        [&](const Entity &, const IntComponent *_int, const Even *)->bool
+        {
+          EXPECT_EQ(0, _int->Data() % 2);
+          ++evenCount;
+          return true;
+        });
+
+    int doubleCount{0};
+    manager.Each<DoubleComponent, IntComponent>(
+        [&](const Entity &, const DoubleComponent *_double,
+            const IntComponent *_int)->bool
+        {
+          EXPECT_DOUBLE_EQ(_double->Data(), _int->Data());
+          EXPECT_EQ(0, _int->Data() % 3);
+          ++doubleCount;
+          return true;
+        });
+
+    _count(intCount, evenCount, doubleCount);
+  };
+
+  // Views created before and after the entities must agree
+  for (int i = 0; i < 2; ++i)
+  {
+    countAndCheck([](int _ints, int _evens, int _doubles)
+        {
+          EXPECT_EQ(30, _ints);
+          EXPECT_EQ(15, _evens);
+          EXPECT_EQ(10, _doubles);
+        });
+  }
+
+  // Move entities between archetypes by adding and removing components
+  for (int i = 0; i < 30; i += 2)
+  {
+    EXPECT_TRUE(manager.RemoveComponent<Even>(entities[i]));
+    manager.CreateComponent<Odd>(entities[i], Odd());
+  }
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(entities[0]));
+
+  countAndCheck([](int _ints, int _evens, int _doubles)
+      {
+        EXPECT_EQ(30, _ints);
+        EXPECT_EQ(0, _evens);
+        EXPECT_EQ(9, _doubles);
+      });
+
+  // Remove some entities
+  for (int i = 0; i < 30; i += 5)
+    manager.RequestRemoveEntity(entities[i]);
+  manager.ProcessEntityRemovals();
+
+  countAndCheck([](int _ints, int _evens, int _doubles)
+      {
+        EXPECT_EQ(24, _ints);
+        EXPECT_EQ(0, _evens);
+        EXPECT_EQ(8, _doubles);
+      });
+
+  // Rebuilding the views from the archetypes gives the same result
+  manager.RebuildViews();
+  countAndCheck([](int _ints, int _evens, int _doubles)
+      {
+        EXPECT_EQ(24, _ints);
+        EXPECT_EQ(0, _evens);
+        EXPECT_EQ(8, _doubles);
+      });
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ViewComponentsAfterStorageChanges)
+{
+  // Create the view before the entities, so it caches component pointers
+  // while the storage grows.
+  manager.Each<IntComponent>([&](const Entity &, const IntComponent *)
+      {
+        return true;
+      });
+
+  std::vector<Entity> entities;
+  for (int i = 0; i < 500; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    entities.push_back(entity);
+  }
+
+  // Entities are visited in order, with the correct data.
+  int count{0};
+  manager.Each<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *_int)->bool
+      {
+        EXPECT_EQ(entities[count], _entity);
+        EXPECT_EQ(count, _int->Data());
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(500, count);
+
+  // Create components of the same type while iterating, which moves the
+  // storage data.
+  count = 0;
+  manager.Each<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *_int)->bool
+      {
+        EXPECT_EQ(entities[_int->Data()], _entity);
+        if (count < 200)
+        {
+          Entity entity = manager.CreateEntity();
+          manager.CreateComponent<IntComponent>(entity,
+              IntComponent(static_cast<int>(entities.size())));
+          entities.push_back(entity);
+        }
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(700, count);
+
+  // Remove components, which swaps data within the storage, including
+  // components of the entity being visited.
+  count = 0;
+  manager.Each<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *_int)->bool
+      {
+        EXPECT_EQ(entities[_int->Data()], _entity);
+        if (_int->Data() % 2 == 0)
+        {
+          EXPECT_TRUE(manager.RemoveComponent<IntComponent>(_entity));
+        }
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(700, count);
+
+  count = 0;
+  manager.Each<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *_int)->bool
+      {
+        EXPECT_EQ(1, _int->Data() % 2);
+        EXPECT_EQ(entities[_int->Data()], _entity);
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(350, count);
+
+  // Entities added back are still visited in order.
+  manager.CreateComponent<IntComponent>(entities[0], IntComponent(0));
+  Entity previous{kNullEntity};
+  count = 0;
+  manager.Each<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *_int)->bool
+      {
+        EXPECT_LT(previous, _entity);
+        EXPECT_EQ(entities[_int->Data()], _entity);
+        previous = _entity;
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(351, count);
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ReadOnlyPhase)
+{
+  std::vector<Entity> entities;
+  for (int i = 0; i < 1000; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    manager.CreateComponent<DoubleComponent>(entity, DoubleComponent(i));
+    entities.push_back(entity);
+  }
+
+  // Iterate once so the view exists, then remove components so that the
+  // view has pending changes when the read-only phase starts.
+  manager.Each<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *, const DoubleComponent *)
+      {
+        return true;
+      });
+  for (int i = 0; i < 1000; i += 10)
+    EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(entities[i]));
+
+  manager.RunSetReadOnly(true);
+
+  const EntityComponentManager &ecm = manager;
+  std::vector<int> counts(4, 0);
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < counts.size(); ++t)
+  {
+    threads.emplace_back([&, t]()
+    {
+      for (int iter = 0; iter < 10; ++iter)
+      {
+        ecm.Each<IntComponent, DoubleComponent>(
+            [&](const Entity &_entity, const IntComponent *_int,
+                const DoubleComponent *_double)
+            {
+              if (_int->Data() % 10 != 0 &&
+                  static_cast<int>(_double->Data()) == _int->Data() &&
+                  ecm.Component<IntComponent>(_entity) == _int)
+              {
+                ++counts[t];
+              }
+              return true;
+            });
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  manager.RunSetReadOnly(false);
+
+  for (const int count : counts)
+    EXPECT_EQ(9000, count);
+
+  // Components can be created again after the phase ends.
+  manager.CreateComponent<DoubleComponent>(entities[0], DoubleComponent(0));
+  int count{0};
+  manager.Each<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *, const DoubleComponent *)
+      {
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(901, count);
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ReadOnlyRejectsChanges)
+{
+  Entity entity = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(entity, IntComponent(1));
+
+  manager.RunSetReadOnly(true);
+
+  // Rejected with an error, and asserting in debug builds
+  EXPECT_DEBUG_DEATH(
+      manager.CreateComponent<DoubleComponent>(entity, DoubleComponent(2)),
+      "read-only");
+  EXPECT_DEBUG_DEATH(manager.RemoveComponent<IntComponent>(entity),
+      "read-only");
+  EXPECT_DEBUG_DEATH(manager.RemoveComponents({entity}), "read-only");
+  EXPECT_DEBUG_DEATH(manager.RequestRemoveEntity(entity), "read-only");
+  EXPECT_DEBUG_DEATH(manager.RequestRemoveEntities(), "read-only");
+
+  manager.RunSetReadOnly(false);
+
+  // Nothing changed
+  manager.ProcessEntityRemovals();
+  EXPECT_TRUE(manager.HasEntity(entity));
+  ASSERT_NE(nullptr, manager.Component<IntComponent>(entity));
+  EXPECT_EQ(nullptr, manager.Component<DoubleComponent>(entity));
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, RemoveComponents)
+{
+  std::vector<Entity> entities;
+  for (int i = 0; i < 200; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    manager.CreateComponent<DoubleComponent>(entity, DoubleComponent(i));
+    entities.push_back(entity);
+  }
+  manager.RunClearNewlyCreatedEntities();
+
+  int count{0};
+  manager.Each<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *, const DoubleComponent *)
+      {
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(200, count);
+
+  // Remove the components of every third entity, in an order which moves
+  // components around inside the storages.
+  std::vector<Entity> toRemove;
+  for (int i = 198; i >= 0; i -= 3)
+    toRemove.push_back(entities[i]);
+  toRemove.push_back(entities[0]);
+  toRemove.push_back(entities[3]);
+
+  EXPECT_EQ(134u, manager.RemoveComponents(toRemove));
+  EXPECT_EQ(0u, manager.RemoveComponents(toRemove));
+
+  for (int i = 0; i < 200; ++i)
+  {
+    const bool removed = i % 3 == 0;
+    EXPECT_NE(removed, manager.EntityHasComponentType(entities[i],
+        IntComponent::typeId)) << i;
+    EXPECT_NE(removed, manager.EntityHasComponentType(entities[i],
+        DoubleComponent::typeId)) << i;
+    EXPECT_TRUE(manager.HasEntity(entities[i]));
+
+    if (!removed)
+    {
+      ASSERT_NE(nullptr, manager.Component<IntComponent>(entities[i]));
+      EXPECT_EQ(i, manager.Component<IntComponent>(entities[i])->Data());
+      EXPECT_DOUBLE_EQ(i,
+          manager.Component<DoubleComponent>(entities[i])->Data());
+    }
+  }
+
+  count = 0;
+  manager.Each<IntComponent, DoubleComponent>(
+      [&](const Entity &_entity, const IntComponent *_int,
+          const DoubleComponent *_double)
+      {
+        EXPECT_EQ(entities[_int->Data()], _entity);
+        EXPECT_DOUBLE_EQ(_double->Data(), _int->Data());
+        EXPECT_NE(0, _int->Data() % 3);
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(133, count);
+
+  // The removed components are part of the changed state
+  msgs::SerializedStateMap stateMsg;
+  manager.State(stateMsg, {entities[3]}, {}, false);
+  ASSERT_EQ(1, stateMsg.entities_size());
+  const auto &entityMsg = stateMsg.entities().begin()->second;
+  EXPECT_EQ(2, entityMsg.components_size());
+  for (const auto &comp : entityMsg.components())
+    EXPECT_TRUE(comp.second.remove());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ParallelEach)
+{
+  // Nothing to iterate
+  int calls{0};
+  manager.ParallelEach<IntComponent>(
+      [&](const Entity &, IntComponent *)
+      {
+        ++calls;
+      });
+  EXPECT_EQ(0, calls);
+
+  std::vector<Entity> entities;
+  for (int i = 0; i < 5000; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    if (i % 2 == 0)
+      manager.CreateComponent<DoubleComponent>(entity, DoubleComponent(0.0));
+    entities.push_back(entity);
+  }
+
+  // Mutate the components of each entity, reading other components through
+  // the const API.
+  const EntityComponentManager &ecm = manager;
+  manager.ParallelEach<IntComponent, DoubleComponent>(
+      [&](const Entity &_entity, IntComponent *_int,
+          DoubleComponent *_double)
+      {
+        EXPECT_EQ(_int, ecm.Component<IntComponent>(_entity));
+        const auto *next = ecm.Component<IntComponent>(
+            entities[(_int->Data() + 1) % entities.size()]);
+        ASSERT_NE(nullptr, next);
+        _double->Data() = _int->Data() + next->Data();
+        _int->Data() *= 2;
+      });
+  EXPECT_FALSE(manager.ReadOnly());
+
+  for (int i = 0; i < 5000; ++i)
+  {
+    auto *intComp = manager.Component<IntComponent>(entities[i]);
+    ASSERT_NE(nullptr, intComp);
+    if (i % 2 == 0)
+    {
+      EXPECT_EQ(2 * i, intComp->Data());
+      EXPECT_DOUBLE_EQ(2 * i + 1,
+          manager.Component<DoubleComponent>(entities[i])->Data());
+    }
+    else
+    {
+      EXPECT_EQ(i, intComp->Data());
+    }
+  }
+
+  // Const version visits every entity once
+  std::atomic<int> count{0};
+  std::atomic<int> sum{0};
+  ecm.ParallelEach<IntComponent>(
+      [&](const Entity &, const IntComponent *_int)
+      {
+        ++count;
+        sum += _int->Data() % 7;
+      });
+  EXPECT_EQ(5000, count);
+
+  int expectedSum{0};
+  manager.Each<IntComponent>([&](const Entity &, const IntComponent *_int)
+      {
+        expectedSum += _int->Data() % 7;
+        return true;
+      });
+  EXPECT_EQ(expectedSum, sum);
+
+  // Components can be created again afterwards
+  manager.CreateComponent<DoubleComponent>(entities[1], DoubleComponent(1.0));
+  count = 0;
+  ecm.ParallelEach<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *, const DoubleComponent *)
+      {
+        ++count;
+      });
+  EXPECT_EQ(2501, count);
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ComponentVersions)
+{
+  EXPECT_EQ(0u, manager.Version());
+
+  Entity e1 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e1, IntComponent(1));
+  EXPECT_EQ(1u, manager.Version());
+  EXPECT_EQ(1u, manager.ComponentVersion(e1, IntComponent::typeId));
+  EXPECT_EQ(0u, manager.ComponentVersion(e1, DoubleComponent::typeId));
+
+  manager.CreateComponent<DoubleComponent>(e1, DoubleComponent(2.0));
+  EXPECT_EQ(2u, manager.Version());
+  EXPECT_EQ(1u, manager.ComponentVersion(e1, IntComponent::typeId));
+  EXPECT_EQ(2u, manager.ComponentVersion(e1, DoubleComponent::typeId));
+
+  // Modifying without SetChanged doesn't change the version
+  manager.Component<IntComponent>(e1)->Data() = 3;
+  EXPECT_EQ(2u, manager.Version());
+
+  manager.SetChanged(e1, IntComponent::typeId,
+      ComponentState::PeriodicChange);
+  EXPECT_EQ(3u, manager.Version());
+  EXPECT_EQ(3u, manager.ComponentVersion(e1, IntComponent::typeId));
+
+  // Marking as unchanged doesn't change the version
+  manager.SetChanged(e1, IntComponent::typeId, ComponentState::NoChange);
+  EXPECT_EQ(3u, manager.Version());
+
+  // Removals
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(e1));
+  EXPECT_EQ(4u, manager.Version());
+  EXPECT_EQ(0u, manager.ComponentVersion(e1, DoubleComponent::typeId));
+
+  manager.RequestRemoveEntity(e1);
+  EXPECT_EQ(4u, manager.Version());
+  manager.ProcessEntityRemovals();
+  EXPECT_EQ(5u, manager.Version());
+  EXPECT_EQ(0u, manager.ComponentVersion(e1, IntComponent::typeId));
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, DeltaState)
+{
+  // Start logging versions
+  EXPECT_EQ(0u, manager.Version());
+
+  Entity e1 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e1, IntComponent(1));
+  manager.CreateComponent<DoubleComponent>(e1, DoubleComponent(2.0));
+  Entity e2 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e2, IntComponent(3));
+  manager.CreateComponent<StringComponent>(e2, StringComponent("e2"));
+  Entity e3 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e3, IntComponent(4));
+
+  // Delta from the beginning has everything
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, 0));
+    EXPECT_EQ(3, stateMsg.entities_size());
+
+    EntityCompMgrTest newManager;
+    newManager.SetState(stateMsg);
+    EXPECT_EQ(1, newManager.Component<IntComponent>(e1)->Data());
+    EXPECT_DOUBLE_EQ(2.0, newManager.Component<DoubleComponent>(e1)->Data());
+    EXPECT_EQ(3, newManager.Component<IntComponent>(e2)->Data());
+    EXPECT_EQ("e2", newManager.Component<StringComponent>(e2)->Data());
+    EXPECT_EQ(4, newManager.Component<IntComponent>(e3)->Data());
+  }
+
+  // Nothing changed since the current version
+  const uint64_t acked = manager.Version();
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, acked));
+    EXPECT_EQ(0, stateMsg.entities_size());
+  }
+
+  // Receiver which is up to date with the acknowledged version
+  EntityCompMgrTest receiver;
+  {
+    msgs::SerializedStateMap stateMsg;
+    manager.State(stateMsg);
+    receiver.SetState(stateMsg);
+  }
+
+  // Change, create and remove components, and remove an entity
+  manager.Component<IntComponent>(e1)->Data() = 10;
+  manager.SetChanged(e1, IntComponent::typeId,
+      ComponentState::OneTimeChange);
+  manager.CreateComponent<BoolComponent>(e1, BoolComponent(true));
+  EXPECT_TRUE(manager.RemoveComponent<StringComponent>(e2));
+  manager.RequestRemoveEntity(e3);
+
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, acked));
+    ASSERT_EQ(3, stateMsg.entities_size());
+
+    // Only the modified components of e1
+    const auto &e1Msg = stateMsg.entities().at(e1);
+    EXPECT_FALSE(e1Msg.remove());
+    EXPECT_EQ(2, e1Msg.components_size());
+    EXPECT_EQ(0u, e1Msg.components().count(DoubleComponent::typeId));
+
+    // Removed component of e2
+    const auto &e2Msg = stateMsg.entities().at(e2);
+    EXPECT_FALSE(e2Msg.remove());
+    ASSERT_EQ(1, e2Msg.components_size());
+    EXPECT_TRUE(e2Msg.components().at(StringComponent::typeId).remove());
+
+    // Entity pending removal
+    EXPECT_TRUE(stateMsg.entities().at(e3).remove());
+
+    receiver.SetState(stateMsg);
+    receiver.ProcessEntityRemovals();
+    EXPECT_EQ(10, receiver.Component<IntComponent>(e1)->Data());
+    EXPECT_DOUBLE_EQ(2.0, receiver.Component<DoubleComponent>(e1)->Data());
+    EXPECT_TRUE(receiver.Component<BoolComponent>(e1)->Data());
+    EXPECT_EQ(nullptr, receiver.Component<StringComponent>(e2));
+    EXPECT_FALSE(receiver.HasEntity(e3));
+  }
+
+  // Once the entity is removed, it's still part of the delta
+  manager.ProcessEntityRemovals();
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, acked));
+    ASSERT_EQ(1u, stateMsg.entities().count(e3));
+    EXPECT_TRUE(stateMsg.entities().at(e3).remove());
+    EXPECT_EQ(0, stateMsg.entities().at(e3).components_size());
+  }
+
+  // A component removed and created again is sent with its value
+  const uint64_t acked2 = manager.Version();
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(e1));
+  manager.CreateComponent<DoubleComponent>(e1, DoubleComponent(5.0));
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, acked2));
+    ASSERT_EQ(1, stateMsg.entities_size());
+    const auto &comps = stateMsg.entities().at(e1).components();
+    ASSERT_EQ(1, comps.size());
+    EXPECT_FALSE(comps.at(DoubleComponent::typeId).remove());
+
+    receiver.SetState(stateMsg);
+    EXPECT_DOUBLE_EQ(5.0, receiver.Component<DoubleComponent>(e1)->Data());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, DeltaStateRepeatedChanges)
+{
+  // Start logging versions
+  EXPECT_EQ(0u, manager.Version());
+
+  Entity e1 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e1, IntComponent(0));
+  manager.CreateComponent<DoubleComponent>(e1, DoubleComponent(1.0));
+  Entity e2 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e2, IntComponent(0));
+  const uint64_t acked = manager.Version();
+
+  // Changing the same component many times compacts its older changes
+  for (int i = 1; i <= 5000; ++i)
+  {
+    manager.Component<IntComponent>(e1)->Data() = i;
+    manager.SetChanged(e1, IntComponent::typeId,
+        ComponentState::PeriodicChange);
+  }
+
+  for (const uint64_t since : {acked, acked + 2500})
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, since));
+    ASSERT_EQ(1, stateMsg.entities_size());
+    EXPECT_EQ(1, stateMsg.entities().at(e1).components_size());
+
+    EntityCompMgrTest receiver;
+    receiver.SetState(stateMsg);
+    ASSERT_NE(nullptr, receiver.Component<IntComponent>(e1));
+    EXPECT_EQ(5000, receiver.Component<IntComponent>(e1)->Data());
+  }
+
+  // Components which didn't change are still part of older deltas
+  {
+    msgs::SerializedStateMap stateMsg;
+    EXPECT_TRUE(manager.DeltaState(stateMsg, 0));
+    ASSERT_EQ(2, stateMsg.entities_size());
+    EXPECT_EQ(2, stateMsg.entities().at(e1).components_size());
+    EXPECT_EQ(1, stateMsg.entities().at(e2).components_size());
+  }
+
+  msgs::SerializedStateMap stateMsg;
+  EXPECT_TRUE(manager.DeltaState(stateMsg, manager.Version()));
+  EXPECT_EQ(0, stateMsg.entities_size());
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, DeltaStateForgotten)
+{
+  std::vector<Entity> entities;
+  for (int i = 0; i < 10001; ++i)
+  {
+    entities.push_back(manager.CreateEntity());
+    manager.CreateComponent<IntComponent>(entities.back(), IntComponent(i));
+  }
+
+  const uint64_t acked = manager.Version();
+  EXPECT_EQ(10001u, acked);
+
+  // The oldest removal is forgotten
+  EXPECT_EQ(10001u, manager.RemoveComponents(entities));
+
+  msgs::SerializedStateMap stateMsg;
+  EXPECT_FALSE(manager.DeltaState(stateMsg, acked));
+  EXPECT_EQ(0, stateMsg.entities_size());
+
+  EXPECT_TRUE(manager.DeltaState(stateMsg, acked + 1));
+  EXPECT_EQ(10000, stateMsg.entities_size());
+
+  // Removing all entities forgets everything
+  manager.CreateComponent<IntComponent>(entities[0], IntComponent(0));
+  const uint64_t acked2 = manager.Version();
+  manager.RequestRemoveEntities();
+  manager.ProcessEntityRemovals();
+  EXPECT_FALSE(manager.DeltaState(stateMsg, acked2));
+  EXPECT_TRUE(manager.DeltaState(stateMsg, manager.Version()));
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, VersionLogOptIn)
+{
+  Entity e1 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e1, IntComponent(1));
+  manager.CreateComponent<DoubleComponent>(e1, DoubleComponent(2.0));
+
+  // Versions increase, but changes made before the first versioned call
+  // aren't logged, so deltas from before it aren't possible
+  msgs::SerializedStateMap stateMsg;
+  EXPECT_FALSE(manager.DeltaState(stateMsg, 0));
+  EXPECT_EQ(0, stateMsg.entities_size());
+  EXPECT_EQ(2u, manager.Version());
+  EXPECT_EQ(0u, manager.ComponentVersion(e1, IntComponent::typeId));
+
+  // Changes are logged from then on
+  manager.SetChanged(e1, IntComponent::typeId,
+      ComponentState::PeriodicChange);
+  EXPECT_EQ(3u, manager.ComponentVersion(e1, IntComponent::typeId));
+  EXPECT_TRUE(manager.DeltaState(stateMsg, 2));
+  ASSERT_EQ(1, stateMsg.entities_size());
+  EXPECT_EQ(1, stateMsg.entities().at(e1).components_size());
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, BinarySerialization)
+{
+  EXPECT_FALSE(manager.BinarySerialization());
+
+  Entity e1 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e1, IntComponent(-123));
+  manager.CreateComponent<DoubleComponent>(e1, DoubleComponent(0.1));
+  manager.CreateComponent<StringComponent>(e1,
+      StringComponent("with spaces"));
+  manager.CreateComponent<BoolComponent>(e1, BoolComponent(true));
+  manager.CreateComponent<Even>(e1, Even());
+  manager.CreateComponent<Pose>(e1,
+      Pose(math::Pose3d(1, 2, 3, 0.1, 0.2, 0.3)));
+  // Doesn't support binary serialization
+  manager.CreateComponent<CustomComponent>(e1, CustomComponent(Custom()));
+
+  msgs::SerializedStateMap textMsg;
+  manager.State(textMsg);
+  EXPECT_EQ(0, textMsg.header().data_size());
+
+  manager.SetBinarySerialization(true);
+  EXPECT_TRUE(manager.BinarySerialization());
+
+  msgs::SerializedStateMap binaryMsg;
+  manager.State(binaryMsg);
+  ASSERT_EQ(1, binaryMsg.header().data_size());
+  EXPECT_EQ("serialization", binaryMsg.header().data(0).key());
+
+  // Fixed size binary data
+  const auto &comps = binaryMsg.entities().at(e1).components();
+  EXPECT_EQ(sizeof(int), comps.at(IntComponent::typeId).component().size());
+  EXPECT_EQ(sizeof(double),
+      comps.at(DoubleComponent::typeId).component().size());
+  EXPECT_EQ(7 * sizeof(double), comps.at(Pose::typeId).component().size());
+
+  // Both formats can be read
+  for (const auto &msg : {textMsg, binaryMsg})
+  {
+    EntityCompMgrTest newManager;
+    newManager.SetState(msg);
+    EXPECT_EQ(-123, newManager.Component<IntComponent>(e1)->Data());
+    EXPECT_TRUE(newManager.Component<BoolComponent>(e1)->Data());
+    EXPECT_NE(nullptr, newManager.Component<Even>(e1));
+    EXPECT_EQ(123, newManager.Component<CustomComponent>(e1)->Data().dummy);
+    const auto &pose = newManager.Component<Pose>(e1)->Data();
+    EXPECT_DOUBLE_EQ(1.0, pose.Pos().X());
+    EXPECT_DOUBLE_EQ(3.0, pose.Pos().Z());
+  }
+
+  // Binary doubles and strings round trip exactly
+  EntityCompMgrTest newManager;
+  newManager.SetState(binaryMsg);
+  EXPECT_EQ("with spaces", newManager.Component<StringComponent>(e1)->Data());
+  EXPECT_EQ(manager.Component<Pose>(e1)->Data(),
+      newManager.Component<Pose>(e1)->Data());
+  EXPECT_EQ(0.1, newManager.Component<DoubleComponent>(e1)->Data());
+
+  // Updates and deltas use binary too
+  const uint64_t acked = manager.Version();
+  manager.Component<DoubleComponent>(e1)->Data() = 0.3;
+  manager.SetChanged(e1, DoubleComponent::typeId,
+      ComponentState::PeriodicChange);
+  msgs::SerializedStateMap deltaMsg;
+  EXPECT_TRUE(manager.DeltaState(deltaMsg, acked));
+  EXPECT_EQ(1, deltaMsg.header().data_size());
+  newManager.SetState(deltaMsg);
+  EXPECT_EQ(0.3, newManager.Component<DoubleComponent>(e1)->Data());
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, StateThreadCount)
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    Entity e = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(e, IntComponent(i));
+    if (i % 3 == 0)
+      manager.CreateComponent<DoubleComponent>(e, DoubleComponent(i * 0.5));
+  }
+
+  // The result doesn't depend on the number of threads
+  std::vector<msgs::SerializedStateMap> stateMsgs;
+  for (unsigned int threadCount : {0u, 1u, 3u, 8u})
+  {
+    manager.SetStateThreadCount(threadCount);
+    EXPECT_EQ(threadCount, manager.StateThreadCount());
+
+    // Calling twice reuses the same work split
+    for (int j = 0; j < 2; ++j)
+    {
+      msgs::SerializedStateMap stateMsg;
+      manager.State(stateMsg, {}, {}, true);
+      EXPECT_EQ(100, stateMsg.entities_size());
+      stateMsgs.push_back(stateMsg);
+    }
+  }
+
+  for (const auto &stateMsg : stateMsgs)
+  {
+    EntityCompMgrTest newManager;
+    newManager.SetState(stateMsg);
+    for (int i = 0; i < 100; ++i)
+    {
+      const Entity e = static_cast<Entity>(i + 1);
+      EXPECT_EQ(i, newManager.Component<IntComponent>(e)->Data());
+      EXPECT_EQ(i % 3 == 0,
+          nullptr != newManager.Component<DoubleComponent>(e));
+    }
+  }
+
+  // Only some entities, into a message which already has data
+  manager.SetStateThreadCount(2u);
+  msgs::SerializedStateMap stateMsg;
+  manager.State(stateMsg, {1, 2}, {}, true);
+  manager.State(stateMsg, {2, 3}, {IntComponent::typeId}, true);
+  ASSERT_EQ(3, stateMsg.entities_size());
+  EXPECT_EQ(2, stateMsg.entities().at(1).components_size());
+  EXPECT_EQ(1, stateMsg.entities().at(2).components_size());
+  EXPECT_EQ(1, stateMsg.entities().at(3).components_size());
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, SetStateInPlace)
+{
+  for (int i = 0; i < 250; ++i)
+  {
+    Entity e = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(e, IntComponent(i));
+    manager.CreateComponent<StringComponent>(e,
+        StringComponent("entity_" + std::to_string(i)));
+  }
+  manager.CreateComponent<Even>(1, Even());
+
+  msgs::SerializedStateMap stateMsg;
+  manager.State(stateMsg, {}, {}, true);
+
+  // The view exists before the components are created, and must see their
+  // deserialized values
+  EntityCompMgrTest newManager;
+  int count{0};
+  newManager.Each<IntComponent, StringComponent>(
+      [&](const Entity &, const IntComponent *, const StringComponent *)
+      {
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(0, count);
+
+  newManager.SetState(stateMsg);
+  newManager.Each<IntComponent, StringComponent>(
+      [&](const Entity &_entity, const IntComponent *_int,
+          const StringComponent *_string)
+      {
+        EXPECT_EQ(static_cast<int>(_entity) - 1, _int->Data());
+        EXPECT_EQ("entity_" + std::to_string(_int->Data()), _string->Data());
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(250, count);
+  EXPECT_NE(nullptr, newManager.Component<Even>(1));
+  EXPECT_TRUE(newManager.HasOneTimeComponentChanges());
+
+  // Existing components are updated in place
+  const IntComponent *intComp = newManager.Component<IntComponent>(10);
+  ASSERT_NE(nullptr, intComp);
+  manager.Component<IntComponent>(10)->Data() = 1000;
+  manager.Component<StringComponent>(10)->Data() = "updated";
+  stateMsg.Clear();
+  manager.State(stateMsg, {10}, {}, true);
+  newManager.SetState(stateMsg);
+  EXPECT_EQ(intComp, newManager.Component<IntComponent>(10));
+  EXPECT_EQ(1000, intComp->Data());
+  EXPECT_EQ("updated", newManager.Component<StringComponent>(10)->Data());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, Merge)
+{
+  Entity existing = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(existing, IntComponent(-1));
+
+  // Staging manager with a parent and two children
+  EntityCompMgrTest staging;
+  Entity parent = staging.CreateEntity();
+  Entity child1 = staging.CreateEntity();
+  Entity child2 = staging.CreateEntity();
+  staging.CreateComponent<IntComponent>(parent, IntComponent(0));
+  staging.CreateComponent<IntComponent>(child1, IntComponent(1));
+  staging.CreateComponent<StringComponent>(child1, StringComponent("one"));
+  staging.CreateComponent<IntComponent>(child2, IntComponent(2));
+  EXPECT_TRUE(staging.SetParentEntity(child1, parent));
+  EXPECT_TRUE(staging.SetParentEntity(child2, parent));
+
+  auto newEntities = manager.Merge(staging);
+  ASSERT_EQ(3u, newEntities.size());
+  EXPECT_EQ(4u, manager.EntityCount());
+
+  // New IDs follow the existing ones, in creation order
+  EXPECT_EQ(existing + 1, newEntities[parent]);
+  EXPECT_EQ(existing + 2, newEntities[child1]);
+  EXPECT_EQ(existing + 3, newEntities[child2]);
+
+  EXPECT_EQ(-1, manager.Component<IntComponent>(existing)->Data());
+  EXPECT_EQ(0, manager.Component<IntComponent>(newEntities[parent])->Data());
+  EXPECT_EQ(1, manager.Component<IntComponent>(newEntities[child1])->Data());
+  EXPECT_EQ("one",
+      manager.Component<StringComponent>(newEntities[child1])->Data());
+  EXPECT_EQ(2, manager.Component<IntComponent>(newEntities[child2])->Data());
+  EXPECT_EQ(nullptr,
+      manager.Component<StringComponent>(newEntities[child2]));
+
+  EXPECT_EQ(kNullEntity, manager.ParentEntity(newEntities[parent]));
+  EXPECT_EQ(newEntities[parent], manager.ParentEntity(newEntities[child1]));
+  EXPECT_EQ(newEntities[parent], manager.ParentEntity(newEntities[child2]));
+  EXPECT_EQ(3u, manager.Descendants(newEntities[parent]).size());
+
+  // Merged entities are new
+  EXPECT_TRUE(manager.HasNewEntities());
+
+  // The staging manager isn't changed
+  EXPECT_EQ(3u, staging.EntityCount());
+  EXPECT_EQ(1, staging.Component<IntComponent>(child1)->Data());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, Snapshot)
+{
+  // The parent is created after its child
+  Entity child = manager.CreateEntity();
+  Entity parent = manager.CreateEntity();
+  Entity removed = manager.CreateEntity();
+  Entity other = manager.CreateEntity();
+  EXPECT_TRUE(manager.SetParentEntity(child, parent));
+  manager.CreateComponent<Pose>(child, Pose(math::Pose3d(1, 2, 3, 0, 0, 0)));
+  manager.CreateComponent<StringComponent>(child, StringComponent("child"));
+  manager.CreateComponent<Pose>(parent, Pose(math::Pose3d(4, 5, 6, 0, 0, 0)));
+  manager.CreateComponent<Even>(parent, Even());
+  manager.CreateComponent<IntComponent>(other, IntComponent(123));
+  manager.RequestRemoveEntity(removed);
+  manager.ProcessEntityRemovals();
+
+  std::string snapshot;
+  manager.Snapshot(snapshot);
+  EXPECT_FALSE(snapshot.empty());
+
+  EntityCompMgrTest restored;
+  EXPECT_TRUE(restored.LoadSnapshot(snapshot.data(), snapshot.size()));
+  EXPECT_EQ(3u, restored.EntityCount());
+  EXPECT_FALSE(restored.HasEntity(removed));
+  EXPECT_EQ(parent, restored.ParentEntity(child));
+  EXPECT_EQ(kNullEntity, restored.ParentEntity(other));
+
+  ASSERT_NE(nullptr, restored.Component<Pose>(child));
+  EXPECT_EQ(math::Pose3d(1, 2, 3, 0, 0, 0),
+      restored.Component<Pose>(child)->Data());
+  EXPECT_EQ("child", restored.Component<StringComponent>(child)->Data());
+  ASSERT_NE(nullptr, restored.Component<Pose>(parent));
+  EXPECT_EQ(math::Pose3d(4, 5, 6, 0, 0, 0),
+      restored.Component<Pose>(parent)->Data());
+  EXPECT_NE(nullptr, restored.Component<Even>(parent));
+  EXPECT_EQ(nullptr, restored.Component<StringComponent>(parent));
+  ASSERT_NE(nullptr, restored.Component<IntComponent>(other));
+  EXPECT_EQ(123, restored.Component<IntComponent>(other)->Data());
+
+  // New entities follow the restored ones
+  EXPECT_EQ(other + 1, restored.CreateEntity());
+
+  // Can't load into a manager with entities
+  EXPECT_FALSE(restored.LoadSnapshot(snapshot.data(), snapshot.size()));
+
+  // Truncated snapshot
+  EntityCompMgrTest truncated;
+  EXPECT_FALSE(truncated.LoadSnapshot(snapshot.data(), snapshot.size() / 2));
+  EXPECT_EQ(0u, truncated.EntityCount());
+
+  // Binary data which can't be decoded rejects the whole snapshot, instead
+  // of being read as text
+  EntityCompMgrTest single;
+  Entity singleEntity = single.CreateEntity();
+  single.CreateComponent<Pose>(singleEntity, Pose());
+  std::string corrupt;
+  single.Snapshot(corrupt);
+
+  // Drop the last byte of the pose, which is the last component, and move
+  // its end offset accordingly
+  const uint64_t poseSize = 7 * sizeof(double) - 1;
+  corrupt.pop_back();
+  std::memcpy(&corrupt[corrupt.size() - poseSize - sizeof(uint64_t)],
+      &poseSize, sizeof(uint64_t));
+
+  EntityCompMgrTest corrupted;
+  EXPECT_FALSE(corrupted.LoadSnapshot(corrupt.data(), corrupt.size()));
+  EXPECT_EQ(0u, corrupted.EntityCount());
+
+  // A component type which isn't registered rejects the whole snapshot,
+  // instead of restoring the entity without it. The type of the only column
+  // follows the version, the entity with its parent, and the column count.
+  std::string unknown;
+  single.Snapshot(unknown);
+  const uint64_t unknownType{0xdeadbeef};
+  std::memcpy(&unknown[sizeof(uint32_t) + 4 * sizeof(uint64_t)],
+      &unknownType, sizeof(uint64_t));
+
+  EntityCompMgrTest unregistered;
+  EXPECT_FALSE(unregistered.LoadSnapshot(unknown.data(), unknown.size()));
+  EXPECT_EQ(0u, unregistered.EntityCount());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, Reset)
+{
+  EXPECT_FALSE(manager.HasResetPoint());
+  EXPECT_FALSE(manager.Reset());
+
+  Entity parent = manager.CreateEntity();
+  Entity child = manager.CreateEntity();
+  Entity removed = manager.CreateEntity();
+  EXPECT_TRUE(manager.SetParentEntity(child, parent));
+  EXPECT_TRUE(manager.SetParentEntity(removed, parent));
+  manager.CreateComponent<Pose>(child, Pose(math::Pose3d(1, 2, 3, 0, 0, 0)));
+  manager.CreateComponent<IntComponent>(child, IntComponent(123));
+  manager.CreateComponent<IntComponent>(removed, IntComponent(456));
+  manager.CreateComponent<StringComponent>(parent, StringComponent("parent"));
+
+  manager.SetResetPoint();
+  EXPECT_TRUE(manager.HasResetPoint());
+  manager.RunClearNewlyCreatedEntities();
+  manager.RunSetAllComponentsUnchanged();
+
+  // Change the world: write in place without marking as changed, remove and
+  // add components and entities.
+  auto pose = manager.Component<Pose>(child);
+  ASSERT_NE(nullptr, pose);
+  pose->Data().Pos().X() = 10.0;
+  EXPECT_TRUE(manager.RemoveComponent<IntComponent>(child));
+  manager.CreateComponent<DoubleComponent>(child, DoubleComponent(0.5));
+  EXPECT_TRUE(manager.SetParentEntity(child, kNullEntity));
+  Entity created = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(created, IntComponent(789));
+  manager.RequestRemoveEntity(removed);
+  manager.ProcessEntityRemovals();
+  manager.RunClearNewlyCreatedEntities();
+  manager.RunClearRemovedComponents();
+  manager.RunSetAllComponentsUnchanged();
+  EXPECT_FALSE(manager.HasEntity(removed));
+
+  // The pose keeps its address
+  EXPECT_TRUE(manager.Reset());
+  EXPECT_EQ(pose, manager.Component<Pose>(child));
+  EXPECT_EQ(math::Pose3d(1, 2, 3, 0, 0, 0), pose->Data());
+  EXPECT_EQ(ComponentState::OneTimeChange,
+      manager.ComponentState(child, Pose::typeId));
+  EXPECT_EQ(parent, manager.ParentEntity(child));
+
+  ASSERT_NE(nullptr, manager.Component<IntComponent>(child));
+  EXPECT_EQ(123, manager.Component<IntComponent>(child)->Data());
+
+  // Storages which were only read weren't copied, so their components
+  // aren't marked as changed
+  EXPECT_EQ(ComponentState::NoChange,
+      manager.ComponentState(parent, StringComponent::typeId));
+
+  // Components created since the reset point are kept
+  ASSERT_NE(nullptr, manager.Component<DoubleComponent>(child));
+  EXPECT_DOUBLE_EQ(0.5, manager.Component<DoubleComponent>(child)->Data());
+
+  // Removed entities come back with their IDs, as new entities
+  EXPECT_TRUE(manager.HasEntity(removed));
+  EXPECT_EQ(parent, manager.ParentEntity(removed));
+  ASSERT_NE(nullptr, manager.Component<IntComponent>(removed));
+  EXPECT_EQ(456, manager.Component<IntComponent>(removed)->Data());
+  EXPECT_TRUE(manager.HasNewEntities());
+
+  // New entities are removed through the usual requests
+  EXPECT_TRUE(manager.HasEntity(created));
+  EXPECT_TRUE(manager.HasEntitiesMarkedForRemoval());
+  std::size_t removedCount{0};
+  manager.EachRemoved<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *) -> bool
+      {
+        EXPECT_EQ(created, _entity);
+        ++removedCount;
+        return true;
+      });
+  EXPECT_EQ(1u, removedCount);
+
+  // The entity counter is rewound, skipping entities waiting for removal
+  Entity pending = manager.CreateEntity();
+  EXPECT_EQ(created + 1, pending);
+  manager.RequestRemoveEntity(pending);
+  manager.ProcessEntityRemovals();
+  EXPECT_FALSE(manager.HasEntity(created));
+  EXPECT_EQ(3u, manager.EntityCount());
+
+  // Resetting again gives new entities the same IDs
+  EXPECT_TRUE(manager.Reset());
+  EXPECT_EQ(created, manager.CreateEntity());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, Batch)
+{
+  auto countEntities = [&]()
+  {
+    std::size_t count{0};
+    manager.Each<IntComponent, DoubleComponent>(
+        [&](const Entity &, const IntComponent *_int,
+            const DoubleComponent *_double) -> bool
+        {
+          EXPECT_DOUBLE_EQ(_int->Data() * 0.5, _double->Data());
+          ++count;
+          return true;
+        });
+    return count;
+  };
+
+  // Create the view before the batch, so it must be updated
+  Entity first = manager.CreateEntity();
+  manager.CreateComponent(first, IntComponent(0));
+  manager.CreateComponent(first, DoubleComponent(0.0));
+  EXPECT_EQ(1u, countEntities());
+
+  // Enough entities to grow the storages, in nested batches
+  manager.BeginBatch();
+  manager.BeginBatch();
+  std::vector<Entity> entities;
+  for (int i = 1; i < 500; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent(entity, IntComponent(i));
+    manager.CreateComponent(entity, DoubleComponent(i * 0.5));
+    entities.push_back(entity);
+  }
+  manager.EndBatch();
+
+  // Components are accessible during the batch
+  ASSERT_NE(nullptr, manager.Component<IntComponent>(entities.back()));
+  EXPECT_EQ(499, manager.Component<IntComponent>(entities.back())->Data());
+
+  // Views are brought up to date when used during the batch
+  EXPECT_EQ(500u, countEntities());
+
+  // Removals are batched too
+  for (std::size_t i = 0; i < 100; ++i)
+    manager.RequestRemoveEntity(entities[i]);
+  Entity last = manager.CreateEntity();
+  manager.CreateComponent(last, IntComponent(500));
+  manager.CreateComponent(last, DoubleComponent(250.0));
+  manager.EndBatch();
+
+  std::size_t removedCount{0};
+  manager.EachRemoved<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *,
+          const DoubleComponent *) -> bool
+      {
+        ++removedCount;
+        return true;
+      });
+  EXPECT_EQ(100u, removedCount);
+
+  std::size_t newCount{0};
+  manager.EachNew<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *,
+          const DoubleComponent *) -> bool
+      {
+        ++newCount;
+        return true;
+      });
+  EXPECT_EQ(501u, newCount);
+
+  manager.ProcessEntityRemovals();
+  EXPECT_EQ(401u, countEntities());
+  EXPECT_EQ(last, manager.EntityByComponents(IntComponent(500)));
+
+  // Unbalanced end is ignored
+  manager.EndBatch();
+  EXPECT_EQ(401u, countEntities());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, WorldPose)
+{
+  Entity world = manager.CreateEntity();
+  Entity model = manager.CreateEntity();
+  Entity link = manager.CreateEntity();
+  Entity noPose = manager.CreateEntity();
+  manager.CreateComponent(model, ParentEntity(world));
+  manager.CreateComponent(model, Pose(math::Pose3d(1, 0, 0, 0, 0, IGN_PI_2)));
+  manager.CreateComponent(link, ParentEntity(model));
+  manager.CreateComponent(link, Pose(math::Pose3d(1, 0, 0, 0, 0, 0)));
+  manager.CreateComponent(noPose, ParentEntity(link));
+
+  // The world doesn't have a pose, so it's the root
+  EXPECT_FALSE(manager.WorldPose(world));
+  EXPECT_FALSE(manager.WorldPose(noPose));
+  ASSERT_TRUE(manager.WorldPose(link));
+  EXPECT_EQ(math::Pose3d(1, 1, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+  EXPECT_EQ(math::Pose3d(1, 0, 0, 0, 0, IGN_PI_2), *manager.WorldPose(model));
+
+  // Changes marked through SetChanged invalidate the entity's subtree
+  manager.Component<Pose>(model)->Data().Pos().X() = 2;
+  manager.SetChanged(model, Pose::typeId, ComponentState::PeriodicChange);
+  EXPECT_EQ(math::Pose3d(2, 1, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+
+  // Even if the descendant was already validated in this step
+  manager.Component<Pose>(model)->Data().Pos().X() = 4;
+  manager.SetChanged(model, Pose::typeId, ComponentState::PeriodicChange);
+  EXPECT_EQ(math::Pose3d(4, 1, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+
+  // Other changes are seen on the next step, for ancestors and descendants
+  manager.Component<Pose>(model)->Data().Pos().X() = 3;
+  EXPECT_EQ(math::Pose3d(4, 1, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+  manager.RunSetAllComponentsUnchanged();
+  EXPECT_EQ(math::Pose3d(3, 1, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+
+  manager.Component<Pose>(link)->Data().Pos().X() = 2;
+  manager.RunSetAllComponentsUnchanged();
+  EXPECT_EQ(math::Pose3d(3, 2, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+  EXPECT_EQ(math::Pose3d(3, 0, 0, 0, 0, IGN_PI_2), *manager.WorldPose(model));
+  manager.Component<Pose>(link)->Data().Pos().X() = 1;
+  manager.RunSetAllComponentsUnchanged();
+
+  // Reparenting invalidates the cache
+  EXPECT_TRUE(manager.RemoveComponent<ParentEntity>(link));
+  EXPECT_EQ(math::Pose3d(1, 0, 0, 0, 0, 0), *manager.WorldPose(link));
+  manager.CreateComponent(link, ParentEntity(model));
+  EXPECT_EQ(math::Pose3d(3, 1, 0, 0, 0, IGN_PI_2), *manager.WorldPose(link));
+
+  // So does removing an ancestor
+  manager.RequestRemoveEntity(model, false);
+  manager.ProcessEntityRemovals();
+  EXPECT_EQ(math::Pose3d(1, 0, 0, 0, 0, 0), *manager.WorldPose(link));
+}
+
 // Run multiple times. We want to make sure that static globals don't cause
 // problems.
 INSTANTIATE_TEST_SUITE_P(EntityComponentManagerRepeat,
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "LevelGrid.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <ignition/common/Profiler.hh>
+
+using namespace ignition;
+using namespace gazebo;
+
+//////////////////////////////////////////////////
+std::size_t LevelGrid::CellHash::operator()(const Cell &_cell) const
+{
+  std::size_t hash = std::hash<int64_t>()(_cell[0]);
+  hash = hash * 31 + std::hash<int64_t>()(_cell[1]);
+  hash = hash * 31 + std::hash<int64_t>()(_cell[2]);
+  return hash;
+}
+
+//////////////////////////////////////////////////
+void LevelGrid::Build(std::vector<Level> _levels)
+{
+  IGN_PROFILE("LevelGrid::Build");
+
+  this->levels = std::move(_levels);
+  this->indices.clear();
+  this->cells.clear();
+  this->largeLevels.clear();
+  this->cellSize.Set(1, 1, 1);
+
+  if (this->levels.empty())
+    return;
+
+  // Cells as large as the average level, so levels span a few cells each
+  math::Vector3d total;
+  std::size_t finiteCount{0};
+  for (const auto &level : this->levels)
+  {
+    const math::Vector3d size =
+        level.outerRegion.Max() - level.outerRegion.Min();
+    if (size.IsFinite())
+    {
+      total += size;
+      ++finiteCount;
+    }
+  }
+  for (unsigned int i = 0; finiteCount > 0 && i < 3; ++i)
+  {
+    const double average = total[i] / static_cast<double>(finiteCount);
+    if (average > 0)
+      this->cellSize[i] = average;
+  }
+
+  for (std::size_t index = 0; index < this->levels.size(); ++index)
+  {
+    this->indices[this->levels[index].entity] = index;
+
+    Cell first;
+    Cell last;
+    if (!this->CellRange(this->levels[index].outerRegion, first, last))
+    {
+      this->largeLevels.push_back(index);
+      continue;
+    }
+
+    for (int64_t x = first[0]; x <= last[0]; ++x)
+    {
+      for (int64_t y = first[1]; y <= last[1]; ++y)
+      {
+        for (int64_t z = first[2]; z <= last[2]; ++z)
+          this->cells[{x, y, z}].push_back(index);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void LevelGrid::Query(const math::AxisAlignedBox &_box,
+    std::vector<std::size_t> &_indices) const
+{
+  IGN_PROFILE("LevelGrid::Query");
+
+  _indices.clear();
+  if (this->levels.empty())
+    return;
+
+  Cell first;
+  Cell last;
+  if (!this->CellRange(_box, first, last))
+  {
+    // Boxes covering many cells are cheaper to check against every level
+    for (std::size_t index = 0; index < this->levels.size(); ++index)
+    {
+      if (this->levels[index].outerRegion.Intersects(_box))
+        _indices.push_back(index);
+    }
+    return;
+  }
+
+  for (int64_t x = first[0]; x <= last[0]; ++x)
+  {
+    for (int64_t y = first[1]; y <= last[1]; ++y)
+    {
+      for (int64_t z = first[2]; z <= last[2]; ++z)
+      {
+        auto iter = this->cells.find({x, y, z});
+        if (iter == this->cells.end())
+          continue;
+
+        for (const std::size_t index : iter->second)
+        {
+          if (this->levels[index].outerRegion.Intersects(_box))
+            _indices.push_back(index);
+        }
+      }
+    }
+  }
+
+  for (const std::size_t index : this->largeLevels)
+  {
+    if (this->levels[index].outerRegion.Intersects(_box))
+      _indices.push_back(index);
+  }
+
+  // Levels spanning several cells are found more than once
+  std::sort(_indices.begin(), _indices.end());
+  _indices.erase(std::unique(_indices.begin(), _indices.end()),
+      _indices.end());
+}
+
+//////////////////////////////////////////////////
+const std::vector<LevelGrid::Level> &LevelGrid::Levels() const
+{
+  return this->levels;
+}
+
+//////////////////////////////////////////////////
+bool LevelGrid::Contains(const Entity _entity) const
+{
+  return this->indices.find(_entity) != this->indices.end();
+}
+
+//////////////////////////////////////////////////
+bool LevelGrid::CellRange(const math::AxisAlignedBox &_box,
+    Cell &_first, Cell &_last) const
+{
+  double count{1};
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    const double first = std::floor(_box.Min()[i] / this->cellSize[i]);
+    const double last = std::floor(_box.Max()[i] / this->cellSize[i]);
+    if (!std::isfinite(first) || !std::isfinite(last) || last < first)
+      return false;
+
+    count *= last - first + 1;
+    if (count > kMaxCells)
+      return false;
+
+    _first[i] = static_cast<int64_t>(first);
+    _last[i] = static_cast<int64_t>(last);
+  }
+  return true;
+}
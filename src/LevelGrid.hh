@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_LEVELGRID_HH_
+#define IGNITION_GAZEBO_LEVELGRID_HH_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/math/Vector3.hh>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Entity.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class LevelGrid LevelGrid.hh
+    /// \brief Uniform grid over the regions of levels, used to find the
+    /// levels near a performer without checking every level.
+    ///
+    /// Each level is registered in every cell its outer region, that is,
+    /// its region grown by its buffer, overlaps. Cells are as large as the
+    /// average outer region, so a level only spans a few cells.
+    class IGNITION_GAZEBO_VISIBLE LevelGrid
+    {
+      /// \brief A level in the grid.
+      public: struct Level
+      {
+        /// \brief Level entity.
+        Entity entity{kNullEntity};
+
+        /// \brief Region of the level.
+        math::AxisAlignedBox region;
+
+        /// \brief Region of the level grown by its buffer.
+        math::AxisAlignedBox outerRegion;
+      };
+
+      /// \brief Replace all the levels in the grid.
+      /// \param[in] _levels The levels.
+      public: void Build(std::vector<Level> _levels);
+
+      /// \brief Find the levels whose outer region intersects a box.
+      /// \param[in] _box The box.
+      /// \param[out] _indices Indices of the levels, see Levels, sorted.
+      /// Cleared first.
+      public: void Query(const math::AxisAlignedBox &_box,
+                  std::vector<std::size_t> &_indices) const;
+
+      /// \brief Get the levels in the grid.
+      /// \return The levels, in the order they were given to Build.
+      public: const std::vector<Level> &Levels() const;
+
+      /// \brief Check whether an entity is a level in the grid.
+      /// \param[in] _entity The entity.
+      /// \return True if the entity is in the grid.
+      public: bool Contains(const Entity _entity) const;
+
+      /// \brief Coordinates of a cell.
+      private: using Cell = std::array<int64_t, 3>;
+
+      /// \brief Hash of a cell's coordinates.
+      private: struct CellHash
+      {
+        std::size_t operator()(const Cell &_cell) const;
+      };
+
+      /// \brief Get the range of cells a box overlaps.
+      /// \param[in] _box The box.
+      /// \param[out] _first Lowest cell.
+      /// \param[out] _last Highest cell.
+      /// \return False if the box isn't finite or overlaps more than
+      /// kMaxCells cells, in which case it shouldn't go through the cells.
+      private: bool CellRange(const math::AxisAlignedBox &_box,
+                   Cell &_first, Cell &_last) const;
+
+      /// \brief Maximum number of cells a level is registered in. Larger
+      /// levels are checked on every query instead.
+      private: static constexpr double kMaxCells{4096};
+
+      /// \brief The levels.
+      private: std::vector<Level> levels;
+
+      /// \brief Level entities, so membership is checked in constant time.
+      private: std::unordered_map<Entity, std::size_t> indices;
+
+      /// \brief Indices of the levels overlapping each non empty cell.
+      private: std::unordered_map<Cell, std::vector<std::size_t>, CellHash>
+                   cells;
+
+      /// \brief Indices of the levels too large to be registered in cells.
+      private: std::vector<std::size_t> largeLevels;
+
+      /// \brief Size of the cells along each axis.
+      private: math::Vector3d cellSize{1, 1, 1};
+    };
+    }
+  }
+}
+#endif
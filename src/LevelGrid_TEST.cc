@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <vector>
+
+#include "LevelGrid.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Create a level centered at a point.
+/// \param[in] _entity Level entity.
+/// \param[in] _center Center of the level.
+/// \param[in] _size Size of the level.
+/// \param[in] _buffer Buffer around the level.
+/// \return The level.
+static LevelGrid::Level makeLevel(const Entity _entity,
+    const math::Vector3d &_center, const math::Vector3d &_size,
+    const double _buffer)
+{
+  const math::Vector3d buffer(_buffer, _buffer, _buffer);
+  LevelGrid::Level level;
+  level.entity = _entity;
+  level.region = math::AxisAlignedBox(_center - _size / 2,
+      _center + _size / 2);
+  level.outerRegion = math::AxisAlignedBox(level.region.Min() - buffer,
+      level.region.Max() + buffer);
+  return level;
+}
+
+/////////////////////////////////////////////////
+TEST(LevelGrid, Query)
+{
+  // 50 x 50 tiles of 10 m, with a 1 m buffer
+  std::vector<LevelGrid::Level> levels;
+  for (int x = 0; x < 50; ++x)
+  {
+    for (int y = 0; y < 50; ++y)
+    {
+      levels.push_back(makeLevel(1 + x * 50 + y,
+          math::Vector3d(x * 10.0, y * 10.0, 0), math::Vector3d(10, 10, 10),
+          1.0));
+    }
+  }
+
+  LevelGrid grid;
+  std::vector<std::size_t> indices;
+  grid.Query(math::AxisAlignedBox(-1, -1, -1, 1, 1, 1), indices);
+  EXPECT_TRUE(indices.empty());
+
+  grid.Build(levels);
+  EXPECT_EQ(2500u, grid.Levels().size());
+  EXPECT_TRUE(grid.Contains(1));
+  EXPECT_TRUE(grid.Contains(2500));
+  EXPECT_FALSE(grid.Contains(2501));
+
+  // Same results as checking every level
+  std::vector<math::AxisAlignedBox> boxes{
+      {12, 12, -1, 13, 13, 1},
+      {14, 14, -1, 16, 16, 1},
+      {-30, -30, -1, -20, -20, 1},
+      {100, 200, -1, 140, 230, 1},
+      {-1e9, -1e9, -1e9, 1e9, 1e9, 1e9}};
+  for (const auto &box : boxes)
+  {
+    std::vector<std::size_t> expected;
+    for (std::size_t i = 0; i < levels.size(); ++i)
+    {
+      if (levels[i].outerRegion.Intersects(box))
+        expected.push_back(i);
+    }
+
+    grid.Query(box, indices);
+    EXPECT_EQ(expected, indices);
+  }
+
+  // Near the corner of 4 tiles, within their buffers
+  grid.Query(math::AxisAlignedBox(14, 14, -1, 16, 16, 1), indices);
+  EXPECT_EQ(4u, indices.size());
+}
+
+/////////////////////////////////////////////////
+TEST(LevelGrid, LargeLevels)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<LevelGrid::Level> levels{
+      makeLevel(1, {0, 0, 0}, {1, 1, 1}, 0.0),
+      makeLevel(2, {0, 0, 0}, {1e6, 1e6, 1e6}, 0.0),
+      makeLevel(3, {0, 0, 0}, {inf, inf, inf}, 0.0)};
+
+  LevelGrid grid;
+  grid.Build(levels);
+
+  std::vector<std::size_t> indices;
+  grid.Query(math::AxisAlignedBox(0, 0, 0, 0.1, 0.1, 0.1), indices);
+  EXPECT_EQ(std::vector<std::size_t>({0, 1, 2}), indices);
+
+  grid.Query(math::AxisAlignedBox(1000, 1000, 0, 1001, 1001, 1), indices);
+  EXPECT_EQ(std::vector<std::size_t>({1, 2}), indices);
+
+  // Rebuilding replaces the levels
+  grid.Build({});
+  EXPECT_FALSE(grid.Contains(1));
+  grid.Query(math::AxisAlignedBox(0, 0, 0, 0.1, 0.1, 0.1), indices);
+  EXPECT_TRUE(indices.empty());
+}
@@ -18,11 +18,15 @@
 #include "LevelManager.hh"
 
 #include <algorithm>
+#include <unordered_set>
+#include <vector>
 
 #include <sdf/Actor.hh>
 #include <sdf/Atmosphere.hh>
 #include <sdf/Light.hh>
+#include <sdf/Link.hh>
 #include <sdf/Model.hh>
+#include <sdf/Sensor.hh>
 #include <sdf/World.hh>
 
 #include <ignition/common/Profiler.hh>
@@ -32,9 +36,12 @@
 
 #include "ignition/gazebo/components/Actor.hh"
 #include "ignition/gazebo/components/Atmosphere.hh"
+#include "ignition/gazebo/components/ContactSensor.hh"
 #include "ignition/gazebo/components/Geometry.hh"
 #include "ignition/gazebo/components/Gravity.hh"
 #include "ignition/gazebo/components/Level.hh"
+#include "ignition/gazebo/components/Link.hh"
+#include "ignition/gazebo/components/LogicalCamera.hh"
 #include "ignition/gazebo/components/Model.hh"
 #include "ignition/gazebo/components/Light.hh"
 #include "ignition/gazebo/components/Name.hh"
@@ -52,6 +59,7 @@
 #include "ignition/gazebo/components/RenderEngineGuiPlugin.hh"
 #include "ignition/gazebo/components/RenderEngineServerPlugin.hh"
 #include "ignition/gazebo/components/Scene.hh"
+#include "ignition/gazebo/components/Sensor.hh"
 #include "ignition/gazebo/components/Wind.hh"
 #include "ignition/gazebo/components/World.hh"
 
@@ -60,8 +68,17 @@
 using namespace ignition;
 using namespace gazebo;
 
+/// \brief Minimum distance a performer can move before the levels near it
+/// are looked up again, in meters.
+static constexpr double kPerformerQueryMargin{1.0};
+
+/// \brief How far ahead in time levels are prefetched while streaming, in
+/// seconds of simulation time, given each performer's velocity.
+static constexpr double kPrefetchTime{2.0};
+
 /////////////////////////////////////////////////
-LevelManager::LevelManager(SimulationRunner *_runner, const bool _useLevels)
+LevelManager::LevelManager(SimulationRunner *_runner, const bool _useLevels,
+    const bool _restored)
     : runner(_runner), useLevels(_useLevels)
 {
   if (nullptr == _runner)
@@ -74,8 +91,15 @@ LevelManager::LevelManager(SimulationRunner *_runner, const bool _useLevels)
       this->runner->entityCompMgr,
       this->runner->eventMgr);
 
-  this->ReadLevelPerformerInfo();
-  this->CreatePerformers();
+  if (_restored)
+  {
+    this->RestoreLevelPerformerInfo();
+  }
+  else
+  {
+    this->ReadLevelPerformerInfo();
+    this->CreatePerformers();
+  }
 
   std::string service = transport::TopicUtils::AsValidTopic("/world/" +
       this->runner->sdfWorld->Name() + "/level/set_performer");
@@ -88,6 +112,12 @@ LevelManager::LevelManager(SimulationRunner *_runner, const bool _useLevels)
   this->node.Advertise(service, &LevelManager::OnSetPerformer, this);
 }
 
+/////////////////////////////////////////////////
+LevelManager::~LevelManager()
+{
+  this->stopStaging = true;
+}
+
 /////////////////////////////////////////////////
 void LevelManager::ReadLevelPerformerInfo()
 {
@@ -222,6 +252,124 @@ void LevelManager::ReadLevelPerformerInfo()
       worldEntity, components::WorldSdf(*this->runner->sdfWorld));
 }
 
+/////////////////////////////////////////////////
+void LevelManager::RestoreLevelPerformerInfo()
+{
+  IGN_PROFILE("LevelManager::RestoreLevelPerformerInfo");
+
+  auto &ecm = this->runner->entityCompMgr;
+
+  this->worldEntity = ecm.EntityByComponents(components::World());
+  if (this->worldEntity == kNullEntity)
+  {
+    ignerr << "Could not find the world entity among restored entities\n";
+    return;
+  }
+
+  // Performers are keyed by the name of the model or actor they belong to
+  ecm.Each<components::Performer, components::ParentEntity>(
+      [&](const Entity &_entity, const components::Performer *,
+          const components::ParentEntity *_parent) -> bool
+      {
+        auto name = ecm.Component<components::Name>(_parent->Data());
+        if (nullptr != name)
+          this->performerMap[name->Data()] = _entity;
+        return true;
+      });
+
+  // The default level was already loaded
+  ecm.Each<components::DefaultLevel, components::LevelEntityNames>(
+      [&](const Entity &_entity, const components::DefaultLevel *,
+          const components::LevelEntityNames *_names) -> bool
+      {
+        this->activeLevels.push_back(_entity);
+        this->activeEntityNames.insert(_names->Data().begin(),
+            _names->Data().end());
+        // We assume one default level
+        return false;
+      });
+
+  // The SDF DOM components are restored empty, so fill them from the world's
+  // SDF.
+  ecm.SetComponentData<components::WorldSdf>(this->worldEntity,
+      *this->runner->sdfWorld);
+
+  for (const Entity model : ecm.EntitiesByComponents(components::Model(),
+      components::ParentEntity(this->worldEntity)))
+  {
+    auto name = ecm.Component<components::Name>(model);
+    if (nullptr == name)
+      continue;
+
+    auto sdfModel = this->runner->sdfWorld->ModelByName(name->Data());
+    if (nullptr == sdfModel)
+    {
+      ignwarn << "Model [" << name->Data() << "] isn't in the world's SDF, "
+              << "so its SDF can't be restored." << std::endl;
+      continue;
+    }
+    this->RestoreModelSdf(model, sdfModel);
+  }
+}
+
+/////////////////////////////////////////////////
+void LevelManager::RestoreModelSdf(const Entity _entity,
+    const sdf::Model *_model)
+{
+  auto &ecm = this->runner->entityCompMgr;
+
+  if (ecm.EntityHasComponentType(_entity, components::ModelSdf::typeId))
+    ecm.SetComponentData<components::ModelSdf>(_entity, *_model);
+
+  for (const Entity child : ecm.EntitiesByComponents(
+      components::ParentEntity(_entity)))
+  {
+    auto name = ecm.Component<components::Name>(child);
+    if (nullptr == name)
+      continue;
+
+    if (ecm.EntityHasComponentType(child, components::Model::typeId))
+    {
+      auto nested = _model->ModelByName(name->Data());
+      if (nullptr != nested)
+        this->RestoreModelSdf(child, nested);
+      continue;
+    }
+
+    if (!ecm.EntityHasComponentType(child, components::Link::typeId))
+      continue;
+
+    auto link = _model->LinkByName(name->Data());
+    if (nullptr == link)
+      continue;
+
+    for (const Entity sensor : ecm.EntitiesByComponents(
+        components::Sensor(), components::ParentEntity(child)))
+    {
+      auto sensorName = ecm.Component<components::Name>(sensor);
+      if (nullptr == sensorName)
+        continue;
+
+      auto sdfSensor = link->SensorByName(sensorName->Data());
+      if (nullptr == sdfSensor)
+        continue;
+
+      if (ecm.EntityHasComponentType(sensor,
+          components::LogicalCamera::typeId))
+      {
+        ecm.SetComponentData<components::LogicalCamera>(sensor,
+            sdfSensor->Element());
+      }
+      if (ecm.EntityHasComponentType(sensor,
+          components::ContactSensor::typeId))
+      {
+        ecm.SetComponentData<components::ContactSensor>(sensor,
+            sdfSensor->Element());
+      }
+    }
+  }
+}
+
 /////////////////////////////////////////////////
 void LevelManager::ReadPerformers(const sdf::ElementPtr &_sdf)
 {
@@ -583,9 +731,23 @@ void LevelManager::UpdateLevelsState()
         });
   }
 
+  // Levels which some performer is heading towards, while streaming
+  std::set<Entity> prefetchLevels;
+
   // If levels are not being used, we only process the default level.
   if (this->useLevels)
   {
+    this->UpdateLevelGrid();
+    const auto &levels = this->levelGrid.Levels();
+
+    // Levels which some performer is in, or within the buffer of
+    std::set<Entity> performerLevels;
+    bool hasPerformers{false};
+
+    // Looked up for every level near every performer
+    const std::unordered_set<Entity> activeLevelSet(
+        this->activeLevels.begin(), this->activeLevels.end());
+
     this->runner->entityCompMgr.Each<
       components::Performer,
       components::PerformerLevels,
@@ -610,71 +772,116 @@ void LevelManager::UpdateLevelsState()
           << "] missing box." << std::endl;
           return true;
           }
+          hasPerformers = true;
 
+          const math::Vector3d &position = pose->Data().Pos();
           math::AxisAlignedBox performerVolume{
-            pose->Data().Pos() - perfBox->Size() / 2,
-              pose->Data().Pos() + perfBox->Size() / 2};
+            position - perfBox->Size() / 2,
+              position + perfBox->Size() / 2};
+
+          // Only query the index again once the performer left the volume
+          // the levels nearby were found for.
+          auto &candidates = this->performerCandidates[_perfEntity];
+          const math::Vector3d offset = (position - candidates.position).Abs();
+          if (candidates.size != perfBox->Size() ||
+              offset.Max() > candidates.margin)
+          {
+            candidates.position = position;
+            candidates.size = perfBox->Size();
+            candidates.margin = std::max(kPerformerQueryMargin,
+                0.5 * perfBox->Size().Max());
+            const math::Vector3d margin(candidates.margin, candidates.margin,
+                candidates.margin);
+            this->levelGrid.Query(
+                math::AxisAlignedBox(performerVolume.Min() - margin,
+                performerVolume.Max() + margin), candidates.levels);
+          }
 
           std::set<Entity> newPerfLevels;
 
-          // loop through levels and check for intersections
-          // Add all levels with intersections to the levelsToLoad even if they
-          // are currently active.
-          this->runner->entityCompMgr.Each<components::Level, components::Pose,
-            components::Geometry,
-            components::LevelBuffer >(
-                [&](const Entity &_entity, const components::Level *,
-                  const components::Pose *_pose,
-                  const components::Geometry *_levelGeometry,
-                  const components::LevelBuffer *_levelBuffer) -> bool
-                {
-                IGN_PROFILE("CheckPerformerAgainstLevel");
-                // Check if the performer is in this level
-                // assume a box for now
-                auto box = _levelGeometry->Data().BoxShape();
-                if (nullptr == box)
-                {
-                ignerr << "Level [" << _entity
-                << "]'s geometry is not a box." << std::endl;
-                return true;
-                }
-                auto buffer = _levelBuffer->Data();
-                auto center = _pose->Data().Pos();
-                math::AxisAlignedBox region{center - box->Size() / 2,
-                center + box->Size() / 2};
-
-                math::AxisAlignedBox outerRegion{
-                  center - (box->Size() / 2 + buffer),
-                         center + (box->Size() / 2 + buffer)};
-
-                if (region.Intersects(performerVolume))
-                {
-                  newPerfLevels.insert(_entity);
-                  levelsToLoad.push_back(_entity);
-                }
-                else
-                {
-                  // If the level is active, check if the performer is
-                  // outside of the buffer of this level
-                  if (this->IsLevelActive(_entity))
-                  {
-                    if (outerRegion.Intersects(performerVolume))
-                    {
-                      newPerfLevels.insert(_entity);
-                      levelsToLoad.push_back(_entity);
-                      return true;
-                    }
-                    // Otherwise, mark the level to be unloaded
-                    levelsToUnload.push_back(_entity);
-                  }
-                }
-                return true;
-                });
+          // Check the nearby levels for intersections. Add all levels with
+          // intersections to the levelsToLoad even if they are currently
+          // active. Active levels are kept while the performer is within
+          // their buffer.
+          for (const std::size_t index : candidates.levels)
+          {
+            IGN_PROFILE("CheckPerformerAgainstLevel");
+            const auto &level = levels[index];
+            if (!this->runner->entityCompMgr.HasEntity(level.entity))
+            {
+              this->levelGridDirty = true;
+              continue;
+            }
+
+            if (level.region.Intersects(performerVolume) ||
+                (activeLevelSet.count(level.entity) > 0 &&
+                 level.outerRegion.Intersects(performerVolume)))
+            {
+              newPerfLevels.insert(level.entity);
+              levelsToLoad.push_back(level.entity);
+            }
+          }
+          performerLevels.insert(newPerfLevels.begin(), newPerfLevels.end());
 
           *_perfLevels = components::PerformerLevels(newPerfLevels);
 
+          if (!this->streaming)
+            return true;
+
+          // Estimate the performer's velocity from its last position, and
+          // prefetch the levels its volume sweeps through in the near future.
+          auto &motion = this->performerMotion[_perfEntity];
+          const auto simTime = this->runner->currentInfo.simTime;
+          if (simTime > motion.simTime)
+          {
+            if (motion.simTime.count() >= 0)
+            {
+              const double dt =
+                  std::chrono::duration<double>(simTime - motion.simTime)
+                  .count();
+              motion.velocity = (position - motion.position) / dt;
+            }
+            motion.position = position;
+            motion.simTime = simTime;
+          }
+
+          const math::Vector3d ahead = motion.velocity * kPrefetchTime;
+          if (ahead == math::Vector3d::Zero)
+            return true;
+
+          math::Vector3d sweptMin = performerVolume.Min() + ahead;
+          math::Vector3d sweptMax = performerVolume.Max() + ahead;
+          sweptMin.Min(performerVolume.Min());
+          sweptMax.Max(performerVolume.Max());
+          const math::AxisAlignedBox swept(sweptMin, sweptMax);
+
+          this->levelGrid.Query(swept, this->prefetchCandidates);
+          for (const std::size_t index : this->prefetchCandidates)
+          {
+            const auto &level = levels[index];
+            if (newPerfLevels.find(level.entity) == newPerfLevels.end() &&
+                level.region.Intersects(swept))
+            {
+              prefetchLevels.insert(level.entity);
+            }
+          }
+
           return true;
           });
+
+    // Active levels which no performer is within the buffer of are unloaded
+    if (hasPerformers)
+    {
+      for (const Entity level : this->activeLevels)
+      {
+        if (this->levelGrid.Contains(level) &&
+            this->runner->entityCompMgr.HasEntity(level) &&
+            performerLevels.find(level) == performerLevels.end())
+        {
+          levelsToUnload.push_back(level);
+        }
+      }
+    }
   }
 
   // Sort levelsToLoad and levelsToUnload so as to run std::unique on them.
@@ -771,6 +978,42 @@ void LevelManager::UpdateLevelsState()
   }
   // Erase from vector
   this->activeLevels.erase(pendingEnd, this->activeLevels.end());
+
+  if (this->streaming)
+  {
+    std::set<std::string> prefetchNames;
+    for (const Entity level : prefetchLevels)
+    {
+      if (!this->runner->entityCompMgr.HasEntity(level))
+        continue;
+
+      for (const auto &name : this->runner->entityCompMgr
+          .Component<components::LevelEntityNames>(level)->Data())
+      {
+        if (this->activeEntityNames.find(name) ==
+            this->activeEntityNames.end())
+        {
+          prefetchNames.insert(name);
+        }
+      }
+    }
+    this->StreamModels(prefetchNames);
+  }
+  // Levels which become active after the world is loaded are streamed.
+  // Distributed simulation requires entity IDs to match across processes,
+  // so entities must be created in the same step everywhere.
+  else if (this->useLevels && nullptr == this->runner->networkMgr &&
+      this->runner->serverConfig.LevelStreamingBudget() >
+      std::chrono::steady_clock::duration::zero())
+  {
+    this->streaming = true;
+    for (uint64_t modelIndex = 0;
+         modelIndex < this->runner->sdfWorld->ModelCount(); ++modelIndex)
+    {
+      auto model = this->runner->sdfWorld->ModelByIndex(modelIndex);
+      this->sdfModels[model->Name()] = model;
+    }
+  }
 }
 
 /////////////////////////////////////////////////
@@ -784,19 +1027,26 @@ void LevelManager::LoadActiveEntities(const std::set<std::string> &_namesToLoad)
     return;
   }
 
-  // Models
+  // Models, which are created in parallel
+  std::vector<const sdf::Model *> models;
   for (uint64_t modelIndex = 0;
        modelIndex < this->runner->sdfWorld->ModelCount(); ++modelIndex)
   {
     // There is no sdf::World::ModelByName so we have to iterate by index and
     // check if the model is in this level
     auto model = this->runner->sdfWorld->ModelByIndex(modelIndex);
-    if (_namesToLoad.find(model->Name()) != _namesToLoad.end())
-    {
-      Entity modelEntity = this->entityCreator->CreateEntities(model);
+    if (_namesToLoad.find(model->Name()) == _namesToLoad.end())
+      continue;
 
-      this->entityCreator->SetParent(modelEntity, this->worldEntity);
-    }
+    // Streamed models are added once they're staged
+    if (this->streaming)
+      this->modelsToAdd.insert(model->Name());
+    else
+      models.push_back(model);
+  }
+  for (auto modelEntity : this->entityCreator->CreateEntities(models))
+  {
+    this->entityCreator->SetParent(modelEntity, this->worldEntity);
   }
 
   // Actors
@@ -870,9 +1120,160 @@ void LevelManager::UnloadInactiveEntities(
   for (const auto &name : _namesToUnload)
   {
     this->activeEntityNames.erase(name);
+    this->modelsToAdd.erase(name);
   }
 }
 
+/////////////////////////////////////////////////
+void LevelManager::StageModels(const std::set<std::string> &_names)
+{
+  using StagedModelPtr = std::shared_ptr<SdfEntityCreator::StagedModel>;
+
+  std::vector<std::pair<const sdf::Model *, std::promise<StagedModelPtr>>>
+      batch;
+  for (const auto &name : _names)
+  {
+    if (this->stagedModels.find(name) != this->stagedModels.end())
+      continue;
+
+    auto model = this->sdfModels.find(name);
+    if (model == this->sdfModels.end())
+      continue;
+
+    std::promise<StagedModelPtr> promise;
+    this->stagedModels[name] = promise.get_future();
+    batch.emplace_back(model->second, std::move(promise));
+  }
+
+  if (batch.empty())
+    return;
+
+  // The models are staged in order, so the first ones can be added before
+  // the whole batch is staged.
+  this->stagingTasks.push_back(std::async(std::launch::async,
+      [batch = std::move(batch), stop = &this->stopStaging]() mutable
+      {
+        for (auto &[model, promise] : batch)
+        {
+          promise.set_value(
+              *stop ? nullptr : SdfEntityCreator::StageModel(model));
+        }
+      }));
+}
+
+/////////////////////////////////////////////////
+void LevelManager::StreamModels(const std::set<std::string> &_prefetchNames)
+{
+  IGN_PROFILE("LevelManager::StreamModels");
+
+  this->StageModels(this->modelsToAdd);
+  this->StageModels(_prefetchNames);
+
+  // Forget models which aren't needed anymore. Models being staged are
+  // dropped once they're ready.
+  for (auto it = this->stagedModels.begin(); it != this->stagedModels.end();)
+  {
+    if (this->modelsToAdd.find(it->first) == this->modelsToAdd.end() &&
+        _prefetchNames.find(it->first) == _prefetchNames.end())
+    {
+      it = this->stagedModels.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  this->stagingTasks.remove_if([](const std::future<void> &_task)
+      {
+        return _task.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready;
+      });
+
+  // Add staged models until the budget runs out, at least one per update
+  const auto start = std::chrono::steady_clock::now();
+  const auto budget = this->runner->serverConfig.LevelStreamingBudget();
+  for (auto it = this->modelsToAdd.begin(); it != this->modelsToAdd.end();)
+  {
+    auto staged = this->stagedModels.find(*it);
+    if (staged == this->stagedModels.end() ||
+        staged->second.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+    {
+      ++it;
+      continue;
+    }
+
+    auto model = staged->second.get();
+    this->stagedModels.erase(staged);
+    it = this->modelsToAdd.erase(it);
+    if (nullptr == model)
+      continue;
+
+    Entity modelEntity = this->entityCreator->CreateEntities(*model);
+    this->entityCreator->SetParent(modelEntity, this->worldEntity);
+
+    if (std::chrono::steady_clock::now() - start >= budget)
+      break;
+  }
+}
+
+/////////////////////////////////////////////////
+void LevelManager::UpdateLevelGrid()
+{
+  // Levels are usually only created when the world is loaded. Removed
+  // levels are found while checking performers.
+  this->runner->entityCompMgr.EachNew<components::Level, components::Pose,
+      components::Geometry, components::LevelBuffer>(
+      [&](const Entity &, const components::Level *,
+          const components::Pose *, const components::Geometry *,
+          const components::LevelBuffer *) -> bool
+      {
+        this->levelGridDirty = true;
+        return false;
+      });
+
+  if (!this->levelGridDirty)
+    return;
+
+  IGN_PROFILE("LevelManager::UpdateLevelGrid");
+
+  std::vector<LevelGrid::Level> levels;
+  this->runner->entityCompMgr.Each<components::Level, components::Pose,
+      components::Geometry, components::LevelBuffer>(
+      [&](const Entity &_entity, const components::Level *,
+          const components::Pose *_pose,
+          const components::Geometry *_levelGeometry,
+          const components::LevelBuffer *_levelBuffer) -> bool
+      {
+        // assume a box for now
+        auto box = _levelGeometry->Data().BoxShape();
+        if (nullptr == box)
+        {
+          ignerr << "Level [" << _entity << "]'s geometry is not a box."
+                 << std::endl;
+          return true;
+        }
+
+        const math::Vector3d &center = _pose->Data().Pos();
+        const math::Vector3d buffer(_levelBuffer->Data(), _levelBuffer->Data(),
+            _levelBuffer->Data());
+
+        LevelGrid::Level level;
+        level.entity = _entity;
+        level.region = math::AxisAlignedBox(center - box->Size() / 2,
+            center + box->Size() / 2);
+        level.outerRegion = math::AxisAlignedBox(
+            level.region.Min() - buffer, level.region.Max() + buffer);
+        levels.push_back(level);
+        return true;
+      });
+
+  this->levelGrid.Build(std::move(levels));
+  this->performerCandidates.clear();
+  this->levelGridDirty = false;
+}
+
 /////////////////////////////////////////////////
 bool LevelManager::IsLevelActive(const Entity _entity) const
 {
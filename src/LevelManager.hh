@@ -21,7 +21,11 @@
 #include <ignition/msgs/boolean.pb.h>
 #include <ignition/msgs/stringmsg.pb.h>
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <list>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -38,6 +42,8 @@
 #include "ignition/gazebo/SdfEntityCreator.hh"
 #include "ignition/gazebo/Types.hh"
 
+#include "LevelGrid.hh"
+
 namespace ignition
 {
   namespace gazebo
@@ -74,13 +80,25 @@ namespace ignition
     ///   when the level is reloaded. Likewise, they should not be deleted.
     /// * Entities spawned during simulation are part of the default level.
     ///
+    /// When streaming is enabled with ServerConfig::SetLevelStreamingBudget,
+    /// the models of levels which become active after the world is loaded
+    /// are converted to entities and components on a background thread, and
+    /// added over the following steps.
+    ///
     class IGNITION_GAZEBO_VISIBLE LevelManager
     {
       /// \brief Constructor
       /// \param[in] _runner A pointer to the simulationrunner that owns this
       /// \param[in] _useLevels Whether to use the levels defined. If false, all
       /// will only be loaded for active performers.
-      public: LevelManager(SimulationRunner *_runner, bool _useLevels = false);
+      /// \param[in] _restored True if the runner's entities were restored
+      /// from a snapshot with the default level already loaded, so they
+      /// shouldn't be created from SDF.
+      public: LevelManager(SimulationRunner *_runner, bool _useLevels = false,
+                  bool _restored = false);
+
+      /// \brief Destructor, which waits for models being staged.
+      public: ~LevelManager();
 
       /// \brief Load and unload levels
       /// This is where we compute intersections and determine if a performer is
@@ -102,6 +120,18 @@ namespace ignition
       /// object
       private: void ReadLevelPerformerInfo();
 
+      /// \brief Find the world, performers and default level among entities
+      /// restored from a snapshot, and fill the components holding SDF DOM
+      /// objects, which aren't serialized.
+      private: void RestoreLevelPerformerInfo();
+
+      /// \brief Fill the SDF DOM components of a restored model and its
+      /// nested models and sensors.
+      /// \param[in] _entity Model entity.
+      /// \param[in] _model The model's SDF DOM.
+      private: void RestoreModelSdf(const Entity _entity,
+          const sdf::Model *_model);
+
       /// \brief Create performers
       /// Assuming that a simulation runner is performer-centered
       private: void CreatePerformers();
@@ -120,6 +150,22 @@ namespace ignition
       /// schedule them to be loaded
       private: void ConfigureDefaultLevel();
 
+      /// \brief Rebuild the spatial index of levels if levels were created
+      /// or removed since it was last built.
+      private: void UpdateLevelGrid();
+
+      /// \brief Start converting models to entities and components on a
+      /// background thread, unless they're already being converted.
+      /// \param[in] _names Names of the models. Names which aren't models in
+      /// the world are ignored.
+      private: void StageModels(const std::set<std::string> &_names);
+
+      /// \brief Stage the models which will be needed soon, and add the
+      /// staged models of active levels within the streaming budget.
+      /// \param[in] _prefetchNames Names of entities in levels which
+      /// performers are heading towards.
+      private: void StreamModels(const std::set<std::string> &_prefetchNames);
+
       /// \brief Determine if a level is active
       /// \param[in] _entity Entity of level to be checked
       /// \return True of the level is currently active
@@ -178,6 +224,81 @@ namespace ignition
 
       /// \brief Mutex to protect performersToAdd list.
       private: std::mutex performerToAddMutex;
+
+      /// \brief Spatial index of the levels' regions.
+      private: LevelGrid levelGrid;
+
+      /// \brief True if the spatial index must be rebuilt.
+      private: bool levelGridDirty{true};
+
+      /// \brief Levels near a performer, found by querying the spatial index
+      /// with the performer's volume grown by a margin. They're valid until
+      /// the performer moves further than the margin.
+      private: struct PerformerCandidates
+      {
+        /// \brief Position of the performer when queried.
+        math::Vector3d position;
+
+        /// \brief Size of the performer's volume when queried.
+        math::Vector3d size;
+
+        /// \brief Margin the volume was grown by, negative until queried.
+        double margin{-1.0};
+
+        /// \brief Indices of the levels, see LevelGrid::Levels.
+        std::vector<std::size_t> levels;
+      };
+
+      /// \brief Levels near each performer.
+      private: std::unordered_map<Entity, PerformerCandidates>
+                   performerCandidates;
+
+      /// \brief Motion of a performer, estimated from its position at each
+      /// update.
+      private: struct PerformerMotion
+      {
+        /// \brief Position at the last update.
+        math::Vector3d position;
+
+        /// \brief Simulation time of the last update, negative until the
+        /// first one.
+        std::chrono::steady_clock::duration simTime{-1};
+
+        /// \brief Estimated linear velocity.
+        math::Vector3d velocity;
+      };
+
+      /// \brief Motion of each performer, only tracked while streaming.
+      private: std::unordered_map<Entity, PerformerMotion> performerMotion;
+
+      /// \brief Levels which performers are heading towards, found by
+      /// querying the spatial index. Kept to reuse its memory.
+      private: std::vector<std::size_t> prefetchCandidates;
+
+      /// \brief True if models of newly active levels are streamed, see
+      /// ServerConfig::SetLevelStreamingBudget. Levels active when the world
+      /// is loaded are always loaded synchronously.
+      private: bool streaming{false};
+
+      /// \brief SDF models of the world, by name, to stage them.
+      private: std::unordered_map<std::string, const sdf::Model *> sdfModels;
+
+      /// \brief Names of the models of active levels which haven't been
+      /// added yet.
+      private: std::set<std::string> modelsToAdd;
+
+      /// \brief Set to stop staging models, when the manager is destroyed.
+      /// Declared before stagingTasks, which are waited for first.
+      private: std::atomic<bool> stopStaging{false};
+
+      /// \brief Models being staged or staged, by name. A model is staged
+      /// once its future is ready.
+      private: std::map<std::string,
+                   std::future<std::shared_ptr<SdfEntityCreator::StagedModel>>>
+                   stagedModels;
+
+      /// \brief Background tasks staging models.
+      private: std::list<std::future<void>> stagingTasks;
     };
     }
   }
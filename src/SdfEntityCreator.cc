@@ -15,6 +15,10 @@
  *
 */
 
+#include <map>
+#include <memory>
+#include <unordered_map>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Profiler.hh>
 #include <sdf/Types.hh>
@@ -74,6 +78,8 @@
 #include "ignition/gazebo/components/WindMode.hh"
 #include "ignition/gazebo/components/World.hh"
 
+#include "ThreadPool.hh"
+
 class ignition::gazebo::SdfEntityCreatorPrivate
 {
   /// \brief Pointer to entity component manager. We don't assume ownership.
@@ -95,9 +101,69 @@ class ignition::gazebo::SdfEntityCreatorPrivate
   public: std::map<Entity, sdf::ElementPtr> newVisuals;
 };
 
+/// \brief A model converted to entities and components in a staging entity
+/// component manager of its own.
+class ignition::gazebo::SdfEntityCreator::StagedModel
+{
+  /// \brief Staging entity component manager holding the model.
+  public: EntityComponentManager ecm;
+
+  /// \brief Model entity in ecm.
+  public: Entity entity{kNullEntity};
+
+  /// \brief Models whose plugins are loaded once the model is added.
+  public: std::map<Entity, sdf::ElementPtr> newModels;
+
+  /// \brief Sensors whose plugins are loaded once the model is added.
+  public: std::map<Entity, sdf::ElementPtr> newSensors;
+
+  /// \brief Visuals whose plugins are loaded once the model is added.
+  public: std::map<Entity, sdf::ElementPtr> newVisuals;
+};
+
 using namespace ignition;
 using namespace gazebo;
 
+/////////////////////////////////////////////////
+/// \brief Get the new ID of a staged entity.
+/// \param[in] _newEntities Map returned by mergeStaged.
+/// \param[in] _entity Staged entity.
+/// \return New entity ID, or _entity if it wasn't staged.
+static Entity stagedToMerged(
+    const std::unordered_map<Entity, Entity> &_newEntities,
+    const Entity _entity)
+{
+  auto it = _newEntities.find(_entity);
+  return it == _newEntities.end() ? _entity : it->second;
+}
+
+/////////////////////////////////////////////////
+/// \brief Merge a staging entity component manager into another one and
+/// update the components which refer to the staged entities.
+/// \param[in] _ecm Entity component manager to merge into.
+/// \param[in] _staging Staging entity component manager.
+/// \return Map from the staged entity IDs to the new entity IDs.
+static std::unordered_map<Entity, Entity> mergeStaged(
+    EntityComponentManager &_ecm, const EntityComponentManager &_staging)
+{
+  auto newEntities = _ecm.Merge(_staging);
+
+  for (const auto &ids : newEntities)
+  {
+    auto parentComp = _ecm.Component<components::ParentEntity>(ids.second);
+    if (parentComp)
+      parentComp->Data() = stagedToMerged(newEntities, parentComp->Data());
+
+    auto canonicalLinkComp =
+        _ecm.Component<components::ModelCanonicalLink>(ids.second);
+    if (canonicalLinkComp)
+      canonicalLinkComp->Data() =
+          stagedToMerged(newEntities, canonicalLinkComp->Data());
+  }
+
+  return newEntities;
+}
+
 /////////////////////////////////////////////////
 /// \brief Resolve the pose of an SDF DOM object with respect to its relative_to
 /// frame. If that fails, return the raw pose
@@ -214,6 +280,8 @@ Entity SdfEntityCreator::CreateEntities(const sdf::World *_world)
 {
   IGN_PROFILE("SdfEntityCreator::CreateEntities(sdf::World)");
 
+  this->dataPtr->ecm->BeginBatch();
+
   // World entity
   Entity worldEntity = this->dataPtr->ecm->CreateEntity();
 
@@ -237,12 +305,14 @@ Entity SdfEntityCreator::CreateEntities(const sdf::World *_world)
   }
 
   // Models
+  std::vector<const sdf::Model *> models;
   for (uint64_t modelIndex = 0; modelIndex < _world->ModelCount();
       ++modelIndex)
   {
-    auto model = _world->ModelByIndex(modelIndex);
-    auto modelEntity = this->CreateEntities(model);
-
+    models.push_back(_world->ModelByIndex(modelIndex));
+  }
+  for (auto modelEntity : this->CreateEntities(models))
+  {
     this->SetParent(modelEntity, worldEntity);
   }
 
@@ -316,6 +386,7 @@ Entity SdfEntityCreator::CreateEntities(const sdf::World *_world)
   this->dataPtr->ecm->CreateComponent(
       worldEntity, components::WorldSdf(*_world));
 
+  this->dataPtr->ecm->EndBatch();
   return worldEntity;
 }
 
@@ -324,7 +395,10 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Model *_model)
 {
   IGN_PROFILE("SdfEntityCreator::CreateEntities(sdf::Model)");
 
+  // Views are updated once for the whole model, before plugins are loaded.
+  this->dataPtr->ecm->BeginBatch();
   auto ent = this->CreateEntities(_model, false);
+  this->dataPtr->ecm->EndBatch();
 
   // Load all model plugins afterwards, so we get scoped name for nested models.
   for (const auto &[entity, element] : this->dataPtr->newModels)
@@ -350,6 +424,88 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Model *_model)
   return ent;
 }
 
+//////////////////////////////////////////////////
+std::vector<Entity> SdfEntityCreator::CreateEntities(
+    const std::vector<const sdf::Model *> &_models)
+{
+  IGN_PROFILE("SdfEntityCreator::CreateEntities(std::vector<sdf::Model>)");
+
+  std::vector<Entity> modelEntities;
+  modelEntities.reserve(_models.size());
+
+  // A single model isn't worth staging
+  if (_models.size() < 2u)
+  {
+    for (const auto *model : _models)
+      modelEntities.push_back(this->CreateEntities(model));
+    return modelEntities;
+  }
+
+  // Convert each model into a staging manager of its own in parallel
+  std::vector<std::shared_ptr<StagedModel>> staged(_models.size());
+  {
+    IGN_PROFILE("Staging");
+    ThreadPool::Shared().ParallelFor(_models.size(), 1,
+        [&](std::size_t _begin, std::size_t _end)
+        {
+          for (std::size_t i = _begin; i < _end; ++i)
+            staged[i] = StageModel(_models[i]);
+        });
+  }
+
+  // Then merge them one at a time, loading each model's plugins before
+  // merging the next one, so plugins see the same world, and entities get
+  // the same IDs, as when creating models one at a time.
+  for (auto &model : staged)
+  {
+    modelEntities.push_back(this->CreateEntities(*model));
+    model.reset();
+  }
+
+  return modelEntities;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SdfEntityCreator::StagedModel> SdfEntityCreator::StageModel(
+    const sdf::Model *_model)
+{
+  IGN_PROFILE("SdfEntityCreator::StageModel");
+
+  auto staged = std::make_shared<StagedModel>();
+
+  // Plugins aren't loaded from the staging creator, so its events go nowhere
+  EventManager eventManager;
+  SdfEntityCreator creator(staged->ecm, eventManager);
+  staged->entity = creator.CreateEntities(_model, false);
+  staged->newModels.swap(creator.dataPtr->newModels);
+  staged->newSensors.swap(creator.dataPtr->newSensors);
+  staged->newVisuals.swap(creator.dataPtr->newVisuals);
+
+  return staged;
+}
+
+//////////////////////////////////////////////////
+Entity SdfEntityCreator::CreateEntities(const StagedModel &_staged)
+{
+  IGN_PROFILE("SdfEntityCreator::CreateEntities(StagedModel)");
+
+  auto newEntities = mergeStaged(*this->dataPtr->ecm, _staged.ecm);
+
+  // Load plugins in the same order as when creating the model directly
+  for (const auto *entities :
+      {&_staged.newModels, &_staged.newSensors, &_staged.newVisuals})
+  {
+    std::map<Entity, sdf::ElementPtr> merged;
+    for (const auto &[entity, element] : *entities)
+      merged[stagedToMerged(newEntities, entity)] = element;
+
+    for (const auto &[entity, element] : merged)
+      this->dataPtr->eventManager->Emit<events::LoadPlugins>(entity, element);
+  }
+
+  return stagedToMerged(newEntities, _staged.entity);
+}
+
 //////////////////////////////////////////////////
 Entity SdfEntityCreator::CreateEntities(const sdf::Model *_model,
                                         bool _staticParent)
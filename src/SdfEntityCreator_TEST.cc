@@ -51,6 +51,7 @@
 #include "ignition/gazebo/components/Visibility.hh"
 #include "ignition/gazebo/components/Visual.hh"
 #include "ignition/gazebo/components/World.hh"
+#include "ignition/gazebo/Events.hh"
 #include "ignition/gazebo/SdfEntityCreator.hh"
 
 using namespace ignition;
@@ -1273,3 +1274,118 @@ TEST_F(SdfEntityCreatorTest, EachRemovedRecursiveRemoved)
   EXPECT_EQ(0u, removedCount<components::Collision>(ecm));
   EXPECT_EQ(0u, removedCount<components::Visual>(ecm));
 }
+
+/////////////////////////////////////////////////
+TEST_F(SdfEntityCreatorTest, CreateModelsInParallel)
+{
+  // Load SDF file with nested models
+  sdf::Root root;
+  root.Load(std::string(PROJECT_SOURCE_PATH) +
+      "/test/worlds/nested_model_canonical_link.sdf");
+  ASSERT_EQ(1u, root.WorldCount());
+  const auto *world = root.WorldByIndex(0);
+  ASSERT_LT(1u, world->ModelCount());
+
+  std::vector<const sdf::Model *> models;
+  for (uint64_t i = 0; i < world->ModelCount(); ++i)
+    models.push_back(world->ModelByIndex(i));
+
+  // Create models one at a time
+  EntityCompMgrTest serialEcm;
+  EventManager serialEvm;
+  SdfEntityCreator serialCreator(serialEcm, serialEvm);
+  std::vector<Entity> serialEntities;
+  for (const auto *model : models)
+    serialEntities.push_back(serialCreator.CreateEntities(model));
+
+  // Create models in parallel
+  SdfEntityCreator creator(this->ecm, evm);
+  auto entities = creator.CreateEntities(models);
+
+  // Entities and their hierarchy are the same
+  EXPECT_EQ(serialEntities, entities);
+  ASSERT_EQ(serialEcm.EntityCount(), this->ecm.EntityCount());
+  for (Entity entity = 1; entity <= this->ecm.EntityCount(); ++entity)
+  {
+    EXPECT_EQ(serialEcm.ParentEntity(entity), this->ecm.ParentEntity(entity));
+
+    auto serialName = serialEcm.Component<components::Name>(entity);
+    auto name = this->ecm.Component<components::Name>(entity);
+    ASSERT_EQ(nullptr == serialName, nullptr == name);
+    if (name)
+      EXPECT_EQ(serialName->Data(), name->Data());
+
+    auto serialParent = serialEcm.Component<components::ParentEntity>(entity);
+    auto parent = this->ecm.Component<components::ParentEntity>(entity);
+    ASSERT_EQ(nullptr == serialParent, nullptr == parent);
+    if (parent)
+      EXPECT_EQ(serialParent->Data(), parent->Data());
+
+    auto serialCanonical =
+        serialEcm.Component<components::ModelCanonicalLink>(entity);
+    auto canonical = this->ecm.Component<components::ModelCanonicalLink>(
+        entity);
+    ASSERT_EQ(nullptr == serialCanonical, nullptr == canonical);
+    if (canonical)
+      EXPECT_EQ(serialCanonical->Data(), canonical->Data());
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(SdfEntityCreatorTest, CreateModelsInParallelWithPlugins)
+{
+  sdf::Root root;
+  root.Load(std::string(PROJECT_SOURCE_PATH) +
+      "/test/worlds/nested_model_canonical_link.sdf");
+  ASSERT_EQ(1u, root.WorldCount());
+  const auto *world = root.WorldByIndex(0);
+  ASSERT_LT(1u, world->ModelCount());
+
+  std::vector<const sdf::Model *> models;
+  for (uint64_t i = 0; i < world->ModelCount(); ++i)
+    models.push_back(world->ModelByIndex(i));
+
+  // Plugins which create an entity when they're configured, and record how
+  // many models existed then
+  auto connectPlugins = [](EventManager &_evm, EntityComponentManager &_ecm,
+      std::vector<std::size_t> &_modelCounts)
+  {
+    return _evm.Connect<events::LoadPlugins>(
+        [&](const Entity _entity, const sdf::ElementPtr &)
+        {
+          _modelCounts.push_back(_ecm.EntitiesByComponents(
+              components::Model()).size());
+          auto entity = _ecm.CreateEntity();
+          _ecm.CreateComponent(entity,
+              components::Name("plugin_" + std::to_string(_entity)));
+        });
+  };
+
+  EntityCompMgrTest serialEcm;
+  EventManager serialEvm;
+  std::vector<std::size_t> serialCounts;
+  auto serialConn = connectPlugins(serialEvm, serialEcm, serialCounts);
+  SdfEntityCreator serialCreator(serialEcm, serialEvm);
+  std::vector<Entity> serialEntities;
+  for (const auto *model : models)
+    serialEntities.push_back(serialCreator.CreateEntities(model));
+
+  std::vector<std::size_t> counts;
+  auto conn = connectPlugins(evm, this->ecm, counts);
+  SdfEntityCreator creator(this->ecm, evm);
+  auto entities = creator.CreateEntities(models);
+
+  // Plugins are loaded model by model, so they see the same models, and the
+  // entities they create get the same IDs
+  EXPECT_EQ(serialCounts, counts);
+  EXPECT_EQ(serialEntities, entities);
+  ASSERT_EQ(serialEcm.EntityCount(), this->ecm.EntityCount());
+  for (Entity entity = 1; entity <= this->ecm.EntityCount(); ++entity)
+  {
+    auto serialName = serialEcm.Component<components::Name>(entity);
+    auto name = this->ecm.Component<components::Name>(entity);
+    ASSERT_EQ(nullptr == serialName, nullptr == name);
+    if (name)
+      EXPECT_EQ(serialName->Data(), name->Data());
+  }
+}
@@ -29,6 +29,8 @@
 
 #include "ServerPrivate.hh"
 #include "SimulationRunner.hh"
+#include "ThreadPool.hh"
+#include "WorldSnapshot.hh"
 
 using namespace ignition;
 using namespace gazebo;
@@ -98,8 +100,26 @@ Server::Server(const ServerConfig &_config)
 
   sdf::Errors errors;
 
-  // Load a world if specified. Check SDF string first, then SDF file
-  if (!_config.SdfString().empty())
+  // Load a world if specified. Check for a snapshot first, then SDF string,
+  // then SDF file
+  std::unique_ptr<WorldSnapshot> snapshot;
+  if (!_config.SnapshotPath().empty())
+  {
+    snapshot = std::make_unique<WorldSnapshot>();
+    if (!snapshot->Load(_config.SnapshotPath()))
+      return;
+
+    ignmsg << "Loading world snapshot [" << _config.SnapshotPath() << "].\n";
+    errors = this->dataPtr->sdfRoot.LoadSdfString(snapshot->WorldSdf());
+
+    if (_config.UseLevels())
+    {
+      ignwarn << "World snapshots can't be restored when using levels, "
+              << "creating the world from the snapshot's SDF instead.\n";
+      snapshot.reset();
+    }
+  }
+  else if (!_config.SdfString().empty())
   {
     std::string msg = "Loading SDF string. ";
     if (_config.SdfFile().empty())
@@ -190,7 +210,7 @@ Server::Server(const ServerConfig &_config)
     this->dataPtr->AddRecordPlugin(_config);
   }
 
-  this->dataPtr->CreateEntities();
+  this->dataPtr->CreateEntities(snapshot.get());
 
   // Set the desired update period, this will override the desired RTF given in
   // the world file which was parsed by CreateEntities.
@@ -265,6 +285,58 @@ bool Server::RunOnce(const bool _paused)
   return this->Run(true, 1, _paused);
 }
 
+/////////////////////////////////////////////////
+bool Server::StepWorlds(const uint64_t _steps)
+{
+  std::vector<double> observations;
+  return this->StepWorlds(_steps, 0u, nullptr, observations);
+}
+
+/////////////////////////////////////////////////
+bool Server::StepWorlds(const uint64_t _steps,
+    const std::size_t _observationSize, const ObserveCallback &_observe,
+    std::vector<double> &_observations)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->runMutex);
+    if (this->dataPtr->running)
+    {
+      ignwarn << "The server is already running.\n";
+      return false;
+    }
+    this->dataPtr->running = true;
+  }
+
+  auto &runners = this->dataPtr->simRunners;
+  if (_steps > 0)
+  {
+    for (std::unique_ptr<SimulationRunner> &runner : runners)
+      runner->SetPaused(false);
+    this->dataPtr->StepWorlds(_steps, false);
+  }
+
+  if (_observe)
+  {
+    _observations.resize(runners.size() * _observationSize);
+    ThreadPool::Shared().ParallelFor(runners.size(), 1,
+        [&](std::size_t _begin, std::size_t _end)
+        {
+          for (std::size_t i = _begin; i < _end; ++i)
+          {
+            _observe(static_cast<unsigned int>(i),
+                runners[i]->EntityCompMgr(),
+                _observations.data() + i * _observationSize);
+          }
+        });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->runMutex);
+    this->dataPtr->running = false;
+  }
+  return true;
+}
+
 /////////////////////////////////////////////////
 void Server::SetUpdatePeriod(
     const std::chrono::steady_clock::duration &_updatePeriod,
@@ -301,6 +373,18 @@ bool Server::SetPaused(const bool _paused,
   return false;
 }
 
+//////////////////////////////////////////////////
+bool Server::Reset(const unsigned int _worldIndex) const
+{
+  if (_worldIndex < this->dataPtr->simRunners.size())
+  {
+    this->dataPtr->simRunners[_worldIndex]->Reset();
+    return true;
+  }
+
+  return false;
+}
+
 //////////////////////////////////////////////////
 std::optional<bool> Server::Paused(const unsigned int _worldIndex) const
 {
@@ -376,6 +460,27 @@ std::optional<bool> Server::AddSystem(const std::shared_ptr<System> &_system,
   return std::nullopt;
 }
 
+//////////////////////////////////////////////////
+bool Server::SaveSnapshot(const std::string &_path,
+    const unsigned int _worldIndex)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->runMutex);
+  if (this->dataPtr->running)
+  {
+    ignerr << "Cannot save a snapshot while the server is running.\n";
+    return false;
+  }
+
+  if (_worldIndex >= this->dataPtr->simRunners.size())
+    return false;
+
+  if (!this->dataPtr->simRunners[_worldIndex]->SaveSnapshot(_path))
+    return false;
+
+  ignmsg << "Saved world snapshot [" << _path << "].\n";
+  return true;
+}
+
 //////////////////////////////////////////////////
 bool Server::HasEntity(const std::string &_name,
                        const unsigned int _worldIndex) const
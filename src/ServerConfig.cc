@@ -18,6 +18,8 @@
 
 #include <tinyxml2.h>
 
+#include <algorithm>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
 #include <ignition/common/Util.hh>
@@ -235,7 +237,17 @@ class ignition::gazebo::ServerConfigPrivate
             plugins(_cfg->plugins),
             networkRole(_cfg->networkRole),
             networkSecondaries(_cfg->networkSecondaries),
+            networkPipelined(_cfg->networkPipelined),
             seed(_cfg->seed),
+            systemThreadCount(_cfg->systemThreadCount),
+            stateThreadCount(_cfg->stateThreadCount),
+            binaryStateSerialization(_cfg->binaryStateSerialization),
+            pacing(_cfg->pacing),
+            maxCatchUpSteps(_cfg->maxCatchUpSteps),
+            stepBatchSize(_cfg->stepBatchSize),
+            snapshotPath(_cfg->snapshotPath),
+            worldCopies(_cfg->worldCopies),
+            levelStreamingBudget(_cfg->levelStreamingBudget),
             logRecordTopics(_cfg->logRecordTopics) { }
 
   // \brief The SDF file that the server should load
@@ -293,9 +305,41 @@ class ignition::gazebo::ServerConfigPrivate
   /// \brief The number of network secondaries.
   public: unsigned int networkSecondaries = 0;
 
+  /// \brief Whether the network primary pipelines steps with secondaries.
+  public: bool networkPipelined{false};
+
   /// \brief The given random seed.
   public: unsigned int seed = 0;
 
+  /// \brief An optional number of worker threads to update systems.
+  public: std::optional<unsigned int> systemThreadCount;
+
+  /// \brief An optional number of worker threads to serialize states.
+  public: std::optional<unsigned int> stateThreadCount;
+
+  /// \brief Whether serialized states use binary serialization.
+  public: bool binaryStateSerialization{false};
+
+  /// \brief Strategy to pace simulation steps.
+  public: ServerConfig::PacingStrategy pacing{
+      ServerConfig::PacingStrategy::Sleep};
+
+  /// \brief Maximum number of steps to catch up with the CatchUp strategy.
+  public: unsigned int maxCatchUpSteps{10};
+
+  /// \brief Number of steps over which housekeeping is spread.
+  public: unsigned int stepBatchSize{1};
+
+  /// \brief Path to a world snapshot to restore instead of loading SDF.
+  public: std::string snapshotPath = "";
+
+  /// \brief Number of copies of the first world.
+  public: unsigned int worldCopies{1};
+
+  /// \brief Time per step to add streamed level models, zero to load
+  /// levels synchronously.
+  public: std::chrono::steady_clock::duration levelStreamingBudget{0};
+
   /// \brief Timestamp that marks when this ServerConfig was created.
   public: std::chrono::time_point<std::chrono::system_clock> timestamp;
 
@@ -409,6 +453,18 @@ std::string ServerConfig::NetworkRole() const
   return this->dataPtr->networkRole;
 }
 
+/////////////////////////////////////////////////
+void ServerConfig::SetNetworkPipelined(bool _pipelined)
+{
+  this->dataPtr->networkPipelined = _pipelined;
+}
+
+/////////////////////////////////////////////////
+bool ServerConfig::NetworkPipelined() const
+{
+  return this->dataPtr->networkPipelined;
+}
+
 /////////////////////////////////////////////////
 bool ServerConfig::UseDistributedSimulation() const
 {
@@ -502,6 +558,116 @@ void ServerConfig::SetSeed(unsigned int _seed)
   ignition::math::Rand::Seed(_seed);
 }
 
+/////////////////////////////////////////////////
+void ServerConfig::SetSystemThreadCount(unsigned int _threads)
+{
+  this->dataPtr->systemThreadCount = _threads;
+}
+
+/////////////////////////////////////////////////
+std::optional<unsigned int> ServerConfig::SystemThreadCount() const
+{
+  return this->dataPtr->systemThreadCount;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetStateThreadCount(unsigned int _threads)
+{
+  this->dataPtr->stateThreadCount = _threads;
+}
+
+/////////////////////////////////////////////////
+std::optional<unsigned int> ServerConfig::StateThreadCount() const
+{
+  return this->dataPtr->stateThreadCount;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetBinaryStateSerialization(bool _binary)
+{
+  this->dataPtr->binaryStateSerialization = _binary;
+}
+
+/////////////////////////////////////////////////
+bool ServerConfig::BinaryStateSerialization() const
+{
+  return this->dataPtr->binaryStateSerialization;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetPacing(PacingStrategy _strategy)
+{
+  this->dataPtr->pacing = _strategy;
+}
+
+/////////////////////////////////////////////////
+ServerConfig::PacingStrategy ServerConfig::Pacing() const
+{
+  return this->dataPtr->pacing;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetMaxCatchUpSteps(unsigned int _steps)
+{
+  this->dataPtr->maxCatchUpSteps = _steps;
+}
+
+/////////////////////////////////////////////////
+unsigned int ServerConfig::MaxCatchUpSteps() const
+{
+  return this->dataPtr->maxCatchUpSteps;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetStepBatchSize(unsigned int _steps)
+{
+  this->dataPtr->stepBatchSize = std::max(1u, _steps);
+}
+
+/////////////////////////////////////////////////
+unsigned int ServerConfig::StepBatchSize() const
+{
+  return this->dataPtr->stepBatchSize;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetSnapshotPath(const std::string &_path)
+{
+  this->dataPtr->snapshotPath = _path;
+}
+
+/////////////////////////////////////////////////
+const std::string &ServerConfig::SnapshotPath() const
+{
+  return this->dataPtr->snapshotPath;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetWorldCopies(unsigned int _copies)
+{
+  this->dataPtr->worldCopies = std::max(1u, _copies);
+}
+
+/////////////////////////////////////////////////
+unsigned int ServerConfig::WorldCopies() const
+{
+  return this->dataPtr->worldCopies;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetLevelStreamingBudget(
+    const std::chrono::steady_clock::duration &_budget)
+{
+  this->dataPtr->levelStreamingBudget =
+      std::max(std::chrono::steady_clock::duration::zero(), _budget);
+}
+
+/////////////////////////////////////////////////
+std::chrono::steady_clock::duration ServerConfig::LevelStreamingBudget() const
+{
+  return this->dataPtr->levelStreamingBudget;
+}
+
 /////////////////////////////////////////////////
 const std::string &ServerConfig::ResourceCache() const
 {
@@ -17,6 +17,8 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+
 #include <ignition/common/Console.hh>
 #include <ignition/gazebo/ServerConfig.hh>
 #include <ignition/gazebo/Util.hh>
@@ -228,3 +230,145 @@ TEST(ServerConfig, GenerateRecordPlugin)
   EXPECT_EQ(plugin.Name(), "ignition::gazebo::systems::LogRecord");
 }
 
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, SystemThreadCount)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.SystemThreadCount());
+
+  config.SetSystemThreadCount(3u);
+  ASSERT_TRUE(config.SystemThreadCount());
+  EXPECT_EQ(3u, *config.SystemThreadCount());
+
+  config.SetSystemThreadCount(0u);
+  ASSERT_TRUE(config.SystemThreadCount());
+  EXPECT_EQ(0u, *config.SystemThreadCount());
+
+  ServerConfig copy(config);
+  ASSERT_TRUE(copy.SystemThreadCount());
+  EXPECT_EQ(0u, *copy.SystemThreadCount());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, BinaryStateSerialization)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.BinaryStateSerialization());
+
+  config.SetBinaryStateSerialization(true);
+  EXPECT_TRUE(config.BinaryStateSerialization());
+
+  ServerConfig copy(config);
+  EXPECT_TRUE(copy.BinaryStateSerialization());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, StateThreadCount)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.StateThreadCount());
+
+  config.SetStateThreadCount(2u);
+  ASSERT_TRUE(config.StateThreadCount());
+  EXPECT_EQ(2u, *config.StateThreadCount());
+
+  ServerConfig copy(config);
+  ASSERT_TRUE(copy.StateThreadCount());
+  EXPECT_EQ(2u, *copy.StateThreadCount());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, Pacing)
+{
+  ServerConfig config;
+  EXPECT_EQ(ServerConfig::PacingStrategy::Sleep, config.Pacing());
+  EXPECT_EQ(10u, config.MaxCatchUpSteps());
+
+  config.SetPacing(ServerConfig::PacingStrategy::CatchUp);
+  config.SetMaxCatchUpSteps(3u);
+  EXPECT_EQ(ServerConfig::PacingStrategy::CatchUp, config.Pacing());
+  EXPECT_EQ(3u, config.MaxCatchUpSteps());
+
+  ServerConfig copy(config);
+  EXPECT_EQ(ServerConfig::PacingStrategy::CatchUp, copy.Pacing());
+  EXPECT_EQ(3u, copy.MaxCatchUpSteps());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, StepBatchSize)
+{
+  ServerConfig config;
+  EXPECT_EQ(1u, config.StepBatchSize());
+
+  config.SetStepBatchSize(8u);
+  EXPECT_EQ(8u, config.StepBatchSize());
+
+  ServerConfig copy(config);
+  EXPECT_EQ(8u, copy.StepBatchSize());
+
+  config.SetStepBatchSize(0u);
+  EXPECT_EQ(1u, config.StepBatchSize());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, NetworkPipelined)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.NetworkPipelined());
+
+  config.SetNetworkPipelined(true);
+  EXPECT_TRUE(config.NetworkPipelined());
+
+  ServerConfig copy(config);
+  EXPECT_TRUE(copy.NetworkPipelined());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, SnapshotPath)
+{
+  ServerConfig config;
+  EXPECT_TRUE(config.SnapshotPath().empty());
+
+  config.SetSnapshotPath("/tmp/world.snapshot");
+  EXPECT_EQ("/tmp/world.snapshot", config.SnapshotPath());
+
+  ServerConfig copy(config);
+  EXPECT_EQ("/tmp/world.snapshot", copy.SnapshotPath());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, WorldCopies)
+{
+  ServerConfig config;
+  EXPECT_EQ(1u, config.WorldCopies());
+
+  config.SetWorldCopies(8u);
+  EXPECT_EQ(8u, config.WorldCopies());
+
+  ServerConfig copy(config);
+  EXPECT_EQ(8u, copy.WorldCopies());
+
+  config.SetWorldCopies(0u);
+  EXPECT_EQ(1u, config.WorldCopies());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, LevelStreamingBudget)
+{
+  using namespace std::chrono_literals;
+
+  ServerConfig config;
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(),
+      config.LevelStreamingBudget());
+
+  config.SetLevelStreamingBudget(2ms);
+  EXPECT_EQ(2ms, config.LevelStreamingBudget());
+
+  ServerConfig copy(config);
+  EXPECT_EQ(2ms, copy.LevelStreamingBudget());
+
+  config.SetLevelStreamingBudget(-1ms);
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(),
+      config.LevelStreamingBudget());
+}
@@ -30,6 +30,7 @@
 
 #include "ignition/gazebo/Util.hh"
 #include "SimulationRunner.hh"
+#include "ThreadPool.hh"
 
 using namespace ignition;
 using namespace gazebo;
@@ -164,6 +165,10 @@ bool ServerPrivate::Run(const uint64_t _iterations,
   {
     result = this->simRunners[0]->Run(_iterations);
   }
+  else if (this->config.WorldCopies() > 1u)
+  {
+    this->StepWorlds(_iterations, true);
+  }
   else
   {
     for (std::unique_ptr<SimulationRunner> &runner : this->simRunners)
@@ -182,6 +187,27 @@ bool ServerPrivate::Run(const uint64_t _iterations,
   return result;
 }
 
+/////////////////////////////////////////////////
+void ServerPrivate::StepWorlds(const uint64_t _steps, const bool _paced)
+{
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve(this->simRunners.size());
+  for (std::unique_ptr<SimulationRunner> &runner : this->simRunners)
+  {
+    SimulationRunner *runnerPtr = runner.get();
+    tasks.push_back([runnerPtr, _paced]()
+        {
+          runnerPtr->Run(1, _paced);
+        });
+  }
+
+  for (uint64_t step = 0; this->running && (_steps == 0 || step < _steps);
+       ++step)
+  {
+    ThreadPool::Shared().Run(tasks);
+  }
+}
+
 //////////////////////////////////////////////////
 sdf::ElementPtr GetRecordPluginElem(sdf::Root &_sdfRoot)
 {
@@ -297,7 +323,7 @@ void ServerPrivate::AddRecordPlugin(const ServerConfig &_config)
 }
 
 //////////////////////////////////////////////////
-void ServerPrivate::CreateEntities()
+void ServerPrivate::CreateEntities(const WorldSnapshot *_snapshot)
 {
   // Create a simulation runner for each world.
   for (uint64_t worldIndex = 0; worldIndex <
@@ -309,11 +335,47 @@ void ServerPrivate::CreateEntities()
       std::lock_guard<std::mutex> lock(this->worldsMutex);
       this->worldNames.push_back(world->Name());
     }
+    // Snapshots hold a single world
     auto runner = std::make_unique<SimulationRunner>(
-        world, this->systemLoader, this->config);
+        world, this->systemLoader, this->config,
+        worldIndex == 0 ? _snapshot : nullptr);
     runner->SetFuelUriMap(this->fuelUriMap);
     this->simRunners.push_back(std::move(runner));
   }
+
+  const unsigned int copies = this->config.WorldCopies();
+  if (copies <= 1u || this->sdfRoot.WorldCount() == 0)
+    return;
+
+  if (this->config.UseDistributedSimulation())
+  {
+    ignwarn << "World copies aren't supported with distributed simulation, "
+            << "ignoring them." << std::endl;
+    return;
+  }
+
+  // Copies get their own names, so their entities and transport topics
+  // don't clash with the first world's.
+  auto world = this->sdfRoot.WorldByIndex(0);
+  for (unsigned int i = 1; i < copies; ++i)
+  {
+    auto copy = std::make_unique<sdf::World>(*world);
+    copy->SetName(world->Name() + "_" + std::to_string(i));
+
+    {
+      std::lock_guard<std::mutex> lock(this->worldsMutex);
+      this->worldNames.push_back(copy->Name());
+    }
+
+    auto runner = std::make_unique<SimulationRunner>(
+        copy.get(), this->systemLoader, this->config, _snapshot);
+    runner->SetFuelUriMap(this->fuelUriMap);
+    this->simRunners.push_back(std::move(runner));
+    this->worldCopies.push_back(std::move(copy));
+  }
+
+  ignmsg << "Created [" << copies - 1 << "] copies of world ["
+         << world->Name() << "]." << std::endl;
 }
 
 //////////////////////////////////////////////////
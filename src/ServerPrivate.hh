@@ -31,6 +31,7 @@
 #include <vector>
 
 #include <sdf/Root.hh>
+#include <sdf/World.hh>
 
 #include <ignition/common/SignalHandler.hh>
 #include <ignition/common/URI.hh>
@@ -54,6 +55,7 @@ namespace ignition
     // Inline bracket to help doxygen filtering.
     inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     class SimulationRunner;
+    class WorldSnapshot;
 
     // Private data for Server
     class IGNITION_GAZEBO_HIDDEN ServerPrivate
@@ -75,8 +77,19 @@ namespace ignition
       /// \param[in] _config Server configuration parameters.
       public: void AddRecordPlugin(const ServerConfig &_config);
 
-      /// \brief Create all entities that exist in the sdf::Root object.
-      public: void CreateEntities();
+      /// \brief Create all entities that exist in the sdf::Root object, and
+      /// the copies of the first world, see ServerConfig::SetWorldCopies.
+      /// \param[in] _snapshot Snapshot to restore the first world and its
+      /// copies from instead, or null.
+      public: void CreateEntities(const WorldSnapshot *_snapshot = nullptr);
+
+      /// \brief Step all the simulation runners in lockstep on the shared
+      /// thread pool. Each step is a batch of one task per runner, so no
+      /// runner starts a step before all of them finished the previous one.
+      /// \param[in] _steps Number of steps, 0 to step until stopped.
+      /// \param[in] _paced False to start each step as soon as the previous
+      /// one finished, instead of pacing steps to the update period.
+      public: void StepWorlds(const uint64_t _steps, const bool _paced);
 
       /// \brief Stop server.
       public: void Stop();
@@ -142,6 +155,10 @@ namespace ignition
       /// pointer to child nodes of the root
       public: sdf::Root sdfRoot;
 
+      /// \brief Copies of the first world in sdfRoot, renamed, see
+      /// ServerConfig::SetWorldCopies.
+      public: std::vector<std::unique_ptr<sdf::World>> worldCopies;
+
       /// \brief The server configuration.
       public: ServerConfig config;
 
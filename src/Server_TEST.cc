@@ -16,8 +16,14 @@
 */
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
 #include <vector>
+#include <ignition/common/Filesystem.hh>
 #include <ignition/common/StringUtils.hh>
 #include <ignition/common/Util.hh>
 #include <ignition/math/Rand.hh>
@@ -27,6 +33,8 @@
 #include "ignition/gazebo/components/AxisAlignedBox.hh"
 #include "ignition/gazebo/components/Geometry.hh"
 #include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
 #include "ignition/gazebo/System.hh"
@@ -287,6 +295,217 @@ TEST_P(ServerFixture, SdfServerConfig)
   EXPECT_FALSE(server.HasEntity("bad", 1));
 }
 
+/////////////////////////////////////////////////
+TEST_P(ServerFixture, Snapshot)
+{
+  auto snapshotPath = common::joinPaths(
+      std::string(PROJECT_BINARY_PATH), "shapes.snapshot");
+
+  {
+    ServerConfig serverConfig;
+    serverConfig.SetSdfFile(std::string(PROJECT_SOURCE_PATH) +
+        "/test/worlds/shapes.sdf");
+
+    gazebo::Server server(serverConfig);
+    EXPECT_EQ(24u, *server.EntityCount());
+    EXPECT_FALSE(server.SaveSnapshot(snapshotPath, 1));
+    EXPECT_TRUE(server.SaveSnapshot(snapshotPath));
+  }
+
+  ServerConfig serverConfig;
+  serverConfig.SetSnapshotPath(snapshotPath);
+
+  {
+    gazebo::Server server(serverConfig);
+    EXPECT_EQ(24u, *server.EntityCount());
+    EXPECT_EQ(3u, *server.SystemCount());
+    EXPECT_TRUE(server.HasEntity("box"));
+    EXPECT_TRUE(server.HasEntity("sphere"));
+    EXPECT_TRUE(server.HasEntity("ellipsoid"));
+
+    // The restored world runs
+    EXPECT_TRUE(server.Run(true, 10, false));
+    EXPECT_EQ(10u, *server.IterationCount());
+    EXPECT_EQ(24u, *server.EntityCount());
+  }
+
+  // Copies restored from the same snapshot get their own world names
+  {
+    ServerConfig copiesConfig(serverConfig);
+    copiesConfig.SetWorldCopies(2);
+    gazebo::Server server(copiesConfig);
+    EXPECT_TRUE(server.HasEntity("default", 0));
+    EXPECT_FALSE(server.HasEntity("default", 1));
+    EXPECT_TRUE(server.HasEntity("default_1", 1));
+    EXPECT_TRUE(server.HasEntity("box", 1));
+    EXPECT_TRUE(server.StepWorlds(5));
+    EXPECT_EQ(5u, *server.IterationCount(1));
+  }
+
+  // Corrupt the version of the entities, which are stored last, prefixed
+  // by their size
+  std::string contents;
+  {
+    std::ifstream file(snapshotPath, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  bool corrupted{false};
+  for (std::size_t i = contents.size() - sizeof(uint64_t); i > 0; --i)
+  {
+    uint64_t ecmBytes;
+    std::memcpy(&ecmBytes, &contents[i], sizeof(uint64_t));
+    if (ecmBytes == contents.size() - i - sizeof(uint64_t))
+    {
+      contents[i + sizeof(uint64_t)] ^= 0x7f;
+      corrupted = true;
+      break;
+    }
+  }
+  ASSERT_TRUE(corrupted);
+  {
+    std::ofstream file(snapshotPath, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  }
+
+  // The world is created from the snapshot's SDF instead
+  gazebo::Server fallback(serverConfig);
+  EXPECT_EQ(24u, *fallback.EntityCount());
+  EXPECT_TRUE(fallback.HasEntity("box"));
+  EXPECT_TRUE(fallback.Run(true, 10, false));
+  EXPECT_EQ(10u, *fallback.IterationCount());
+
+  common::removeFile(snapshotPath);
+}
+
+/////////////////////////////////////////////////
+/// \brief System which changes the world once, and records resets.
+class ResettableSystem :
+  public System,
+  public ISystemPreUpdate,
+  public ISystemPostUpdate,
+  public ISystemReset
+{
+  public: void PreUpdate(const UpdateInfo &,
+              EntityComponentManager &_ecm) override
+  {
+    if (this->changed)
+      return;
+    this->changed = true;
+
+    // Written in place, without marking it as changed
+    auto capsule = _ecm.EntityByComponents(components::Name("capsule"),
+        components::Model());
+    _ecm.Component<components::Name>(capsule)->Data() = "renamed";
+
+    auto spawned = _ecm.CreateEntity();
+    _ecm.CreateComponent(spawned, components::Name("spawned"));
+  }
+
+  public: void PostUpdate(const UpdateInfo &,
+              const EntityComponentManager &_ecm) override
+  {
+    auto box = _ecm.EntityByComponents(components::Name("box"),
+        components::Model());
+    this->boxPose = _ecm.Component<components::Pose>(box)->Data();
+  }
+
+  public: void Reset(const UpdateInfo &_info,
+              EntityComponentManager &) override
+  {
+    ++this->resetCount;
+    this->resetTime = _info.simTime;
+  }
+
+  public: bool changed{false};
+  public: math::Pose3d boxPose;
+  public: unsigned int resetCount{0};
+  public: std::chrono::steady_clock::duration resetTime{-1};
+};
+
+/////////////////////////////////////////////////
+TEST_P(ServerFixture, Reset)
+{
+  ServerConfig serverConfig;
+  serverConfig.SetSdfFile(std::string(PROJECT_SOURCE_PATH) +
+      "/test/worlds/shapes.sdf");
+
+  gazebo::Server server(serverConfig);
+  EXPECT_FALSE(server.Reset(1));
+
+  auto system = std::make_shared<ResettableSystem>();
+  EXPECT_TRUE(*server.AddSystem(system));
+
+  // The box falls
+  EXPECT_TRUE(server.Run(true, 10, false));
+  EXPECT_EQ(25u, *server.EntityCount());
+  EXPECT_TRUE(server.HasEntity("spawned"));
+  EXPECT_FALSE(server.HasEntity("capsule"));
+  EXPECT_LT(system->boxPose.Pos().Z(), 3.0);
+
+  // The reset happens at the end of the next step, and the step after it
+  // starts from the loaded world.
+  EXPECT_TRUE(server.Reset());
+  EXPECT_TRUE(server.Run(true, 2, false));
+  EXPECT_EQ(1u, system->resetCount);
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(), system->resetTime);
+  EXPECT_EQ(24u, *server.EntityCount());
+  EXPECT_FALSE(server.HasEntity("spawned"));
+  EXPECT_TRUE(server.HasEntity("capsule"));
+  EXPECT_NEAR(1.0, system->boxPose.Pos().X(), 1e-6);
+  EXPECT_NEAR(2.0, system->boxPose.Pos().Y(), 1e-6);
+  EXPECT_NEAR(3.0, system->boxPose.Pos().Z(), 1e-6);
+
+  // Systems aren't reloaded
+  EXPECT_EQ(4u, *server.SystemCount());
+}
+
+/////////////////////////////////////////////////
+TEST_P(ServerFixture, WorldCopies)
+{
+  ServerConfig serverConfig;
+  serverConfig.SetSdfFile(std::string(PROJECT_SOURCE_PATH) +
+      "/test/worlds/shapes.sdf");
+  serverConfig.SetWorldCopies(3);
+
+  gazebo::Server server(serverConfig);
+  EXPECT_TRUE(server.HasEntity("box", 0));
+  EXPECT_TRUE(server.HasEntity("box", 2));
+  EXPECT_FALSE(server.IterationCount(3));
+
+  // All copies are stepped together
+  EXPECT_TRUE(server.StepWorlds(5));
+  for (unsigned int i = 0; i < 3; ++i)
+    EXPECT_EQ(5u, *server.IterationCount(i));
+
+  // Observe the height of each box
+  std::vector<double> observations;
+  EXPECT_TRUE(server.StepWorlds(1, 1,
+      [](const unsigned int, const EntityComponentManager &_ecm,
+         double *_observation)
+      {
+        auto box = _ecm.EntityByComponents(components::Name("box"),
+            components::Model());
+        *_observation = _ecm.Component<components::Pose>(box)->Data().Z();
+      }, observations));
+  ASSERT_EQ(3u, observations.size());
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(6u, *server.IterationCount(i));
+    EXPECT_LT(observations[i], 3.0);
+    EXPECT_DOUBLE_EQ(observations[0], observations[i]);
+  }
+
+  // Steps aren't paced to the update period
+  for (unsigned int i = 0; i < 3; ++i)
+    server.SetUpdatePeriod(100ms, i);
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(server.StepWorlds(5));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 400ms);
+  for (unsigned int i = 0; i < 3; ++i)
+    EXPECT_EQ(11u, *server.IterationCount(i));
+}
+
 /////////////////////////////////////////////////
 TEST_P(ServerFixture, ServerConfigLogRecord)
 {
@@ -18,7 +18,9 @@
 #include "SimulationRunner.hh"
 
 #include <algorithm>
+#include <thread>
 
+#include <sdf/parser.hh>
 #include <sdf/Root.hh>
 
 #include "ignition/common/Profiler.hh"
@@ -41,11 +43,19 @@ using namespace gazebo;
 
 using StringSet = std::unordered_set<std::string>;
 
+/// \brief Number of steps between two batchings of the PostUpdate systems.
+static const unsigned int kPostUpdateBatchPeriod{100};
+
+/// \brief Weight of the latest measurement in the average cost of a
+/// PostUpdate system.
+static const double kPostUpdateCostWeight{0.1};
+
 
 //////////////////////////////////////////////////
 SimulationRunner::SimulationRunner(const sdf::World *_world,
                                    const SystemLoaderPtr &_systemLoader,
-                                   const ServerConfig &_config)
+                                   const ServerConfig &_config,
+                                   const WorldSnapshot *_snapshot)
     // \todo(nkoenig) Either copy the world, or add copy constructor to the
     // World and other elements.
     : sdfWorld(_world), serverConfig(_config)
@@ -62,6 +72,18 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
   // Keep system loader so plugins can be loaded at runtime
   this->systemLoader = _systemLoader;
 
+  this->entityCompMgr.SetBinarySerialization(
+      this->serverConfig.BinaryStateSerialization());
+
+  this->pacer = std::make_unique<StepPacer>(this->serverConfig.Pacing(),
+      this->serverConfig.MaxCatchUpSteps());
+
+  if (this->serverConfig.StateThreadCount())
+  {
+    this->entityCompMgr.SetStateThreadCount(
+        *this->serverConfig.StateThreadCount());
+  }
+
   // Get the physics profile
   // TODO(luca): remove duplicated logic in SdfEntityCreator and LevelManager
   auto physics = _world->PhysicsByIndex(0);
@@ -116,8 +138,27 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
       std::bind(&SimulationRunner::LoadPlugins, this, std::placeholders::_1,
       std::placeholders::_2));
 
+  // Restore the entities from the snapshot, which already hold the default
+  // level, so the level manager doesn't create them from SDF. A snapshot
+  // which fails to restore leaves the entity component manager untouched,
+  // so the world can still be created from the snapshot's SDF.
+  const WorldSnapshot *snapshot = _snapshot;
+  if (nullptr != snapshot &&
+      !snapshot->Restore(this->entityCompMgr, this->worldName))
+  {
+    ignerr << "Failed to restore world [" << this->worldName
+           << "] from snapshot, creating it from its SDF instead."
+           << std::endl;
+    snapshot = nullptr;
+  }
+
   // Create the level manager
-  this->levelMgr = std::make_unique<LevelManager>(this, _config.UseLevels());
+  this->levelMgr = std::make_unique<LevelManager>(this, _config.UseLevels(),
+      nullptr != snapshot);
+
+  // Systems which would have been loaded with the entities
+  if (nullptr != snapshot)
+    this->LoadSnapshotPlugins(snapshot->Plugins());
 
   // Check if this is going to be a distributed runner
   // Attempt to create the manager based on environment variables.
@@ -137,7 +178,8 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
           std::bind(&SimulationRunner::Step, this, std::placeholders::_1),
           this->entityCompMgr, &this->eventMgr,
           NetworkConfig::FromValues(
-            _config.NetworkRole(), _config.NetworkSecondaries()));
+            _config.NetworkRole(), _config.NetworkSecondaries(),
+            _config.NetworkPipelined()));
     }
 
     if (this->networkMgr)
@@ -146,7 +188,9 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
       {
         ignmsg << "Network Primary, expects ["
           << this->networkMgr->Config().numSecondariesExpected
-          << "] secondaries." << std::endl;
+          << "] secondaries"
+          << (this->networkMgr->Config().pipelined ? ", pipelined" : "")
+          << "." << std::endl;
       }
       else if (this->networkMgr->IsSecondary())
       {
@@ -174,6 +218,15 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
 
   this->LoadLoggingPlugins(this->serverConfig);
 
+  // Keep the loaded world, so it can be reset without reloading it. Levels
+  // and distributed simulation load and unload entities on their own, and
+  // playback restores its own state, so those can only be rewound.
+  if (!_config.UseLevels() && !this->networkMgr &&
+      this->serverConfig.LogPlaybackPath().empty())
+  {
+    this->entityCompMgr.SetResetPoint();
+  }
+
   // World control
   transport::NodeOptions opts;
   std::string ns{"/world/" + this->worldName};
@@ -227,10 +280,7 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
 }
 
 //////////////////////////////////////////////////
-SimulationRunner::~SimulationRunner()
-{
-  this->StopWorkerThreads();
-}
+SimulationRunner::~SimulationRunner() = default;
 
 /////////////////////////////////////////////////
 void SimulationRunner::UpdateCurrentInfo()
@@ -410,6 +460,31 @@ void SimulationRunner::PublishStats()
 
   msg.set_paused(this->currentInfo.paused);
 
+  // Histogram of how far from their deadline steps started
+  if (nullptr != this->pacer)
+  {
+    auto bucketsData = msg.mutable_header()->add_data();
+    bucketsData->set_key("step_jitter_bucket_us");
+    for (auto bound : StepPacer::kJitterBucketsUs)
+      bucketsData->add_value(std::to_string(bound));
+    bucketsData->add_value("inf");
+
+    auto countsData = msg.mutable_header()->add_data();
+    countsData->set_key("step_jitter_count");
+    for (auto count : this->pacer->JitterHistogram())
+      countsData->add_value(std::to_string(count));
+
+    auto maxData = msg.mutable_header()->add_data();
+    maxData->set_key("step_jitter_max_us");
+    maxData->add_value(std::to_string(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+        this->pacer->MaxJitter()).count()));
+
+    auto droppedData = msg.mutable_header()->add_data();
+    droppedData->set_key("dropped_steps");
+    droppedData->add_value(std::to_string(this->pacer->DroppedSteps()));
+  }
+
   // Publish the stats message. The stats message is throttled.
   this->statsPub.Publish(msg);
 
@@ -480,14 +555,37 @@ void SimulationRunner::AddSystemToRunner(SystemInternal _system)
 {
   this->systems.push_back(_system);
 
+  std::optional<ComponentAccess> access;
+  if (_system.componentAccess)
+  {
+    ComponentAccess declared;
+    if (_system.componentAccess->ComponentAccess(declared.reads,
+        declared.writes))
+    {
+      access = declared;
+    }
+  }
+
   if (_system.preupdate)
+  {
     this->systemsPreupdate.push_back(_system.preupdate);
+    this->preupdateAccess.push_back(access);
+  }
 
   if (_system.update)
+  {
     this->systemsUpdate.push_back(_system.update);
+    this->updateAccess.push_back(access);
+  }
 
   if (_system.postupdate)
+  {
     this->systemsPostupdate.push_back(_system.postupdate);
+    this->postUpdateCosts.push_back(-1.0);
+  }
+
+  if (_system.reset)
+    this->systemsReset.push_back(_system.reset);
 }
 
 /////////////////////////////////////////////////
@@ -495,12 +593,8 @@ void SimulationRunner::ProcessSystemQueue()
 {
   std::lock_guard<std::mutex> lock(this->pendingSystemsMutex);
   auto pending = this->pendingSystems.size();
-
-  if (pending > 0)
-  {
-    // If additional systems are to be added, stop the existing threads.
-    this->StopWorkerThreads();
-  }
+  if (pending == 0)
+    return;
 
   for (const auto &system : this->pendingSystems)
   {
@@ -508,42 +602,37 @@ void SimulationRunner::ProcessSystemQueue()
   }
   this->pendingSystems.clear();
 
-  // If additional systems were added, recreate the worker threads.
-  if (pending > 0)
-  {
-    igndbg << "Creating PostUpdate worker threads: "
-      << this->systemsPostupdate.size() + 1 << std::endl;
-
-    this->postUpdateStartBarrier =
-      std::make_unique<Barrier>(this->systemsPostupdate.size() + 1u);
-    this->postUpdateStopBarrier =
-      std::make_unique<Barrier>(this->systemsPostupdate.size() + 1u);
-
-    this->postUpdateThreadsRunning = true;
-    int id = 0;
+  this->preupdateStages = ScheduleSystems(this->preupdateAccess);
+  this->updateStages = ScheduleSystems(this->updateAccess);
+  this->postUpdateBatchCountdown = 0;
 
-    for (auto &system : this->systemsPostupdate)
+  // Only pay for worker threads once some systems can run concurrently.
+  auto concurrent = [](const std::vector<std::size_t> &_stage)
+  {
+    return _stage.size() > 1u;
+  };
+  if (!this->systemPool &&
+      (this->systemsPostupdate.size() > 1u ||
+       std::any_of(this->preupdateStages.begin(),
+          this->preupdateStages.end(), concurrent) ||
+       std::any_of(this->updateStages.begin(), this->updateStages.end(),
+          concurrent)))
+  {
+    if (this->serverConfig.WorldCopies() > 1u)
     {
-      igndbg << "Creating postupdate worker thread (" << id << ")" << std::endl;
-
-      this->postUpdateThreads.push_back(std::thread([&, id]()
-      {
-        std::stringstream ss;
-        ss << "PostUpdateThread: " << id;
-        IGN_PROFILE_THREAD_NAME(ss.str().c_str());
-        while (this->postUpdateThreadsRunning)
-        {
-          this->postUpdateStartBarrier->Wait();
-          if (this->postUpdateThreadsRunning)
-          {
-            system->PostUpdate(this->currentInfo, this->entityCompMgr);
-          }
-          this->postUpdateStopBarrier->Wait();
-        }
-        igndbg << "Exiting postupdate worker thread ("
-          << id << ")" << std::endl;
-      }));
-      id++;
+      // Copies of a world already keep the shared pool busy, so they share
+      // it instead of oversubscribing the cores.
+      this->systemPool = &ThreadPool::Shared();
+    }
+    else
+    {
+      const unsigned int threadCount =
+          this->serverConfig.SystemThreadCount().value_or(
+          std::max(1u, std::thread::hardware_concurrency()) - 1u);
+      igndbg << "Creating system thread pool: " << threadCount << " threads"
+             << std::endl;
+      this->ownedSystemPool = std::make_unique<ThreadPool>(threadCount);
+      this->systemPool = this->ownedSystemPool.get();
     }
   }
 }
@@ -552,33 +641,157 @@ void SimulationRunner::ProcessSystemQueue()
 void SimulationRunner::UpdateSystems()
 {
   IGN_PROFILE("SimulationRunner::UpdateSystems");
-  // \todo(nkoenig)  Systems used to be updated in parallel using
-  // an ignition::common::WorkerPool. There is overhead associated with
-  // this, most notably the creation and destruction of WorkOrders (see
-  // WorkerPool.cc). We could turn on parallel updates in the future, and/or
-  // turn it on if there are sufficient systems. More testing is required.
 
+  // Systems which declared their component access through
+  // ISystemComponentAccess may run concurrently with the systems they don't
+  // conflict with. All other systems run serially in insertion order.
   {
     IGN_PROFILE("PreUpdate");
-    for (auto& system : this->systemsPreupdate)
-      system->PreUpdate(this->currentInfo, this->entityCompMgr);
+    this->RunStages(this->preupdateStages, [this](std::size_t _index)
+        {
+          this->systemsPreupdate[_index]->PreUpdate(this->currentInfo,
+              this->entityCompMgr);
+        });
   }
 
   {
     IGN_PROFILE("Update");
-    for (auto& system : this->systemsUpdate)
-      system->Update(this->currentInfo, this->entityCompMgr);
+    this->RunStages(this->updateStages, [this](std::size_t _index)
+        {
+          this->systemsUpdate[_index]->Update(this->currentInfo,
+              this->entityCompMgr);
+        });
   }
 
+  if (!this->systemsPostupdate.empty())
   {
     IGN_PROFILE("PostUpdate");
-    // If no systems implementing PostUpdate have been added, then
-    // the barriers will be uninitialized, so guard against that condition.
-    if (this->postUpdateStartBarrier && this->postUpdateStopBarrier)
+    if (this->postUpdateBatchCountdown == 0)
+      this->BatchPostUpdateSystems();
+    --this->postUpdateBatchCountdown;
+
+    // Systems only read the ECM during PostUpdate, so the workers can
+    // access components without contending on locks.
+    this->entityCompMgr.SetReadOnly(true);
+    if (this->systemPool)
+    {
+      this->systemPool->Run(this->postUpdateTasks);
+    }
+    else
+    {
+      for (const auto &task : this->postUpdateTasks)
+        task();
+    }
+    this->entityCompMgr.SetReadOnly(false);
+  }
+}
+
+/////////////////////////////////////////////////
+void SimulationRunner::BatchPostUpdateSystems()
+{
+  IGN_PROFILE("SimulationRunner::BatchPostUpdateSystems");
+
+  this->postUpdateBatches.clear();
+
+  // Systems which haven't been measured yet get a batch of their own.
+  std::vector<std::size_t> measured;
+  double total{0.0};
+  for (std::size_t i = 0; i < this->systemsPostupdate.size(); ++i)
+  {
+    if (this->postUpdateCosts[i] < 0.0)
+    {
+      this->postUpdateBatches.push_back({i});
+    }
+    else
+    {
+      measured.push_back(i);
+      total += this->postUpdateCosts[i];
+    }
+  }
+
+  // Aim for a few batches per thread, so that work stealing can still even
+  // out the load, the same as ThreadPool::ParallelFor.
+  const unsigned int threads =
+      this->systemPool ? this->systemPool->ThreadCount() + 1u : 1u;
+  const double batchCost = total / (threads * 4u);
+
+  // Most expensive first, so that cheap systems fill up the last batches.
+  std::stable_sort(measured.begin(), measured.end(),
+      [this](std::size_t _a, std::size_t _b)
+      {
+        return this->postUpdateCosts[_a] > this->postUpdateCosts[_b];
+      });
+
+  std::vector<std::size_t> batch;
+  double cost{0.0};
+  for (const std::size_t index : measured)
+  {
+    batch.push_back(index);
+    cost += this->postUpdateCosts[index];
+    if (cost >= batchCost)
+    {
+      this->postUpdateBatches.push_back(std::move(batch));
+      batch.clear();
+      cost = 0.0;
+    }
+  }
+  if (!batch.empty())
+    this->postUpdateBatches.push_back(std::move(batch));
+
+  // Batch again right after new systems have been measured.
+  this->postUpdateBatchCountdown =
+      measured.size() == this->systemsPostupdate.size() ?
+      kPostUpdateBatchPeriod : 1u;
+
+  this->postUpdateTasks.clear();
+  for (std::size_t b = 0; b < this->postUpdateBatches.size(); ++b)
+  {
+    this->postUpdateTasks.push_back([this, b]
+        {
+          // Each system belongs to a single batch, so its cost is only
+          // updated by this task.
+          for (const std::size_t index : this->postUpdateBatches[b])
+          {
+            const auto start = std::chrono::steady_clock::now();
+            this->systemsPostupdate[index]->PostUpdate(this->currentInfo,
+                this->entityCompMgr);
+            const double elapsed = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+            double &average = this->postUpdateCosts[index];
+            if (average < 0.0)
+              average = elapsed;
+            else
+              average += kPostUpdateCostWeight * (elapsed - average);
+          }
+        });
+  }
+}
+
+/////////////////////////////////////////////////
+void SimulationRunner::RunStages(
+    const std::vector<std::vector<std::size_t>> &_stages,
+    const std::function<void(std::size_t)> &_update)
+{
+  std::vector<std::function<void()>> tasks;
+  for (const auto &stage : _stages)
+  {
+    if (stage.size() == 1u || !this->systemPool)
     {
-      this->postUpdateStartBarrier->Wait();
-      this->postUpdateStopBarrier->Wait();
+      for (const std::size_t index : stage)
+        _update(index);
+      continue;
     }
+
+    tasks.clear();
+    for (const std::size_t index : stage)
+      tasks.push_back([&_update, index]{_update(index);});
+
+    // Systems in a concurrent stage only modify component data, so the
+    // ECM can be shared between threads the same way as during PostUpdate.
+    this->entityCompMgr.SetReadOnly(true);
+    this->systemPool->Run(tasks);
+    this->entityCompMgr.SetReadOnly(false);
   }
 }
 
@@ -596,26 +809,7 @@ void SimulationRunner::OnStop()
 }
 
 /////////////////////////////////////////////////
-void SimulationRunner::StopWorkerThreads()
-{
-  this->postUpdateThreadsRunning = false;
-  if (this->postUpdateStartBarrier)
-  {
-    this->postUpdateStartBarrier->Cancel();
-  }
-  if (this->postUpdateStopBarrier)
-  {
-    this->postUpdateStopBarrier->Cancel();
-  }
-  for (auto &thread : this->postUpdateThreads)
-  {
-    thread.join();
-  }
-  this->postUpdateThreads.clear();
-}
-
-/////////////////////////////////////////////////
-bool SimulationRunner::Run(const uint64_t _iterations)
+bool SimulationRunner::Run(const uint64_t _iterations, const bool _paced)
 {
   // \todo(nkoenig) Systems will need a an update structure, such as
   // priorties, or a dependency chain.
@@ -648,11 +842,6 @@ bool SimulationRunner::Run(const uint64_t _iterations)
   if (!this->currentInfo.paused)
     this->realTimeWatch.Start();
 
-  // Variables for time keeping.
-  std::chrono::steady_clock::time_point startTime;
-  std::chrono::steady_clock::duration sleepTime;
-  std::chrono::steady_clock::duration actualSleep;
-
   this->running = true;
 
   // Create the world statistics publisher.
@@ -664,7 +853,7 @@ bool SimulationRunner::Run(const uint64_t _iterations)
         "stats", advertOpts);
   }
 
-  if (!this->rootStatsPub.Valid())
+  if (!this->rootStatsPub.Valid() && !this->rootTopicsChecked)
   {
     // Check for the existence of other publishers on `/stats`
     std::vector<ignition::transport::MessagePublisher> publishers;
@@ -697,7 +886,7 @@ bool SimulationRunner::Run(const uint64_t _iterations)
     this->clockPub = this->node->Advertise<ignition::msgs::Clock>("clock");
 
   // Create the global clock publisher.
-  if (!this->rootClockPub.Valid())
+  if (!this->rootClockPub.Valid() && !this->rootTopicsChecked)
   {
     // Check for the existence of other publishers on `/clock`
     std::vector<ignition::transport::MessagePublisher> publishers;
@@ -725,6 +914,8 @@ bool SimulationRunner::Run(const uint64_t _iterations)
     }
   }
 
+  this->rootTopicsChecked = true;
+
   // Keep number of iterations requested by caller
   uint64_t processedIterations{0};
 
@@ -738,31 +929,14 @@ bool SimulationRunner::Run(const uint64_t _iterations)
     // Update the step size and desired rtf
     this->UpdatePhysicsParams();
 
-    // Compute the time to sleep in order to match, as closely as possible,
-    // the update period.
-    sleepTime = 0ns;
-    actualSleep = 0ns;
-
-    sleepTime = std::max(0ns, this->prevUpdateRealTime +
-        this->updatePeriod - std::chrono::steady_clock::now() -
-        this->sleepOffset);
-
-    // Only sleep if needed.
-    if (sleepTime > 0ns)
-    {
-      IGN_PROFILE("Sleep");
-      // Get the current time, sleep for the duration needed to match the
-      // updatePeriod, and then record the actual time slept.
-      startTime = std::chrono::steady_clock::now();
-      std::this_thread::sleep_for(sleepTime);
-      actualSleep = std::chrono::steady_clock::now() - startTime;
-    }
-
-    // Exponentially average out the difference between expected sleep time
-    // and actual sleep time.
-    this->sleepOffset =
-      std::chrono::duration_cast<std::chrono::nanoseconds>(
-          (actualSleep - sleepTime) * 0.01 + this->sleepOffset * 0.99);
+    // Wait in order to match, as closely as possible, the update period.
+    // Unpaced iterations restart the pacer's schedule instead, so the next
+    // paced iteration doesn't try to catch up with them.
+    this->pacer->SetPeriod(this->updatePeriod);
+    if (_paced)
+      this->pacer->Wait(this->prevUpdateRealTime);
+    else
+      this->pacer->Reset();
 
     // Update time information. This will update the iteration count, RTF,
     // and other values.
@@ -795,6 +969,15 @@ bool SimulationRunner::Run(const uint64_t _iterations)
 
   this->running = false;
 
+  // Pipelined secondaries may still be computing the last step, whose
+  // states would otherwise never reach the primary.
+  if (this->networkMgr && this->networkMgr->IsPrimary())
+  {
+    auto netPrimary =
+        dynamic_cast<NetworkManagerPrimary *>(this->networkMgr.get());
+    netPrimary->Flush();
+  }
+
   return true;
 }
 
@@ -804,16 +987,36 @@ void SimulationRunner::Step(const UpdateInfo &_info)
   IGN_PROFILE("SimulationRunner::Step");
   this->currentInfo = _info;
 
+  // In throughput mode, housekeeping is spread over a batch of steps while
+  // running.
+  bool housekeeping{true};
+  if (this->serverConfig.StepBatchSize() > 1 && !this->currentInfo.paused &&
+      !this->networkMgr)
+  {
+    housekeeping = this->housekeepingCountdown == 0;
+    this->housekeepingCountdown = housekeeping ?
+        this->serverConfig.StepBatchSize() - 1 :
+        this->housekeepingCountdown - 1;
+  }
+  else
+  {
+    this->housekeepingCountdown = 0;
+  }
+
   // Publish info
-  this->PublishStats();
+  if (housekeeping)
+    this->PublishStats();
 
   // Record when the update step starts.
   this->prevUpdateRealTime = std::chrono::steady_clock::now();
 
-  this->levelMgr->UpdateLevelsState();
+  if (housekeeping)
+  {
+    this->levelMgr->UpdateLevelsState();
 
-  // Handle pending systems
-  this->ProcessSystemQueue();
+    // Handle pending systems
+    this->ProcessSystemQueue();
+  }
 
   // Update all the systems.
   this->UpdateSystems();
@@ -839,6 +1042,23 @@ void SimulationRunner::Step(const UpdateInfo &_info)
     }
   }
 
+  // Poses may have been written without being marked as changed, so the
+  // next step can't reuse this step's world poses. This isn't left to
+  // SetAllComponentsUnchanged, which batched steps skip.
+  this->entityCompMgr.InvalidateWorldPoses();
+
+  // Within a batch, only process new and removed entities if there are
+  // any, so systems don't see them again on the next step.
+  if (!housekeeping)
+  {
+    if (this->entityCompMgr.HasNewEntities())
+      this->entityCompMgr.ClearNewlyCreatedEntities();
+    if (this->entityCompMgr.HasEntitiesMarkedForRemoval())
+      this->entityCompMgr.ProcessRemoveEntityRequests();
+    this->entityCompMgr.ClearRemovedComponents();
+    return;
+  }
+
   // Process world control messages.
   this->ProcessMessages();
 
@@ -854,6 +1074,38 @@ void SimulationRunner::Step(const UpdateInfo &_info)
   // Each network manager takes care of marking its components as unchanged
   if (!this->networkMgr)
     this->entityCompMgr.SetAllComponentsUnchanged();
+
+  // Reset once the step is over, so the next step starts from the restored
+  // world at time zero, and systems see the restored entities as changes.
+  if (this->requestedReset)
+    this->ResetWorld();
+}
+
+/////////////////////////////////////////////////
+void SimulationRunner::ResetWorld()
+{
+  IGN_PROFILE("SimulationRunner::ResetWorld");
+
+  this->requestedReset = false;
+  this->requestedRewind = true;
+
+  if (!this->entityCompMgr.Reset())
+  {
+    ignwarn << "World [" << this->worldName << "] uses levels, distributed "
+            << "simulation or log playback, so it can't be reset without "
+            << "reloading it. Only rewinding time." << std::endl;
+    return;
+  }
+
+  // Same time as the step which rewinds
+  UpdateInfo info = this->currentInfo;
+  info.dt = -this->currentInfo.simTime;
+  info.simTime = std::chrono::steady_clock::duration::zero();
+  info.realTime = std::chrono::steady_clock::duration::zero();
+  info.iterations = 0;
+
+  for (auto &system : this->systemsReset)
+    system->Reset(info, this->entityCompMgr);
 }
 
 //////////////////////////////////////////////////
@@ -1000,6 +1252,8 @@ void SimulationRunner::LoadPlugins(const Entity _entity,
     // automatically added.
     if (filename != "__default__" && name != "__default__")
     {
+      this->loadedPlugins.push_back(
+          {_entity, filename, name, pluginElem->ToString("")});
       this->LoadPlugin(_entity, filename, name, pluginElem);
     }
 
@@ -1007,6 +1261,54 @@ void SimulationRunner::LoadPlugins(const Entity _entity,
   }
 }
 
+/////////////////////////////////////////////////
+void SimulationRunner::LoadSnapshotPlugins(
+    const std::vector<WorldSnapshot::Plugin> &_plugins)
+{
+  for (const auto &plugin : _plugins)
+  {
+    if (!this->entityCompMgr.HasEntity(plugin.entity))
+    {
+      ignwarn << "Entity [" << plugin.entity << "] of system [" << plugin.name
+              << "] isn't in the snapshot, not loading the system."
+              << std::endl;
+      continue;
+    }
+
+    sdf::Errors errors;
+    sdf::ElementPtr pluginElem(new sdf::Element);
+    sdf::initFile("plugin.sdf", pluginElem);
+    sdf::readString(std::string("<sdf version='") + SDF_VERSION + "'>" +
+        plugin.sdf + "</sdf>", pluginElem, errors);
+    if (!errors.empty())
+    {
+      ignerr << "Failed to parse the SDF of system [" << plugin.name
+             << "] from the snapshot:" << std::endl;
+      for (const auto &err : errors)
+        ignerr << err << std::endl;
+      continue;
+    }
+
+    this->loadedPlugins.push_back(plugin);
+    this->LoadPlugin(plugin.entity, plugin.filename, plugin.name,
+        pluginElem);
+  }
+}
+
+/////////////////////////////////////////////////
+bool SimulationRunner::SaveSnapshot(const std::string &_path) const
+{
+  IGN_PROFILE("SimulationRunner::SaveSnapshot");
+
+  // Includes have already been resolved in the world's element.
+  const std::string worldSdf = std::string("<?xml version='1.0'?>") +
+      "<sdf version='" + SDF_VERSION + "'>" +
+      this->sdfWorld->Element()->ToString("") + "</sdf>";
+
+  return WorldSnapshot::Save(_path, worldSdf, this->loadedPlugins,
+      this->entityCompMgr);
+}
+
 /////////////////////////////////////////////////
 bool SimulationRunner::Running() const
 {
@@ -1109,6 +1411,7 @@ bool SimulationRunner::OnWorldControl(const msgs::WorldControl &_req,
   if (_req.has_reset())
   {
     control.rewind = _req.reset().all() || _req.reset().time_only();
+    control.reset = _req.reset().all();
 
     if (_req.reset().model_only())
     {
@@ -1188,6 +1491,8 @@ void SimulationRunner::ProcessWorldControl()
 
     // Rewind / reset
     this->requestedRewind = control.rewind;
+    if (control.reset)
+      this->requestedReset = true;
 
     // Seek
     if (control.seek >= std::chrono::steady_clock::duration::zero())
@@ -1207,6 +1512,12 @@ bool SimulationRunner::Paused() const
   return this->currentInfo.paused;
 }
 
+/////////////////////////////////////////////////
+void SimulationRunner::Reset()
+{
+  this->requestedReset = true;
+}
+
 /////////////////////////////////////////////////
 const EntityComponentManager &SimulationRunner::EntityCompMgr() const
 {
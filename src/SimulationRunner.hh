@@ -53,7 +53,10 @@
 
 #include "network/NetworkManager.hh"
 #include "LevelManager.hh"
-#include "Barrier.hh"
+#include "SystemScheduler.hh"
+#include "StepPacer.hh"
+#include "ThreadPool.hh"
+#include "WorldSnapshot.hh"
 
 using namespace std::chrono_literals;
 
@@ -83,6 +86,11 @@ namespace ignition
       // cppcheck-suppress unusedStructMember
       bool rewind{false};  // NOLINT
 
+      /// \brief Restore entities and components to their state after the
+      /// world was loaded, see SimulationRunner::Reset. It also rewinds.
+      // cppcheck-suppress unusedStructMember
+      bool reset{false};  // NOLINT
+
       /// \brief A simulation time in the future to run to and then pause.
       /// A negative number indicates that this variable it not being used.
       std::chrono::steady_clock::duration runToSimTime{-1};  // NOLINT
@@ -105,7 +113,10 @@ namespace ignition
                 configure(systemPlugin->QueryInterface<ISystemConfigure>()),
                 preupdate(systemPlugin->QueryInterface<ISystemPreUpdate>()),
                 update(systemPlugin->QueryInterface<ISystemUpdate>()),
-                postupdate(systemPlugin->QueryInterface<ISystemPostUpdate>())
+                postupdate(systemPlugin->QueryInterface<ISystemPostUpdate>()),
+                componentAccess(
+                    systemPlugin->QueryInterface<ISystemComponentAccess>()),
+                reset(systemPlugin->QueryInterface<ISystemReset>())
       {
       }
 
@@ -117,7 +128,10 @@ namespace ignition
                 configure(dynamic_cast<ISystemConfigure *>(_system.get())),
                 preupdate(dynamic_cast<ISystemPreUpdate *>(_system.get())),
                 update(dynamic_cast<ISystemUpdate *>(_system.get())),
-                postupdate(dynamic_cast<ISystemPostUpdate *>(_system.get()))
+                postupdate(dynamic_cast<ISystemPostUpdate *>(_system.get())),
+                componentAccess(
+                    dynamic_cast<ISystemComponentAccess *>(_system.get())),
+                reset(dynamic_cast<ISystemReset *>(_system.get()))
       {
       }
 
@@ -149,6 +163,14 @@ namespace ignition
       /// Will be nullptr if the System doesn't implement this interface.
       public: ISystemPostUpdate *postupdate = nullptr;
 
+      /// \brief Access this system via the ISystemComponentAccess interface
+      /// Will be nullptr if the System doesn't implement this interface.
+      public: ISystemComponentAccess *componentAccess = nullptr;
+
+      /// \brief Access this system via the ISystemReset interface
+      /// Will be nullptr if the System doesn't implement this interface.
+      public: ISystemReset *reset = nullptr;
+
       /// \brief Vector of queries and callbacks
       public: std::vector<EntityQueryCallback> updates;
     };
@@ -159,9 +181,14 @@ namespace ignition
       /// \param[in] _world Pointer to the SDF world.
       /// \param[in] _systemLoader Reference to system manager.
       /// \param[in] _useLevels Whether to use levles or not. False by default.
+      /// \param[in] _snapshot Snapshot to restore the world's entities and
+      /// systems from, instead of creating them from _world. It must have
+      /// been saved from the same world, and it's only used during
+      /// construction.
       public: explicit SimulationRunner(const sdf::World *_world,
                                 const SystemLoaderPtr &_systemLoader,
-                                const ServerConfig &_config = ServerConfig());
+                                const ServerConfig &_config = ServerConfig(),
+                                const WorldSnapshot *_snapshot = nullptr);
 
       /// \brief Destructor.
       public: virtual ~SimulationRunner();
@@ -172,13 +199,12 @@ namespace ignition
       /// \brief Internal method for handling stop event (to prevent recursion)
       private: void OnStop();
 
-      /// \brief Stop and join all post update worker threads
-      private: void StopWorkerThreads();
-
       /// \brief Run the simulationrunner.
       /// \param[in] _iterations Number of iterations.
+      /// \param[in] _paced False to run iterations back to back, instead of
+      /// pacing them to the update period.
       /// \return True if the operation completed successfully.
-      public: bool Run(const uint64_t _iterations);
+      public: bool Run(const uint64_t _iterations, const bool _paced = true);
 
       /// \brief Perform a simulation step:
       /// * Publish stats and process control messages
@@ -218,6 +244,20 @@ namespace ignition
       /// \brief Update all the systems
       public: void UpdateSystems();
 
+      /// \brief Group the PostUpdate systems into batches which are each
+      /// updated by a single task, based on how long each system took in
+      /// previous steps. Expensive systems get a batch of their own, while
+      /// cheap systems are batched together so they don't pay for a task
+      /// each.
+      private: void BatchPostUpdateSystems();
+
+      /// \brief Run the stages of a phase, one after the other. The systems
+      /// of each stage run concurrently on the system pool.
+      /// \param[in] _stages Stages of the phase.
+      /// \param[in] _update Function which updates the system at an index.
+      private: void RunStages(const std::vector<std::vector<std::size_t>>
+          &_stages, const std::function<void(std::size_t)> &_update);
+
       /// \brief Publish current world statistics.
       public: void PublishStats();
 
@@ -237,6 +277,20 @@ namespace ignition
       public: void LoadPlugins(const Entity _entity,
           const sdf::ElementPtr &_sdf);
 
+      /// \brief Load the systems recorded by a snapshot.
+      /// \param[in] _plugins Systems loaded from SDF when the snapshot was
+      /// saved.
+      private: void LoadSnapshotPlugins(
+          const std::vector<WorldSnapshot::Plugin> &_plugins);
+
+      /// \brief Save a snapshot of the world, which can be restored
+      /// instead of creating the world from SDF. It shouldn't be called while
+      /// the runner is running.
+      /// \param[in] _path Path of the snapshot file.
+      /// \return True if the snapshot was saved.
+      /// \sa WorldSnapshot
+      public: bool SaveSnapshot(const std::string &_path) const;
+
       /// \brief Load server plugins for a given entity.
       /// \param[in] _config Configuration to load plugins from.
       ///     plugins based on the _config contents
@@ -291,6 +345,14 @@ namespace ignition
       /// \return True if the simulation runner is paused, false otherwise.
       public: bool Paused() const;
 
+      /// \brief Request to reset the world to its state right after it was
+      /// loaded, without reloading it. At the end of the current step,
+      /// entities and components are restored in place, see
+      /// EntityComponentManager::Reset, systems implementing ISystemReset are
+      /// notified, and time is rewound to zero. Worlds using levels or
+      /// distributed simulation can only be rewound.
+      public: void Reset();
+
       /// \brief Set the run to simulation time.
       /// \param[in] _time A simulation time in the future to run to and then
       /// pause. A negative number or a time less than the current simulation
@@ -395,6 +457,9 @@ namespace ignition
       /// \brief Process world control service messages.
       private: void ProcessWorldControl();
 
+      /// \brief Reset the world, as requested by Reset.
+      private: void ResetWorld();
+
       /// \brief Actually add system to the runner
       /// \param[in] _system System to be added
       public: void AddSystemToRunner(SystemInternal _system);
@@ -472,6 +537,49 @@ namespace ignition
       /// \brief Systems implementing PostUpdate
       private: std::vector<ISystemPostUpdate *> systemsPostupdate;
 
+      /// \brief Systems implementing Reset
+      private: std::vector<ISystemReset *> systemsReset;
+
+      /// \brief Declared component access of each system in
+      /// systemsPreupdate, nullopt for systems which didn't declare it.
+      private: std::vector<std::optional<ComponentAccess>> preupdateAccess;
+
+      /// \brief Declared component access of each system in systemsUpdate,
+      /// nullopt for systems which didn't declare it.
+      private: std::vector<std::optional<ComponentAccess>> updateAccess;
+
+      /// \brief Stages of systemsPreupdate, see ScheduleSystems.
+      private: std::vector<std::vector<std::size_t>> preupdateStages;
+
+      /// \brief Stages of systemsUpdate, see ScheduleSystems.
+      private: std::vector<std::vector<std::size_t>> updateStages;
+
+      /// \brief Pool updating PostUpdate systems, and non-conflicting
+      /// PreUpdate and Update systems, concurrently. Only set once there
+      /// are systems to update concurrently. It's ownedSystemPool, or the
+      /// process' shared pool for copies of a world, which are also stepped
+      /// on it, see ServerConfig::SetWorldCopies.
+      private: ThreadPool *systemPool{nullptr};
+
+      /// \brief Pool owned by this runner, whose size comes from
+      /// ServerConfig::SystemThreadCount.
+      private: std::unique_ptr<ThreadPool> ownedSystemPool;
+
+      /// \brief Average wall time taken by each system in systemsPostupdate
+      /// in seconds. Negative for systems which haven't been measured yet.
+      private: std::vector<double> postUpdateCosts;
+
+      /// \brief Batches of indices into systemsPostupdate.
+      /// \sa BatchPostUpdateSystems
+      private: std::vector<std::vector<std::size_t>> postUpdateBatches;
+
+      /// \brief One task per batch in postUpdateBatches.
+      private: std::vector<std::function<void()>> postUpdateTasks;
+
+      /// \brief Number of steps until the PostUpdate systems are batched
+      /// again.
+      private: unsigned int postUpdateBatchCountdown{0};
+
       /// \brief Manager of all events.
       private: EventManager eventMgr;
 
@@ -490,9 +598,8 @@ namespace ignition
       /// \brief Wall time of the previous update.
       private: std::chrono::steady_clock::time_point prevUpdateRealTime;
 
-      /// \brief A duration used to account for inaccuracies associated with
-      /// sleep durations.
-      private: std::chrono::steady_clock::duration sleepOffset{0};
+      /// \brief Paces iterations to the update period.
+      private: std::unique_ptr<StepPacer> pacer;
 
       /// \brief This is the rate at which the systems are updated.
       /// The default update rate is 500hz, which is a period of 2ms.
@@ -557,9 +664,20 @@ namespace ignition
       /// executed yet.
       private: unsigned int pendingSimIterations{0};
 
+      /// \brief Number of steps left until the next housekeeping step. See
+      /// ServerConfig::SetStepBatchSize.
+      private: unsigned int housekeepingCountdown{0};
+
       /// \brief True if user requested to rewind simulation.
       private: bool requestedRewind{false};
 
+      /// \brief True once Run has checked for other publishers of the root
+      /// stats and clock topics, so runs of a single step don't check again.
+      private: bool rootTopicsChecked{false};
+
+      /// \brief True if user requested to reset the world, see Reset.
+      private: std::atomic<bool> requestedReset{false};
+
       /// \brief If user asks to seek to a specific sim time, this holds the
       /// time.s A negative value means there's no request from the user.
       private: std::chrono::steady_clock::duration requestedSeek{-1};
@@ -583,24 +701,15 @@ namespace ignition
       /// \brief Copy of the server configuration.
       public: ServerConfig serverConfig;
 
-      /// \brief Collection of threads running system PostUpdates
-      private: std::vector<std::thread> postUpdateThreads;
-
-      /// \brief Flag to indicate running status of PostUpdate threads
-      private: std::atomic<bool> postUpdateThreadsRunning{false};
-
-      /// \brief Barrier to signal beginning of PostUpdate thread execution
-      private: std::unique_ptr<Barrier> postUpdateStartBarrier;
-
-      /// \brief Barrier to signal end of PostUpdate thread execution
-      private: std::unique_ptr<Barrier> postUpdateStopBarrier;
-
       /// \brief Map from file paths to Fuel URIs.
       private: std::unordered_map<std::string, std::string> fuelUriMap;
 
       /// \brief True if Server::RunOnce triggered a blocking paused step
       private: bool blockingPausedStepPending{false};
 
+      /// \brief Systems loaded from SDF, which are saved with snapshots.
+      private: std::vector<WorldSnapshot::Plugin> loadedPlugins;
+
       friend class LevelManager;
     };
     }
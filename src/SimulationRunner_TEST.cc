@@ -18,6 +18,14 @@
 #include <gtest/gtest.h>
 #include <tinyxml2.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
 #include <ignition/transport/Node.hh>
@@ -96,6 +104,81 @@ class SimulationRunnerTest : public ::testing::TestWithParam<int>
 std::vector<msgs::Clock> clockMsgs;
 std::vector<msgs::Clock> rootClockMsgs;
 
+/// \brief System which declares its component access, and calls a function
+/// on PreUpdate.
+class AccessSystem
+  : public System,
+    public ISystemPreUpdate,
+    public ISystemComponentAccess
+{
+  public: AccessSystem(const std::set<ComponentTypeId> &_reads,
+              const std::set<ComponentTypeId> &_writes,
+              std::function<void()> _f)
+          : reads(_reads), writes(_writes), f(std::move(_f))
+  {
+  }
+
+  // Documentation inherited
+  public: bool ComponentAccess(std::set<ComponentTypeId> &_reads,
+              std::set<ComponentTypeId> &_writes) override
+  {
+    _reads = this->reads;
+    _writes = this->writes;
+    return true;
+  }
+
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &,
+              EntityComponentManager &) override
+  {
+    this->f();
+  }
+
+  private: std::set<ComponentTypeId> reads;
+  private: std::set<ComponentTypeId> writes;
+  private: std::function<void()> f;
+};
+
+/// \brief System which doesn't declare its component access.
+class UndeclaredSystem
+  : public System,
+    public ISystemPreUpdate
+{
+  public: explicit UndeclaredSystem(std::function<void()> _f)
+          : f(std::move(_f))
+  {
+  }
+
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &,
+              EntityComponentManager &) override
+  {
+    this->f();
+  }
+
+  private: std::function<void()> f;
+};
+
+/// \brief System which calls a function on PostUpdate.
+class PostUpdateSystem
+  : public System,
+    public ISystemPostUpdate
+{
+  public: explicit PostUpdateSystem(std::function<void()> _f)
+          : f(std::move(_f))
+  {
+  }
+
+  // Documentation inherited
+  public: void PostUpdate(const UpdateInfo &,
+              const EntityComponentManager &) override
+  {
+    this->f();
+  }
+
+  private: std::function<void()> f;
+};
+
 /////////////////////////////////////////////////
 void clockCb(const msgs::Clock &_msg)
 {
@@ -1573,6 +1656,251 @@ TEST_P(SimulationRunnerTest, GenerateWorldSdf)
   EXPECT_EQ(5u, world->ModelCount());
 }
 
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, ConcurrentSystems)
+{
+  // Load SDF file
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  // Create simulation runner
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader);
+
+  const auto intType = IntComponent::typeId;
+  const auto doubleType = DoubleComponent::typeId;
+
+  // Each system records when it starts and finishes
+  std::mutex mutex;
+  std::vector<std::string> events;
+  auto record = [&](const std::string &_event)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(_event);
+  };
+
+  // The two writers wait for each other, which only succeeds if they run
+  // concurrently.
+  std::atomic<int> arrived{0};
+  std::atomic<int> met{0};
+  auto rendezvous = [&](const std::string &_name)
+  {
+    record(_name + " start");
+    ++arrived;
+    auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (arrived < 2 && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+    if (arrived >= 2)
+      ++met;
+    record(_name + " end");
+  };
+
+  runner.AddSystem(std::make_shared<AccessSystem>(
+      std::set<ComponentTypeId>(), std::set<ComponentTypeId>({intType}),
+      [&]{rendezvous("intWriter");}));
+  runner.AddSystem(std::make_shared<AccessSystem>(
+      std::set<ComponentTypeId>(), std::set<ComponentTypeId>({doubleType}),
+      [&]{rendezvous("doubleWriter");}));
+
+  // Reads what the first writer writes, so it must run after it
+  runner.AddSystem(std::make_shared<AccessSystem>(
+      std::set<ComponentTypeId>({intType}), std::set<ComponentTypeId>(),
+      [&]{record("intReader");}));
+
+  // Runs alone, after all the previous systems
+  runner.AddSystem(std::make_shared<UndeclaredSystem>(
+      [&]{record("undeclared");}));
+
+  runner.SetPaused(false);
+  EXPECT_TRUE(runner.Run(1));
+
+  ASSERT_EQ(6u, events.size());
+  auto position = [&](const std::string &_event)
+  {
+    return std::find(events.begin(), events.end(), _event) - events.begin();
+  };
+  EXPECT_LT(position("intWriter end"), position("intReader"));
+  EXPECT_EQ(5, position("undeclared"));
+
+  if (std::thread::hardware_concurrency() > 1)
+  {
+    EXPECT_EQ(2, met);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, PostUpdateThreads)
+{
+  // Load SDF file
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  ServerConfig serverConfig;
+  serverConfig.SetSystemThreadCount(2u);
+
+  // Create simulation runner
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader, serverConfig);
+
+  // Many more systems than threads, some of them slower than others
+  const int systemCount = 50;
+  std::mutex mutex;
+  std::set<std::thread::id> threadIds;
+  std::vector<int> calls(systemCount, 0);
+  for (int i = 0; i < systemCount; ++i)
+  {
+    runner.AddSystem(std::make_shared<PostUpdateSystem>([&, i]
+        {
+          if (i % 10 == 0)
+            std::this_thread::sleep_for(1ms);
+
+          std::lock_guard<std::mutex> lock(mutex);
+          threadIds.insert(std::this_thread::get_id());
+          ++calls[i];
+        }));
+  }
+
+  // Run long enough for the systems to be batched based on their cost
+  runner.SetPaused(false);
+  EXPECT_TRUE(runner.Run(110));
+
+  // Every system is updated once per step, by at most the 2 workers and
+  // the thread running the simulation.
+  for (int i = 0; i < systemCount; ++i)
+    EXPECT_EQ(110, calls[i]) << i;
+  EXPECT_LE(threadIds.size(), 3u);
+}
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, StepBatchSize)
+{
+  // Load SDF file
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  std::mutex mutex;
+  std::vector<msgs::Clock> batchClockMsgs;
+  std::function<void(const msgs::Clock &)> cb =
+      [&](const msgs::Clock &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        batchClockMsgs.push_back(_msg);
+      };
+  transport::Node node;
+  node.Subscribe("/world/default/clock", cb);
+
+  ServerConfig serverConfig;
+  serverConfig.SetStepBatchSize(4u);
+
+  // Create simulation runner
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader, serverConfig);
+
+  int calls{0};
+  runner.AddSystem(std::make_shared<PostUpdateSystem>([&]
+      {
+        ++calls;
+      }));
+
+  // Systems are updated every step, but the clock is only published at the
+  // beginning of each batch
+  runner.SetPaused(false);
+  EXPECT_TRUE(runner.Run(100));
+  EXPECT_EQ(100, calls);
+  EXPECT_EQ(100u, runner.CurrentInfo().iterations);
+
+  auto countMsgs = [&]()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return batchClockMsgs.size();
+  };
+  int sleep = 0;
+  while (countMsgs() < 25u && sleep++ < 100)
+    std::this_thread::sleep_for(10ms);
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(25u, countMsgs());
+}
+
+/////////////////////////////////////////////////
+/// \brief System which calls a function on PreUpdate with the entity
+/// component manager.
+class EcmPreUpdateSystem
+  : public System,
+    public ISystemPreUpdate
+{
+  public: explicit EcmPreUpdateSystem(
+              std::function<void(EntityComponentManager &)> _f)
+          : f(std::move(_f))
+  {
+  }
+
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &,
+              EntityComponentManager &_ecm) override
+  {
+    this->f(_ecm);
+  }
+
+  private: std::function<void(EntityComponentManager &)> f;
+};
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, StepBatchSizeWorldPose)
+{
+  sdf::Root root;
+  root.LoadSdfString(R"(
+      <?xml version="1.0" ?>
+      <sdf version="1.6">
+        <world name="default"/>
+      </sdf>)");
+  ASSERT_EQ(1u, root.WorldCount());
+
+  ServerConfig serverConfig;
+  serverConfig.SetStepBatchSize(4u);
+
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader, serverConfig);
+
+  // Move a parent every step by writing its pose in place, without marking
+  // it as changed, and check its child's world pose on the next step, which
+  // may be within the same batch
+  Entity parent{kNullEntity};
+  Entity child{kNullEntity};
+  int checks{0};
+  runner.AddSystem(std::make_shared<EcmPreUpdateSystem>(
+      [&](EntityComponentManager &_ecm)
+      {
+        if (kNullEntity == parent)
+        {
+          parent = _ecm.CreateEntity();
+          _ecm.CreateComponent(parent, components::Pose());
+          child = _ecm.CreateEntity();
+          _ecm.CreateComponent(child, components::ParentEntity(parent));
+          _ecm.CreateComponent(child,
+              components::Pose(math::Pose3d(1, 0, 0, 0, 0, 0)));
+          return;
+        }
+
+        auto &parentPose = _ecm.Component<components::Pose>(parent)->Data();
+        auto childPose = _ecm.WorldPose(child);
+        ASSERT_TRUE(childPose);
+        EXPECT_DOUBLE_EQ(parentPose.Pos().X() + 1, childPose->Pos().X());
+        ++checks;
+
+        parentPose.Pos().X() += 1;
+      }));
+
+  runner.SetPaused(false);
+  EXPECT_TRUE(runner.Run(20));
+  EXPECT_EQ(19, checks);
+}
+
 // Run multiple times. We want to make sure that static globals don't cause
 // problems.
 INSTANTIATE_TEST_SUITE_P(ServerRepeat, SimulationRunnerTest,
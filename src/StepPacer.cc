@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#include <ignition/common/Profiler.hh>
+
+#include "StepPacer.hh"
+
+using namespace ignition::gazebo;
+using namespace std::chrono_literals;
+
+/// \brief Spin at least this long before a HybridSpin deadline.
+static const StepPacer::Clock::duration kMinSpin{20us};
+
+/// \brief Spin at most this long before a HybridSpin deadline.
+static const StepPacer::Clock::duration kMaxSpin{2ms};
+
+//////////////////////////////////////////////////
+StepPacer::StepPacer(ServerConfig::PacingStrategy _strategy,
+    unsigned int _maxCatchUpSteps)
+  : strategy(_strategy), maxCatchUpSteps(_maxCatchUpSteps)
+{
+}
+
+//////////////////////////////////////////////////
+void StepPacer::SetPeriod(const Clock::duration &_period)
+{
+  if (_period == this->period)
+    return;
+
+  this->period = _period;
+  this->Reset();
+}
+
+//////////////////////////////////////////////////
+StepPacer::Clock::duration StepPacer::Period() const
+{
+  return this->period;
+}
+
+//////////////////////////////////////////////////
+ServerConfig::PacingStrategy StepPacer::Strategy() const
+{
+  return this->strategy;
+}
+
+//////////////////////////////////////////////////
+void StepPacer::Reset()
+{
+  this->started = false;
+}
+
+//////////////////////////////////////////////////
+void StepPacer::Wait(const Clock::time_point &_prevStepStart)
+{
+  if (this->period <= Clock::duration::zero())
+    return;
+
+  switch (this->strategy)
+  {
+    case ServerConfig::PacingStrategy::Sleep:
+    case ServerConfig::PacingStrategy::HybridSpin:
+      // The first step doesn't have a previous step to follow.
+      if (_prevStepStart == Clock::time_point())
+        return;
+      this->deadline = _prevStepStart + this->period;
+      if (this->strategy == ServerConfig::PacingStrategy::Sleep)
+        this->WaitSleep(this->deadline);
+      else
+        this->WaitHybrid(this->deadline);
+      break;
+    case ServerConfig::PacingStrategy::AbsoluteDeadline:
+    case ServerConfig::PacingStrategy::CatchUp:
+      // The first step after a reset starts the schedule.
+      if (!this->started)
+      {
+        this->started = true;
+        this->deadline = Clock::now();
+        return;
+      }
+      this->deadline += this->period;
+      if (this->strategy == ServerConfig::PacingStrategy::CatchUp)
+      {
+        this->WaitHybrid(this->deadline);
+      }
+      else
+      {
+        IGN_PROFILE("Sleep");
+        SleepUntil(this->deadline);
+      }
+      break;
+  }
+
+  const auto now = Clock::now();
+  this->RecordJitter(now - this->deadline);
+
+  // Strategies with a fixed schedule. AbsoluteDeadline doesn't catch up, so
+  // a late step moves the schedule. CatchUp runs late steps back to back,
+  // unless it's too far behind.
+  if (this->strategy == ServerConfig::PacingStrategy::AbsoluteDeadline)
+  {
+    this->deadline = std::max(this->deadline, now);
+  }
+  else if (this->strategy == ServerConfig::PacingStrategy::CatchUp &&
+      now - this->deadline > this->period * this->maxCatchUpSteps)
+  {
+    this->droppedSteps += static_cast<uint64_t>(
+        (now - this->deadline) / this->period);
+    this->deadline = now;
+  }
+}
+
+//////////////////////////////////////////////////
+void StepPacer::WaitSleep(const Clock::time_point &_deadline)
+{
+  Clock::duration sleepTime = std::max(Clock::duration::zero(),
+      _deadline - Clock::now() - this->sleepOffset);
+  Clock::duration actualSleep{0};
+
+  // Only sleep if needed.
+  if (sleepTime > Clock::duration::zero())
+  {
+    IGN_PROFILE("Sleep");
+    // Get the current time, sleep for the duration needed to match the
+    // updatePeriod, and then record the actual time slept.
+    auto startTime = Clock::now();
+    std::this_thread::sleep_for(sleepTime);
+    actualSleep = Clock::now() - startTime;
+  }
+
+  // Exponentially average out the difference between expected sleep time
+  // and actual sleep time.
+  this->sleepOffset = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      (actualSleep - sleepTime) * 0.01 + this->sleepOffset * 0.99);
+}
+
+//////////////////////////////////////////////////
+void StepPacer::WaitHybrid(const Clock::time_point &_deadline)
+{
+  // Sleep until the average oversleep, with some margin, before the
+  // deadline.
+  const auto spin = std::clamp<Clock::duration>(this->oversleep * 2,
+      kMinSpin, kMaxSpin);
+  const auto wakeUp = _deadline - spin;
+  if (Clock::now() < wakeUp)
+  {
+    IGN_PROFILE("Sleep");
+    SleepUntil(wakeUp);
+    this->oversleep = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        (Clock::now() - wakeUp) * 0.1 + this->oversleep * 0.9);
+  }
+
+  // Spin for the rest of the time.
+  IGN_PROFILE("Spin");
+  while (Clock::now() < _deadline)
+    std::this_thread::yield();
+}
+
+//////////////////////////////////////////////////
+void StepPacer::SleepUntil(const Clock::time_point &_time)
+{
+#ifdef __linux__
+  // The steady clock is CLOCK_MONOTONIC on Linux.
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _time.time_since_epoch()).count();
+  if (ns <= 0)
+    return;
+
+  timespec ts;
+  ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+  ts.tv_nsec = static_cast<long>(ns % 1000000000);  // NOLINT
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) ==
+      EINTR)
+  {
+  }
+#else
+  std::this_thread::sleep_until(_time);
+#endif
+}
+
+//////////////////////////////////////////////////
+void StepPacer::RecordJitter(Clock::duration _jitter)
+{
+  if (_jitter < Clock::duration::zero())
+    _jitter = -_jitter;
+
+  this->maxJitter = std::max(this->maxJitter, _jitter);
+
+  const auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(_jitter).count();
+  auto bucket = std::upper_bound(kJitterBucketsUs.begin(),
+      kJitterBucketsUs.end(), us) - kJitterBucketsUs.begin();
+  ++this->jitterHistogram[bucket];
+}
+
+//////////////////////////////////////////////////
+const std::array<uint64_t, StepPacer::kJitterBucketCount>
+    &StepPacer::JitterHistogram() const
+{
+  return this->jitterHistogram;
+}
+
+//////////////////////////////////////////////////
+StepPacer::Clock::duration StepPacer::MaxJitter() const
+{
+  return this->maxJitter;
+}
+
+//////////////////////////////////////////////////
+uint64_t StepPacer::DroppedSteps() const
+{
+  return this->droppedSteps;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_STEPPACER_HH_
+#define IGNITION_GAZEBO_STEPPACER_HH_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+#include <ignition/gazebo/ServerConfig.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class StepPacer StepPacer.hh
+    /// \brief Paces the simulation loop so that steps start once per update
+    /// period, following one of the strategies in
+    /// ServerConfig::PacingStrategy.
+    ///
+    /// It also keeps a histogram of the jitter of each step, which is how
+    /// far from its deadline the step actually started.
+    class IGNITION_GAZEBO_VISIBLE StepPacer
+    {
+      /// \brief Clock used for pacing.
+      public: using Clock = std::chrono::steady_clock;
+
+      /// \brief Number of buckets in the jitter histogram.
+      public: static constexpr std::size_t kJitterBucketCount{10};
+
+      /// \brief Upper bound of each bucket of the jitter histogram, in
+      /// microseconds, exclusive. The last bucket has no upper bound.
+      public: static constexpr std::array<int64_t, kJitterBucketCount - 1>
+          kJitterBucketsUs{{10, 25, 50, 100, 250, 500, 1000, 2500, 5000}};
+
+      /// \brief Constructor
+      /// \param[in] _strategy Pacing strategy.
+      /// \param[in] _maxCatchUpSteps Maximum number of steps to catch up
+      /// with the CatchUp strategy.
+      public: StepPacer(ServerConfig::PacingStrategy _strategy,
+                  unsigned int _maxCatchUpSteps);
+
+      /// \brief Set the update period. If it changed, the schedule is reset.
+      /// \param[in] _period Update period. Steps aren't paced if it's not
+      /// positive.
+      public: void SetPeriod(const Clock::duration &_period);
+
+      /// \brief Get the update period.
+      /// \return The update period.
+      public: Clock::duration Period() const;
+
+      /// \brief Get the pacing strategy.
+      /// \return The pacing strategy.
+      public: ServerConfig::PacingStrategy Strategy() const;
+
+      /// \brief Block until the next step is due, and record its jitter.
+      /// \param[in] _prevStepStart When the previous step started. The
+      /// Sleep and HybridSpin strategies start the next step one period after
+      /// it, while the others keep a fixed schedule.
+      public: void Wait(const Clock::time_point &_prevStepStart);
+
+      /// \brief Restart the fixed schedule of the AbsoluteDeadline and
+      /// CatchUp strategies with the next step. That step doesn't wait, and
+      /// its jitter isn't recorded.
+      public: void Reset();
+
+      /// \brief Get the number of steps in each bucket of the jitter
+      /// histogram, since the pacer was created.
+      /// \return Count per bucket.
+      /// \sa kJitterBucketsUs
+      public: const std::array<uint64_t, kJitterBucketCount>
+          &JitterHistogram() const;
+
+      /// \brief Get the largest jitter recorded.
+      /// \return The largest jitter.
+      public: Clock::duration MaxJitter() const;
+
+      /// \brief Get the number of steps dropped by the CatchUp strategy
+      /// because simulation fell behind by more than the maximum number of
+      /// steps to catch up.
+      /// \return Number of dropped steps.
+      public: uint64_t DroppedSteps() const;
+
+      /// \brief Sleep for a duration, correcting for the average oversleep.
+      /// \param[in] _deadline When the step is due.
+      private: void WaitSleep(const Clock::time_point &_deadline);
+
+      /// \brief Sleep until shortly before a deadline, then spin.
+      /// \param[in] _deadline When the step is due.
+      private: void WaitHybrid(const Clock::time_point &_deadline);
+
+      /// \brief Sleep until an absolute time.
+      /// \param[in] _time Time to wake up.
+      private: static void SleepUntil(const Clock::time_point &_time);
+
+      /// \brief Add a step's jitter to the histogram.
+      /// \param[in] _jitter Difference between when the step started and
+      /// its deadline.
+      private: void RecordJitter(Clock::duration _jitter);
+
+      /// \brief Pacing strategy.
+      private: ServerConfig::PacingStrategy strategy;
+
+      /// \brief Maximum number of steps to catch up.
+      private: unsigned int maxCatchUpSteps;
+
+      /// \brief Update period.
+      private: Clock::duration period{0};
+
+      /// \brief Deadline of the previous step, for strategies with a fixed
+      /// schedule.
+      private: Clock::time_point deadline;
+
+      /// \brief False until the first step after a reset.
+      private: bool started{false};
+
+      /// \brief Average difference between the requested and actual sleep
+      /// durations of the Sleep strategy.
+      private: Clock::duration sleepOffset{0};
+
+      /// \brief Average time a sleep overshoots its wake up time, used by
+      /// HybridSpin to decide when to start spinning.
+      private: Clock::duration oversleep{std::chrono::microseconds(100)};
+
+      /// \brief Count per bucket of the jitter histogram.
+      private: std::array<uint64_t, kJitterBucketCount> jitterHistogram{};
+
+      /// \brief Largest jitter recorded.
+      private: Clock::duration maxJitter{0};
+
+      /// \brief Number of steps dropped by CatchUp.
+      private: uint64_t droppedSteps{0};
+    };
+    }  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
+  }  // namespace gazebo
+}  // namespace ignition
+
+#endif  // IGNITION_GAZEBO_STEPPACER_HH_
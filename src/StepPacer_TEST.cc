@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <numeric>
+#include <thread>
+
+#include "StepPacer.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace std::chrono_literals;
+
+using Clock = StepPacer::Clock;
+
+/// \brief Run steps with a pacer and return how long they took.
+/// \param[in] _pacer Pacer.
+/// \param[in] _steps Number of steps.
+/// \param[in] _work Duration of each step.
+/// \return Duration of all the steps.
+Clock::duration RunSteps(StepPacer &_pacer, int _steps,
+    Clock::duration _work = 0ns)
+{
+  Clock::time_point prevStepStart;
+  auto start = Clock::now();
+  for (int i = 0; i < _steps; ++i)
+  {
+    _pacer.Wait(prevStepStart);
+    prevStepStart = Clock::now();
+    if (_work > 0ns)
+      std::this_thread::sleep_for(_work);
+  }
+  return Clock::now() - start;
+}
+
+/// \brief Get the number of steps in the jitter histogram.
+/// \param[in] _pacer Pacer.
+/// \return Number of steps.
+uint64_t JitterCount(const StepPacer &_pacer)
+{
+  const auto &histogram = _pacer.JitterHistogram();
+  return std::accumulate(histogram.begin(), histogram.end(), uint64_t{0});
+}
+
+//////////////////////////////////////////////////
+TEST(StepPacer, Strategies)
+{
+  for (auto strategy : {ServerConfig::PacingStrategy::Sleep,
+                        ServerConfig::PacingStrategy::HybridSpin,
+                        ServerConfig::PacingStrategy::AbsoluteDeadline,
+                        ServerConfig::PacingStrategy::CatchUp})
+  {
+    StepPacer pacer(strategy, 10);
+    EXPECT_EQ(strategy, pacer.Strategy());
+    pacer.SetPeriod(2ms);
+    EXPECT_EQ(2ms, pacer.Period());
+
+    // The first step doesn't wait, the others wait one period each
+    auto duration = RunSteps(pacer, 51);
+    EXPECT_GE(duration, 100ms - 1ms) << static_cast<int>(strategy);
+    EXPECT_LT(duration, 200ms) << static_cast<int>(strategy);
+
+    // Jitter is recorded for all but the first step
+    EXPECT_EQ(50u, JitterCount(pacer));
+    EXPECT_EQ(0u, pacer.DroppedSteps());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(StepPacer, NoPeriod)
+{
+  StepPacer pacer(ServerConfig::PacingStrategy::HybridSpin, 10);
+  pacer.SetPeriod(0ns);
+  RunSteps(pacer, 10);
+  EXPECT_EQ(0u, JitterCount(pacer));
+}
+
+//////////////////////////////////////////////////
+TEST(StepPacer, CatchUp)
+{
+  StepPacer pacer(ServerConfig::PacingStrategy::CatchUp, 100);
+  pacer.SetPeriod(5ms);
+  RunSteps(pacer, 1);
+
+  // A slow step puts the schedule behind, and the following steps run back
+  // to back until it's caught up
+  std::this_thread::sleep_for(20ms);
+  auto start = Clock::now();
+  RunSteps(pacer, 3);
+  EXPECT_LT(Clock::now() - start, 5ms);
+  EXPECT_EQ(0u, pacer.DroppedSteps());
+
+  // Falling too far behind drops steps
+  StepPacer bounded(ServerConfig::PacingStrategy::CatchUp, 2);
+  bounded.SetPeriod(5ms);
+  RunSteps(bounded, 1);
+  std::this_thread::sleep_for(50ms);
+  RunSteps(bounded, 1);
+  EXPECT_GE(bounded.DroppedSteps(), 5u);
+
+  // And the schedule restarts from there
+  start = Clock::now();
+  RunSteps(bounded, 2);
+  EXPECT_GE(Clock::now() - start, 10ms - 1ms);
+}
+
+//////////////////////////////////////////////////
+TEST(StepPacer, AbsoluteDeadlineDoesntCatchUp)
+{
+  StepPacer pacer(ServerConfig::PacingStrategy::AbsoluteDeadline, 10);
+  pacer.SetPeriod(5ms);
+  RunSteps(pacer, 1);
+
+  // Steps after a slow step are paced from it
+  std::this_thread::sleep_for(20ms);
+  RunSteps(pacer, 1);
+  auto start = Clock::now();
+  RunSteps(pacer, 2);
+  EXPECT_GE(Clock::now() - start, 10ms - 1ms);
+  EXPECT_EQ(0u, pacer.DroppedSteps());
+}
+
+//////////////////////////////////////////////////
+TEST(StepPacer, Reset)
+{
+  StepPacer pacer(ServerConfig::PacingStrategy::AbsoluteDeadline, 10);
+  pacer.SetPeriod(5ms);
+  RunSteps(pacer, 3);
+  EXPECT_EQ(2u, JitterCount(pacer));
+
+  // Changing the period restarts the schedule
+  pacer.SetPeriod(1ms);
+  auto start = Clock::now();
+  RunSteps(pacer, 1);
+  EXPECT_LT(Clock::now() - start, 1ms);
+  EXPECT_EQ(2u, JitterCount(pacer));
+}
+
+//////////////////////////////////////////////////
+TEST(StepPacer, JitterHistogram)
+{
+  StepPacer pacer(ServerConfig::PacingStrategy::Sleep, 10);
+  pacer.SetPeriod(1ms);
+
+  // Steps which take longer than the period start late
+  RunSteps(pacer, 11, 7ms);
+  EXPECT_EQ(10u, JitterCount(pacer));
+  EXPECT_GE(pacer.MaxJitter(), 5ms);
+
+  // They're all in the buckets over 5 ms
+  const auto &histogram = pacer.JitterHistogram();
+  EXPECT_EQ(10u, histogram[StepPacer::kJitterBucketCount - 1]);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+
+#include "SystemScheduler.hh"
+
+using namespace ignition::gazebo;
+
+namespace
+{
+/// \brief Check whether two sorted sets have an element in common.
+/// \param[in] _a First set.
+/// \param[in] _b Second set.
+/// \return True if the sets intersect.
+bool Intersect(const std::set<ComponentTypeId> &_a,
+    const std::set<ComponentTypeId> &_b)
+{
+  auto a = _a.begin();
+  auto b = _b.begin();
+  while (a != _a.end() && b != _b.end())
+  {
+    if (*a < *b)
+      ++a;
+    else if (*b < *a)
+      ++b;
+    else
+      return true;
+  }
+  return false;
+}
+}
+
+//////////////////////////////////////////////////
+bool ignition::gazebo::SystemsConflict(
+    const std::optional<ComponentAccess> &_a,
+    const std::optional<ComponentAccess> &_b)
+{
+  if (!_a || !_b)
+    return true;
+
+  return Intersect(_a->writes, _b->writes) ||
+         Intersect(_a->writes, _b->reads) ||
+         Intersect(_a->reads, _b->writes);
+}
+
+//////////////////////////////////////////////////
+std::vector<std::vector<std::size_t>> ignition::gazebo::ScheduleSystems(
+    const std::vector<std::optional<ComponentAccess>> &_access)
+{
+  // Each system goes in the stage right after the last stage holding a
+  // system it conflicts with. This is the longest path to the system in the
+  // dependency graph, where edges go from each system to the later systems
+  // it conflicts with.
+  std::vector<std::size_t> stageOf(_access.size(), 0u);
+  std::vector<std::vector<std::size_t>> stages;
+  for (std::size_t i = 0; i < _access.size(); ++i)
+  {
+    std::size_t stage{0};
+    for (std::size_t j = 0; j < i; ++j)
+    {
+      if (stageOf[j] + 1 > stage && SystemsConflict(_access[j], _access[i]))
+        stage = stageOf[j] + 1;
+    }
+
+    stageOf[i] = stage;
+    if (stage >= stages.size())
+      stages.resize(stage + 1);
+    stages[stage].push_back(i);
+  }
+  return stages;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_SYSTEMSCHEDULER_HH_
+#define IGNITION_GAZEBO_SYSTEMSCHEDULER_HH_
+
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+#include <ignition/gazebo/Types.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \brief Component types accessed by a system, as declared through
+    /// ISystemComponentAccess.
+    struct ComponentAccess
+    {
+      /// \brief Component types which are only read.
+      std::set<ComponentTypeId> reads;
+
+      /// \brief Component types which are modified.
+      std::set<ComponentTypeId> writes;
+    };
+
+    /// \brief Check whether two systems must not run concurrently, which is
+    /// the case if either of them writes a component type that the other one
+    /// accesses, or if either of them didn't declare its access.
+    /// \param[in] _a Access of the first system, or nullopt if undeclared.
+    /// \param[in] _b Access of the second system, or nullopt if undeclared.
+    /// \return True if the systems conflict.
+    IGNITION_GAZEBO_VISIBLE
+    bool SystemsConflict(const std::optional<ComponentAccess> &_a,
+        const std::optional<ComponentAccess> &_b);
+
+    /// \brief Group the systems of one phase into stages which run one after
+    /// the other. Systems within a stage don't conflict with each other, so
+    /// they can run concurrently. A system always runs in a later stage than
+    /// the systems added before it which it conflicts with, so systems which
+    /// don't declare their access keep running in insertion order.
+    /// \param[in] _access Access of each system, in insertion order. Use
+    /// nullopt for systems which didn't declare their access.
+    /// \return Indices into _access for each stage, in the order the stages
+    /// must run. Indices within a stage are sorted.
+    IGNITION_GAZEBO_VISIBLE
+    std::vector<std::vector<std::size_t>> ScheduleSystems(
+        const std::vector<std::optional<ComponentAccess>> &_access);
+    }  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
+  }  // namespace gazebo
+}  // namespace ignition
+
+#endif  // IGNITION_GAZEBO_SYSTEMSCHEDULER_HH_
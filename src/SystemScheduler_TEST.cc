@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ignition/common/Filesystem.hh>
+#include <sdf/Model.hh>
+#include <sdf/Root.hh>
+#include <sdf/World.hh>
+
+#include "ignition/gazebo/EntityComponentManager.hh"
+#include "ignition/gazebo/EventManager.hh"
+#include "ignition/gazebo/SdfEntityCreator.hh"
+#include "ignition/gazebo/System.hh"
+#include "ignition/gazebo/SystemLoader.hh"
+#include "ignition/gazebo/components/ExternalWorldWrenchCmd.hh"
+#include "ignition/gazebo/components/JointVelocityCmd.hh"
+#include "ignition/gazebo/components/Model.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/test_config.hh"  // NOLINT(build/include)
+
+#include "SystemScheduler.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+using Stages = std::vector<std::vector<std::size_t>>;
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, Conflict)
+{
+  ComponentAccess readA{{1}, {}};
+  ComponentAccess readB{{2}, {}};
+  ComponentAccess writeA{{}, {1}};
+  ComponentAccess writeB{{2}, {3}};
+
+  // Undeclared systems conflict with everything
+  EXPECT_TRUE(SystemsConflict(std::nullopt, std::nullopt));
+  EXPECT_TRUE(SystemsConflict(readA, std::nullopt));
+  EXPECT_TRUE(SystemsConflict(std::nullopt, readA));
+
+  // Readers don't conflict with each other
+  EXPECT_FALSE(SystemsConflict(readA, readA));
+  EXPECT_FALSE(SystemsConflict(readA, readB));
+
+  // Writers conflict with readers and writers of the same type
+  EXPECT_TRUE(SystemsConflict(readA, writeA));
+  EXPECT_TRUE(SystemsConflict(writeA, readA));
+  EXPECT_TRUE(SystemsConflict(writeA, writeA));
+  EXPECT_FALSE(SystemsConflict(writeA, writeB));
+  EXPECT_FALSE(SystemsConflict(readA, writeB));
+  EXPECT_FALSE(SystemsConflict(readB, writeA));
+  EXPECT_FALSE(SystemsConflict(readB, writeB));
+  EXPECT_TRUE(SystemsConflict(ComponentAccess{{3}, {}}, writeB));
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, Undeclared)
+{
+  EXPECT_TRUE(ScheduleSystems({}).empty());
+
+  // Systems which don't declare their access run in insertion order
+  EXPECT_EQ(Stages({{0}, {1}, {2}}),
+      ScheduleSystems({std::nullopt, std::nullopt, std::nullopt}));
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, Stages)
+{
+  ComponentAccess readPose{{1}, {}};
+  ComponentAccess writePose{{}, {1}};
+  ComponentAccess writeVel{{1}, {2}};
+  ComponentAccess writeForce{{2}, {3}};
+
+  // Independent systems share a stage
+  EXPECT_EQ(Stages({{0, 1, 2}}),
+      ScheduleSystems({readPose, readPose, writeForce}));
+
+  // A writer waits for the earlier readers, and later readers wait for it
+  EXPECT_EQ(Stages({{0, 1}, {2}, {3}}),
+      ScheduleSystems({readPose, readPose, writePose, readPose}));
+
+  // A chain of dependencies. The last reader only waits for the pose
+  // writer, so it runs alongside the velocity writer.
+  EXPECT_EQ(Stages({{0}, {1, 3}, {2}}),
+      ScheduleSystems({writePose, writeVel, writeForce, readPose}));
+
+  // Undeclared systems split the declared ones around them
+  EXPECT_EQ(Stages({{0, 1}, {2}, {3, 4}}),
+      ScheduleSystems({readPose, writeForce, std::nullopt, readPose,
+      writeVel}));
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, ControllerSystems)
+{
+  // A vehicle with wheels, an arm, a mast and a propeller, each driven by
+  // one of the controller systems
+  const std::string lib{std::string("libignition-gazebo") +
+      IGNITION_GAZEBO_MAJOR_VERSION_STR};
+  auto plugin = [&](const std::string &_system, const std::string &_class,
+      const std::string &_params)
+  {
+    return "<plugin filename='" + lib + "-" + _system + "-system.so' "
+        "name='ignition::gazebo::systems::" + _class + "'>" + _params +
+        "</plugin>";
+  };
+  auto joint = [](const std::string &_child)
+  {
+    return "<link name='" + _child + "'/>"
+        "<joint name='" + _child + "_joint' type='revolute'>"
+        "<parent>chassis</parent><child>" + _child + "</child>"
+        "<axis><xyz>1 0 0</xyz></axis></joint>";
+  };
+
+  sdf::Root root;
+  auto errors = root.LoadSdfString(
+      "<?xml version='1.0'?><sdf version='1.6'><world name='default'>"
+      "<model name='vehicle'><link name='chassis'/>" +
+      joint("left_wheel") + joint("right_wheel") + joint("arm") +
+      joint("mast") + joint("propeller") +
+      plugin("diff-drive", "DiffDrive",
+          "<left_joint>left_wheel_joint</left_joint>"
+          "<right_joint>right_wheel_joint</right_joint>") +
+      plugin("joint-controller", "JointController",
+          "<joint_name>arm_joint</joint_name>") +
+      plugin("joint-controller", "JointController",
+          "<joint_name>mast_joint</joint_name>"
+          "<use_force_commands>true</use_force_commands>") +
+      plugin("thruster", "Thruster",
+          "<joint_name>propeller_joint</joint_name>"
+          "<thrust_coefficient>0.004</thrust_coefficient>"
+          "<propeller_diameter>0.2</propeller_diameter>") +
+      "</model>"
+      "<model name='trailer'><link name='chassis'/>" +
+      plugin("diff-drive", "DiffDrive",
+          "<left_joint>left_wheel_joint</left_joint>"
+          "<right_joint>right_wheel_joint</right_joint>") +
+      "</model></world></sdf>");
+  ASSERT_TRUE(errors.empty());
+  ASSERT_EQ(1u, root.WorldCount());
+
+  // The systems outlive the manager, which holds components they created
+  SystemLoader loader;
+  loader.AddSystemPluginPath(common::joinPaths(
+      std::string(PROJECT_BINARY_PATH), "lib"));
+  std::vector<SystemPluginPtr> systems;
+
+  EntityComponentManager ecm;
+  EventManager eventMgr;
+  SdfEntityCreator creator(ecm, eventMgr);
+  creator.CreateEntities(root.WorldByIndex(0));
+
+  const Entity model = ecm.EntityByComponents(components::Model(),
+      components::Name("vehicle"));
+  ASSERT_NE(kNullEntity, model);
+
+  // Configure each system the way the runner does, then get its access
+  std::vector<std::optional<ComponentAccess>> access;
+  auto modelElem = root.WorldByIndex(0)->ModelByIndex(0)->Element();
+  for (auto elem = modelElem->GetElement("plugin"); elem;
+      elem = elem->GetNextElement("plugin"))
+  {
+    auto system = loader.LoadPlugin(elem);
+    ASSERT_TRUE(system.has_value());
+    systems.push_back(system.value());
+
+    auto configure = system.value()->QueryInterface<ISystemConfigure>();
+    ASSERT_NE(nullptr, configure);
+    configure->Configure(model, elem, ecm, eventMgr);
+
+    auto declared = system.value()->QueryInterface<ISystemComponentAccess>();
+    ASSERT_NE(nullptr, declared);
+    ComponentAccess systemAccess;
+    EXPECT_TRUE(declared->ComponentAccess(systemAccess.reads,
+        systemAccess.writes));
+    access.push_back(systemAccess);
+  }
+  ASSERT_EQ(4u, access.size());
+
+  // The commands are created on Configure, since they can't be created
+  // while the systems run concurrently
+  auto entity = [&](const std::string &_name)
+  {
+    return ecm.EntityByComponents(components::Name(_name));
+  };
+  EXPECT_NE(nullptr, ecm.Component<components::JointVelocityCmd>(
+      entity("left_wheel_joint")));
+  EXPECT_NE(nullptr, ecm.Component<components::JointVelocityCmd>(
+      entity("arm_joint")));
+  EXPECT_NE(nullptr, ecm.Component<components::ExternalWorldWrenchCmd>(
+      entity("propeller")));
+
+  // Both the diff drive and the velocity controller write joint velocity
+  // commands, so they run one after the other. The force controller and the
+  // thruster run alongside the diff drive.
+  EXPECT_EQ(Stages({{0, 2, 3}, {1}}), ScheduleSystems(access));
+
+  // A diff drive whose joints don't exist yet looks for them on PreUpdate,
+  // where it creates their commands, so it doesn't declare its access
+  const Entity trailer = ecm.EntityByComponents(components::Model(),
+      components::Name("trailer"));
+  ASSERT_NE(kNullEntity, trailer);
+
+  auto trailerElem = root.WorldByIndex(0)->ModelByIndex(1)->Element()
+      ->GetElement("plugin");
+  auto diffDrive = loader.LoadPlugin(trailerElem);
+  ASSERT_TRUE(diffDrive.has_value());
+  systems.push_back(diffDrive.value());
+
+  diffDrive.value()->QueryInterface<ISystemConfigure>()->Configure(trailer,
+      trailerElem, ecm, eventMgr);
+  ComponentAccess diffDriveAccess;
+  EXPECT_FALSE(diffDrive.value()->QueryInterface<ISystemComponentAccess>()
+      ->ComponentAccess(diffDriveAccess.reads, diffDriveAccess.writes));
+}
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "ThreadPool.hh"
+
+using namespace ignition::gazebo;
+
+namespace
+{
+/// \brief A batch of tasks submitted with one call to ThreadPool::Run.
+struct Batch
+{
+  /// \brief Number of tasks which haven't finished.
+  std::size_t remaining{0};
+
+  /// \brief Mutex protecting remaining.
+  std::mutex mutex;
+
+  /// \brief Signaled when all tasks are done.
+  std::condition_variable cv;
+};
+
+/// \brief A task waiting in a queue.
+struct Job
+{
+  /// \brief Function to run. It's owned by the caller of Run, which blocks
+  /// until the job is done.
+  const std::function<void()> *function{nullptr};
+
+  /// \brief Batch the job belongs to.
+  std::shared_ptr<Batch> batch;
+};
+
+/// \brief Queue of jobs owned by a worker.
+struct Queue
+{
+  /// \brief Mutex protecting the jobs.
+  std::mutex mutex;
+
+  /// \brief Jobs. The owner takes jobs from the back and other threads
+  /// steal from the front.
+  std::deque<Job> jobs;
+};
+}
+
+class ignition::gazebo::ThreadPoolPrivate
+{
+  /// \brief Take a job, first from the preferred queue and then from any
+  /// other queue.
+  /// \param[in] _index Preferred queue, or the number of queues for none.
+  /// \param[out] _job The job.
+  /// \return True if a job was taken.
+  public: bool Take(std::size_t _index, Job &_job);
+
+  /// \brief Take a job of a given batch from any queue.
+  /// \param[in] _batch The batch.
+  /// \param[out] _job The job.
+  /// \return True if a job was taken.
+  public: bool TakeFromBatch(const Batch *_batch, Job &_job);
+
+  /// \brief Run a job and report its completion to its batch.
+  /// \param[in] _job The job.
+  public: static void Execute(const Job &_job);
+
+  /// \brief Work loop of a worker thread.
+  /// \param[in] _index Index of the worker.
+  public: void Work(std::size_t _index);
+
+  /// \brief One queue per worker.
+  public: std::vector<std::unique_ptr<Queue>> queues;
+
+  /// \brief Worker threads.
+  public: std::vector<std::thread> threads;
+
+  /// \brief Number of jobs in all the queues.
+  public: std::atomic<std::size_t> pending{0};
+
+  /// \brief Queue which receives the next job.
+  public: std::atomic<std::size_t> nextQueue{0};
+
+  /// \brief Mutex used by idle workers to wait for jobs.
+  public: std::mutex mutex;
+
+  /// \brief Signaled when jobs are added or the pool stops.
+  public: std::condition_variable cv;
+
+  /// \brief True when the pool is being destroyed.
+  public: bool stop{false};
+};
+
+//////////////////////////////////////////////////
+bool ThreadPoolPrivate::Take(std::size_t _index, Job &_job)
+{
+  if (this->pending == 0)
+    return false;
+
+  // Own queue first, newest job first since it's likely still in cache.
+  if (_index < this->queues.size())
+  {
+    Queue &queue = *this->queues[_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty())
+    {
+      _job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+      --this->pending;
+      return true;
+    }
+  }
+
+  // Steal the oldest job from another queue.
+  for (std::size_t i = 1; i <= this->queues.size(); ++i)
+  {
+    Queue &queue = *this->queues[(_index + i) % this->queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty())
+    {
+      _job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      --this->pending;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool ThreadPoolPrivate::TakeFromBatch(const Batch *_batch, Job &_job)
+{
+  if (this->pending == 0)
+    return false;
+
+  for (auto &queue : this->queues)
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    auto iter = std::find_if(queue->jobs.begin(), queue->jobs.end(),
+        [_batch](const Job &_queued)
+        {
+          return _queued.batch.get() == _batch;
+        });
+    if (iter != queue->jobs.end())
+    {
+      _job = std::move(*iter);
+      queue->jobs.erase(iter);
+      --this->pending;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::Execute(const Job &_job)
+{
+  (*_job.function)();
+
+  std::lock_guard<std::mutex> lock(_job.batch->mutex);
+  if (--_job.batch->remaining == 0)
+    _job.batch->cv.notify_all();
+}
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::Work(std::size_t _index)
+{
+  while (true)
+  {
+    Job job;
+    if (this->Take(_index, job))
+    {
+      Execute(job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cv.wait(lock, [this]
+        {
+          return this->stop || this->pending > 0;
+        });
+    if (this->stop)
+      return;
+  }
+}
+
+//////////////////////////////////////////////////
+ThreadPool::ThreadPool(unsigned int _threadCount)
+  : dataPtr(std::make_unique<ThreadPoolPrivate>())
+{
+  for (unsigned int i = 0; i < _threadCount; ++i)
+    this->dataPtr->queues.push_back(std::make_unique<Queue>());
+
+  for (unsigned int i = 0; i < _threadCount; ++i)
+  {
+    this->dataPtr->threads.emplace_back(
+        &ThreadPoolPrivate::Work, this->dataPtr.get(), i);
+  }
+}
+
+//////////////////////////////////////////////////
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->stop = true;
+  }
+  this->dataPtr->cv.notify_all();
+
+  for (auto &thread : this->dataPtr->threads)
+    thread.join();
+}
+
+//////////////////////////////////////////////////
+unsigned int ThreadPool::ThreadCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->threads.size());
+}
+
+//////////////////////////////////////////////////
+void ThreadPool::Run(const std::vector<std::function<void()>> &_tasks)
+{
+  if (_tasks.empty())
+    return;
+
+  // Without workers, or with a single task, there's nothing to distribute.
+  if (this->dataPtr->queues.empty() || _tasks.size() == 1)
+  {
+    for (const auto &task : _tasks)
+      task();
+    return;
+  }
+
+  auto batch = std::make_shared<Batch>();
+  batch->remaining = _tasks.size();
+
+  // Spread the tasks over the queues, starting where the previous batch
+  // stopped so that small batches don't always land on the same workers.
+  const std::size_t queueCount = this->dataPtr->queues.size();
+  std::size_t index = this->dataPtr->nextQueue.fetch_add(_tasks.size());
+  for (const auto &task : _tasks)
+  {
+    Queue &queue = *this->dataPtr->queues[index++ % queueCount];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back({&task, batch});
+    ++this->dataPtr->pending;
+  }
+
+  {
+    // Lock so that a worker can't miss the notification between checking
+    // for pending jobs and waiting.
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  }
+  this->dataPtr->cv.notify_all();
+
+  // Help with the jobs of this batch while waiting for it. Jobs of other
+  // batches are left to the workers, otherwise a task waiting on a nested
+  // batch could pick up an unrelated long task, or another task which nests
+  // a batch itself, and delay its own caller arbitrarily.
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      if (batch->remaining == 0)
+        return;
+    }
+
+    Job job;
+    if (this->dataPtr->TakeFromBatch(batch.get(), job))
+    {
+      ThreadPoolPrivate::Execute(job);
+      continue;
+    }
+
+    // All the jobs of this batch are running on other threads.
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->cv.wait(lock, [&batch]
+        {
+          return batch->remaining == 0;
+        });
+    return;
+  }
+}
+
+//////////////////////////////////////////////////
+void ThreadPool::ParallelFor(std::size_t _count, std::size_t _grainSize,
+    const std::function<void(std::size_t, std::size_t)> &_f)
+{
+  if (_count == 0)
+    return;
+
+  // A few chunks per thread give work stealing something to balance.
+  const std::size_t threads = this->ThreadCount() + 1u;
+  if (_grainSize == 0)
+    _grainSize = std::max<std::size_t>(1u, _count / (threads * 4u));
+
+  if (threads == 1u || _count <= _grainSize)
+  {
+    _f(0, _count);
+    return;
+  }
+
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve((_count + _grainSize - 1) / _grainSize);
+  for (std::size_t begin = 0; begin < _count; begin += _grainSize)
+  {
+    const std::size_t end = std::min(_count, begin + _grainSize);
+    tasks.push_back([&_f, begin, end]
+        {
+          _f(begin, end);
+        });
+  }
+  this->Run(tasks);
+}
+
+//////////////////////////////////////////////////
+ThreadPool &ThreadPool::Shared()
+{
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) -
+      1u);
+  return pool;
+}
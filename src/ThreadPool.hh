@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_THREADPOOL_HH_
+#define IGNITION_GAZEBO_THREADPOOL_HH_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    // Forward declarations.
+    class ThreadPoolPrivate;
+
+    /// \class ThreadPool ThreadPool.hh
+    /// \brief Fixed size pool of worker threads with work stealing.
+    ///
+    /// Work is submitted in batches of tasks with Run, which blocks until
+    /// every task in the batch has finished. Tasks are spread over one queue
+    /// per worker, and workers that run out of tasks steal from the other
+    /// queues, so batches with uneven tasks are balanced.
+    ///
+    /// The thread that calls Run also executes tasks of its own batch while
+    /// it waits, but never tasks of other batches. This means a task may
+    /// submit a nested batch without deadlocking or being delayed by
+    /// unrelated work, and that a pool without worker threads runs every
+    /// batch serially.
+    ///
+    /// Tasks must not throw.
+    class IGNITION_GAZEBO_VISIBLE ThreadPool
+    {
+      /// \brief Constructor
+      /// \param[in] _threadCount Number of worker threads. The thread
+      /// calling Run is not included in this count.
+      public: explicit ThreadPool(unsigned int _threadCount);
+
+      /// \brief Destructor. Waits for the worker threads to finish.
+      public: ~ThreadPool();
+
+      /// \brief Get the number of worker threads.
+      /// \return Number of worker threads.
+      public: unsigned int ThreadCount() const;
+
+      /// \brief Run a batch of tasks, and block until all of them are done.
+      /// \param[in] _tasks Tasks to run. They may run in any order and
+      /// concurrently with each other.
+      public: void Run(const std::vector<std::function<void()>> &_tasks);
+
+      /// \brief Split a range of indices into chunks, and run a function on
+      /// each chunk in parallel. Blocks until all chunks are done.
+      /// \param[in] _count Number of indices, the range is [0, _count).
+      /// \param[in] _grainSize Minimum number of indices per chunk. Use 0 to
+      /// pick a size based on the number of threads.
+      /// \param[in] _f Function called with the beginning and end of each
+      /// chunk.
+      public: void ParallelFor(std::size_t _count, std::size_t _grainSize,
+                  const std::function<void(std::size_t, std::size_t)> &_f);
+
+      /// \brief Get a pool shared by the whole process. It's created on first
+      /// use, with one worker thread less than the hardware concurrency, since
+      /// the calling thread also does work.
+      /// \return The shared pool.
+      public: static ThreadPool &Shared();
+
+      /// \brief Pointer to private data.
+      private: std::unique_ptr<ThreadPoolPrivate> dataPtr;
+    };
+    }  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
+  }  // namespace gazebo
+}  // namespace ignition
+
+#endif  // IGNITION_GAZEBO_THREADPOOL_HH_
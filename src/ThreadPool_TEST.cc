@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hh"
+
+using namespace ignition;
+
+//////////////////////////////////////////////////
+TEST(ThreadPool, Run)
+{
+  for (unsigned int threadCount : {0u, 1u, 4u})
+  {
+    gazebo::ThreadPool pool(threadCount);
+    EXPECT_EQ(threadCount, pool.ThreadCount());
+
+    std::vector<int> results(100, 0);
+    std::vector<std::function<void()>> tasks;
+    for (std::size_t i = 0; i < results.size(); ++i)
+      tasks.push_back([&results, i]{results[i] = static_cast<int>(i);});
+
+    // Run the same batch several times
+    for (int run = 0; run < 10; ++run)
+    {
+      std::fill(results.begin(), results.end(), -1);
+      pool.Run(tasks);
+      for (std::size_t i = 0; i < results.size(); ++i)
+        EXPECT_EQ(static_cast<int>(i), results[i]);
+    }
+
+    // Empty batch
+    pool.Run({});
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ThreadPool, RunUsesWorkers)
+{
+  gazebo::ThreadPool pool(3);
+
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::vector<std::function<void()>> tasks;
+  for (int i = 0; i < 16; ++i)
+  {
+    tasks.push_back([&]
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+          std::lock_guard<std::mutex> lock(mutex);
+          ids.insert(std::this_thread::get_id());
+        });
+  }
+  pool.Run(tasks);
+
+  // Tasks are spread over the workers and the calling thread
+  EXPECT_GT(ids.size(), 1u);
+  EXPECT_LE(ids.size(), 4u);
+}
+
+//////////////////////////////////////////////////
+TEST(ThreadPool, NestedRun)
+{
+  gazebo::ThreadPool pool(2);
+
+  std::atomic<int> count{0};
+  std::vector<std::function<void()>> inner;
+  for (int i = 0; i < 8; ++i)
+    inner.push_back([&count]{++count;});
+
+  // Every outer task waits on its own nested batch
+  std::vector<std::function<void()>> outer;
+  for (int i = 0; i < 8; ++i)
+    outer.push_back([&]{pool.Run(inner);});
+
+  pool.Run(outer);
+  EXPECT_EQ(64, count);
+}
+
+//////////////////////////////////////////////////
+TEST(ThreadPool, NestedRunOnlyHelpsOwnBatch)
+{
+  gazebo::ThreadPool pool(2);
+
+  // Depth of outer tasks on each thread
+  static thread_local int depth{0};
+  std::atomic<int> maxDepth{0};
+
+  std::vector<std::function<void()>> inner;
+  for (int i = 0; i < 4; ++i)
+  {
+    inner.push_back([]
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+  }
+
+  std::vector<std::function<void()>> outer;
+  for (int i = 0; i < 16; ++i)
+  {
+    outer.push_back([&]
+        {
+          ++depth;
+          int expected = maxDepth;
+          while (depth > expected &&
+              !maxDepth.compare_exchange_weak(expected, depth))
+          {
+          }
+          pool.Run(inner);
+          --depth;
+        });
+  }
+  pool.Run(outer);
+
+  // Waiting on a nested batch never picks up another outer task
+  EXPECT_EQ(1, maxDepth);
+}
+
+//////////////////////////////////////////////////
+TEST(ThreadPool, ParallelFor)
+{
+  gazebo::ThreadPool pool(3);
+
+  for (std::size_t count : {0u, 1u, 7u, 1000u})
+  {
+    for (std::size_t grain : {0u, 1u, 64u})
+    {
+      std::vector<std::atomic<int>> visits(count);
+      pool.ParallelFor(count, grain,
+          [&](std::size_t _begin, std::size_t _end)
+          {
+            EXPECT_LT(_begin, _end);
+            if (grain > 0)
+            {
+              EXPECT_LE(_end - _begin, grain);
+            }
+            for (std::size_t i = _begin; i < _end; ++i)
+              ++visits[i];
+          });
+
+      // Every index is visited exactly once
+      for (const auto &visit : visits)
+        EXPECT_EQ(1, visit);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ThreadPool, Shared)
+{
+  gazebo::ThreadPool &pool = gazebo::ThreadPool::Shared();
+  EXPECT_EQ(&pool, &gazebo::ThreadPool::Shared());
+  EXPECT_EQ(std::max(1u, std::thread::hardware_concurrency()) - 1u,
+      pool.ThreadCount());
+}
@@ -14,6 +14,8 @@
  * limitations under the License.
  *
 */
+#include <algorithm>
+
 #include "ignition/gazebo/detail/View.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
 
@@ -21,64 +23,268 @@ using namespace ignition;
 using namespace gazebo;
 using namespace detail;
 
+//////////////////////////////////////////////////
+View::View(const ComponentTypeKey &_types)
+  : types(_types.begin(), _types.end())
+{
+}
+
 //////////////////////////////////////////////////
 void View::AddEntity(const Entity _entity, const bool _new)
 {
-  this->entities.insert(_entity);
-  if (_new)
+  auto iter = this->entityRows.find(_entity);
+  if (iter == this->entityRows.end())
   {
-    this->newEntities.insert(_entity);
+    if (_entity < this->maxEntity)
+      this->unsorted = true;
+    this->maxEntity = std::max(this->maxEntity, _entity);
+
+    iter = this->entityRows.emplace(_entity, this->entities.size()).first;
+    this->entities.push_back(_entity);
+    this->newRows.push_back(false);
+    this->toRemoveRows.push_back(false);
+    this->componentIds.resize(this->componentIds.size() + this->types.size(),
+        kComponentIdInvalid);
+    this->componentPtrs.resize(
+        this->componentPtrs.size() + this->types.size(), nullptr);
+  }
+
+  if (_new && !this->newRows[iter->second])
+  {
+    this->newRows[iter->second] = true;
+    ++this->newCount;
   }
 }
 
 //////////////////////////////////////////////////
 void View::AddComponent(const Entity _entity,
     const ComponentTypeId _typeId,
-    const ComponentId _componentId)
+    const ComponentId _componentId,
+    const components::BaseComponent *_comp)
 {
-  this->components.insert(
-      std::make_pair(std::make_pair(_entity, _typeId), _componentId));
+  auto iter = this->entityRows.find(_entity);
+  std::size_t column = this->Column(_typeId);
+  if (iter == this->entityRows.end() || column >= this->types.size())
+    return;
+
+  std::size_t index = iter->second * this->types.size() + column;
+  this->componentIds[index] = _componentId;
+  this->componentPtrs[index] = const_cast<components::BaseComponent *>(_comp);
 }
 
 //////////////////////////////////////////////////
-bool View::RemoveEntity(const Entity _entity, const ComponentTypeKey &_key)
+bool View::RemoveEntity(const Entity _entity, const ComponentTypeKey &)
 {
-  if (this->entities.find(_entity) == this->entities.end())
+  auto iter = this->entityRows.find(_entity);
+  if (iter == this->entityRows.end())
     return false;
 
-  // Otherwise, remove the entity from the view
-  this->entities.erase(_entity);
-  this->newEntities.erase(_entity);
-  this->toRemoveEntities.erase(_entity);
+  // Leave an empty row behind, so that rows don't move while the view may
+  // be iterated. The row is dropped the next time the view is compacted.
+  const std::size_t row = iter->second;
+  this->entityRows.erase(iter);
+  this->entities[row] = kNullEntity;
+  if (this->newRows[row])
+  {
+    this->newRows[row] = false;
+    --this->newCount;
+  }
+  if (this->toRemoveRows[row])
+  {
+    this->toRemoveRows[row] = false;
+    --this->toRemoveCount;
+  }
+  const std::size_t offset = row * this->types.size();
+  std::fill_n(this->componentPtrs.begin() + offset, this->types.size(),
+      nullptr);
+  ++this->emptyCount;
+
+  return true;
+}
 
-  // Remove the entity from the components map
-  for (const ComponentTypeId &compTypeId : _key)
-    this->components.erase(std::make_pair(_entity, compTypeId));
+//////////////////////////////////////////////////
+void View::ClearNewEntities()
+{
+  if (this->newCount == 0)
+    return;
 
+  std::fill(this->newRows.begin(), this->newRows.end(), false);
+  this->newCount = 0;
+}
+
+//////////////////////////////////////////////////
+bool View::AddEntityToRemoved(const Entity _entity)
+{
+  auto iter = this->entityRows.find(_entity);
+  if (iter == this->entityRows.end())
+    return false;
+
+  if (!this->toRemoveRows[iter->second])
+  {
+    this->toRemoveRows[iter->second] = true;
+    ++this->toRemoveCount;
+  }
   return true;
 }
 
-/////////////////////////////////////////////////
-const components::BaseComponent *View::ComponentImplementation(
-    const Entity _entity,
-    ComponentTypeId _typeId,
-    const EntityComponentManager *_ecm) const
+//////////////////////////////////////////////////
+void View::Reset()
 {
-  return _ecm->ComponentImplementation(
-      {_typeId, this->components.at({_entity, _typeId})});
+  // Rows are emptied rather than erased if the view is being iterated.
+  if (this->iterationDepth > 0)
+  {
+    std::vector<Entity> current;
+    current.reserve(this->entityRows.size());
+    for (const auto &entityRow : this->entityRows)
+      current.push_back(entityRow.first);
+    for (const Entity entity : current)
+      this->RemoveEntity(entity, {});
+    return;
+  }
+
+  this->entities.clear();
+  this->newRows.clear();
+  this->toRemoveRows.clear();
+  this->componentIds.clear();
+  this->componentPtrs.clear();
+  this->entityRows.clear();
+  this->newCount = 0;
+  this->toRemoveCount = 0;
+  this->emptyCount = 0;
+  this->maxEntity = kNullEntity;
+  this->unsorted = false;
+  this->stale = false;
 }
 
 //////////////////////////////////////////////////
-void View::ClearNewEntities()
+void View::InvalidateComponents()
 {
-  this->newEntities.clear();
+  this->stale = true;
 }
 
 //////////////////////////////////////////////////
-bool View::AddEntityToRemoved(const Entity _entity)
+bool View::HasComponentType(const ComponentTypeId _typeId) const
+{
+  return this->Column(_typeId) < this->types.size();
+}
+
+//////////////////////////////////////////////////
+std::size_t View::Column(const ComponentTypeId _typeId) const
 {
-  if (this->entities.find(_entity) == this->entities.end())
+  auto iter = std::lower_bound(this->types.begin(), this->types.end(),
+      _typeId);
+  if (iter == this->types.end() || *iter != _typeId)
+    return this->types.size();
+  return static_cast<std::size_t>(std::distance(this->types.begin(), iter));
+}
+
+//////////////////////////////////////////////////
+void View::Prepare(const EntityComponentManager *_ecm)
+{
+  if (_ecm->IsReadOnly())
+    return;
+
+  if (this->iterationDepth == 0 && (this->emptyCount > 0 || this->unsorted))
+    this->Compact();
+
+  if (this->stale)
+    this->RefreshComponents(_ecm);
+}
+
+//////////////////////////////////////////////////
+void View::RefreshComponents(const EntityComponentManager *_ecm)
+{
+  this->stale = false;
+
+  const std::size_t typeCount = this->types.size();
+  for (std::size_t row = 0; row < this->entities.size(); ++row)
+  {
+    if (this->entities[row] == kNullEntity)
+      continue;
+
+    const std::size_t offset = row * typeCount;
+    for (std::size_t column = 0; column < typeCount; ++column)
+    {
+      this->componentPtrs[offset + column] =
+          _ecm->ViewComponentImplementation({this->types[column],
+              this->componentIds[offset + column]});
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void View::Compact()
+{
+  std::vector<std::size_t> order;
+  order.reserve(this->entityRows.size());
+  for (std::size_t row = 0; row < this->entities.size(); ++row)
+  {
+    if (this->entities[row] != kNullEntity)
+      order.push_back(row);
+  }
+
+  if (this->unsorted)
+  {
+    std::sort(order.begin(), order.end(),
+        [this](const std::size_t _a, const std::size_t _b)
+        {
+          return this->entities[_a] < this->entities[_b];
+        });
+  }
+
+  const std::size_t typeCount = this->types.size();
+  std::vector<Entity> newEntities;
+  std::vector<bool> newNewRows;
+  std::vector<bool> newToRemoveRows;
+  std::vector<ComponentId> newComponentIds;
+  std::vector<components::BaseComponent *> newComponentPtrs;
+  newEntities.reserve(order.size());
+  newNewRows.reserve(order.size());
+  newToRemoveRows.reserve(order.size());
+  newComponentIds.reserve(order.size() * typeCount);
+  newComponentPtrs.reserve(order.size() * typeCount);
+
+  for (const std::size_t row : order)
+  {
+    const Entity entity = this->entities[row];
+    this->entityRows[entity] = newEntities.size();
+    newEntities.push_back(entity);
+    newNewRows.push_back(this->newRows[row]);
+    newToRemoveRows.push_back(this->toRemoveRows[row]);
+
+    const std::size_t offset = row * typeCount;
+    newComponentIds.insert(newComponentIds.end(),
+        this->componentIds.begin() + offset,
+        this->componentIds.begin() + offset + typeCount);
+    newComponentPtrs.insert(newComponentPtrs.end(),
+        this->componentPtrs.begin() + offset,
+        this->componentPtrs.begin() + offset + typeCount);
+  }
+
+  this->entities = std::move(newEntities);
+  this->newRows = std::move(newNewRows);
+  this->toRemoveRows = std::move(newToRemoveRows);
+  this->componentIds = std::move(newComponentIds);
+  this->componentPtrs = std::move(newComponentPtrs);
+  this->emptyCount = 0;
+  this->unsorted = false;
+  this->maxEntity = this->entities.empty() ? kNullEntity :
+      this->entities.back();
+}
+
+//////////////////////////////////////////////////
+bool View::BeginIteration(const EntityComponentManager *_ecm)
+{
+  if (_ecm->IsReadOnly())
     return false;
-  this->toRemoveEntities.insert(_entity);
+
+  this->Prepare(_ecm);
+  ++this->iterationDepth;
   return true;
 }
+
+//////////////////////////////////////////////////
+void View::EndIteration()
+{
+  --this->iterationDepth;
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Profiler.hh>
+
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/World.hh"
+
+#include "WorldSnapshot.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Identifies snapshot files.
+static const char kMagic[8] = {'I', 'G', 'N', 'S', 'N', 'A', 'P', '\0'};
+
+/// \brief Version of the file layout.
+static const uint32_t kVersion{1};
+
+/// \brief Append a fixed size value to a file's contents.
+/// \param[out] _out Contents to append to.
+/// \param[in] _value Value to append.
+template <typename T>
+static void appendValue(std::string &_out, const T &_value)
+{
+  _out.append(reinterpret_cast<const char *>(&_value), sizeof(T));
+}
+
+/// \brief Append a string, prefixed by its size, to a file's contents.
+/// \param[out] _out Contents to append to.
+/// \param[in] _str String to append.
+static void appendString(std::string &_out, const std::string &_str)
+{
+  appendValue<uint64_t>(_out, _str.size());
+  _out += _str;
+}
+
+/// \brief Read a fixed size value from a file's contents.
+/// \param[in, out] _data Next byte to read, moved past the value.
+/// \param[in] _end End of the contents.
+/// \param[out] _value Value read.
+/// \return False if the contents are too short.
+template <typename T>
+static bool readValue(const char *&_data, const char *_end, T &_value)
+{
+  if (static_cast<std::size_t>(_end - _data) < sizeof(T))
+    return false;
+  std::memcpy(&_value, _data, sizeof(T));
+  _data += sizeof(T);
+  return true;
+}
+
+/// \brief Read a string written by appendString.
+/// \param[in, out] _data Next byte to read, moved past the string.
+/// \param[in] _end End of the contents.
+/// \param[out] _str String read.
+/// \return False if the contents are too short.
+static bool readString(const char *&_data, const char *_end,
+    std::string &_str)
+{
+  uint64_t size{0};
+  if (!readValue(_data, _end, size) ||
+      static_cast<uint64_t>(_end - _data) < size)
+  {
+    return false;
+  }
+  _str.assign(_data, size);
+  _data += size;
+  return true;
+}
+
+//////////////////////////////////////////////////
+WorldSnapshot::~WorldSnapshot()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool WorldSnapshot::Save(const std::string &_path,
+    const std::string &_worldSdf, const std::vector<Plugin> &_plugins,
+    const EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("WorldSnapshot::Save");
+
+  std::string contents(kMagic, sizeof(kMagic));
+  appendValue(contents, kVersion);
+  appendString(contents, _worldSdf);
+
+  appendValue<uint64_t>(contents, _plugins.size());
+  for (const auto &plugin : _plugins)
+  {
+    appendValue<uint64_t>(contents, plugin.entity);
+    appendString(contents, plugin.filename);
+    appendString(contents, plugin.name);
+    appendString(contents, plugin.sdf);
+  }
+
+  std::string ecm;
+  _ecm.Snapshot(ecm);
+  appendString(contents, ecm);
+
+  std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    ignerr << "Failed to open snapshot file [" << _path << "] for writing."
+           << std::endl;
+    return false;
+  }
+  file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  return file.good();
+}
+
+//////////////////////////////////////////////////
+bool WorldSnapshot::Load(const std::string &_path)
+{
+  IGN_PROFILE("WorldSnapshot::Load");
+
+  this->Close();
+
+#ifndef _WIN32
+  int fd = open(_path.c_str(), O_RDONLY);
+  if (fd >= 0)
+  {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      void *addr = mmap(nullptr, static_cast<std::size_t>(st.st_size),
+          PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED)
+      {
+        this->data = static_cast<const char *>(addr);
+        this->size = static_cast<std::size_t>(st.st_size);
+        this->mapped = true;
+      }
+    }
+    close(fd);
+  }
+#endif
+
+  // Fall back to reading the whole file
+  if (nullptr == this->data)
+  {
+    std::ifstream file(_path, std::ios::binary);
+    if (!file.is_open())
+    {
+      ignerr << "Failed to open snapshot file [" << _path << "]."
+             << std::endl;
+      return false;
+    }
+    this->buffer.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+  }
+
+  const char *next = this->data;
+  const char *end = this->data + this->size;
+
+  uint32_t version{0};
+  if (this->size < sizeof(kMagic) ||
+      std::memcmp(next, kMagic, sizeof(kMagic)) != 0)
+  {
+    ignerr << "File [" << _path << "] isn't a world snapshot." << std::endl;
+    this->Close();
+    return false;
+  }
+  next += sizeof(kMagic);
+
+  if (!readValue(next, end, version) || version != kVersion)
+  {
+    ignerr << "Unsupported version [" << version << "] of world snapshot ["
+           << _path << "], expected [" << kVersion << "]." << std::endl;
+    this->Close();
+    return false;
+  }
+
+  uint64_t pluginCount{0};
+  bool valid = readString(next, end, this->worldSdf) &&
+      readValue(next, end, pluginCount);
+  for (uint64_t i = 0; valid && i < pluginCount; ++i)
+  {
+    Plugin plugin;
+    valid = readValue(next, end, plugin.entity) &&
+        readString(next, end, plugin.filename) &&
+        readString(next, end, plugin.name) &&
+        readString(next, end, plugin.sdf);
+    this->plugins.push_back(std::move(plugin));
+  }
+
+  // The entities are only read when restored, straight from the file.
+  uint64_t ecmBytes{0};
+  valid = valid && readValue(next, end, ecmBytes) &&
+      static_cast<uint64_t>(end - next) >= ecmBytes;
+  if (!valid)
+  {
+    ignerr << "World snapshot [" << _path << "] is truncated." << std::endl;
+    this->Close();
+    return false;
+  }
+  this->ecmData = next;
+  this->ecmSize = ecmBytes;
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+const std::string &WorldSnapshot::WorldSdf() const
+{
+  return this->worldSdf;
+}
+
+//////////////////////////////////////////////////
+const std::vector<WorldSnapshot::Plugin> &WorldSnapshot::Plugins() const
+{
+  return this->plugins;
+}
+
+//////////////////////////////////////////////////
+bool WorldSnapshot::Restore(EntityComponentManager &_ecm,
+    const std::string &_worldName) const
+{
+  IGN_PROFILE("WorldSnapshot::Restore");
+
+  if (nullptr == this->ecmData)
+  {
+    ignerr << "Can't restore a world snapshot which hasn't been loaded."
+           << std::endl;
+    return false;
+  }
+
+  if (!_ecm.LoadSnapshot(this->ecmData, this->ecmSize))
+    return false;
+
+  // Systems such as the scene broadcaster and user commands name their
+  // topics after the world, so rename it before they're loaded.
+  if (!_worldName.empty())
+  {
+    auto world = _ecm.EntityByComponents(components::World());
+    if (kNullEntity != world)
+      _ecm.SetComponentData<components::Name>(world, _worldName);
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+void WorldSnapshot::Close()
+{
+#ifndef _WIN32
+  if (this->mapped)
+    munmap(const_cast<char *>(this->data), this->size);
+#endif
+  this->mapped = false;
+  this->data = nullptr;
+  this->size = 0;
+  this->buffer.clear();
+  this->ecmData = nullptr;
+  this->ecmSize = 0;
+  this->worldSdf.clear();
+  this->plugins.clear();
+}
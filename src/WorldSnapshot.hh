@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_WORLDSNAPSHOT_HH_
+#define IGNITION_GAZEBO_WORLDSNAPSHOT_HH_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Entity.hh>
+#include <ignition/gazebo/EntityComponentManager.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class WorldSnapshot WorldSnapshot.hh
+    /// \brief A file holding a fully initialized world, so it can be
+    /// restored without parsing its original SDF, fetching resources and
+    /// creating its entities.
+    ///
+    /// The file holds the world's SDF with all includes resolved, the
+    /// systems which were loaded from SDF, and the snapshot of the entity
+    /// component manager, see EntityComponentManager::Snapshot. It's memory
+    /// mapped when loaded, where supported.
+    class IGNITION_GAZEBO_VISIBLE WorldSnapshot
+    {
+      /// \brief A system loaded from SDF, which is loaded again when the
+      /// world is restored.
+      public: struct Plugin
+      {
+        /// \brief Entity the system is attached to.
+        Entity entity{kNullEntity};
+
+        /// \brief Library holding the system.
+        std::string filename;
+
+        /// \brief Name of the system in the library.
+        std::string name;
+
+        /// \brief The system's `<plugin>` element.
+        std::string sdf;
+      };
+
+      /// \brief Constructor
+      public: WorldSnapshot() = default;
+
+      /// \brief Destructor, which unmaps the file.
+      public: ~WorldSnapshot();
+
+      /// \brief Copying would unmap the file twice.
+      public: WorldSnapshot(const WorldSnapshot &) = delete;
+
+      /// \brief Copying would unmap the file twice.
+      public: WorldSnapshot &operator=(const WorldSnapshot &) = delete;
+
+      /// \brief Write a snapshot to a file.
+      /// \param[in] _path Path of the file, which is overwritten.
+      /// \param[in] _worldSdf SDF string holding the world.
+      /// \param[in] _plugins Systems loaded from SDF.
+      /// \param[in] _ecm Entity component manager holding the world.
+      /// \return True if the file was written.
+      public: static bool Save(const std::string &_path,
+                  const std::string &_worldSdf,
+                  const std::vector<Plugin> &_plugins,
+                  const EntityComponentManager &_ecm);
+
+      /// \brief Load a snapshot from a file. Its entities are only read when
+      /// restored.
+      /// \param[in] _path Path of the file.
+      /// \return True if the file is a valid snapshot.
+      public: bool Load(const std::string &_path);
+
+      /// \brief Get the world's SDF.
+      /// \return SDF string holding the world.
+      public: const std::string &WorldSdf() const;
+
+      /// \brief Get the systems loaded from SDF.
+      /// \return The systems, in the order they were loaded.
+      public: const std::vector<Plugin> &Plugins() const;
+
+      /// \brief Create the snapshot's entities and components.
+      /// \param[in] _ecm Entity component manager without entities.
+      /// \param[in] _worldName Name given to the restored world entity, so
+      /// copies of a world restored from the same snapshot get their own
+      /// names. The name in the snapshot is kept if empty.
+      /// \return True if successful.
+      public: bool Restore(EntityComponentManager &_ecm,
+                  const std::string &_worldName = "") const;
+
+      /// \brief Unmap or free the loaded file.
+      private: void Close();
+
+      /// \brief Start of the loaded file.
+      private: const char *data{nullptr};
+
+      /// \brief Size of the loaded file in bytes.
+      private: std::size_t size{0};
+
+      /// \brief True if data is memory mapped, false if it's held by buffer.
+      private: bool mapped{false};
+
+      /// \brief Contents of the file where it can't be memory mapped.
+      private: std::string buffer;
+
+      /// \brief Start of the entity component manager's snapshot.
+      private: const char *ecmData{nullptr};
+
+      /// \brief Size of the entity component manager's snapshot.
+      private: std::size_t ecmSize{0};
+
+      /// \brief SDF string holding the world.
+      private: std::string worldSdf;
+
+      /// \brief Systems loaded from SDF.
+      private: std::vector<Plugin> plugins;
+    };
+    }  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
+  }  // namespace gazebo
+}  // namespace ignition
+
+#endif  // IGNITION_GAZEBO_WORLDSNAPSHOT_HH_
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/World.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+#include "ignition/gazebo/test_config.hh"
+
+#include "WorldSnapshot.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+TEST(WorldSnapshot, SaveLoad)
+{
+  const auto path = common::joinPaths(std::string(PROJECT_BINARY_PATH),
+      "world_snapshot_test.snapshot");
+
+  EntityComponentManager ecm;
+  Entity world = ecm.CreateEntity();
+  Entity model = ecm.CreateEntity();
+  ecm.SetParentEntity(model, world);
+  ecm.CreateComponent(world, components::World());
+  ecm.CreateComponent(world, components::Name("default"));
+  ecm.CreateComponent(model, components::Name("box"));
+  ecm.CreateComponent(model,
+      components::Pose(math::Pose3d(1, 2, 3, 0, 0, 0)));
+
+  std::vector<WorldSnapshot::Plugin> plugins{
+      {world, "libfoo.so", "foo::Foo", "<plugin name='foo::Foo'/>"},
+      {model, "libbar.so", "bar::Bar", "<plugin name='bar::Bar'/>"}};
+
+  const std::string sdf{"<sdf version='1.8'><world name='default'/></sdf>"};
+  EXPECT_TRUE(WorldSnapshot::Save(path, sdf, plugins, ecm));
+
+  WorldSnapshot snapshot;
+  ASSERT_TRUE(snapshot.Load(path));
+  EXPECT_EQ(sdf, snapshot.WorldSdf());
+  ASSERT_EQ(2u, snapshot.Plugins().size());
+  EXPECT_EQ(world, snapshot.Plugins()[0].entity);
+  EXPECT_EQ("libfoo.so", snapshot.Plugins()[0].filename);
+  EXPECT_EQ("foo::Foo", snapshot.Plugins()[0].name);
+  EXPECT_EQ("<plugin name='foo::Foo'/>", snapshot.Plugins()[0].sdf);
+  EXPECT_EQ(model, snapshot.Plugins()[1].entity);
+  EXPECT_EQ("bar::Bar", snapshot.Plugins()[1].name);
+
+  EntityComponentManager restored;
+  EXPECT_TRUE(snapshot.Restore(restored));
+  EXPECT_EQ(2u, restored.EntityCount());
+  EXPECT_EQ(world, restored.EntityByComponents(components::Name("default")));
+  EXPECT_EQ(world, restored.ParentEntity(model));
+  EXPECT_EQ(model, restored.EntityByComponents(components::Name("box")));
+  ASSERT_NE(nullptr, restored.Component<components::Pose>(model));
+  EXPECT_EQ(math::Pose3d(1, 2, 3, 0, 0, 0),
+      restored.Component<components::Pose>(model)->Data());
+
+  // Can't restore twice into the same manager
+  EXPECT_FALSE(snapshot.Restore(restored));
+
+  // Copies of the world are restored under their own names
+  EntityComponentManager copy;
+  EXPECT_TRUE(snapshot.Restore(copy, "default_1"));
+  EXPECT_EQ(world, copy.EntityByComponents(components::Name("default_1")));
+  EXPECT_EQ(kNullEntity,
+      copy.EntityByComponents(components::Name("default")));
+  EXPECT_EQ(model, copy.EntityByComponents(components::Name("box")));
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST(WorldSnapshot, Invalid)
+{
+  WorldSnapshot snapshot;
+  EXPECT_FALSE(snapshot.Load("/not/a/snapshot"));
+
+  EntityComponentManager ecm;
+  EXPECT_FALSE(snapshot.Restore(ecm));
+
+  const auto path = common::joinPaths(std::string(PROJECT_BINARY_PATH),
+      "world_snapshot_invalid.snapshot");
+  {
+    std::ofstream file(path);
+    file << "<sdf version='1.8'/>";
+  }
+  EXPECT_FALSE(snapshot.Load(path));
+
+  // Truncated snapshot
+  EXPECT_TRUE(WorldSnapshot::Save(path, "<sdf/>", {}, ecm));
+  std::string contents;
+  {
+    std::ifstream file(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(),
+        static_cast<std::streamsize>(contents.size() - 1));
+  }
+  EXPECT_FALSE(snapshot.Load(path));
+
+  common::removeFile(path);
+}
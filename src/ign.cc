@@ -121,7 +121,8 @@ extern "C" int runServer(const char *_sdfString,
     int _recordResources, int _logOverwrite, int _logCompress,
     const char *_playback, const char *_physicsEngine,
     const char *_renderEngineServer, const char *_renderEngineGui,
-    const char *_file, const char *_recordTopics)
+    const char *_file, const char *_recordTopics, const char *_snapshot,
+    const char *_saveSnapshot)
 {
   ignition::gazebo::ServerConfig serverConfig;
 
@@ -344,9 +345,23 @@ extern "C" int runServer(const char *_sdfString,
     serverConfig.SetRenderEngineGui(_renderEngineGui);
   }
 
+  if (_snapshot != nullptr && std::strlen(_snapshot) > 0)
+  {
+    serverConfig.SetSnapshotPath(_snapshot);
+  }
+
   // Create the Gazebo server
   ignition::gazebo::Server server(serverConfig);
 
+  // Save the initialized world before running it
+  if (_saveSnapshot != nullptr && std::strlen(_saveSnapshot) > 0 &&
+      !server.SaveSnapshot(_saveSnapshot))
+  {
+    ignerr << "Failed to save snapshot [" << _saveSnapshot << "]"
+           << std::endl;
+    return -1;
+  }
+
   // Run the server
   server.Run(true, _iterations, _run == 0);
 
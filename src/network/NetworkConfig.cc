@@ -26,7 +26,7 @@ using namespace gazebo;
 
 /////////////////////////////////////////////////
 NetworkConfig NetworkConfig::FromValues(const std::string &_role,
-    unsigned int _secondaries)
+    unsigned int _secondaries, bool _pipelined)
 {
   NetworkConfig config;
 
@@ -65,6 +65,7 @@ NetworkConfig NetworkConfig::FromValues(const std::string &_role,
   if (config.role == NetworkRole::SimulationPrimary)
   {
     config.numSecondariesExpected = _secondaries;
+    config.pipelined = _pipelined;
     if (config.numSecondariesExpected == 0)
     {
       config.role = NetworkRole::None;
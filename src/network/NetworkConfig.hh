@@ -43,15 +43,22 @@ namespace ignition
       /// \param[in] _role One of [primary, secondary].
       /// \param[in] _secondaries Number of secondaries the primary should
       /// expect. This is only meaningful if _role == primary.
+      /// \param[in] _pipelined True if the primary should pipeline steps
+      /// with the secondaries. This is only meaningful if _role == primary.
       /// \return A NetworkConfig object based on the provided values.
       public: static NetworkConfig FromValues(const std::string &_role,
-                                              unsigned int _secondaries = 0);
+                                              unsigned int _secondaries = 0,
+                                              bool _pipelined = false);
 
       /// \brief Role of this network participant
       public: NetworkRole role { NetworkRole::None };
 
       /// \brief Expect number of network secondaries.
       public: size_t numSecondariesExpected { 0 };
+
+      /// \brief True if the primary applies the secondaries' states one
+      /// step late, so they can step while the primary merges states.
+      public: bool pipelined { false };
     };
     }
   }  // namespace gazebo
@@ -42,6 +42,19 @@ TEST(NetworkManager, ValueConstructor)
     assert(config.numSecondariesExpected == 3);
   }
 
+  {
+    // Primary can pipeline steps
+    auto config = NetworkConfig::FromValues("PRIMARY", 3, true);
+    assert(config.role == NetworkRole::SimulationPrimary);
+    assert(config.pipelined);
+  }
+
+  {
+    // Secondaries don't pipeline steps
+    auto config = NetworkConfig::FromValues("SECONDARY", 0, true);
+    assert(!config.pipelined);
+  }
+
   {
     // Secondary is always valid
     auto config = NetworkConfig::FromValues("SECONDARY", 0);
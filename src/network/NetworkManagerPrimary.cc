@@ -18,10 +18,13 @@
 #include "NetworkManagerPrimary.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <future>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
@@ -30,6 +33,7 @@
 #include "msgs/peer_control.pb.h"
 #include "msgs/simulation_step.pb.h"
 
+#include "ignition/gazebo/components/ParentEntity.hh"
 #include "ignition/gazebo/components/PerformerAffinity.hh"
 #include "ignition/gazebo/components/PerformerLevels.hh"
 #include "ignition/gazebo/Conversions.hh"
@@ -44,6 +48,18 @@ using namespace ignition;
 using namespace gazebo;
 using namespace std::chrono_literals;
 
+/// \brief Number of steps to wait after migrating a performer before
+/// balancing again, so the reported costs have time to settle.
+static const uint64_t kMigrationCooldown{200};
+
+/// \brief Performers are only migrated if the slowest secondary is slower
+/// than the fastest by more than this ratio, so small imbalances don't cause
+/// performers to bounce between secondaries.
+static const double kImbalanceThreshold{0.2};
+
+/// \brief Weight of each new sample in the averaged costs.
+static const double kCostWeight{0.1};
+
 //////////////////////////////////////////////////
 NetworkManagerPrimary::NetworkManagerPrimary(
     const std::function<void(const UpdateInfo &_info)> &_stepFunction,
@@ -96,6 +112,7 @@ void NetworkManagerPrimary::Handshake()
              << timeout << " ms" << std::endl;
     }
 
+    std::lock_guard<std::mutex> lock(this->statesMutex);
     this->secondaries[sc->prefix] = std::move(sc);
   }
 }
@@ -142,10 +159,37 @@ bool NetworkManagerPrimary::Step(const UpdateInfo &_info)
     return false;
   }
 
+  // When pipelined, secondaries compute this step while the primary applies
+  // their states from the previous step and runs its own systems.
+  if (this->dataPtr->config.pipelined)
+  {
+    this->simStepPub.Publish(step);
+
+    if (!this->Flush())
+      return false;
+    this->stepInFlight = true;
+
+    // Nothing else runs while paused, so don't leave the states of a paused
+    // step in flight until simulation resumes.
+    if (_info.paused && !this->Flush())
+      return false;
+
+    // Step all systems
+    this->dataPtr->stepFunction(_info);
+
+    this->dataPtr->ecm->SetAllComponentsUnchanged();
+
+    return true;
+  }
+
   // Send step to all secondaries
-  this->secondaryStates.clear();
-  this->secondaryStatesPromise = std::promise<void>{};
-  auto future = this->secondaryStatesPromise.get_future();
+  std::future<void> future;
+  {
+    std::lock_guard<std::mutex> lock(this->statesMutex);
+    this->secondaryStates.clear();
+    this->secondaryStatesPromise = std::promise<void>{};
+    future = this->secondaryStatesPromise.get_future();
+  }
   this->simStepPub.Publish(step);
 
   // Block until all secondaries are done
@@ -156,7 +200,12 @@ bool NetworkManagerPrimary::Step(const UpdateInfo &_info)
 
     if (std::future_status::ready != result)
     {
-      ignerr << "Waited 10 s and got only [" << this->secondaryStates.size()
+      std::size_t received;
+      {
+        std::lock_guard<std::mutex> lock(this->statesMutex);
+        received = this->secondaryStates.size();
+      }
+      ignerr << "Waited 10 s and got only [" << received
              << " / " << this->secondaries.size()
              << "] responses from secondaries. Stopping simulation."
              << std::endl;
@@ -168,11 +217,16 @@ bool NetworkManagerPrimary::Step(const UpdateInfo &_info)
   // Update primary state with states received from secondaries
   {
     IGN_PROFILE("Updating primary state");
-    for (const auto &msg : this->secondaryStates)
+    std::vector<private_msgs::SimulationStepAck> states;
     {
-      this->dataPtr->ecm->SetState(msg);
+      std::lock_guard<std::mutex> lock(this->statesMutex);
+      states.swap(this->secondaryStates);
+    }
+    for (const auto &msg : states)
+    {
+      this->UpdateCosts(msg);
+      this->dataPtr->ecm->SetState(msg.state());
     }
-    this->secondaryStates.clear();
   }
 
   // Step all systems
@@ -183,6 +237,70 @@ bool NetworkManagerPrimary::Step(const UpdateInfo &_info)
   return true;
 }
 
+//////////////////////////////////////////////////
+bool NetworkManagerPrimary::Flush()
+{
+  if (!this->stepInFlight)
+    return true;
+
+  // Cleared first, so a step which timed out isn't waited for again
+  this->stepInFlight = false;
+  return this->ApplyPipelinedStates();
+}
+
+//////////////////////////////////////////////////
+bool NetworkManagerPrimary::ApplyPipelinedStates()
+{
+  IGN_PROFILE("NetworkManagerPrimary::ApplyPipelinedStates");
+
+  std::set<std::string> pending;
+  for (const auto &secondary : this->secondaries)
+    pending.insert(secondary.first);
+
+  // Apply each state as soon as it arrives, so the slowest secondary only
+  // has to wait for its own state to be applied.
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (!pending.empty())
+  {
+    private_msgs::SimulationStepAck msg;
+    {
+      std::unique_lock<std::mutex> lock(this->statesMutex);
+      auto prefixIt = pending.end();
+      auto stateQueued = [&]
+      {
+        prefixIt = std::find_if(pending.begin(), pending.end(),
+            [&](const std::string &_prefix)
+            {
+              return !this->secondaries.at(_prefix)->states.empty();
+            });
+        return prefixIt != pending.end();
+      };
+
+      if (!this->statesCv.wait_until(lock, deadline, stateQueued))
+      {
+        ignerr << "Waited 10 s and got only ["
+               << this->secondaries.size() - pending.size() << " / "
+               << this->secondaries.size()
+               << "] responses from secondaries. Stopping simulation."
+               << std::endl;
+        this->dataPtr->eventMgr->Emit<events::Stop>();
+        return false;
+      }
+
+      auto &states = this->secondaries.at(*prefixIt)->states;
+      msg = std::move(states.front());
+      states.pop_front();
+      pending.erase(prefixIt);
+    }
+
+    IGN_PROFILE("Updating primary state");
+    this->UpdateCosts(msg);
+    this->dataPtr->ecm->SetState(msg.state());
+  }
+
+  return true;
+}
+
 //////////////////////////////////////////////////
 std::string NetworkManagerPrimary::Namespace() const
 {
@@ -197,8 +315,28 @@ std::map<std::string, SecondaryControl::Ptr>
 }
 
 //////////////////////////////////////////////////
-void NetworkManagerPrimary::OnStepAck(const msgs::SerializedStateMap &_msg)
+void NetworkManagerPrimary::OnStepAck(
+    const private_msgs::SimulationStepAck &_msg)
 {
+  if (this->dataPtr->config.pipelined)
+  {
+    // Queue the state for the secondary that sent it
+    {
+      std::lock_guard<std::mutex> lock(this->statesMutex);
+      auto it = this->secondaries.find(_msg.secondary_prefix());
+      if (it == this->secondaries.end())
+      {
+        ignerr << "Received state from unknown secondary ["
+               << _msg.secondary_prefix() << "]." << std::endl;
+        return;
+      }
+      it->second->states.push_back(_msg);
+    }
+    this->statesCv.notify_one();
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->statesMutex);
   this->secondaryStates.push_back(_msg);
   if (this->secondaryStates.size() == this->secondaries.size())
   {
@@ -300,9 +438,128 @@ void NetworkManagerPrimary::PopulateAffinities(
     return;
   }
 
+  this->BalanceLoad(_msg);
+
   // TODO(louise) Process level changes
 }
 
+//////////////////////////////////////////////////
+void NetworkManagerPrimary::BalanceLoad(private_msgs::SimulationStep &_msg)
+{
+  IGN_PROFILE("NetworkManagerPrimary::BalanceLoad");
+
+  if (this->secondaries.size() < 2u ||
+      ++this->stepsSinceMigration < kMigrationCooldown)
+  {
+    return;
+  }
+
+  // Find the slowest and fastest secondaries, once all of them reported
+  SecondaryControl *slowest{nullptr};
+  SecondaryControl *fastest{nullptr};
+  for (const auto &secondary : this->secondaries)
+  {
+    auto sc = secondary.second.get();
+    if (!sc->hasCost)
+      return;
+    if (nullptr == slowest || sc->stepCost > slowest->stepCost)
+      slowest = sc;
+    if (nullptr == fastest || sc->stepCost < fastest->stepCost)
+      fastest = sc;
+  }
+
+  if (slowest->stepCost <= fastest->stepCost * (1.0 + kImbalanceThreshold))
+    return;
+
+  // Pick the performer which brings both secondaries closest to each other.
+  // Only performers costing less than the difference qualify, otherwise the
+  // fastest secondary would become at least as slow as the slowest was.
+  const double diff = slowest->stepCost - fastest->stepCost;
+  Entity performer{kNullEntity};
+  double performerCost{0.0};
+  double bestError{diff};
+  this->dataPtr->ecm->Each<components::PerformerAffinity>(
+    [&](const Entity &_entity,
+        const components::PerformerAffinity *_affinity) -> bool
+    {
+      if (_affinity->Data() != slowest->prefix)
+        return true;
+
+      auto costIt = this->performerCosts.find(_entity);
+      if (costIt == this->performerCosts.end())
+        return true;
+
+      double error = std::abs(diff - 2.0 * costIt->second);
+      if (error < bestError)
+      {
+        bestError = error;
+        performer = _entity;
+        performerCost = costIt->second;
+      }
+      return true;
+    });
+
+  if (kNullEntity == performer)
+    return;
+
+  auto parent =
+      this->dataPtr->ecm->Component<components::ParentEntity>(performer);
+  if (nullptr == parent)
+    return;
+
+  ignmsg << "Migrating performer [" << performer << "] from secondary ["
+         << slowest->prefix << "] to [" << fastest->prefix
+         << "] to balance their load." << std::endl;
+
+  auto affinityMsg = _msg.add_affinity();
+  this->SetAffinity(performer, fastest->prefix, affinityMsg);
+
+  // The model was removed from the new secondary when the performer was
+  // assigned elsewhere, so send it the whole model.
+  this->dataPtr->ecm->State(*affinityMsg->mutable_state(),
+      this->dataPtr->ecm->Descendants(parent->Data()), {}, true);
+
+  // Until the secondaries report their new costs, assume the performer
+  // costs the same on both.
+  slowest->stepCost -= performerCost;
+  fastest->stepCost += performerCost;
+  this->stepsSinceMigration = 0;
+}
+
+//////////////////////////////////////////////////
+void NetworkManagerPrimary::UpdateCosts(
+    const private_msgs::SimulationStepAck &_msg)
+{
+  auto average = [](double &_average, double _sample)
+  {
+    _average = kCostWeight * _sample + (1.0 - kCostWeight) * _average;
+  };
+
+  for (const auto &perfCost : _msg.performer_cost())
+  {
+    auto costIt = this->performerCosts.find(perfCost.entity().id());
+    if (costIt == this->performerCosts.end())
+      this->performerCosts[perfCost.entity().id()] = perfCost.cost_us();
+    else
+      average(costIt->second, perfCost.cost_us());
+  }
+
+  auto it = this->secondaries.find(_msg.secondary_prefix());
+  if (it == this->secondaries.end())
+    return;
+
+  auto &sc = it->second;
+  if (!sc->hasCost)
+  {
+    sc->stepCost = _msg.step_cost_us();
+    sc->hasCost = true;
+  }
+  else
+  {
+    average(sc->stepCost, _msg.step_cost_us());
+  }
+}
+
 //////////////////////////////////////////////////
 void NetworkManagerPrimary::SetAffinity(Entity _performer,
     const std::string &_secondary, private_msgs::PerformerAffinity *_msg)
@@ -18,9 +18,12 @@
 #define IGNITION_GAZEBO_NETWORK_NETWORKMANAGERPRIMARY_HH_
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -50,6 +53,16 @@ namespace ignition
       /// \brief prefix namespace of the secondary peer
       std::string prefix;
 
+      /// \brief States received from the secondary which haven't been
+      /// applied yet. Only used when steps are pipelined.
+      std::deque<private_msgs::SimulationStepAck> states;
+
+      /// \brief Averaged time the secondary takes to step, in microseconds.
+      double stepCost{0.0};
+
+      /// \brief True once the secondary has reported its step cost.
+      bool hasCost{false};
+
       /// \brief Convenience alias for unique_ptr.
       using Ptr = std::unique_ptr<SecondaryControl>;
     };
@@ -88,9 +101,22 @@ namespace ignition
       /// peers.
       public: std::map<std::string, SecondaryControl::Ptr>& Secondaries();
 
+      /// \brief Apply the states of the step the secondaries are computing,
+      /// if any, waiting for them. Steps are only in flight when pipelined.
+      /// This should be called when the primary stops stepping, so the
+      /// states of its last step aren't lost.
+      /// \return False if some secondaries didn't respond in time.
+      public: bool Flush();
+
       /// \brief Callback for step ack messages.
-      /// \param[in] _msg Message containing secondary's updated state.
-      private: void OnStepAck(const msgs::SerializedStateMap &_msg);
+      /// \param[in] _msg Message containing secondary's updated state and
+      /// costs.
+      private: void OnStepAck(const private_msgs::SimulationStepAck &_msg);
+
+      /// \brief Apply the states of the previous step from all secondaries,
+      /// in the order they arrive. Only used when steps are pipelined.
+      /// \return False if some secondaries didn't respond in time.
+      private: bool ApplyPipelinedStates();
 
       /// \brief Check if the step publisher has connections.
       private: bool SecondariesCanStep() const;
@@ -100,6 +126,19 @@ namespace ignition
       /// \param[in] _msg Step message.
       private: void PopulateAffinities(private_msgs::SimulationStep &_msg);
 
+      /// \brief Migrate a performer from the slowest to the fastest
+      /// secondary, if they're unbalanced enough. Only one performer is
+      /// migrated at a time, and costs are left to settle before the next
+      /// migration.
+      /// \param[in] _msg Step message, populated with the new affinity.
+      private: void BalanceLoad(private_msgs::SimulationStep &_msg);
+
+      /// \brief Update the averaged costs with the ones reported by a
+      /// secondary.
+      /// \param[in] _msg Step ack from the secondary.
+      private: void UpdateCosts(
+          const private_msgs::SimulationStepAck &_msg);
+
       /// \brief Set the performer to secondary affinity.
       /// \param[in] _performer Performer entity.
       /// \param[in] _secondary Secondary identifier.
@@ -117,10 +156,28 @@ namespace ignition
       private: ignition::transport::Node::Publisher simStepPub;
 
       /// \brief Keep track of states received from secondaries.
-      private: std::vector<msgs::SerializedStateMap> secondaryStates;
+      private: std::vector<private_msgs::SimulationStepAck> secondaryStates;
 
       /// \brief Promise used to notify when all secondaryStates where received.
       private: std::promise<void> secondaryStatesPromise;
+
+      /// \brief Protects secondaries, their queues of states and
+      /// secondaryStates, which are accessed from transport callbacks.
+      private: std::mutex statesMutex;
+
+      /// \brief Notified when a state is queued by a secondary.
+      private: std::condition_variable statesCv;
+
+      /// \brief True if the secondaries are computing a pipelined step whose
+      /// states haven't been applied yet.
+      private: bool stepInFlight{false};
+
+      /// \brief Averaged cost of each performer, in microseconds, as
+      /// reported by the secondary simulating it.
+      private: std::map<Entity, double> performerCosts;
+
+      /// \brief Number of steps since a performer was last migrated.
+      private: uint64_t stepsSinceMigration{0};
     };
     }
   }  // namespace gazebo
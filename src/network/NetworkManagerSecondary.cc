@@ -16,6 +16,7 @@
 */
 
 #include <algorithm>
+#include <chrono>
 #include <string>
 
 #include <ignition/common/Console.hh>
@@ -61,7 +62,8 @@ NetworkManagerSecondary::NetworkManagerSecondary(
 
   this->node.Subscribe("step", &NetworkManagerSecondary::OnStep, this);
 
-  this->stepAckPub = this->node.Advertise<msgs::SerializedStateMap>("step_ack");
+  this->stepAckPub =
+      this->node.Advertise<private_msgs::SimulationStepAck>("step_ack");
 }
 
 //////////////////////////////////////////////////
@@ -117,6 +119,29 @@ void NetworkManagerSecondary::OnStep(
 
     if (affinityMsg.secondary_prefix() == this->Namespace())
     {
+      // A performer migrating from another secondary comes with the state of
+      // its model, which was removed from this secondary.
+      if (affinityMsg.has_state() &&
+          nullptr == this->dataPtr->ecm->Component<components::ParentEntity>(
+          entityId))
+      {
+        this->dataPtr->ecm->SetState(affinityMsg.state());
+
+        // The entity graph isn't part of the state, so rebuild it from the
+        // parent components.
+        for (const auto &entityIt : affinityMsg.state().entities())
+        {
+          auto parent =
+              this->dataPtr->ecm->Component<components::ParentEntity>(
+              entityIt.first);
+          if (parent)
+          {
+            this->dataPtr->ecm->SetParentEntity(entityIt.first,
+                parent->Data());
+          }
+        }
+      }
+
       this->performers.insert(entityId);
 
       ignmsg << "Secondary [" << this->Namespace()
@@ -126,9 +151,12 @@ void NetworkManagerSecondary::OnStep(
     // If performer has been assigned to another secondary, remove it
     else
     {
+      // The model may have been removed already, when migrating performers
+      // between other secondaries
       auto parent =
           this->dataPtr->ecm->Component<components::ParentEntity>(entityId);
-      this->dataPtr->ecm->RequestRemoveEntity(parent->Data());
+      if (parent)
+        this->dataPtr->ecm->RequestRemoveEntity(parent->Data());
 
       if (this->performers.find(entityId) != this->performers.end())
       {
@@ -143,13 +171,19 @@ void NetworkManagerSecondary::OnStep(
   // Update info
   auto info = convert<UpdateInfo>(_msg.stats());
 
-  // Step runner
+  // Step runner, timing it so the primary can balance the load
+  auto stepStart = std::chrono::steady_clock::now();
   this->dataPtr->stepFunction(info);
 
-  // Update state with all the performer's entities
-  std::unordered_set<Entity> entities;
+  // Update state with all the performer's entities, timing the work on each
+  // performer's model so the primary knows how much each of them costs.
+  private_msgs::SimulationStepAck ackMsg;
+  ackMsg.set_secondary_prefix(this->Namespace());
+  auto stateMsg = ackMsg.mutable_state();
   for (const auto &perf : this->performers)
   {
+    auto perfStart = std::chrono::steady_clock::now();
+
     // Performer model
     auto parent = this->dataPtr->ecm->Component<components::ParentEntity>(perf);
     if (parent == nullptr)
@@ -161,16 +195,21 @@ void NetworkManagerSecondary::OnStep(
     auto modelEntity = parent->Data();
 
     auto children = this->dataPtr->ecm->Descendants(modelEntity);
-    entities.insert(children.begin(), children.end());
+    this->dataPtr->ecm->State(*stateMsg, children);
+
+    auto costMsg = ackMsg.add_performer_cost();
+    costMsg->mutable_entity()->set_id(perf);
+    costMsg->set_cost_us(std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - perfStart).count());
   }
 
-  msgs::SerializedStateMap stateMsg;
-  if (!entities.empty())
-    this->dataPtr->ecm->State(stateMsg, entities);
-  stateMsg.set_has_one_time_component_changes(
+  ackMsg.set_step_cost_us(std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now() - stepStart).count());
+
+  stateMsg->set_has_one_time_component_changes(
     this->dataPtr->ecm->HasOneTimeComponentChanges());
 
-  this->stepAckPub.Publish(stateMsg);
+  this->stepAckPub.Publish(ackMsg);
 
   this->dataPtr->ecm->SetAllComponentsUnchanged();
 }
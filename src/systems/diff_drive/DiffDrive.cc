@@ -35,6 +35,7 @@
 #include "ignition/gazebo/components/CanonicalLink.hh"
 #include "ignition/gazebo/components/JointPosition.hh"
 #include "ignition/gazebo/components/JointVelocityCmd.hh"
+#include "ignition/gazebo/components/Name.hh"
 #include "ignition/gazebo/Link.hh"
 #include "ignition/gazebo/Model.hh"
 #include "ignition/gazebo/Util.hh"
@@ -109,6 +110,11 @@ class ignition::gazebo::systems::DiffDrivePrivate
   /// \brief Model interface
   public: Model model{kNullEntity};
 
+  /// \brief True if the joints were found on Configure, so the system
+  /// declares its component access and doesn't create components on
+  /// PreUpdate.
+  public: bool accessDeclared{false};
+
   /// \brief The model's canonical link.
   public: Link canonicalLink{kNullEntity};
 
@@ -200,6 +206,45 @@ void DiffDrive::Configure(const Entity &_entity,
     sdfElem = sdfElem->GetNextElement("right_joint");
   }
 
+  // If the joints already exist, create the components accessed on
+  // PreUpdate, so the system can declare its access. Otherwise, the joints
+  // are looked up and their components created on PreUpdate.
+  auto findJoints = [&](const std::vector<std::string> &_names,
+      std::vector<Entity> &_joints)
+  {
+    for (const std::string &name : _names)
+    {
+      Entity joint = this->dataPtr->model.JointByName(_ecm, name);
+      if (joint != kNullEntity)
+        _joints.push_back(joint);
+    }
+  };
+  findJoints(this->dataPtr->leftJointNames, this->dataPtr->leftJoints);
+  findJoints(this->dataPtr->rightJointNames, this->dataPtr->rightJoints);
+
+  if (this->dataPtr->leftJoints.empty() || this->dataPtr->rightJoints.empty())
+  {
+    this->dataPtr->leftJoints.clear();
+    this->dataPtr->rightJoints.clear();
+  }
+  else
+  {
+    for (const auto &joints :
+        {this->dataPtr->leftJoints, this->dataPtr->rightJoints})
+    {
+      for (Entity joint : joints)
+      {
+        if (!_ecm.Component<components::JointVelocityCmd>(joint))
+          _ecm.CreateComponent(joint, components::JointVelocityCmd({0.0}));
+      }
+
+      // The position of the first joint of each side is used for odometry
+      if (!_ecm.Component<components::JointPosition>(joints[0]))
+        _ecm.CreateComponent(joints[0], components::JointPosition());
+    }
+    this->dataPtr->accessDeclared = true;
+  }
+
   this->dataPtr->wheelSeparation = _sdf->Get<double>("wheel_separation",
       this->dataPtr->wheelSeparation).first;
   this->dataPtr->wheelRadius = _sdf->Get<double>("wheel_radius",
@@ -379,6 +424,8 @@ void DiffDrive::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
   if (_info.paused)
     return;
 
+  // Components are only created here if the system didn't declare its
+  // access, since declared systems may run concurrently with others.
   for (Entity joint : this->dataPtr->leftJoints)
   {
     // skip this entity if it has been removed
@@ -390,8 +437,11 @@ void DiffDrive::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
 
     if (vel == nullptr)
     {
-      _ecm.CreateComponent(
-          joint, components::JointVelocityCmd({this->dataPtr->leftJointSpeed}));
+      if (!this->dataPtr->accessDeclared)
+      {
+        _ecm.CreateComponent(joint,
+            components::JointVelocityCmd({this->dataPtr->leftJointSpeed}));
+      }
     }
     else
     {
@@ -410,8 +460,11 @@ void DiffDrive::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
 
     if (vel == nullptr)
     {
-      _ecm.CreateComponent(joint,
-          components::JointVelocityCmd({this->dataPtr->rightJointSpeed}));
+      if (!this->dataPtr->accessDeclared)
+      {
+        _ecm.CreateComponent(joint,
+            components::JointVelocityCmd({this->dataPtr->rightJointSpeed}));
+      }
     }
     else
     {
@@ -419,6 +472,9 @@ void DiffDrive::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
     }
   }
 
+  if (this->dataPtr->accessDeclared)
+    return;
+
   // Create the left and right side joint position components if they
   // don't exist.
   auto leftPos = _ecm.Component<components::JointPosition>(
@@ -438,6 +494,16 @@ void DiffDrive::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
   }
 }
 
+//////////////////////////////////////////////////
+bool DiffDrive::ComponentAccess(std::set<ComponentTypeId> &_reads,
+    std::set<ComponentTypeId> &_writes)
+{
+  // The model's name is read on every PreUpdate
+  _reads.insert(components::Name::typeId);
+  _writes.insert(components::JointVelocityCmd::typeId);
+  return this->dataPtr->accessDeclared;
+}
+
 //////////////////////////////////////////////////
 void DiffDrive::PostUpdate(const UpdateInfo &_info,
     const EntityComponentManager &_ecm)
@@ -605,6 +671,7 @@ IGNITION_ADD_PLUGIN(DiffDrive,
                     ignition::gazebo::System,
                     DiffDrive::ISystemConfigure,
                     DiffDrive::ISystemPreUpdate,
-                    DiffDrive::ISystemPostUpdate)
+                    DiffDrive::ISystemPostUpdate,
+                    DiffDrive::ISystemComponentAccess)
 
 IGNITION_ADD_PLUGIN_ALIAS(DiffDrive, "ignition::gazebo::systems::DiffDrive")
@@ -18,6 +18,7 @@
 #define IGNITION_GAZEBO_SYSTEMS_DIFFDRIVE_HH_
 
 #include <memory>
+#include <set>
 
 #include <ignition/gazebo/System.hh>
 
@@ -77,11 +78,18 @@ namespace systems
   /// `ignition.msgs.Pose_V` message and the `<odom_topic>`
   /// `ignition.msgs.Odometry` message. This element if optional,
   ///  and the default value is `{name_of_model}/{name_of_link}`.
+  ///
+  /// If the joints exist when the system is configured, their command
+  /// components are created then, so the controller can run concurrently
+  /// with other systems which don't access joint velocity commands.
+  /// Otherwise, the joints are looked up on every PreUpdate until they're
+  /// found, and the controller runs by itself.
   class DiffDrive
       : public System,
         public ISystemConfigure,
         public ISystemPreUpdate,
-        public ISystemPostUpdate
+        public ISystemPostUpdate,
+        public ISystemComponentAccess
   {
     /// \brief Constructor
     public: DiffDrive();
@@ -105,6 +113,10 @@ namespace systems
                 const UpdateInfo &_info,
                 const EntityComponentManager &_ecm) override;
 
+    // Documentation inherited
+    public: bool ComponentAccess(std::set<ComponentTypeId> &_reads,
+                std::set<ComponentTypeId> &_writes) override;
+
     /// \brief Private data pointer
     private: std::unique_ptr<DiffDrivePrivate> dataPtr;
   };
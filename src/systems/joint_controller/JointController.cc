@@ -19,6 +19,7 @@
 
 #include <ignition/msgs/double.pb.h>
 
+#include <set>
 #include <string>
 
 #include <ignition/common/Profiler.hh>
@@ -45,7 +46,7 @@ class ignition::gazebo::systems::JointControllerPrivate
   public: transport::Node node;
 
   /// \brief Joint Entity
-  public: Entity jointEntity;
+  public: Entity jointEntity{kNullEntity};
 
   /// \brief Commanded joint velocity
   public: double jointVelCmd;
@@ -142,6 +143,26 @@ void JointController::Configure(const Entity &_entity,
     igndbg << "[JointController] Velocity mode" << std::endl;
   }
 
+  // Create the components accessed on PreUpdate, which can't create them
+  if (!_ecm.Component<components::JointVelocity>(this->dataPtr->jointEntity))
+  {
+    _ecm.CreateComponent(this->dataPtr->jointEntity,
+        components::JointVelocity());
+  }
+  if (this->dataPtr->useForceCommands &&
+      !_ecm.Component<components::JointForceCmd>(this->dataPtr->jointEntity))
+  {
+    _ecm.CreateComponent(this->dataPtr->jointEntity,
+        components::JointForceCmd({0.0}));
+  }
+  if (!this->dataPtr->useForceCommands &&
+      !_ecm.Component<components::JointVelocityCmd>(
+      this->dataPtr->jointEntity))
+  {
+    _ecm.CreateComponent(this->dataPtr->jointEntity,
+        components::JointVelocityCmd({this->dataPtr->jointVelCmd}));
+  }
+
   // Subscribe to commands
   std::string topic = transport::TopicUtils::AsValidTopic("/model/" +
       this->dataPtr->model.Name(_ecm) + "/joint/" + jointName +
@@ -194,14 +215,10 @@ void JointController::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
   if (_info.paused)
     return;
 
-  // Create joint velocity component if one doesn't exist
+  // The components are created on Configure. They're only missing if
+  // someone else removed them.
   auto jointVelComp =
       _ecm.Component<components::JointVelocity>(this->dataPtr->jointEntity);
-  if (jointVelComp == nullptr)
-  {
-    _ecm.CreateComponent(
-        this->dataPtr->jointEntity, components::JointVelocity());
-  }
   if (jointVelComp == nullptr)
     return;
 
@@ -221,12 +238,7 @@ void JointController::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
 
       auto forceComp =
           _ecm.Component<components::JointForceCmd>(this->dataPtr->jointEntity);
-      if (forceComp == nullptr)
-      {
-        _ecm.CreateComponent(this->dataPtr->jointEntity,
-                             components::JointForceCmd({force}));
-      }
-      else
+      if (forceComp != nullptr && !forceComp->Data().empty())
       {
         forceComp->Data()[0] = force;
       }
@@ -239,19 +251,25 @@ void JointController::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
     auto vel =
       _ecm.Component<components::JointVelocityCmd>(this->dataPtr->jointEntity);
 
-    if (vel == nullptr)
-    {
-      _ecm.CreateComponent(
-          this->dataPtr->jointEntity,
-          components::JointVelocityCmd({targetVel}));
-    }
-    else if (!vel->Data().empty())
+    if (vel != nullptr && !vel->Data().empty())
     {
       vel->Data()[0] = targetVel;
     }
   }
 }
 
+//////////////////////////////////////////////////
+bool JointController::ComponentAccess(std::set<ComponentTypeId> &_reads,
+    std::set<ComponentTypeId> &_writes)
+{
+  _reads.insert(components::JointVelocity::typeId);
+  if (this->dataPtr->useForceCommands)
+    _writes.insert(components::JointForceCmd::typeId);
+  else
+    _writes.insert(components::JointVelocityCmd::typeId);
+  return true;
+}
+
 //////////////////////////////////////////////////
 void JointControllerPrivate::OnCmdVel(const msgs::Double &_msg)
 {
@@ -262,7 +280,8 @@ void JointControllerPrivate::OnCmdVel(const msgs::Double &_msg)
 IGNITION_ADD_PLUGIN(JointController,
                     ignition::gazebo::System,
                     JointController::ISystemConfigure,
-                    JointController::ISystemPreUpdate)
+                    JointController::ISystemPreUpdate,
+                    JointController::ISystemComponentAccess)
 
 IGNITION_ADD_PLUGIN_ALIAS(JointController,
                           "ignition::gazebo::systems::JointController")
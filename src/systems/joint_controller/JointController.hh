@@ -19,6 +19,7 @@
 
 #include <ignition/gazebo/System.hh>
 #include <memory>
+#include <set>
 
 namespace ignition
 {
@@ -74,10 +75,15 @@ namespace systems
   ///
   /// `<cmd_offset>` Command offset (feed-forward) of the PID.
   /// The default value is 0.
+  ///
+  /// The joint's velocity and command components are created on Configure,
+  /// so the controller can run concurrently with other systems which don't
+  /// access the command it writes.
   class JointController
       : public System,
         public ISystemConfigure,
-        public ISystemPreUpdate
+        public ISystemPreUpdate,
+        public ISystemComponentAccess
   {
     /// \brief Constructor
     public: JointController();
@@ -96,6 +102,10 @@ namespace systems
                 const ignition::gazebo::UpdateInfo &_info,
                 ignition::gazebo::EntityComponentManager &_ecm) override;
 
+    // Documentation inherited
+    public: bool ComponentAccess(std::set<ComponentTypeId> &_reads,
+                std::set<ComponentTypeId> &_writes) override;
+
     /// \brief Private data pointer
     private: std::unique_ptr<JointControllerPrivate> dataPtr;
   };
@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ChunkedLog.hh"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Profiler.hh>
+
+using namespace ignition;
+using namespace gazebo;
+using namespace systems;
+
+/// \brief Identifies chunked log files.
+static const char kMagic[8] = {'I', 'G', 'N', 'C', 'L', 'O', 'G', '\0'};
+
+/// \brief Identifies chunked log index files.
+static const char kIndexMagic[8] = {'I', 'G', 'N', 'C', 'I', 'D', 'X', '\0'};
+
+/// \brief Version of the file layout.
+static const uint32_t kVersion{1};
+
+/// \brief Size of a chunk which is written even if it doesn't span its
+/// window of time yet.
+static const std::size_t kMaxChunkBytes{8u * 1024u * 1024u};
+
+/// \brief Number of decompressed chunks kept after a query.
+static const std::size_t kCachedChunks{2u};
+
+/// \brief Append a fixed size value to a file's contents.
+/// \param[out] _out Contents to append to.
+/// \param[in] _value Value to append.
+template <typename T>
+static void appendValue(std::string &_out, const T &_value)
+{
+  _out.append(reinterpret_cast<const char *>(&_value), sizeof(T));
+}
+
+/// \brief Read a fixed size value from a file's contents.
+/// \param[in, out] _data Next byte to read, moved past the value.
+/// \param[in] _end End of the contents.
+/// \param[out] _value Value read.
+/// \return False if the contents are too short.
+template <typename T>
+static bool readValue(const char *&_data, const char *_end, T &_value)
+{
+  if (static_cast<std::size_t>(_end - _data) < sizeof(T))
+    return false;
+  std::memcpy(&_value, _data, sizeof(T));
+  _data += sizeof(T);
+  return true;
+}
+
+/// \brief Read a string prefixed by its size, without copying it.
+/// \param[in, out] _data Next byte to read, moved past the string.
+/// \param[in] _end End of the contents.
+/// \param[out] _str String read.
+/// \return False if the contents are too short.
+template <typename SizeT>
+static bool readView(const char *&_data, const char *_end,
+    std::string_view &_str)
+{
+  SizeT size{0};
+  if (!readValue(_data, _end, size) ||
+      static_cast<uint64_t>(_end - _data) < size)
+  {
+    return false;
+  }
+  _str = std::string_view(_data, size);
+  _data += size;
+  return true;
+}
+
+//////////////////////////////////////////////////
+ChunkedLogWriter::~ChunkedLogWriter()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogWriter::Open(const std::string &_path,
+    const std::chrono::nanoseconds &_chunkDuration)
+{
+  this->Close();
+
+  this->file.open(_path, std::ios::binary | std::ios::trunc);
+  this->index.open(_path + ".idx", std::ios::binary | std::ios::trunc);
+  if (!this->file.is_open() || !this->index.is_open())
+  {
+    ignerr << "Failed to open chunked log [" << _path << "] for writing."
+           << std::endl;
+    this->file.close();
+    this->index.close();
+    return false;
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  appendValue(header, kVersion);
+  this->file.write(header.data(), static_cast<std::streamsize>(header.size()));
+  this->offset = header.size();
+
+  header.assign(kIndexMagic, sizeof(kIndexMagic));
+  appendValue(header, kVersion);
+  this->index.write(header.data(),
+      static_cast<std::streamsize>(header.size()));
+
+  this->chunkDuration = std::max<int64_t>(1, _chunkDuration.count());
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->chunk = Chunk();
+    this->open = true;
+  }
+  this->compressionThread =
+      std::thread(&ChunkedLogWriter::RunCompression, this);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogWriter::Write(const std::chrono::nanoseconds &_time,
+    const std::string &_topic, const std::string &_type, const char *_data,
+    std::size_t _size)
+{
+  const int64_t time = _time.count();
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (!this->open)
+    return;
+
+  // Messages may arrive slightly out of order, so a chunk spans the time
+  // from its earliest message.
+  if (this->chunk.messageCount > 0u &&
+      (time - this->chunk.startTime >= this->chunkDuration ||
+       this->chunk.data.size() >= kMaxChunkBytes))
+  {
+    this->QueueChunk();
+  }
+
+  if (this->chunk.messageCount == 0u)
+  {
+    this->chunk.startTime = time;
+    this->chunk.endTime = time;
+  }
+  else
+  {
+    this->chunk.startTime = std::min(this->chunk.startTime, time);
+    this->chunk.endTime = std::max(this->chunk.endTime, time);
+  }
+
+  auto &data = this->chunk.data;
+  appendValue<int64_t>(data, time);
+  appendValue<uint32_t>(data, static_cast<uint32_t>(_topic.size()));
+  data += _topic;
+  appendValue<uint32_t>(data, static_cast<uint32_t>(_type.size()));
+  data += _type;
+  appendValue<uint64_t>(data, _size);
+  data.append(_data, _size);
+  ++this->chunk.messageCount;
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogWriter::Close()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->open && this->chunk.messageCount > 0u)
+      this->QueueChunk();
+    this->open = false;
+  }
+  this->chunkQueued.notify_one();
+
+  if (this->compressionThread.joinable())
+    this->compressionThread.join();
+
+  this->file.close();
+  this->index.close();
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogWriter::IsOpen() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->open;
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogWriter::QueueChunk()
+{
+  this->queue.push_back(std::move(this->chunk));
+  this->chunk = Chunk();
+  this->chunkQueued.notify_one();
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogWriter::RunCompression()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true)
+  {
+    this->chunkQueued.wait(lock,
+        [this]{return !this->queue.empty() || !this->open;});
+
+    // Closed, and all chunks have been written
+    if (this->queue.empty())
+      break;
+
+    Chunk next = std::move(this->queue.front());
+    this->queue.pop_front();
+    lock.unlock();
+
+    {
+      IGN_PROFILE("ChunkedLogWriter::Compress");
+
+      uLongf compressedSize = compressBound(next.data.size());
+      std::string compressed(compressedSize, '\0');
+      const int result = compress2(
+          reinterpret_cast<Bytef *>(&compressed[0]), &compressedSize,
+          reinterpret_cast<const Bytef *>(next.data.data()),
+          next.data.size(), Z_BEST_SPEED);
+      if (result != Z_OK)
+      {
+        ignerr << "Failed to compress chunk of [" << next.messageCount
+               << "] messages, error [" << result << "]. They won't be "
+               << "recorded." << std::endl;
+      }
+      else
+      {
+        // The chunk is written before its entry, so the index never points
+        // past the end of the log.
+        this->file.write(compressed.data(),
+            static_cast<std::streamsize>(compressedSize));
+        this->file.flush();
+
+        std::string entry;
+        appendValue<int64_t>(entry, next.startTime);
+        appendValue<int64_t>(entry, next.endTime);
+        appendValue<uint64_t>(entry, this->offset);
+        appendValue<uint64_t>(entry, compressedSize);
+        appendValue<uint64_t>(entry, next.data.size());
+        appendValue<uint64_t>(entry, next.messageCount);
+        this->index.write(entry.data(),
+            static_cast<std::streamsize>(entry.size()));
+        this->index.flush();
+
+        this->offset += compressedSize;
+      }
+    }
+
+    lock.lock();
+  }
+}
+
+//////////////////////////////////////////////////
+ChunkedLogReader::~ChunkedLogReader()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogReader::Open(const std::string &_path)
+{
+  IGN_PROFILE("ChunkedLogReader::Open");
+
+  this->Close();
+
+#ifndef _WIN32
+  int fd = open(_path.c_str(), O_RDONLY);
+  if (fd >= 0)
+  {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      void *addr = mmap(nullptr, static_cast<std::size_t>(st.st_size),
+          PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED)
+      {
+        this->data = static_cast<const char *>(addr);
+        this->size = static_cast<std::size_t>(st.st_size);
+        this->mapped = true;
+      }
+    }
+    close(fd);
+  }
+#endif
+
+  // Fall back to reading the whole file
+  if (nullptr == this->data)
+  {
+    std::ifstream file(_path, std::ios::binary);
+    if (!file.is_open())
+    {
+      ignerr << "Failed to open chunked log [" << _path << "]." << std::endl;
+      return false;
+    }
+    this->buffer.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+  }
+
+  const char *next = this->data;
+  uint32_t version{0};
+  if (this->size < sizeof(kMagic) ||
+      std::memcmp(next, kMagic, sizeof(kMagic)) != 0)
+  {
+    ignerr << "File [" << _path << "] isn't a chunked log." << std::endl;
+    this->Close();
+    return false;
+  }
+  next += sizeof(kMagic);
+  if (!readValue(next, this->data + this->size, version) ||
+      version != kVersion)
+  {
+    ignerr << "Unsupported version [" << version << "] of chunked log ["
+           << _path << "], expected [" << kVersion << "]." << std::endl;
+    this->Close();
+    return false;
+  }
+
+  // The index is small, so it's read at once
+  std::string indexPath = _path + ".idx";
+  std::ifstream indexFile(indexPath, std::ios::binary);
+  std::string index((std::istreambuf_iterator<char>(indexFile)),
+      std::istreambuf_iterator<char>());
+  next = index.data();
+  const char *end = index.data() + index.size();
+  if (index.size() < sizeof(kIndexMagic) ||
+      std::memcmp(next, kIndexMagic, sizeof(kIndexMagic)) != 0)
+  {
+    ignerr << "Missing or invalid index [" << indexPath << "]." << std::endl;
+    this->Close();
+    return false;
+  }
+  next += sizeof(kIndexMagic);
+  if (!readValue(next, end, version) || version != kVersion)
+  {
+    ignerr << "Unsupported version [" << version << "] of chunked log index ["
+           << indexPath << "], expected [" << kVersion << "]." << std::endl;
+    this->Close();
+    return false;
+  }
+
+  // A log which wasn't closed properly may end with an incomplete entry or
+  // chunk, which are skipped.
+  ChunkedLogIndexEntry entry;
+  while (readValue(next, end, entry.startTime) &&
+      readValue(next, end, entry.endTime) &&
+      readValue(next, end, entry.offset) &&
+      readValue(next, end, entry.compressedSize) &&
+      readValue(next, end, entry.rawSize) &&
+      readValue(next, end, entry.messageCount))
+  {
+    if (entry.offset > this->size ||
+        entry.compressedSize > this->size - entry.offset)
+    {
+      ignwarn << "Chunked log [" << _path << "] is truncated." << std::endl;
+      break;
+    }
+    this->entries.push_back(entry);
+  }
+
+  std::stable_sort(this->entries.begin(), this->entries.end(),
+      [](const ChunkedLogIndexEntry &_a, const ChunkedLogIndexEntry &_b)
+      {
+        return _a.startTime < _b.startTime;
+      });
+
+  int64_t maxEndTime{std::numeric_limits<int64_t>::min()};
+  this->maxEndTimes.reserve(this->entries.size());
+  for (const auto &e : this->entries)
+  {
+    maxEndTime = std::max(maxEndTime, e.endTime);
+    this->maxEndTimes.push_back(maxEndTime);
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogReader::Query(const std::chrono::nanoseconds &_start,
+    const std::chrono::nanoseconds &_end, const Callback &_callback)
+{
+  IGN_PROFILE("ChunkedLogReader::Query");
+
+  const int64_t start = _start.count();
+  const int64_t end = _end.count();
+  if (this->entries.empty() || end < start)
+    return;
+
+  // Chunks starting after the range are skipped. Walking back from there,
+  // the chunks ending before the range are skipped as well, and the walk
+  // stops once no earlier chunk can reach the range.
+  auto last = std::upper_bound(this->entries.begin(), this->entries.end(),
+      end, [](int64_t _time, const ChunkedLogIndexEntry &_entry)
+      {
+        return _time < _entry.startTime;
+      });
+  std::vector<std::size_t> overlapping;
+  for (auto i = static_cast<std::size_t>(last - this->entries.begin());
+      i > 0u && this->maxEndTimes[i - 1] >= start; --i)
+  {
+    if (this->entries[i - 1].endTime >= start)
+      overlapping.push_back(i - 1);
+  }
+  std::reverse(overlapping.begin(), overlapping.end());
+
+  // Chunks whose times overlap are visited together, so their messages can
+  // be sorted. Otherwise, chunks are visited one after the other.
+  std::vector<Message> messages;
+  for (std::size_t first = 0u; first < overlapping.size();)
+  {
+    std::size_t groupEnd = first + 1u;
+    int64_t groupEndTime = this->entries[overlapping[first]].endTime;
+    while (groupEnd < overlapping.size() &&
+        this->entries[overlapping[groupEnd]].startTime <= groupEndTime)
+    {
+      groupEndTime = std::max(groupEndTime,
+          this->entries[overlapping[groupEnd]].endTime);
+      ++groupEnd;
+    }
+
+    messages.clear();
+    for (auto i = first; i < groupEnd; ++i)
+    {
+      const auto *chunk = this->Chunk(overlapping[i]);
+      if (nullptr == chunk)
+        continue;
+
+      auto msgIt = std::lower_bound(chunk->messages.begin(),
+          chunk->messages.end(), _start,
+          [](const Message &_msg, const std::chrono::nanoseconds &_time)
+          {
+            return _msg.time < _time;
+          });
+      for (; msgIt != chunk->messages.end() && msgIt->time <= _end; ++msgIt)
+        messages.push_back(*msgIt);
+    }
+    if (groupEnd - first > 1u)
+    {
+      std::stable_sort(messages.begin(), messages.end(),
+          [](const Message &_a, const Message &_b)
+          {
+            return _a.time < _b.time;
+          });
+    }
+
+    bool stop{false};
+    for (const auto &msg : messages)
+    {
+      if (!_callback(msg))
+      {
+        stop = true;
+        break;
+      }
+    }
+
+    // Keep the most recently used chunks, for the next query
+    while (this->cache.size() > kCachedChunks)
+      this->cache.pop_back();
+
+    if (stop)
+      break;
+    first = groupEnd;
+  }
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogReader::Query(const Callback &_callback)
+{
+  this->Query(std::chrono::nanoseconds::min(),
+      std::chrono::nanoseconds::max(), _callback);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds ChunkedLogReader::StartTime() const
+{
+  if (this->entries.empty())
+    return std::chrono::nanoseconds::zero();
+  return std::chrono::nanoseconds(this->entries.front().startTime);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds ChunkedLogReader::EndTime() const
+{
+  if (this->maxEndTimes.empty())
+    return std::chrono::nanoseconds::zero();
+  return std::chrono::nanoseconds(this->maxEndTimes.back());
+}
+
+//////////////////////////////////////////////////
+std::size_t ChunkedLogReader::ChunkCount() const
+{
+  return this->entries.size();
+}
+
+//////////////////////////////////////////////////
+const ChunkedLogReader::DecompressedChunk *ChunkedLogReader::Chunk(
+    std::size_t _entry)
+{
+  for (auto it = this->cache.begin(); it != this->cache.end(); ++it)
+  {
+    if (it->entry == _entry)
+    {
+      this->cache.splice(this->cache.begin(), this->cache, it);
+      return &this->cache.front();
+    }
+  }
+
+  IGN_PROFILE("ChunkedLogReader::Decompress");
+
+  // Messages point into the chunk's data, so it's decompressed in place
+  const auto &entry = this->entries[_entry];
+  this->cache.emplace_front();
+  auto &chunk = this->cache.front();
+  chunk.entry = _entry;
+  chunk.data.resize(entry.rawSize);
+
+  uLongf rawSize = entry.rawSize;
+  const int result = uncompress(reinterpret_cast<Bytef *>(&chunk.data[0]),
+      &rawSize, reinterpret_cast<const Bytef *>(this->data + entry.offset),
+      entry.compressedSize);
+  if (result != Z_OK || rawSize != entry.rawSize)
+  {
+    ignerr << "Failed to decompress chunk at offset [" << entry.offset
+           << "], error [" << result << "]." << std::endl;
+    this->cache.pop_front();
+    return nullptr;
+  }
+
+  chunk.messages.reserve(entry.messageCount);
+  const char *next = chunk.data.data();
+  const char *end = chunk.data.data() + chunk.data.size();
+  while (next != end)
+  {
+    Message msg;
+    int64_t time{0};
+    if (!readValue(next, end, time) ||
+        !readView<uint32_t>(next, end, msg.topic) ||
+        !readView<uint32_t>(next, end, msg.type) ||
+        !readView<uint64_t>(next, end, msg.data))
+    {
+      ignerr << "Corrupt chunk at offset [" << entry.offset << "]."
+             << std::endl;
+      this->cache.pop_front();
+      return nullptr;
+    }
+    msg.time = std::chrono::nanoseconds(time);
+    chunk.messages.push_back(msg);
+  }
+
+  std::stable_sort(chunk.messages.begin(), chunk.messages.end(),
+      [](const Message &_a, const Message &_b)
+      {
+        return _a.time < _b.time;
+      });
+
+  return &this->cache.front();
+}
+
+//////////////////////////////////////////////////
+void ChunkedLogReader::Close()
+{
+#ifndef _WIN32
+  if (this->mapped)
+    munmap(const_cast<char *>(this->data), this->size);
+#endif
+  this->mapped = false;
+  this->data = nullptr;
+  this->size = 0;
+  this->buffer.clear();
+  this->entries.clear();
+  this->maxEndTimes.clear();
+  this->cache.clear();
+}
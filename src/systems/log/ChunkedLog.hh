@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_SYSTEMS_LOG_CHUNKEDLOG_HH_
+#define IGNITION_GAZEBO_SYSTEMS_LOG_CHUNKEDLOG_HH_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/log-system/Export.hh>
+
+namespace ignition
+{
+namespace gazebo
+{
+// Inline bracket to help doxygen filtering.
+inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+namespace systems
+{
+  /// \brief Location and time range of a chunk in a chunked log, as written
+  /// to the log's index.
+  struct ChunkedLogIndexEntry
+  {
+    /// \brief Time of the earliest message in the chunk, in nanoseconds.
+    int64_t startTime{0};
+
+    /// \brief Time of the latest message in the chunk, in nanoseconds.
+    int64_t endTime{0};
+
+    /// \brief Offset of the compressed chunk in the log file.
+    uint64_t offset{0};
+
+    /// \brief Size of the compressed chunk in bytes.
+    uint64_t compressedSize{0};
+
+    /// \brief Size of the chunk once decompressed, in bytes.
+    uint64_t rawSize{0};
+
+    /// \brief Number of messages in the chunk.
+    uint64_t messageCount{0};
+  };
+
+  /// \class ChunkedLogWriter ChunkedLog.hh
+  /// \brief Writes messages to a chunked log.
+  ///
+  /// Messages are batched into chunks which span a window of time. Full
+  /// chunks are compressed with zlib on a background thread and appended to
+  /// the log file, and their location is appended to an index file next to
+  /// it, `<path>.idx`. Nothing written before is ever rewritten, so a log
+  /// which wasn't closed properly can still be read, up to its last
+  /// complete chunk.
+  class IGNITION_GAZEBO_LOG_SYSTEM_VISIBLE ChunkedLogWriter
+  {
+    /// \brief Constructor
+    public: ChunkedLogWriter() = default;
+
+    /// \brief Destructor, which closes the log.
+    public: ~ChunkedLogWriter();
+
+    /// \brief Copying would share the files.
+    public: ChunkedLogWriter(const ChunkedLogWriter &) = delete;
+
+    /// \brief Copying would share the files.
+    public: ChunkedLogWriter &operator=(const ChunkedLogWriter &) = delete;
+
+    /// \brief Create a log and start the compression thread.
+    /// \param[in] _path Path of the log file. It and its index are
+    /// overwritten.
+    /// \param[in] _chunkDuration Time spanned by each chunk. Chunks are also
+    /// written once they hold a few megabytes, however short they are.
+    /// \return True if the files were created.
+    public: bool Open(const std::string &_path,
+                const std::chrono::nanoseconds &_chunkDuration);
+
+    /// \brief Add a message to the log. This can be called from any thread.
+    /// \param[in] _time Time to stamp the message with.
+    /// \param[in] _topic Topic the message was published on.
+    /// \param[in] _type Message type.
+    /// \param[in] _data Serialized message.
+    /// \param[in] _size Size of the serialized message in bytes.
+    public: void Write(const std::chrono::nanoseconds &_time,
+                const std::string &_topic, const std::string &_type,
+                const char *_data, std::size_t _size);
+
+    /// \brief Write the chunk being batched, wait for all chunks to be
+    /// written and close the files. Messages written afterwards are
+    /// dropped.
+    public: void Close();
+
+    /// \brief Get whether the log is open.
+    /// \return True if messages can be written.
+    public: bool IsOpen() const;
+
+    /// \brief A chunk which hasn't been compressed yet.
+    private: struct Chunk
+    {
+      /// \brief Messages, serialized one after the other.
+      std::string data;
+
+      /// \brief Time of the earliest message, in nanoseconds.
+      int64_t startTime{0};
+
+      /// \brief Time of the latest message, in nanoseconds.
+      int64_t endTime{0};
+
+      /// \brief Number of messages.
+      uint64_t messageCount{0};
+    };
+
+    /// \brief Queue the chunk being batched for compression. The mutex must
+    /// be locked.
+    private: void QueueChunk();
+
+    /// \brief Compression thread, which compresses and writes queued chunks
+    /// until the log is closed.
+    private: void RunCompression();
+
+    /// \brief Protects chunk, queue and open.
+    private: mutable std::mutex mutex;
+
+    /// \brief Notifies the compression thread.
+    private: std::condition_variable chunkQueued;
+
+    /// \brief Chunk being batched.
+    private: Chunk chunk;
+
+    /// \brief Chunks waiting to be compressed.
+    private: std::deque<Chunk> queue;
+
+    /// \brief True while messages can be written.
+    private: bool open{false};
+
+    /// \brief Time spanned by each chunk, in nanoseconds.
+    private: int64_t chunkDuration{0};
+
+    /// \brief Log file, only used by the compression thread.
+    private: std::ofstream file;
+
+    /// \brief Index file, only used by the compression thread.
+    private: std::ofstream index;
+
+    /// \brief Offset at which the next chunk is written.
+    private: uint64_t offset{0};
+
+    /// \brief Compresses and writes chunks.
+    private: std::thread compressionThread;
+  };
+
+  /// \class ChunkedLogReader ChunkedLog.hh
+  /// \brief Reads a log written by ChunkedLogWriter.
+  ///
+  /// The log file is memory mapped where supported, and only the chunks
+  /// which overlap the times being queried are decompressed. The most
+  /// recently used chunks are kept decompressed, so stepping through the
+  /// log in order decompresses each chunk once.
+  class IGNITION_GAZEBO_LOG_SYSTEM_VISIBLE ChunkedLogReader
+  {
+    /// \brief A message read from the log. Its strings point into the
+    /// decompressed chunks, so they're only valid within the query's
+    /// callback.
+    public: struct Message
+    {
+      /// \brief Time the message was stamped with.
+      std::chrono::nanoseconds time{0};
+
+      /// \brief Topic the message was published on.
+      std::string_view topic;
+
+      /// \brief Message type.
+      std::string_view type;
+
+      /// \brief Serialized message.
+      std::string_view data;
+    };
+
+    /// \brief Callback for messages returned by a query.
+    /// \param[in] _msg Message read from the log.
+    /// \return False to stop the query.
+    public: using Callback = std::function<bool(const Message &_msg)>;
+
+    /// \brief Constructor
+    public: ChunkedLogReader() = default;
+
+    /// \brief Destructor, which unmaps the file.
+    public: ~ChunkedLogReader();
+
+    /// \brief Copying would unmap the file twice.
+    public: ChunkedLogReader(const ChunkedLogReader &) = delete;
+
+    /// \brief Copying would unmap the file twice.
+    public: ChunkedLogReader &operator=(const ChunkedLogReader &) = delete;
+
+    /// \brief Open a log and read its index.
+    /// \param[in] _path Path of the log file.
+    /// \return True if the file is a valid chunked log.
+    public: bool Open(const std::string &_path);
+
+    /// \brief Visit the messages stamped within a time range, ordered by
+    /// time.
+    /// \param[in] _start Start of the range, inclusive.
+    /// \param[in] _end End of the range, inclusive.
+    /// \param[in] _callback Called for each message.
+    public: void Query(const std::chrono::nanoseconds &_start,
+                const std::chrono::nanoseconds &_end,
+                const Callback &_callback);
+
+    /// \brief Visit all messages in the log, ordered by time.
+    /// \param[in] _callback Called for each message.
+    public: void Query(const Callback &_callback);
+
+    /// \brief Get the time of the earliest message.
+    /// \return Time of the earliest message, or zero if the log is empty.
+    public: std::chrono::nanoseconds StartTime() const;
+
+    /// \brief Get the time of the latest message.
+    /// \return Time of the latest message, or zero if the log is empty.
+    public: std::chrono::nanoseconds EndTime() const;
+
+    /// \brief Get the number of chunks in the log.
+    /// \return Number of complete chunks.
+    public: std::size_t ChunkCount() const;
+
+    /// \brief A decompressed chunk.
+    private: struct DecompressedChunk
+    {
+      /// \brief Index of the chunk in entries.
+      std::size_t entry{0};
+
+      /// \brief Decompressed data, which messages point into.
+      std::string data;
+
+      /// \brief Messages, ordered by time.
+      std::vector<Message> messages;
+    };
+
+    /// \brief Get a decompressed chunk, decompressing it if it isn't cached.
+    /// \param[in] _entry Index of the chunk in entries.
+    /// \return The chunk, or nullptr if it's corrupt.
+    private: const DecompressedChunk *Chunk(std::size_t _entry);
+
+    /// \brief Unmap or free the log file.
+    private: void Close();
+
+    /// \brief Start of the log file.
+    private: const char *data{nullptr};
+
+    /// \brief Size of the log file in bytes.
+    private: std::size_t size{0};
+
+    /// \brief True if data is memory mapped, false if it's held by buffer.
+    private: bool mapped{false};
+
+    /// \brief Contents of the file where it can't be memory mapped.
+    private: std::string buffer;
+
+    /// \brief Chunks, ordered by start time.
+    private: std::vector<ChunkedLogIndexEntry> entries;
+
+    /// \brief Latest end time of the chunks up to each entry, so the chunks
+    /// overlapping a time range can be found without visiting all of them.
+    private: std::vector<int64_t> maxEndTimes;
+
+    /// \brief Recently used chunks, most recent first.
+    private: std::list<DecompressedChunk> cache;
+  };
+}
+}
+}
+}
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <ignition/common/Filesystem.hh>
+
+#include "ignition/gazebo/test_config.hh"
+
+#include "ChunkedLog.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace systems;
+using namespace std::chrono_literals;
+
+/// \brief Path of the log written by the tests.
+static const std::string kLogPath(common::joinPaths(
+    std::string(PROJECT_BINARY_PATH), "chunked_log_test.clog"));
+
+/////////////////////////////////////////////////
+/// \brief Write a message every 10 ms for a second, alternating between two
+/// topics, in chunks spanning 100 ms.
+static void writeLog()
+{
+  ChunkedLogWriter writer;
+  ASSERT_TRUE(writer.Open(kLogPath, 100ms));
+  EXPECT_TRUE(writer.IsOpen());
+  for (int i = 0; i <= 100; ++i)
+  {
+    const std::string data = "msg" + std::to_string(i);
+    writer.Write(i * 10ms, i % 2 == 0 ? "/even" : "/odd", "test.Msg",
+        data.data(), data.size());
+  }
+  writer.Close();
+  EXPECT_FALSE(writer.IsOpen());
+
+  // Dropped once closed
+  writer.Write(2s, "/even", "test.Msg", "late", 4u);
+}
+
+/////////////////////////////////////////////////
+TEST(ChunkedLog, WriteRead)
+{
+  writeLog();
+
+  ChunkedLogReader reader;
+  ASSERT_TRUE(reader.Open(kLogPath));
+  EXPECT_EQ(11u, reader.ChunkCount());
+  EXPECT_EQ(0ns, reader.StartTime());
+  EXPECT_EQ(1s, reader.EndTime());
+
+  // All messages, in order
+  std::vector<ChunkedLogReader::Message> messages;
+  std::vector<std::string> data;
+  reader.Query([&](const ChunkedLogReader::Message &_msg)
+      {
+        messages.push_back(_msg);
+        data.emplace_back(_msg.data);
+        return true;
+      });
+  ASSERT_EQ(101u, messages.size());
+  for (int i = 0; i <= 100; ++i)
+  {
+    EXPECT_EQ(i * 10ms, messages[i].time);
+    EXPECT_EQ("msg" + std::to_string(i), data[i]);
+  }
+  EXPECT_EQ("/even", messages.back().topic);
+  EXPECT_EQ("test.Msg", messages.back().type);
+
+  // Time range across chunks, inclusive on both ends
+  data.clear();
+  reader.Query(250ms, 420ms, [&](const ChunkedLogReader::Message &_msg)
+      {
+        data.emplace_back(_msg.data);
+        return true;
+      });
+  ASSERT_EQ(18u, data.size());
+  EXPECT_EQ("msg25", data.front());
+  EXPECT_EQ("msg42", data.back());
+
+  // Single step
+  data.clear();
+  reader.Query(500ms, 500ms, [&](const ChunkedLogReader::Message &_msg)
+      {
+        data.emplace_back(_msg.data);
+        return true;
+      });
+  ASSERT_EQ(1u, data.size());
+  EXPECT_EQ("msg50", data.front());
+
+  // Stop early
+  int count{0};
+  reader.Query([&](const ChunkedLogReader::Message &)
+      {
+        return ++count < 3;
+      });
+  EXPECT_EQ(3, count);
+
+  // Outside the log
+  count = 0;
+  reader.Query(2s, 3s, [&](const ChunkedLogReader::Message &)
+      {
+        return ++count > 0;
+      });
+  EXPECT_EQ(0, count);
+
+  common::removeFile(kLogPath);
+  common::removeFile(kLogPath + ".idx");
+}
+
+/////////////////////////////////////////////////
+TEST(ChunkedLog, OutOfOrder)
+{
+  {
+    ChunkedLogWriter writer;
+    ASSERT_TRUE(writer.Open(kLogPath, 100ms));
+    for (auto time : {0ms, 90ms, 120ms, 80ms, 150ms, 210ms, 110ms})
+    {
+      const std::string data = std::to_string(time.count());
+      writer.Write(time, "/topic", "test.Msg", data.data(), data.size());
+    }
+  }
+
+  ChunkedLogReader reader;
+  ASSERT_TRUE(reader.Open(kLogPath));
+  EXPECT_EQ(0ns, reader.StartTime());
+  EXPECT_EQ(210ms, reader.EndTime());
+
+  std::vector<std::chrono::nanoseconds> times;
+  reader.Query(80ms, 150ms, [&](const ChunkedLogReader::Message &_msg)
+      {
+        times.push_back(_msg.time);
+        return true;
+      });
+  std::vector<std::chrono::nanoseconds> expected{
+      80ms, 90ms, 110ms, 120ms, 150ms};
+  EXPECT_EQ(expected, times);
+
+  common::removeFile(kLogPath);
+  common::removeFile(kLogPath + ".idx");
+}
+
+/////////////////////////////////////////////////
+TEST(ChunkedLog, Invalid)
+{
+  ChunkedLogReader reader;
+  EXPECT_FALSE(reader.Open("/not/a/log.clog"));
+
+  {
+    std::ofstream file(kLogPath);
+    file << "<sdf version='1.8'/>";
+  }
+  EXPECT_FALSE(reader.Open(kLogPath));
+
+  // Missing index
+  writeLog();
+  common::removeFile(kLogPath + ".idx");
+  EXPECT_FALSE(reader.Open(kLogPath));
+
+  // Log which wasn't closed properly, ending with an incomplete chunk
+  writeLog();
+  std::string contents;
+  {
+    std::ifstream file(kLogPath, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(kLogPath, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(),
+        static_cast<std::streamsize>(contents.size() - 1));
+  }
+  ASSERT_TRUE(reader.Open(kLogPath));
+  EXPECT_EQ(10u, reader.ChunkCount());
+  EXPECT_EQ(990ms, reader.EndTime());
+
+  common::removeFile(kLogPath);
+  common::removeFile(kLogPath + ".idx");
+}
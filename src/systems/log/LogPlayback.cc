@@ -20,9 +20,16 @@
 #include <ignition/msgs/pose_v.pb.h>
 #include <ignition/msgs/log_playback_stats.pb.h>
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <regex>
 #include <set>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include <ignition/common/Filesystem.hh>
 #include <ignition/common/Profiler.hh>
@@ -48,6 +55,8 @@
 #include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/components/World.hh"
 
+#include "ChunkedLog.hh"
+
 using namespace ignition;
 using namespace gazebo;
 using namespace systems;
@@ -94,12 +103,59 @@ class ignition::gazebo::systems::LogPlaybackPrivate
   public: void Parse(EntityComponentManager &_ecm,
       const msgs::SerializedStateMap &_msg);
 
+  /// \brief Read the simulation times of the log's keyframes from its
+  /// index, if it has one. Logs recorded before keyframes were introduced
+  /// or without keyframes don't have one.
+  public: void ReadKeyframeIndex();
+
+  /// \brief Find the simulation times of the log's keyframes from the
+  /// time stamps of the recorded keyframe messages. This is only done the
+  /// first time a log without index is sought, since all of the log may
+  /// have to be read.
+  public: void ScanKeyframes();
+
+  /// \brief Set the state to the latest keyframe at or before a time.
+  /// \param[in] _ecm Mutable ECM.
+  /// \param[in] _time Time being sought.
+  /// \param[in, out] _entitiesToRemove Entities to be removed. Entities in
+  /// the keyframe are erased from it.
+  /// \return Time of the keyframe, or nullopt if there's no keyframe before
+  /// _time, in which case the state wasn't changed.
+  public: std::optional<std::chrono::steady_clock::duration> SeekKeyframe(
+      EntityComponentManager &_ecm,
+      const std::chrono::steady_clock::duration &_time,
+      std::set<Entity> &_entitiesToRemove);
+
+  /// \brief Visit the messages recorded within a time range, ordered by
+  /// time, whichever format the log was recorded in.
+  /// \param[in] _start Start of the range, inclusive.
+  /// \param[in] _end End of the range, inclusive.
+  /// \param[in] _callback Called for each message.
+  public: void QueryMessages(const std::chrono::nanoseconds &_start,
+      const std::chrono::nanoseconds &_end,
+      const ChunkedLogReader::Callback &_callback);
+
+  /// \brief Visit all messages in the log, ordered by time.
+  /// \param[in] _callback Called for each message.
+  public: void QueryMessages(const ChunkedLogReader::Callback &_callback);
+
+  /// \brief Get the time of the first message in the log.
+  /// \return Time of the first message.
+  public: std::chrono::nanoseconds LogStartTime() const;
+
+  /// \brief Get the time of the last message in the log.
+  /// \return Time of the last message.
+  public: std::chrono::nanoseconds LogEndTime() const;
+
   /// \brief A batch of data from log file, of all pose messages
   public: transport::log::Batch batch;
 
-  /// \brief Pointer to ign-transport Log
+  /// \brief Pointer to ign-transport Log, if playing a SQLite log.
   public: std::unique_ptr<transport::log::Log> log;
 
+  /// \brief Chunked log, if playing one.
+  public: std::unique_ptr<ChunkedLogReader> chunkedLog;
+
   /// \brief Indicator of whether any playback instance has ever been started
   public: static bool started;
 
@@ -128,8 +184,99 @@ class ignition::gazebo::systems::LogPlaybackPrivate
 
   // \brief Saves which particle emitter emitting components have changed
   public: std::unordered_map<Entity, bool> prevParticleEmitterCmds;
+
+  /// \brief Simulation times of the keyframes, sorted.
+  public: std::vector<std::chrono::steady_clock::duration> keyframeTimes;
+
+  /// \brief True if keyframeTimes were read from the log's index, or found
+  /// with ScanKeyframes, so they don't need to be looked for again.
+  public: bool keyframesKnown{false};
 };
 
+/// \brief Whether a recorded topic holds keyframes, which hold the complete
+/// state and are only used to seek.
+/// \param[in] _topic Recorded topic.
+/// \return True if the topic holds keyframes.
+static bool isKeyframeTopic(std::string_view _topic)
+{
+  static const std::string_view kSuffix{"/state_keyframe"};
+  return _topic.size() >= kSuffix.size() &&
+      _topic.compare(_topic.size() - kSuffix.size(), kSuffix.size(),
+      kSuffix) == 0;
+}
+
+/// \brief Merge a changed state into the changes accumulated from the
+/// states before it, so that setting the merged state has the same result as
+/// setting each of them in order. The latest value of each component wins,
+/// and a removal replaces everything recorded for an entity before it.
+/// \param[in, out] _merged Changes accumulated so far.
+/// \param[in] _msg Changed state that comes after them.
+/// \return False if the states can't be merged because their components are
+/// serialized differently, in which case _merged isn't modified.
+static bool mergeChangedState(msgs::SerializedStateMap &_merged,
+    const msgs::SerializedStateMap &_msg)
+{
+  // The header tells how components are serialized
+  const auto &mergedData = _merged.header().data();
+  const auto &msgData = _msg.header().data();
+  if (mergedData.size() != msgData.size() ||
+      !std::equal(mergedData.begin(), mergedData.end(), msgData.begin(),
+      [](const msgs::Header::Map &_a, const msgs::Header::Map &_b)
+      {
+        return _a.key() == _b.key() && _a.value_size() == _b.value_size() &&
+            std::equal(_a.value().begin(), _a.value().end(),
+            _b.value().begin());
+      }))
+  {
+    return false;
+  }
+
+  if (_msg.has_one_time_component_changes())
+    _merged.set_has_one_time_component_changes(true);
+
+  auto &entities = *_merged.mutable_entities();
+  for (const auto &entIt : _msg.entities())
+  {
+    const auto &entityMsg = entIt.second;
+    auto &mergedEntity = entities[entIt.first];
+
+    // Entities are created again if they're recorded after being removed
+    if (entityMsg.remove() || mergedEntity.remove())
+    {
+      mergedEntity = entityMsg;
+      continue;
+    }
+
+    mergedEntity.set_id(entityMsg.id());
+    auto &components = *mergedEntity.mutable_components();
+    for (const auto &compIt : entityMsg.components())
+      components[compIt.first] = compIt.second;
+  }
+  return true;
+}
+
+/// \brief Visit the messages of a batch read from a SQLite log.
+/// \param[in] _batch Batch of messages.
+/// \param[in] _callback Called for each message.
+static void visitBatch(transport::log::Batch &_batch,
+    const ChunkedLogReader::Callback &_callback)
+{
+  for (auto iter = _batch.begin(); iter != _batch.end(); ++iter)
+  {
+    const std::string topic = iter->Topic();
+    const std::string type = iter->Type();
+    const std::string data = iter->Data();
+
+    ChunkedLogReader::Message msg;
+    msg.time = iter->TimeReceived();
+    msg.topic = topic;
+    msg.type = type;
+    msg.data = data;
+    if (!_callback(msg))
+      break;
+  }
+}
+
 bool LogPlaybackPrivate::started{false};
 
 //////////////////////////////////////////////////
@@ -237,8 +384,11 @@ bool LogPlaybackPrivate::Start(EntityComponentManager &_ecm)
     return false;
   }
 
-  // Append file name
-  std::string dbPath = common::joinPaths(this->logPath, "state.tlog");
+  // Append file name. Chunked logs are played if there's one.
+  std::string dbPath = common::joinPaths(this->logPath, "state.clog");
+  const bool chunked = common::exists(dbPath);
+  if (!chunked)
+    dbPath = common::joinPaths(this->logPath, "state.tlog");
   ignmsg << "Loading log file [" + dbPath + "]\n";
   if (!common::exists(dbPath))
   {
@@ -247,46 +397,59 @@ bool LogPlaybackPrivate::Start(EntityComponentManager &_ecm)
     return false;
   }
 
-  // Call Log.hh directly to load a .tlog file
-  this->log = std::make_unique<transport::log::Log>();
-  if (!this->log->Open(dbPath))
+  if (chunked)
   {
-    ignerr << "Failed to open log file [" << dbPath << "]" << std::endl;
+    // Memory maps the log, chunks are only decompressed as they're played
+    this->chunkedLog = std::make_unique<ChunkedLogReader>();
+    if (!this->chunkedLog->Open(dbPath))
+    {
+      ignerr << "Failed to open log file [" << dbPath << "]" << std::endl;
+      return false;
+    }
   }
-
-  // Access all messages in .tlog file
-  this->batch = this->log->QueryMessages();
-  auto iter = this->batch.begin();
-
-  if (iter == this->batch.end())
+  else
   {
-    ignerr << "No messages found in log file [" << dbPath << "]" << std::endl;
+    // Call Log.hh directly to load a .tlog file
+    this->log = std::make_unique<transport::log::Log>();
+    if (!this->log->Open(dbPath))
+    {
+      ignerr << "Failed to open log file [" << dbPath << "]" << std::endl;
+    }
   }
 
+  this->ReadKeyframeIndex();
+
   // Look for the first SerializedState message and use it to set the initial
   // state of the world. Messages received before this are ignored.
-  for (; iter != this->batch.end(); ++iter)
+  bool foundMessages{false};
+  this->QueryMessages([&](const ChunkedLogReader::Message &_msg)
   {
-    auto msgType = iter->Type();
-    if (msgType == "ignition.msgs.SerializedState")
+    foundMessages = true;
+    if (_msg.type == "ignition.msgs.SerializedState")
     {
       msgs::SerializedState msg;
-      msg.ParseFromString(iter->Data());
+      msg.ParseFromArray(_msg.data.data(), static_cast<int>(_msg.data.size()));
       this->Parse(_ecm, msg);
-      break;
+      return false;
     }
-    else if (msgType == "ignition.msgs.SerializedStateMap")
+    else if (_msg.type == "ignition.msgs.SerializedStateMap")
     {
       msgs::SerializedStateMap msg;
-      msg.ParseFromString(iter->Data());
+      msg.ParseFromArray(_msg.data.data(), static_cast<int>(_msg.data.size()));
       this->Parse(_ecm, msg);
-      break;
+      return false;
     }
+    return true;
+  });
+
+  if (!foundMessages)
+  {
+    ignerr << "No messages found in log file [" << dbPath << "]" << std::endl;
   }
 
   msgs::LogPlaybackStatistics logStats;
-  auto startTime = convert<msgs::Time>(this->log->StartTime());
-  auto endTime = convert<msgs::Time>(this->log->EndTime());
+  auto startTime = convert<msgs::Time>(this->LogStartTime());
+  auto endTime = convert<msgs::Time>(this->LogEndTime());
   logStats.mutable_start_time()->set_sec(startTime.sec());
   logStats.mutable_start_time()->set_nsec(startTime.nsec());
   logStats.mutable_end_time()->set_sec(endTime.sec());
@@ -319,6 +482,169 @@ bool LogPlaybackPrivate::Start(EntityComponentManager &_ecm)
   return true;
 }
 
+//////////////////////////////////////////////////
+void LogPlaybackPrivate::ReadKeyframeIndex()
+{
+  this->keyframeTimes.clear();
+
+  this->keyframesKnown = false;
+
+  std::ifstream index(common::joinPaths(this->logPath, "state_keyframes.idx"));
+  if (!index.is_open())
+    return;
+
+  int64_t nsec{0};
+  while (index >> nsec)
+  {
+    this->keyframeTimes.push_back(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds(nsec)));
+  }
+  std::sort(this->keyframeTimes.begin(), this->keyframeTimes.end());
+
+  this->keyframesKnown = true;
+
+  igndbg << "Found [" << this->keyframeTimes.size() << "] keyframes in log."
+         << std::endl;
+}
+
+//////////////////////////////////////////////////
+void LogPlaybackPrivate::ScanKeyframes()
+{
+  IGN_PROFILE("LogPlaybackPrivate::ScanKeyframes");
+
+  this->keyframeTimes.clear();
+  auto addKeyframe = [&](const ChunkedLogReader::Message &_msg)
+  {
+    if (isKeyframeTopic(_msg.topic))
+    {
+      this->keyframeTimes.push_back(
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          _msg.time));
+    }
+    return true;
+  };
+  if (this->chunkedLog)
+  {
+    this->chunkedLog->Query(addKeyframe);
+  }
+  else
+  {
+    auto keyframes = this->log->QueryMessages(transport::log::TopicPattern(
+        std::regex(".*/state_keyframe")));
+    visitBatch(keyframes, addKeyframe);
+  }
+  std::sort(this->keyframeTimes.begin(), this->keyframeTimes.end());
+  this->keyframesKnown = true;
+
+  if (!this->keyframeTimes.empty())
+  {
+    ignwarn << "Log has [" << this->keyframeTimes.size() << "] keyframes "
+            << "but their index [" << common::joinPaths(this->logPath,
+            "state_keyframes.idx") << "] is missing. Found them by reading "
+            << "the log instead." << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+std::optional<std::chrono::steady_clock::duration>
+LogPlaybackPrivate::SeekKeyframe(EntityComponentManager &_ecm,
+    const std::chrono::steady_clock::duration &_time,
+    std::set<Entity> &_entitiesToRemove)
+{
+  if (!this->keyframesKnown)
+    this->ScanKeyframes();
+
+  auto it = std::upper_bound(this->keyframeTimes.begin(),
+      this->keyframeTimes.end(), _time);
+  if (it == this->keyframeTimes.begin())
+    return std::nullopt;
+  const auto keyframeTime = *std::prev(it);
+
+  // Keyframes are stamped when they're received by the recorder, which may
+  // be a little later than the time they were recorded at.
+  msgs::SerializedStateMap msg;
+  std::optional<std::chrono::nanoseconds> msgTime;
+  auto findKeyframe = [&](const ChunkedLogReader::Message &_msg)
+  {
+    if (!isKeyframeTopic(_msg.topic))
+      return true;
+    msg.ParseFromArray(_msg.data.data(), static_cast<int>(_msg.data.size()));
+    msgTime = _msg.time;
+    return false;
+  };
+  if (this->chunkedLog)
+  {
+    this->chunkedLog->Query(keyframeTime, _time, findKeyframe);
+  }
+  else
+  {
+    auto keyframes = this->log->QueryMessages(transport::log::TopicPattern(
+        std::regex(".*/state_keyframe"), {keyframeTime, _time}));
+    visitBatch(keyframes, findKeyframe);
+  }
+  if (!msgTime)
+    return std::nullopt;
+
+  this->Parse(_ecm, msg);
+  this->ReplaceResourceURIs(_ecm);
+
+  // Poses cached from later in the log would override the keyframe's
+  this->recentEntityPoseUpdates.clear();
+
+  for (const auto &entIt : msg.entities())
+    _entitiesToRemove.erase(Entity(entIt.second.id()));
+
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      *msgTime);
+}
+
+//////////////////////////////////////////////////
+void LogPlaybackPrivate::QueryMessages(const std::chrono::nanoseconds &_start,
+    const std::chrono::nanoseconds &_end,
+    const ChunkedLogReader::Callback &_callback)
+{
+  if (this->chunkedLog)
+  {
+    this->chunkedLog->Query(_start, _end, _callback);
+    return;
+  }
+
+  this->batch = this->log->QueryMessages(
+      transport::log::AllTopics({_start, _end}));
+  visitBatch(this->batch, _callback);
+}
+
+//////////////////////////////////////////////////
+void LogPlaybackPrivate::QueryMessages(
+    const ChunkedLogReader::Callback &_callback)
+{
+  if (this->chunkedLog)
+  {
+    this->chunkedLog->Query(_callback);
+    return;
+  }
+
+  this->batch = this->log->QueryMessages();
+  visitBatch(this->batch, _callback);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds LogPlaybackPrivate::LogStartTime() const
+{
+  if (this->chunkedLog)
+    return this->chunkedLog->StartTime();
+  return this->log->StartTime();
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds LogPlaybackPrivate::LogEndTime() const
+{
+  if (this->chunkedLog)
+    return this->chunkedLog->EndTime();
+  return this->log->EndTime();
+}
+
 //////////////////////////////////////////////////
 void LogPlaybackPrivate::ReplaceResourceURIs(EntityComponentManager &_ecm)
 {
@@ -487,9 +813,9 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   if (!this->dataPtr->instStarted)
     return;
 
-  // Get all messages from this timestep
-  // TODO(anyone) Jumping forward can be expensive for long jumps. For now,
-  // just playing every single step so we don't miss insertions and deletions.
+  // Get all messages from this timestep. When jumping forward, this covers
+  // every step that was jumped over, and their changed states are merged
+  // into a single one below.
   auto startTime = _info.simTime - _info.dt;
   auto endTime = _info.simTime;
 
@@ -497,14 +823,12 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   std::set<Entity> entitiesToRemove;
   if (_info.dt < std::chrono::steady_clock::duration::zero())
   {
-    // Detected jumping back in time. This can be expensive.
-    // To rewind / seek backward in time, we also need to play every single
-    // step from the beginning so we don't miss insertions and deletions
-    // This is because each serialized state is a changed state and not an
-    // absolute state.
-    // todo(anyone) Record absolute states during recording, i.e. key frames,
-    // so that playback can jump to these states without the need to
-    // incrementally build the states from the beginning
+    // Detected jumping back in time.
+    // To rewind / seek backward in time, we need to play every single
+    // step from the latest keyframe, which holds the complete state, so we
+    // don't miss insertions and deletions. This is because each serialized
+    // state is a changed state and not an absolute state. Logs without
+    // keyframes are played from the beginning, which can be expensive.
 
     // Create a list of entities to be removed. The list will be updated later
     // as the log steps forward below
@@ -513,12 +837,12 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
     for (const auto &entity : entities)
       entitiesToRemove.insert(Entity(entity.first));
 
-    startTime = std::chrono::steady_clock::duration::zero();
+    auto keyframeTime = this->dataPtr->SeekKeyframe(_ecm, endTime,
+        entitiesToRemove);
+    startTime = keyframeTime ? *keyframeTime :
+        std::chrono::steady_clock::duration::zero();
   }
 
-  this->dataPtr->batch = this->dataPtr->log->QueryMessages(
-      transport::log::AllTopics({startTime, endTime}));
-
   msgs::Pose_V queuedPose;
 
   // If new pose updates are received, make sure that only the cached poses
@@ -534,10 +858,49 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   // is called).
   bool clearCachedPoseUpdates = true;
 
-  auto iter = this->dataPtr->batch.begin();
-  while (iter != this->dataPtr->batch.end())
+  // Changed states are merged until a message that can't be merged is found,
+  // so the ECM is only updated once for all steps in between.
+  msgs::SerializedStateMap mergedState;
+  bool hasMergedState{false};
+  auto setMergedState = [&]()
   {
-    auto msgType = iter->Type();
+    if (!hasMergedState)
+      return;
+
+    // For seeking back in time only:
+    // Update the list of entities to be removed so we do not remove any
+    // entities that are to be created
+    if (seekRewind)
+    {
+      for (const auto &entIt : mergedState.entities())
+      {
+        const auto &entityMsg = entIt.second;
+        Entity entity{entityMsg.id()};
+        if (entityMsg.remove())
+        {
+          entitiesToRemove.insert(entity);
+        }
+        else
+        {
+          entitiesToRemove.erase(entity);
+        }
+      }
+    }
+
+    this->dataPtr->Parse(_ecm, mergedState);
+    this->dataPtr->ReplaceResourceURIs(_ecm);
+    mergedState.Clear();
+    hasMergedState = false;
+  };
+
+  auto playMessage = [&](const ChunkedLogReader::Message &_msg)
+  {
+    // Keyframes duplicate the changed states recorded before them
+    if (isKeyframeTopic(_msg.topic))
+      return true;
+
+    const auto &msgType = _msg.type;
+    const int msgSize = static_cast<int>(_msg.data.size());
 
     // Only set the last pose of a sequence of poses.
     if (msgType != "ignition.msgs.Pose_V" && queuedPose.pose_size() > 0)
@@ -549,12 +912,15 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
     if (msgType == "ignition.msgs.Pose_V")
     {
       // Queue poses to be set later
-      queuedPose.ParseFromString(iter->Data());
+      queuedPose.ParseFromArray(_msg.data.data(), msgSize);
     }
     else if (msgType == "ignition.msgs.SerializedState")
     {
+      // Keep the order of older changed states, which aren't merged
+      setMergedState();
+
       msgs::SerializedState msg;
-      msg.ParseFromString(iter->Data());
+      msg.ParseFromArray(_msg.data.data(), msgSize);
 
       // For seeking back in time only:
       // While stepping, update the list of entities to be removed
@@ -576,33 +942,21 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
       }
 
       this->dataPtr->Parse(_ecm, msg);
+      this->dataPtr->ReplaceResourceURIs(_ecm);
     }
     else if (msgType == "ignition.msgs.SerializedStateMap")
     {
       msgs::SerializedStateMap msg;
-      msg.ParseFromString(iter->Data());
+      msg.ParseFromArray(_msg.data.data(), msgSize);
 
-      // For seeking back in time only:
-      // While stepping, update the list of entities to be removed
-      // so we do not remove any entities that are to be created
-      if (seekRewind)
+      if (hasMergedState && !mergeChangedState(mergedState, msg))
+        setMergedState();
+
+      if (!hasMergedState)
       {
-        for (const auto &entIt : msg.entities())
-        {
-          const auto &entityMsg = entIt.second;
-          Entity entity{entityMsg.id()};
-          if (entityMsg.remove())
-          {
-            entitiesToRemove.insert(entity);
-          }
-          else
-          {
-            entitiesToRemove.erase(entity);
-          }
-        }
+        mergedState.Swap(&msg);
+        hasMergedState = true;
       }
-
-      this->dataPtr->Parse(_ecm, msg);
     }
     else if (msgType == "ignition.msgs.StringMsg")
     {
@@ -613,9 +967,10 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
       ignwarn << "Trying to playback unsupported message type ["
               << msgType << "]" << std::endl;
     }
-    this->dataPtr->ReplaceResourceURIs(_ecm);
-    ++iter;
-  }
+    return true;
+  };
+  this->dataPtr->QueryMessages(startTime, endTime, playMessage);
+  setMergedState();
 
   if (queuedPose.pose_size() > 0)
   {
@@ -673,11 +1028,11 @@ void LogPlayback::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   }
 
   // pause playback if end of log is reached
-  if (_info.simTime >= this->dataPtr->log->EndTime())
+  if (_info.simTime >= this->dataPtr->LogEndTime())
   {
     ignmsg << "End of log file reached. Time: " <<
       std::chrono::duration_cast<std::chrono::seconds>(
-      this->dataPtr->log->EndTime()).count() << " seconds" << std::endl;
+      this->dataPtr->LogEndTime()).count() << " seconds" << std::endl;
 
     this->dataPtr->eventManager->Emit<events::Pause>(true);
   }
@@ -25,6 +25,10 @@
 #include <ctime>
 #include <set>
 #include <list>
+#include <optional>
+#include <chrono>
+#include <regex>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
@@ -61,6 +65,8 @@
 
 #include "ignition/gazebo/Util.hh"
 
+#include "ChunkedLog.hh"
+
 using namespace ignition;
 using namespace ignition::gazebo;
 using namespace ignition::gazebo::systems;
@@ -105,6 +111,33 @@ class ignition::gazebo::systems::LogRecordPrivate
   /// \brief Compress model resource files and state file into one file.
   public: void CompressStateAndResources();
 
+  /// \brief Publish the complete state as a keyframe if enough time or
+  /// changed state passed since the last one.
+  /// \param[in] _info Current update info.
+  /// \param[in] _ecm Entity component manager.
+  /// \param[in] _changedBytes Size of the changed state published in this
+  /// update.
+  public: void RecordKeyframe(const UpdateInfo &_info,
+      const EntityComponentManager &_ecm, std::size_t _changedBytes);
+
+  /// \brief Write a message published by this system to the chunked log,
+  /// if recording to one. Messages published to the SQLite log are recorded
+  /// by the recorder's subscriptions instead.
+  /// \param[in] _topic Topic the message was published on.
+  /// \param[in] _msg Message.
+  /// \param[in] _time Simulation time to stamp the message with.
+  public: void RecordChunked(const std::string &_topic,
+      const google::protobuf::Message &_msg,
+      const std::chrono::steady_clock::duration &_time);
+
+  /// \brief Subscribe to a topic which is recorded to the chunked log.
+  /// \param[in] _topic Topic to record.
+  public: void SubscribeChunked(const std::string &_topic);
+
+  /// \brief Subscribe to the advertised topics which match any of the
+  /// regular expressions to record to the chunked log.
+  public: void SubscribeChunkedPatterns();
+
   /// \brief Indicator of whether any recorder instance has ever been started.
   /// Currently, only one instance is allowed. This enforcement may be removed
   /// in the future.
@@ -144,6 +177,58 @@ class ignition::gazebo::systems::LogRecordPrivate
   /// \brief Publisher for state changes
   public: transport::Node::Publisher statePub;
 
+  /// \brief Publisher for keyframes, which hold the complete state
+  public: transport::Node::Publisher keyframePub;
+
+  /// \brief Simulation time between keyframes. Zero to not record keyframes
+  /// periodically.
+  public: std::chrono::steady_clock::duration keyframeInterval{
+      std::chrono::steady_clock::duration::zero()};
+
+  /// \brief Size of the changed states recorded since the last keyframe
+  /// which triggers a keyframe, in bytes. Zero to not take size into
+  /// account.
+  public: std::size_t keyframeDeltaBytes{0};
+
+  /// \brief Simulation time of the last keyframe, or of the first recorded
+  /// state, which is complete.
+  public: std::optional<std::chrono::steady_clock::duration> lastKeyframeTime;
+
+  /// \brief Size of the changed states recorded since the last keyframe.
+  public: std::size_t deltaBytes{0};
+
+  /// \brief Index of keyframe times, written as keyframes are recorded.
+  public: std::ofstream keyframeIndex;
+
+  /// \brief True to record to a chunked log instead of a SQLite one.
+  public: bool chunked{false};
+
+  /// \brief Simulation time spanned by each chunk of a chunked log.
+  public: std::chrono::steady_clock::duration chunkDuration{
+      std::chrono::seconds(1)};
+
+  /// \brief Chunked log, if recording to one.
+  public: ChunkedLogWriter chunkedLog;
+
+  /// \brief Topics subscribed to for the chunked log.
+  public: std::set<std::string> chunkedTopics;
+
+  /// \brief Regular expressions of topics to record to the chunked log.
+  /// New topics are matched against them periodically.
+  public: std::vector<std::regex> chunkedPatterns;
+
+  /// \brief Wall time topics were last matched against chunkedPatterns.
+  public: std::chrono::steady_clock::time_point lastPatternCheck;
+
+  /// \brief Topic the SDF string is published on.
+  public: std::string sdfTopic;
+
+  /// \brief Topic state changes are published on.
+  public: std::string stateTopic;
+
+  /// \brief Topic keyframes are published on.
+  public: std::string keyframeTopic;
+
   /// \brief Message holding SDF string of world
   public: msgs::StringMsg sdfMsg;
 
@@ -186,8 +271,20 @@ LogRecord::~LogRecord()
 {
   if (this->dataPtr->instStarted)
   {
-    // Use ign-transport directly
-    this->dataPtr->recorder.Stop();
+    if (this->dataPtr->chunked)
+    {
+      for (const auto &topic : this->dataPtr->chunkedTopics)
+        this->dataPtr->node.Unsubscribe(topic);
+
+      // Waits for the last chunks to be compressed
+      this->dataPtr->chunkedLog.Close();
+    }
+    else
+    {
+      // Use ign-transport directly
+      this->dataPtr->recorder.Stop();
+    }
+    this->dataPtr->keyframeIndex.close();
 
     if (this->dataPtr->compress)
       this->dataPtr->CompressStateAndResources();
@@ -211,8 +308,34 @@ void LogRecord::Configure(const Entity &_entity,
     false).first);
 
   this->dataPtr->compress = _sdf->Get<bool>("compress", false).first;
+
+  const double keyframeInterval = _sdf->Get<double>("keyframe_interval",
+      0.0).first;
+  this->dataPtr->keyframeInterval =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(std::max(0.0, keyframeInterval)));
+  const double keyframeDeltaSize = _sdf->Get<double>("keyframe_delta_size",
+      0.0).first;
+  this->dataPtr->keyframeDeltaBytes = static_cast<std::size_t>(
+      std::max(0.0, keyframeDeltaSize) * 1e6);
   this->dataPtr->cmpPath = _sdf->Get<std::string>("compress_path", "").first;
 
+  const auto format = _sdf->Get<std::string>("format", "tlog").first;
+  if (format == "chunked")
+  {
+    this->dataPtr->chunked = true;
+  }
+  else if (format != "tlog")
+  {
+    ignwarn << "Unknown log format [" << format << "], recording to [tlog]."
+            << std::endl;
+  }
+  const double chunkDuration = _sdf->Get<double>("chunk_duration",
+      1.0).first;
+  this->dataPtr->chunkDuration =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(std::max(0.0, chunkDuration)));
+
   // If plugin is specified in both the SDF tag and on command line, only
   //   activate one recorder.
   if (!LogRecordPrivate::started)
@@ -289,6 +412,7 @@ bool LogRecordPrivate::Start(const std::string &_logPath,
   {
     this->sdfPub = this->node.Advertise(validSdfTopic,
         this->sdfMsg.GetTypeName());
+    this->sdfTopic = validSdfTopic;
   }
   else
   {
@@ -303,6 +427,7 @@ bool LogRecordPrivate::Start(const std::string &_logPath,
   {
     this->statePub = this->node.Advertise<msgs::SerializedStateMap>(
         validStateTopic);
+    this->stateTopic = validStateTopic;
   }
   else
   {
@@ -310,13 +435,38 @@ bool LogRecordPrivate::Start(const std::string &_logPath,
            << stateTopic << "]." << std::endl;
   }
 
-  // Append file name
-  std::string dbPath = common::joinPaths(this->logPath, "state.tlog");
-  if (common::exists(dbPath))
+  // Keyframes are recorded on their own topic, so playing back
+  // continuously can skip them.
+  std::string keyframeTopic = "/world/" + this->worldName + "/state_keyframe";
+  auto validKeyframeTopic = transport::TopicUtils::AsValidTopic(keyframeTopic);
+  if (!validKeyframeTopic.empty())
   {
-    ignmsg << "Overwriting existing file [" << dbPath << "]\n";
-    common::removeFile(dbPath);
+    this->keyframePub = this->node.Advertise<msgs::SerializedStateMap>(
+        validKeyframeTopic);
+    this->keyframeTopic = validKeyframeTopic;
   }
+  else
+  {
+    ignerr << "Failed to generate valid topic to publish keyframes. Tried ["
+           << keyframeTopic << "]." << std::endl;
+  }
+
+  // Append file name. A directory holds a single log, in either format.
+  std::string dbPath = common::joinPaths(this->logPath,
+      this->chunked ? "state.clog" : "state.tlog");
+  for (const auto &file : {"state.tlog", "state.clog", "state.clog.idx"})
+  {
+    auto filePath = common::joinPaths(this->logPath, file);
+    if (common::exists(filePath))
+    {
+      ignmsg << "Overwriting existing file [" << filePath << "]\n";
+      common::removeFile(filePath);
+    }
+  }
+  std::string indexPath =
+      common::joinPaths(this->logPath, "state_keyframes.idx");
+  if (common::exists(indexPath))
+    common::removeFile(indexPath);
   ignmsg << "Recording to log file [" << dbPath << "]" << std::endl;
 
   // Add default topics if no topics were specified.
@@ -326,9 +476,21 @@ bool LogRecordPrivate::Start(const std::string &_logPath,
   igndbg << "Recording default topic[" << dynPoseTopic << "].\n";
   igndbg << "Recording default topic[" << sdfTopic << "].\n";
   igndbg << "Recording default topic[" << stateTopic << "].\n";
-  this->recorder.AddTopic(dynPoseTopic);
-  this->recorder.AddTopic(sdfTopic);
-  this->recorder.AddTopic(stateTopic);
+  igndbg << "Recording default topic[" << keyframeTopic << "].\n";
+  // Topics of the chunked log are subscribed to once it's open. Messages
+  // published by this system are written to it directly.
+  std::vector<std::string> chunkedTopicNames;
+  if (this->chunked)
+  {
+    chunkedTopicNames.push_back(dynPoseTopic);
+  }
+  else
+  {
+    this->recorder.AddTopic(dynPoseTopic);
+    this->recorder.AddTopic(sdfTopic);
+    this->recorder.AddTopic(stateTopic);
+    this->recorder.AddTopic(keyframeTopic);
+  }
 
   // Get the topics to record, if any.
   if (this->sdf->HasElement("record_topic"))
@@ -343,12 +505,18 @@ bool LogRecordPrivate::Start(const std::string &_logPath,
       std::string topic = recordTopicElem->Get<std::string>();
       if (std::regex_match(topic, regexMatch))
       {
-        this->recorder.AddTopic(std::regex(topic));
+        if (this->chunked)
+          this->chunkedPatterns.emplace_back(topic);
+        else
+          this->recorder.AddTopic(std::regex(topic));
         igndbg << "Recording topic[" << topic << "] as regular expression.\n";
       }
       else
       {
-        this->recorder.AddTopic(topic);
+        if (this->chunked)
+          chunkedTopicNames.push_back(topic);
+        else
+          this->recorder.AddTopic(topic);
         igndbg << "Recording topic[" << topic << "] as plain topic.\n";
       }
       recordTopicElem = recordTopicElem->GetNextElement("record_topic");
@@ -361,6 +529,24 @@ bool LogRecordPrivate::Start(const std::string &_logPath,
   auto clockTopic = "/world/" + this->worldName + "/log/clock";
   this->clock = std::make_unique<transport::NetworkClock>(clockTopic,
       transport::NetworkClock::TimeBase::SIM);
+
+  if (this->chunked)
+  {
+    if (!this->chunkedLog.Open(dbPath,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+        this->chunkDuration)))
+    {
+      return false;
+    }
+
+    for (const auto &topic : chunkedTopicNames)
+      this->SubscribeChunked(topic);
+    this->SubscribeChunkedPatterns();
+
+    this->instStarted = true;
+    return true;
+  }
+
   this->recorder.Sync(this->clock.get());
 
   // This calls Log::Open() and loads sql schema
@@ -640,6 +826,108 @@ void LogRecordPrivate::CompressStateAndResources()
   }
 }
 
+//////////////////////////////////////////////////
+void LogRecordPrivate::RecordChunked(const std::string &_topic,
+    const google::protobuf::Message &_msg,
+    const std::chrono::steady_clock::duration &_time)
+{
+  if (!this->chunked || _topic.empty())
+    return;
+
+  std::string data;
+  _msg.SerializeToString(&data);
+  this->chunkedLog.Write(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_time), _topic,
+      _msg.GetTypeName(), data.data(), data.size());
+}
+
+//////////////////////////////////////////////////
+void LogRecordPrivate::SubscribeChunked(const std::string &_topic)
+{
+  if (_topic == this->sdfTopic || _topic == this->stateTopic ||
+      _topic == this->keyframeTopic ||
+      this->chunkedTopics.find(_topic) != this->chunkedTopics.end())
+  {
+    return;
+  }
+
+  // Messages are stamped with the sim time they're received at, like the
+  // recorder does for SQLite logs.
+  auto cb = [this](const char *_data, std::size_t _size,
+      const transport::MessageInfo &_info)
+  {
+    this->chunkedLog.Write(this->clock->Time(), _info.Topic(), _info.Type(),
+        _data, _size);
+  };
+  if (this->node.SubscribeRaw(_topic, cb))
+    this->chunkedTopics.insert(_topic);
+  else
+    ignerr << "Failed to subscribe to [" << _topic << "] to record it.\n";
+}
+
+//////////////////////////////////////////////////
+void LogRecordPrivate::SubscribeChunkedPatterns()
+{
+  this->lastPatternCheck = std::chrono::steady_clock::now();
+  if (this->chunkedPatterns.empty())
+    return;
+
+  std::vector<std::string> topics;
+  this->node.TopicList(topics);
+  for (const auto &topic : topics)
+  {
+    for (const auto &pattern : this->chunkedPatterns)
+    {
+      if (std::regex_match(topic, pattern))
+      {
+        this->SubscribeChunked(topic);
+        break;
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void LogRecordPrivate::RecordKeyframe(const UpdateInfo &_info,
+    const EntityComponentManager &_ecm, std::size_t _changedBytes)
+{
+  // The first recorded state holds all entities
+  if (!this->lastKeyframeTime)
+  {
+    this->lastKeyframeTime = _info.simTime;
+    return;
+  }
+
+  this->deltaBytes += _changedBytes;
+
+  const bool intervalElapsed =
+      this->keyframeInterval > std::chrono::steady_clock::duration::zero() &&
+      _info.simTime - *this->lastKeyframeTime >= this->keyframeInterval;
+  const bool deltaExceeded = this->keyframeDeltaBytes > 0u &&
+      this->deltaBytes >= this->keyframeDeltaBytes;
+  if (!intervalElapsed && !deltaExceeded)
+    return;
+
+  IGN_PROFILE("LogRecordPrivate::RecordKeyframe");
+
+  msgs::SerializedStateMap keyframeMsg;
+  _ecm.State(keyframeMsg, {}, {}, true);
+  this->keyframePub.Publish(keyframeMsg);
+  this->RecordChunked(this->keyframeTopic, keyframeMsg, _info.simTime);
+
+  // The index is only created along with the first keyframe
+  if (!this->keyframeIndex.is_open())
+  {
+    this->keyframeIndex.open(
+        common::joinPaths(this->logPath, "state_keyframes.idx"));
+  }
+  this->keyframeIndex << std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _info.simTime).count() << std::endl;
+
+  this->lastKeyframeTime = _info.simTime;
+  this->deltaBytes = 0u;
+}
+
 //////////////////////////////////////////////////
 void LogRecord::PreUpdate(const UpdateInfo &_info,
     EntityComponentManager &)
@@ -691,6 +979,8 @@ void LogRecord::PostUpdate(const UpdateInfo &_info,
             worldSdfComp->Data().Element()->ToString(""));
 
         this->dataPtr->sdfPub.Publish(this->dataPtr->sdfMsg);
+        this->dataPtr->RecordChunked(this->dataPtr->sdfTopic,
+            this->dataPtr->sdfMsg, _info.simTime);
         this->dataPtr->sdfPublished = true;
       }
     }
@@ -698,18 +988,30 @@ void LogRecord::PostUpdate(const UpdateInfo &_info,
 
   // TODO(louise) Use the SceneBroadcaster's topic once that publishes
   // the changed state
-  // \todo(anyone) A potential enhancement here is have a keyframe mechanism
-  // to store complete state periodically, and then store incremental from
-  // that. It would reduce some of the compute on replaying
-  // (especially in tools like plotting or seeking through logs).
   msgs::SerializedStateMap stateMsg;
   _ecm.ChangedState(stateMsg);
   if (!stateMsg.entities().empty())
+  {
     this->dataPtr->statePub.Publish(stateMsg);
+    this->dataPtr->RecordChunked(this->dataPtr->stateTopic, stateMsg,
+        _info.simTime);
+
+    // Store the complete state periodically, so playback can seek from the
+    // nearest keyframe instead of replaying from the beginning.
+    this->dataPtr->RecordKeyframe(_info, _ecm, stateMsg.ByteSizeLong());
+  }
 
   // If there are new models loaded, save meshes and textures
   if (this->dataPtr->RecordResources() && _ecm.HasNewEntities())
     this->dataPtr->LogModelResources(_ecm);
+
+  // Look for new topics to record, like the recorder does for SQLite logs
+  if (this->dataPtr->chunked && !this->dataPtr->chunkedPatterns.empty() &&
+      std::chrono::steady_clock::now() - this->dataPtr->lastPatternCheck >
+      std::chrono::seconds(1))
+  {
+    this->dataPtr->SubscribeChunkedPatterns();
+  }
 }
 
 IGNITION_ADD_PLUGIN(ignition::gazebo::systems::LogRecord,
@@ -35,6 +35,37 @@ namespace systems
 
   /// \class LogRecord LogRecord.hh ignition/gazebo/systems/log/LogRecord.hh
   /// \brief Log state recorder
+  ///
+  /// ## System Parameters
+  ///
+  /// `<record_path>` Directory to record to.
+  ///
+  /// `<record_resources>` True to also record meshes and materials.
+  ///
+  /// `<record_topic>` Additional topic to record, may be a regular
+  /// expression. Can be repeated.
+  ///
+  /// `<compress>` True to compress the recording once it's stopped.
+  ///
+  /// `<compress_path>` Path of the compressed file.
+  ///
+  /// `<keyframe_interval>` Simulation time in seconds between keyframes,
+  /// which hold the complete state, so playback can seek from the nearest
+  /// keyframe instead of replaying from the beginning. 0 to only record
+  /// keyframes by size. Defaults to 0, so keyframes aren't recorded unless
+  /// this or `<keyframe_delta_size>` are set.
+  ///
+  /// `<keyframe_delta_size>` Size in megabytes of the changed states
+  /// recorded since the last keyframe which triggers a new keyframe. 0 to
+  /// only record keyframes by time. Defaults to 0.
+  ///
+  /// `<format>` Either `tlog`, to record to a SQLite database, `state.tlog`,
+  /// or `chunked`, to record to `state.clog`. Chunked logs batch messages
+  /// into chunks spanning a window of simulation time, which are compressed
+  /// on a background thread while recording. Defaults to `tlog`.
+  ///
+  /// `<chunk_duration>` Simulation time in seconds spanned by each chunk of
+  /// a chunked log. Defaults to 1.
   class LogRecord:
     public System,
     public ISystemConfigure,
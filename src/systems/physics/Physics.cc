@@ -25,16 +25,23 @@
 #include <algorithm>
 #include <iostream>
 #include <deque>
+#include <future>
 #include <map>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include <ignition/common/ColladaLoader.hh>
 #include <ignition/common/HeightmapData.hh>
 #include <ignition/common/ImageHeightmap.hh>
+#include <ignition/common/Mesh.hh>
 #include <ignition/common/MeshManager.hh>
+#include <ignition/common/OBJLoader.hh>
 #include <ignition/common/Profiler.hh>
+#include <ignition/common/STLLoader.hh>
+#include <ignition/common/StringUtils.hh>
 #include <ignition/common/SystemPaths.hh>
 #include <ignition/math/AxisAlignedBox.hh>
 #include <ignition/math/eigen3/Conversions.hh>
@@ -85,6 +92,8 @@
 #include "ignition/gazebo/Model.hh"
 #include "ignition/gazebo/Util.hh"
 
+#include "../../ThreadPool.hh"
+
 // Components
 #include "ignition/gazebo/components/AngularAcceleration.hh"
 #include "ignition/gazebo/components/AngularVelocity.hh"
@@ -197,6 +206,19 @@ class ignition::gazebo::systems::PhysicsPrivate
   /// \param[in] _ecm Constant reference to ECM.
   public: void CreateCollisionEntities(const EntityComponentManager &_ecm);
 
+  /// \brief Start loading the meshes of new collisions in the background,
+  /// so they're loaded while other entities are created.
+  /// \param[in] _ecm Constant reference to ECM.
+  public: void LoadMeshesAsync(const EntityComponentManager &_ecm);
+
+  /// \brief Wait for the meshes loaded in the background and add them to
+  /// the mesh manager.
+  public: void AddLoadedMeshes();
+
+  /// \brief Meshes being loaded in the background. Meshes which failed to
+  /// load are null.
+  public: std::future<std::vector<common::Mesh *>> meshFuture;
+
   /// \brief Create joint entities
   /// \param[in] _ecm Constant reference to ECM.
   public: void CreateJointEntities(const EntityComponentManager &_ecm);
@@ -269,6 +291,15 @@ class ignition::gazebo::systems::PhysicsPrivate
   /// \param[in] _ecm Mutable reference to ECM.
   public: void UpdateCollisions(EntityComponentManager &_ecm);
 
+  /// \brief Move the existing physics entities back to the poses held by
+  /// the restored components, at rest, instead of recreating them.
+  /// \param[in] _ecm Mutable reference to the restored ECM.
+  public: void ResetPhysics(EntityComponentManager &_ecm);
+
+  /// \brief True from a reset until the next update, which rewinds time
+  /// and shouldn't step physics back.
+  public: bool resetPending{false};
+
   /// \brief FrameData relative to world at a given offset pose
   /// \param[in] _link ign-physics link
   /// \param[in] _pose Offset pose in which to compute the frame data
@@ -727,7 +758,9 @@ void Physics::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   IGN_PROFILE("Physics::Update");
 
   // \TODO(anyone) Support rewind
-  if (_info.dt < std::chrono::steady_clock::duration::zero())
+  const bool wasReset = this->dataPtr->resetPending;
+  this->dataPtr->resetPending = false;
+  if (_info.dt < std::chrono::steady_clock::duration::zero() && !wasReset)
   {
     ignwarn << "Detected jump back in time ["
         << std::chrono::duration_cast<std::chrono::seconds>(_info.dt).count()
@@ -739,8 +772,8 @@ void Physics::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
     this->dataPtr->CreatePhysicsEntities(_ecm);
     this->dataPtr->UpdatePhysics(_ecm);
     ignition::physics::ForwardStep::Output stepOutput;
-    // Only step if not paused.
-    if (!_info.paused)
+    // Only step if not paused. Physics was already reset to time zero.
+    if (!_info.paused && !wasReset)
     {
       stepOutput = this->dataPtr->Step(_info.dt);
     }
@@ -754,18 +787,125 @@ void Physics::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   }
 }
 
+//////////////////////////////////////////////////
+void Physics::Reset(const UpdateInfo &/*_info*/, EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("Physics::Reset");
+
+  if (this->dataPtr->engine)
+  {
+    this->dataPtr->ResetPhysics(_ecm);
+    this->dataPtr->resetPending = true;
+  }
+}
+
 //////////////////////////////////////////////////
 void PhysicsPrivate::CreatePhysicsEntities(const EntityComponentManager &_ecm)
 {
+  this->LoadMeshesAsync(_ecm);
   this->CreateWorldEntities(_ecm);
   this->CreateModelEntities(_ecm);
   this->CreateLinkEntities(_ecm);
+  this->AddLoadedMeshes();
   // We don't need to add visuals to the physics engine.
   this->CreateCollisionEntities(_ecm);
   this->CreateJointEntities(_ecm);
   this->CreateBatteryEntities(_ecm);
 }
 
+//////////////////////////////////////////////////
+/// \brief Load a mesh without adding it to the mesh manager, so it can be
+/// done from any thread.
+/// \param[in] _path Full path to the mesh.
+/// \return The mesh, or nullptr if it couldn't be loaded, or if its format
+/// is only supported by the mesh manager.
+static common::Mesh *LoadMesh(const std::string &_path)
+{
+  auto extension = common::lowercase(
+      _path.substr(_path.find_last_of('.') + 1));
+
+  common::Mesh *mesh{nullptr};
+  if (extension == "dae")
+    mesh = common::ColladaLoader().Load(_path);
+  else if (extension == "stl")
+    mesh = common::STLLoader().Load(_path);
+  else if (extension == "obj")
+    mesh = common::OBJLoader().Load(_path);
+
+  // The mesh manager looks meshes up by the path they were loaded from
+  if (nullptr != mesh)
+    mesh->SetName(_path);
+  return mesh;
+}
+
+//////////////////////////////////////////////////
+void PhysicsPrivate::LoadMeshesAsync(const EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("PhysicsPrivate::LoadMeshesAsync");
+
+  auto &meshManager = *common::MeshManager::Instance();
+
+  std::set<std::string> paths;
+  _ecm.EachNew<components::Collision, components::Geometry>(
+      [&](const Entity &, const components::Collision *,
+          const components::Geometry *_geom) -> bool
+      {
+        const sdf::Mesh *meshSdf = _geom->Data().MeshShape();
+        if (_geom->Data().Type() != sdf::GeometryType::MESH ||
+            nullptr == meshSdf)
+        {
+          return true;
+        }
+
+        auto fullPath = asFullPath(meshSdf->Uri(), meshSdf->FilePath());
+        if (!fullPath.empty() && !meshManager.HasMesh(fullPath))
+          paths.insert(fullPath);
+        return true;
+      });
+
+  if (paths.empty())
+    return;
+
+  // The meshes are loaded on the shared pool, so they don't compete with
+  // other parallel work for the cores. A single thread waits for them, and
+  // helps loading, while the simulation thread creates other entities.
+  this->meshFuture = std::async(std::launch::async,
+      [paths = std::vector<std::string>(paths.begin(), paths.end())]()
+      {
+        std::vector<common::Mesh *> meshes(paths.size(), nullptr);
+        ThreadPool::Shared().ParallelFor(paths.size(), 1,
+            [&](std::size_t _begin, std::size_t _end)
+            {
+              for (std::size_t i = _begin; i < _end; ++i)
+                meshes[i] = LoadMesh(paths[i]);
+            });
+        return meshes;
+      });
+}
+
+//////////////////////////////////////////////////
+void PhysicsPrivate::AddLoadedMeshes()
+{
+  IGN_PROFILE("PhysicsPrivate::AddLoadedMeshes");
+
+  // Meshes which failed to load, or with other formats, are loaded later by
+  // the mesh manager, which reports errors.
+  if (!this->meshFuture.valid())
+    return;
+
+  auto &meshManager = *common::MeshManager::Instance();
+  for (auto mesh : this->meshFuture.get())
+  {
+    if (nullptr == mesh)
+      continue;
+
+    if (meshManager.HasMesh(mesh->Name()))
+      delete mesh;
+    else
+      meshManager.AddMesh(mesh);
+  }
+}
+
 //////////////////////////////////////////////////
 void PhysicsPrivate::CreateWorldEntities(const EntityComponentManager &_ecm)
 {
@@ -2084,6 +2224,80 @@ ignition::physics::ForwardStep::Output PhysicsPrivate::Step(
   return output;
 }
 
+//////////////////////////////////////////////////
+void PhysicsPrivate::ResetPhysics(EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("PhysicsPrivate::ResetPhysics");
+
+  // Joints are moved to their restored positions and velocities, before
+  // their models are moved. Joints without those components were never
+  // moved from their zero position when the world was loaded.
+  for (const auto &joint : this->entityJointMap.Map())
+  {
+    auto jointPos = _ecm.Component<components::JointPosition>(joint.first);
+    auto jointVel = _ecm.Component<components::JointVelocity>(joint.first);
+
+    const std::size_t nDofs = joint.second->GetDegreesOfFreedom();
+    for (std::size_t i = 0; i < nDofs; ++i)
+    {
+      joint.second->SetPosition(i,
+          jointPos && i < jointPos->Data().size() ? jointPos->Data()[i] : 0);
+      joint.second->SetVelocity(i,
+          jointVel && i < jointVel->Data().size() ? jointVel->Data()[i] : 0);
+    }
+  }
+
+  // Top level models are moved to their restored poses, at rest. Nested
+  // models follow their parents.
+  _ecm.Each<components::Model, components::Pose>(
+      [&](const Entity &_entity, const components::Model *,
+          const components::Pose *_pose)
+      {
+        auto modelPtrPhys = this->entityModelMap.Get(_entity);
+        if (nullptr == modelPtrPhys)
+          return true;
+
+        auto topLevelIt = this->topLevelModelMap.find(_entity);
+        if (topLevelIt == this->topLevelModelMap.end() ||
+            topLevelIt->second != _entity)
+        {
+          return true;
+        }
+
+        auto freeGroup = modelPtrPhys->FindFreeGroup();
+        if (!freeGroup)
+          return true;
+
+        const auto linkEntity =
+            this->entityLinkMap.Get(freeGroup->RootLink());
+        if (linkEntity == kNullEntity)
+          return true;
+
+        math::Pose3d linkPose =
+            this->RelativePose(_entity, linkEntity, _ecm);
+        freeGroup->SetWorldPose(math::eigen3::convert(_pose->Data() *
+                                linkPose));
+
+        this->entityFreeGroupMap.AddEntity(_entity, freeGroup);
+        auto worldVelFeature =
+            this->entityFreeGroupMap
+                .EntityCast<WorldVelocityCommandFeatureList>(_entity);
+        if (worldVelFeature)
+        {
+          worldVelFeature->SetWorldLinearVelocity(
+              math::eigen3::convert(math::Vector3d::Zero));
+          worldVelFeature->SetWorldAngularVelocity(
+              math::eigen3::convert(math::Vector3d::Zero));
+        }
+
+        return true;
+      });
+
+  // Poses are written back to the components on the next update, even for
+  // links which end up where they were before the reset.
+  this->linkWorldPoses.clear();
+}
+
 //////////////////////////////////////////////////
 ignition::math::Pose3d PhysicsPrivate::RelativePose(const Entity &_from,
   const Entity &_to, const EntityComponentManager &_ecm) const
@@ -2913,6 +3127,7 @@ physics::FrameData3d PhysicsPrivate::LinkFrameDataAtOffset(
 IGNITION_ADD_PLUGIN(Physics,
                     ignition::gazebo::System,
                     Physics::ISystemConfigure,
-                    Physics::ISystemUpdate)
+                    Physics::ISystemUpdate,
+                    Physics::ISystemReset)
 
 IGNITION_ADD_PLUGIN_ALIAS(Physics, "ignition::gazebo::systems::Physics")
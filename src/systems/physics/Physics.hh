@@ -67,7 +67,8 @@ namespace systems
   class Physics:
     public System,
     public ISystemConfigure,
-    public ISystemUpdate
+    public ISystemUpdate,
+    public ISystemReset
   {
     /// \brief Constructor
     public: explicit Physics();
@@ -85,6 +86,10 @@ namespace systems
     public: void Update(const UpdateInfo &_info,
                 EntityComponentManager &_ecm) final;
 
+    /// Documentation inherited
+    public: void Reset(const UpdateInfo &_info,
+                EntityComponentManager &_ecm) final;
+
     /// \brief Private data pointer.
     private: std::unique_ptr<PhysicsPrivate> dataPtr;
   };
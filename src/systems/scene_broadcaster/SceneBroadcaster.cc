@@ -21,6 +21,7 @@
 
 #include <chrono>
 #include <condition_variable>
+#include <optional>
 #include <string>
 #include <unordered_set>
 
@@ -203,6 +204,10 @@ class ignition::gazebo::systems::SceneBroadcasterPrivate
   public: std::chrono::duration<int64_t, std::ratio<1, 1000>>
       statePublishPeriod{std::chrono::milliseconds(1000/60)};
 
+  /// \brief Version of the ECM when the state was last published, used to
+  /// only publish what changed since then.
+  public: std::optional<uint64_t> lastStateVersion;
+
   /// \brief Flag used to indicate if the state service was called.
   public: bool stateServiceRequest{false};
 
@@ -303,13 +308,17 @@ void SceneBroadcaster::PostUpdate(const UpdateInfo &_info,
     {
       _manager.State(*this->dataPtr->stepMsg.mutable_state(), {}, {}, true);
     }
-    // Otherwise publish just periodic change components
+    // Otherwise publish just the components which changed since the last
+    // published state, falling back to the full state if that's too old
     else
     {
       IGN_PROFILE("SceneBroadcast::PostUpdate UpdateState");
-      auto periodicComponents = _manager.ComponentTypesWithPeriodicChanges();
-      _manager.State(*this->dataPtr->stepMsg.mutable_state(),
-          {}, periodicComponents);
+      if (!this->dataPtr->lastStateVersion.has_value() ||
+          !_manager.DeltaState(*this->dataPtr->stepMsg.mutable_state(),
+              *this->dataPtr->lastStateVersion))
+      {
+        _manager.State(*this->dataPtr->stepMsg.mutable_state(), {}, {}, true);
+      }
     }
 
     // Full state on demand
@@ -337,6 +346,7 @@ void SceneBroadcaster::PostUpdate(const UpdateInfo &_info,
       IGN_PROFILE("SceneBroadcast::PostUpdate Publish State");
       this->dataPtr->statePub.Publish(this->dataPtr->stepMsg);
       this->dataPtr->lastStatePubTime = now;
+      this->dataPtr->lastStateVersion = _manager.Version();
     }
   }
 }
@@ -16,6 +16,7 @@
  */
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 
 #include <ignition/math/Helpers.hh>
@@ -28,8 +29,10 @@
 
 #include "ignition/gazebo/components/AngularVelocity.hh"
 #include "ignition/gazebo/components/ChildLinkName.hh"
+#include "ignition/gazebo/components/ExternalWorldWrenchCmd.hh"
 #include "ignition/gazebo/components/LinearVelocity.hh"
 #include "ignition/gazebo/components/JointAxis.hh"
+#include "ignition/gazebo/components/ParentEntity.hh"
 #include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/components/World.hh"
 #include "ignition/gazebo/Link.hh"
@@ -178,6 +181,14 @@ void Thruster::Configure(
       ignition::gazebo::components::WorldAngularVelocity());
   }
 
+  // Create the wrench command here, since PreUpdate can't create it.
+  if (!_ecm.Component<ignition::gazebo::components::ExternalWorldWrenchCmd>(
+      this->dataPtr->linkEntity))
+  {
+    _ecm.CreateComponent(this->dataPtr->linkEntity,
+      ignition::gazebo::components::ExternalWorldWrenchCmd());
+  }
+
   double p         =  0.1;
   double i         =  0;
   double d         =  0;
@@ -242,6 +253,14 @@ void Thruster::PreUpdate(
   if (_info.paused)
     return;
 
+  // The wrench command is created on Configure. It's only missing if the
+  // link has been removed, and adding the wrench would create it again.
+  if (!_ecm.Component<ignition::gazebo::components::ExternalWorldWrenchCmd>(
+      this->dataPtr->linkEntity))
+  {
+    return;
+  }
+
   ignition::gazebo::Link link(this->dataPtr->linkEntity);
 
   auto pose = worldPose(this->dataPtr->linkEntity, _ecm);
@@ -271,9 +290,23 @@ void Thruster::PreUpdate(
     unitVector * torque);
 }
 
+/////////////////////////////////////////////////
+bool Thruster::ComponentAccess(
+  std::set<ignition::gazebo::ComponentTypeId> &_reads,
+  std::set<ignition::gazebo::ComponentTypeId> &_writes)
+{
+  // The link's world pose is composed from the poses of its ancestors
+  _reads.insert(ignition::gazebo::components::Pose::typeId);
+  _reads.insert(ignition::gazebo::components::ParentEntity::typeId);
+  _reads.insert(ignition::gazebo::components::WorldAngularVelocity::typeId);
+  _writes.insert(ignition::gazebo::components::ExternalWorldWrenchCmd::typeId);
+  return true;
+}
+
 IGNITION_ADD_PLUGIN(
   Thruster, System,
   Thruster::ISystemConfigure,
-  Thruster::ISystemPreUpdate)
+  Thruster::ISystemPreUpdate,
+  Thruster::ISystemComponentAccess)
 
 IGNITION_ADD_PLUGIN_ALIAS(Thruster, "ignition::gazebo::systems::Thruster")
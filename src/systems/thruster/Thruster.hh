@@ -20,6 +20,7 @@
 #include <ignition/gazebo/System.hh>
 
 #include <memory>
+#include <set>
 
 namespace ignition
 {
@@ -74,7 +75,8 @@ namespace systems
   class Thruster:
     public ignition::gazebo::System,
     public ignition::gazebo::ISystemConfigure,
-    public ignition::gazebo::ISystemPreUpdate
+    public ignition::gazebo::ISystemPreUpdate,
+    public ignition::gazebo::ISystemComponentAccess
   {
     /// \brief Constructor
     public: Thruster();
@@ -94,6 +96,11 @@ namespace systems
         const ignition::gazebo::UpdateInfo &_info,
         ignition::gazebo::EntityComponentManager &_ecm) override;
 
+    /// Documentation inherited
+    public: bool ComponentAccess(
+        std::set<ignition::gazebo::ComponentTypeId> &_reads,
+        std::set<ignition::gazebo::ComponentTypeId> &_writes) override;
+
     /// \brief Private data pointer
     private: std::unique_ptr<ThrusterPrivateData> dataPtr;
   };
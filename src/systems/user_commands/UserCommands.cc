@@ -482,7 +482,7 @@ void UserCommands::Configure(const Entity &_entity,
 
 //////////////////////////////////////////////////
 void UserCommands::PreUpdate(const UpdateInfo &/*_info*/,
-    EntityComponentManager &)
+    EntityComponentManager &_ecm)
 {
   IGN_PROFILE("UserCommands::PreUpdate");
   // make a copy the cmds so execution does not block receiving other
@@ -498,7 +498,10 @@ void UserCommands::PreUpdate(const UpdateInfo &/*_info*/,
 
   // TODO(louise) Record current world state for undo
 
-  // Execute pending commands
+  // Execute pending commands. Entities spawned or removed by all of them,
+  // such as from a single CreateServiceMultiple request, are applied to the
+  // views at once.
+  _ecm.BeginBatch();
   for (auto &cmd : cmds)
   {
     // Execute
@@ -509,6 +512,7 @@ void UserCommands::PreUpdate(const UpdateInfo &/*_info*/,
 
     // TODO(louise) Move to undo list
   }
+  _ecm.EndBatch();
 
   // TODO(louise) Clear redo list
 }
@@ -18,6 +18,7 @@
 #include <benchmark/benchmark.h>
 
 #include <memory>
+#include <vector>
 
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
@@ -359,6 +360,101 @@ BENCHMARK_DEFINE_F(ManyComponentFixture, Each10ComponentNoCache)
   }
 }
 
+BENCHMARK_DEFINE_F(ManyComponentFixture, Each2ComponentWriteCache)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    auto entityCount = _st.range(0);
+
+    for (int eachIter = 0; eachIter < kEachIterations; eachIter++)
+    {
+      int entitiesMatched = 0;
+
+      mgr->Each<Pose, LinearVelocity>(
+          [&](const Entity &, Pose *_pose, LinearVelocity *_vel)->bool
+          {
+            _pose->Data().Pos() += _vel->Data() * 0.001;
+            entitiesMatched++;
+            return true;
+          });
+
+      if (entitiesMatched != entityCount)
+      {
+        _st.SkipWithError("Failed to match correct number of entities");
+      }
+    }
+  }
+}
+
+BENCHMARK_DEFINE_F(ManyComponentFixture, Each2ComponentWriteParallel)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    for (int eachIter = 0; eachIter < kEachIterations; eachIter++)
+    {
+      mgr->ParallelEach<Pose, LinearVelocity>(
+          [&](const Entity &, Pose *_pose, LinearVelocity *_vel)
+          {
+            _pose->Data().Pos() += _vel->Data() * 0.001;
+          });
+    }
+  }
+}
+
+BENCHMARK_DEFINE_F(ManyComponentFixture, Each5ComponentChurnCache)
+(benchmark::State &_st)
+{
+  // Entities whose components are removed and created again before each
+  // iteration, which moves data inside the component storage.
+  std::vector<Entity> churnEntities;
+  mgr->Each<components::Name>(
+      [&](const Entity &_entity, const components::Name *)->bool
+      {
+        if (churnEntities.size() * 100 < static_cast<size_t>(_st.range(0)))
+          churnEntities.push_back(_entity);
+        return true;
+      });
+
+  for (auto _ : _st)
+  {
+    auto entityCount = _st.range(0);
+
+    for (int eachIter = 0; eachIter < kEachIterations; eachIter++)
+    {
+      for (const Entity entity : churnEntities)
+      {
+        mgr->RemoveComponent<Inertial>(entity);
+        mgr->CreateComponent(entity, Inertial());
+      }
+
+      int entitiesMatched = 0;
+
+      mgr->Each<components::Name,
+                AngularVelocity,
+                Inertial,
+                LinearAcceleration,
+                LinearVelocity>(
+          [&](const Entity &,
+              const components::Name *,
+              const AngularVelocity *,
+              const Inertial *,
+              const LinearAcceleration *,
+              const LinearVelocity *)->bool
+          {
+            entitiesMatched++;
+            return true;
+          });
+
+      if (entitiesMatched != entityCount)
+      {
+        _st.SkipWithError("Failed to match correct number of entities");
+      }
+    }
+  }
+}
+
 /// Method to generate test argument combinations.  google/benchmark does
 /// powers of 2 by default, which looks kind of ugly.
 static void EachTestArgs(benchmark::internal::Benchmark *_b)
@@ -378,6 +474,12 @@ static void EachTestArgs(benchmark::internal::Benchmark *_b)
   }
 }
 
+/// Entity counts used to compare cached views on large worlds.
+static void LargeEachTestArgs(benchmark::internal::Benchmark *_b)
+{
+  _b->Arg(1000)->Arg(10000)->Arg(100000);
+}
+
 BENCHMARK_REGISTER_F(EntityComponentManagerFixture, EachNoCache)
   ->Unit(benchmark::kMillisecond)
   ->Apply(EachTestArgs);
@@ -396,6 +498,8 @@ BENCHMARK_REGISTER_F(ManyComponentFixture, Each1ComponentCache)
   ->Arg(10)
   ->Arg(100)
   ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
   ->Unit(benchmark::kMillisecond);
 
 BENCHMARK_REGISTER_F(ManyComponentFixture, Each5ComponentNoCache)
@@ -408,6 +512,8 @@ BENCHMARK_REGISTER_F(ManyComponentFixture, Each5ComponentCache)
   ->Arg(10)
   ->Arg(100)
   ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
   ->Unit(benchmark::kMillisecond);
 
 BENCHMARK_REGISTER_F(ManyComponentFixture, Each10ComponentNoCache)
@@ -420,6 +526,21 @@ BENCHMARK_REGISTER_F(ManyComponentFixture, Each10ComponentCache)
   ->Arg(10)
   ->Arg(100)
   ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(ManyComponentFixture, Each2ComponentWriteCache)
+  ->Apply(LargeEachTestArgs)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(ManyComponentFixture, Each2ComponentWriteParallel)
+  ->Apply(LargeEachTestArgs)
+  ->UseRealTime()
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(ManyComponentFixture, Each5ComponentChurnCache)
+  ->Apply(LargeEachTestArgs)
   ->Unit(benchmark::kMillisecond);
 
 // OSX needs the semicolon, Ubuntu complains that there's an extra ';'
@@ -18,6 +18,8 @@
 #include <benchmark/benchmark.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
@@ -130,6 +132,60 @@ void BM_Serialize5Component(benchmark::State &_st)
   _st.counters["num_components"] = 5;
 }
 
+/// \brief Serialize the state of a simulation step into a map, where a
+/// tenth of the poses changed since the previous step. Arguments are the
+/// number of entities, whether to use binary serialization and whether to
+/// only serialize the delta since the previous step.
+// NOLINTNEXTLINE
+void BM_SerializeStep(benchmark::State &_st)
+{
+  auto entityCount = _st.range(0);
+  bool binary = _st.range(1) != 0;
+  bool delta = _st.range(2) != 0;
+
+  EntityComponentManager mgr;
+  mgr.SetBinarySerialization(binary);
+  std::vector<Entity> entities;
+  for (int ii = 0; ii < entityCount; ++ii)
+  {
+    auto e = mgr.CreateEntity();
+    mgr.CreateComponent(e, Name("entity_" + std::to_string(ii)));
+    mgr.CreateComponent(e, Pose(math::Pose3d(ii, ii, ii, 0, 0, 0)));
+    mgr.CreateComponent(e, LinearVelocity(math::Vector3d(ii, 0, 0)));
+    entities.push_back(e);
+  }
+
+  int64_t bytes = 0;
+  uint64_t lastVersion = mgr.Version();
+  int step = 0;
+  for (auto _: _st)
+  {
+    _st.PauseTiming();
+    for (std::size_t ii = step % 10; ii < entities.size(); ii += 10)
+    {
+      mgr.Component<Pose>(entities[ii])->Data().Pos().X() += 0.001;
+      mgr.SetChanged(entities[ii], Pose::typeId,
+          ComponentState::PeriodicChange);
+    }
+    ++step;
+    msgs::SerializedStateMap stateMsg;
+    _st.ResumeTiming();
+
+    if (delta)
+      mgr.DeltaState(stateMsg, lastVersion);
+    else
+      mgr.State(stateMsg);
+    lastVersion = mgr.Version();
+
+    auto data = stateMsg.SerializeAsString();
+    bytes += static_cast<int64_t>(data.size());
+  }
+  _st.SetBytesProcessed(bytes);
+  _st.counters["bytes_per_step"] = benchmark::Counter(
+      static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+  _st.counters["num_entities"] = entityCount;
+}
+
 // NOLINTNEXTLINE
 BENCHMARK(BM_Serialize1Component)
   ->Arg(10)
@@ -148,6 +204,18 @@ BENCHMARK(BM_Serialize5Component)
   ->Arg(1000)
   ->Unit(benchmark::kMillisecond);
 
+// NOLINTNEXTLINE
+BENCHMARK(BM_SerializeStep)
+  ->Args({100, 0, 0})
+  ->Args({100, 1, 0})
+  ->Args({100, 0, 1})
+  ->Args({100, 1, 1})
+  ->Args({1000, 0, 0})
+  ->Args({1000, 1, 0})
+  ->Args({1000, 0, 1})
+  ->Args({1000, 1, 1})
+  ->Unit(benchmark::kMillisecond);
+
 // OSX needs the semicolon, Ubuntu complains that there's an extra ';'
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpedantic"
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <ignition/common/Filesystem.hh>
+#include <ignition/transport/log/Log.hh>
+
+#include "ignition/gazebo/EntityComponentManager.hh"
+#include "ignition/gazebo/components/LinearVelocity.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/test_config.hh"
+
+#include "../../src/systems/log/ChunkedLog.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace components;
+
+/// \brief Number of simulation steps recorded by each iteration.
+static const int kSteps{1000};
+
+/// \brief Get the changed states of a world as it's simulated, where a tenth
+/// of the poses change every step.
+/// \param[in] _entityCount Number of entities in the world.
+/// \return Serialized changed state of each step.
+static std::vector<std::string> changedStates(int64_t _entityCount)
+{
+  EntityComponentManager mgr;
+  std::vector<Entity> entities;
+  for (int ii = 0; ii < _entityCount; ++ii)
+  {
+    auto e = mgr.CreateEntity();
+    mgr.CreateComponent(e, Name("entity_" + std::to_string(ii)));
+    mgr.CreateComponent(e, Pose(math::Pose3d(ii, ii, ii, 0, 0, 0)));
+    mgr.CreateComponent(e, LinearVelocity(math::Vector3d(ii, 0, 0)));
+    entities.push_back(e);
+  }
+
+  std::vector<std::string> states;
+  for (int step = 0; step < kSteps; ++step)
+  {
+    std::unordered_set<Entity> changed;
+    for (std::size_t ii = step % 10; ii < entities.size(); ii += 10)
+    {
+      mgr.Component<Pose>(entities[ii])->Data().Pos().X() += 0.001;
+      changed.insert(entities[ii]);
+    }
+
+    msgs::SerializedStateMap stateMsg;
+    mgr.State(stateMsg, changed, {Pose::typeId});
+    states.push_back(stateMsg.SerializeAsString());
+  }
+  return states;
+}
+
+/// \brief Get the size of a file.
+/// \param[in] _path Path of the file.
+/// \return Size in bytes, or zero if it can't be opened.
+static double fileSize(const std::string &_path)
+{
+  std::ifstream file(_path, std::ios::binary | std::ios::ate);
+  if (!file)
+    return 0.0;
+  return static_cast<double>(file.tellg());
+}
+
+/// \brief Record the changed states of a simulation, one message per step
+/// at 1 ms steps, to either a SQLite log or a chunked log, and close it.
+/// Arguments are the number of entities and whether to record a chunked
+/// log. Closing the chunked log includes waiting for all chunks to be
+/// compressed.
+// NOLINTNEXTLINE
+void BM_LogRecord(benchmark::State &_st)
+{
+  const auto entityCount = _st.range(0);
+  const bool chunked = _st.range(1) != 0;
+
+  const auto states = changedStates(entityCount);
+  const std::string topic{"/world/default/changed_state"};
+  const std::string type{"ignition.msgs.SerializedStateMap"};
+  const auto path = common::joinPaths(std::string(PROJECT_BINARY_PATH),
+      chunked ? "benchmark_log_record.clog" : "benchmark_log_record.tlog");
+
+  int64_t bytes = 0;
+  for (auto _: _st)
+  {
+    _st.PauseTiming();
+    common::removeFile(path);
+    common::removeFile(path + ".idx");
+    _st.ResumeTiming();
+
+    if (chunked)
+    {
+      systems::ChunkedLogWriter log;
+      log.Open(path, std::chrono::seconds(1));
+      for (int step = 0; step < kSteps; ++step)
+      {
+        const auto &data = states[step];
+        log.Write(std::chrono::milliseconds(step), topic, type, data.data(),
+            data.size());
+      }
+      log.Close();
+    }
+    else
+    {
+      transport::log::Log log;
+      log.Open(path, std::ios_base::out);
+      for (int step = 0; step < kSteps; ++step)
+      {
+        const auto &data = states[step];
+        log.InsertMessage(std::chrono::milliseconds(step), topic, type,
+            data.data(), data.size());
+      }
+    }
+
+    for (const auto &data : states)
+      bytes += static_cast<int64_t>(data.size());
+  }
+  _st.SetBytesProcessed(bytes);
+
+  _st.counters["file_size"] = fileSize(path) + fileSize(path + ".idx");
+  _st.counters["num_entities"] = entityCount;
+
+  common::removeFile(path);
+  common::removeFile(path + ".idx");
+}
+
+// NOLINTNEXTLINE
+BENCHMARK(BM_LogRecord)
+  ->Args({100, 0})
+  ->Args({100, 1})
+  ->Args({1000, 0})
+  ->Args({1000, 1})
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <ignition/math/Pose3.hh>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+#include "ignition/gazebo/Util.hh"
+
+#include "ignition/gazebo/components/ParentEntity.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/World.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace components;
+
+/// \brief Create a world holding a serial chain of links, such as a
+/// manipulator, each link being the child of the previous one.
+/// \param[in] _ecm Manager to populate.
+/// \param[in] _linkCount Number of links in the chain.
+/// \return The links, from the root to the tip.
+static std::vector<Entity> populateChain(EntityComponentManager &_ecm,
+    const int _linkCount)
+{
+  Entity world = _ecm.CreateEntity();
+  _ecm.CreateComponent(world, World());
+
+  std::vector<Entity> links;
+  Entity parent = world;
+  for (int i = 0; i < _linkCount; ++i)
+  {
+    Entity link = _ecm.CreateEntity();
+    _ecm.CreateComponent(link, ParentEntity(parent));
+    _ecm.CreateComponent(link,
+        Pose(math::Pose3d(0, 0, 0.1, 0, 0.1, 0)));
+    links.push_back(link);
+    parent = link;
+  }
+  return links;
+}
+
+// Query the world pose of every link of a chain once per step. The first
+// argument is the number of links, the second is whether the root moves
+// every step, which invalidates the cached poses of the whole chain.
+// NOLINTNEXTLINE
+void BM_WorldPoseCached(benchmark::State &_st)
+{
+  EntityComponentManager ecm;
+  auto links = populateChain(ecm, static_cast<int>(_st.range(0)));
+  const bool moving = _st.range(1) != 0;
+
+  double sum{0.0};
+  for (auto _ : _st)
+  {
+    if (moving)
+    {
+      ecm.Component<Pose>(links[0])->Data().Pos().X() += 0.001;
+      ecm.SetChanged(links[0], Pose::typeId, ComponentState::PeriodicChange);
+    }
+
+    for (const Entity link : links)
+      sum += ecm.WorldPose(link)->Pos().Z();
+  }
+  benchmark::DoNotOptimize(sum);
+  _st.SetItemsProcessed(_st.iterations() * _st.range(0));
+}
+
+// Same as BM_WorldPoseCached, walking up the chain for every query.
+// NOLINTNEXTLINE
+void BM_WorldPoseWalk(benchmark::State &_st)
+{
+  EntityComponentManager ecm;
+  auto links = populateChain(ecm, static_cast<int>(_st.range(0)));
+  const bool moving = _st.range(1) != 0;
+
+  double sum{0.0};
+  for (auto _ : _st)
+  {
+    if (moving)
+    {
+      ecm.Component<Pose>(links[0])->Data().Pos().X() += 0.001;
+      ecm.SetChanged(links[0], Pose::typeId, ComponentState::PeriodicChange);
+    }
+
+    for (const Entity link : links)
+      sum += worldPose(link, ecm).Pos().Z();
+  }
+  benchmark::DoNotOptimize(sum);
+  _st.SetItemsProcessed(_st.iterations() * _st.range(0));
+}
+
+// NOLINTNEXTLINE
+BENCHMARK(BM_WorldPoseCached)
+  ->Args({10, 0})
+  ->Args({10, 1})
+  ->Args({50, 0})
+  ->Args({50, 1})
+  ->Args({200, 0})
+  ->Args({200, 1})
+  ->Unit(benchmark::kMicrosecond);
+
+// NOLINTNEXTLINE
+BENCHMARK(BM_WorldPoseWalk)
+  ->Args({10, 0})
+  ->Args({10, 1})
+  ->Args({50, 0})
+  ->Args({50, 1})
+  ->Args({200, 0})
+  ->Args({200, 1})
+  ->Unit(benchmark::kMicrosecond);
+
+// OSX needs the semicolon, Ubuntu complains that there's an extra ';'
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+BENCHMARK_MAIN();
+#pragma GCC diagnostic pop
@@ -18,7 +18,9 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
 #include <optional>
+#include <thread>
 #include <vector>
 
 #include <ignition/common/Console.hh>
@@ -474,3 +476,55 @@ TEST_F(LevelManagerFixture, LevelBuffersWithMultiplePerformers)
   testSequence(perf1, perf2);
   testSequence(perf2, perf1);
 }
+
+///////////////////////////////////////////////
+/// Check levels are streamed in the background when there's a budget
+TEST(LevelManagerStreaming, LevelLoadUnload)
+{
+  ignition::common::setenv("IGN_GAZEBO_SYSTEM_PLUGIN_PATH",
+    (std::string(PROJECT_BINARY_PATH) + "/lib").c_str());
+
+  ServerConfig serverConfig;
+  serverConfig.SetSdfFile(std::string(PROJECT_SOURCE_PATH) +
+                          "/test/worlds/levels.sdf");
+  serverConfig.SetUseLevels(true);
+  serverConfig.SetLevelStreamingBudget(10ms);
+
+  Server server(serverConfig);
+
+  bool tile0Loaded{false};
+  bool tile1Loaded{false};
+  test::Relay testSystem;
+  testSystem.OnPostUpdate([&](const gazebo::UpdateInfo &,
+                              const gazebo::EntityComponentManager &_ecm)
+  {
+    tile0Loaded = kNullEntity != _ecm.EntityByComponents(components::Model(),
+        components::Name("tile_0"));
+    tile1Loaded = kNullEntity != _ecm.EntityByComponents(components::Model(),
+        components::Name("tile_1"));
+  });
+  server.AddSystem(testSystem.systemPtr);
+
+  ModelMover perf1(*server.EntityByName("sphere"));
+  server.AddSystem(perf1.systemPtr);
+
+  // The default level is loaded synchronously
+  server.Run(true, 1, false);
+  EXPECT_TRUE(tile0Loaded);
+  EXPECT_FALSE(tile1Loaded);
+
+  // Move performer into level1, whose models are added once staged
+  perf1.SetPose({40, 0, 0, 0, 0, 0});
+  for (int i = 0; i < 1000 && !tile1Loaded; ++i)
+  {
+    server.Run(true, 1, false);
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(tile1Loaded);
+
+  // Move performer out of level1
+  perf1.SetPose({0, 0, 0, 0, 0, 0});
+  server.Run(true, 3, false);
+  EXPECT_FALSE(tile1Loaded);
+  EXPECT_TRUE(tile0Loaded);
+}
@@ -23,8 +23,13 @@
 #ifndef __APPLE__
 #include <filesystem>
 #endif
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <numeric>
+#include <regex>
 #include <string>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
@@ -1028,6 +1033,86 @@ TEST_F(LogSystemTest, LogControl)
   }
 }
 
+/////////////////////////////////////////////////
+TEST_F(LogSystemTest, LogSeekForward)
+{
+  auto logPath = common::joinPaths(PROJECT_SOURCE_PATH, "test", "media",
+      "rolling_shapes_log");
+
+  std::map<std::chrono::steady_clock::duration, math::Pose3d> playedPoses;
+  auto spherePose = [](const EntityComponentManager &_ecm,
+      math::Pose3d &_pose) -> bool
+  {
+    auto entity = _ecm.EntityByComponents(components::Name("sphere"));
+    auto poseComp = _ecm.Component<components::Pose>(entity);
+    if (nullptr == poseComp)
+      return false;
+    _pose = poseComp->Data();
+    return true;
+  };
+
+  // Play every step
+  {
+    ServerConfig config;
+    config.SetLogPlaybackPath(logPath);
+    Server server(config);
+
+    test::Relay testSystem;
+    testSystem.OnPostUpdate(
+        [&](const UpdateInfo &_info, const EntityComponentManager &_ecm)
+        {
+          math::Pose3d pose;
+          if (spherePose(_ecm, pose))
+            playedPoses[_info.simTime] = pose;
+        });
+    server.AddSystem(testSystem.systemPtr);
+    server.Run(true, 3000, false);
+  }
+  ASSERT_FALSE(playedPoses.empty());
+
+  // Jump over the same steps at once
+  ServerConfig config;
+  config.SetLogPlaybackPath(logPath);
+  Server server(config);
+
+  bool sought{false};
+  int compared{0};
+  test::Relay testSystem;
+  testSystem.OnPostUpdate(
+      [&](const UpdateInfo &_info, const EntityComponentManager &_ecm)
+      {
+        math::Pose3d pose;
+        if (!sought || !spherePose(_ecm, pose))
+          return;
+
+        auto played = playedPoses.find(_info.simTime);
+        if (played == playedPoses.end())
+          return;
+        EXPECT_EQ(played->second, pose);
+        ++compared;
+      });
+  server.AddSystem(testSystem.systemPtr);
+  server.Run(true, 10, false);
+
+  transport::Node node;
+  msgs::LogPlaybackControl req;
+  req.mutable_seek()->set_sec(2);
+  req.mutable_seek()->set_nsec(500000000);
+  msgs::Boolean res;
+  bool result{false};
+  EXPECT_TRUE(node.Request("/world/default/playback/control", req, 1000,
+      res, result));
+  EXPECT_TRUE(result);
+  EXPECT_TRUE(res.data());
+
+  // Run 2 iterations because control messages are processed in the end of an
+  // update cycle
+  server.Run(true, 1, false);
+  sought = true;
+  server.Run(true, 1, false);
+  EXPECT_GT(compared, 0);
+}
+
 /////////////////////////////////////////////////
 TEST_F(LogSystemTest, LogOverwrite)
 {
@@ -1710,3 +1795,133 @@ TEST_F(LogSystemTest, LogTopics)
   this->CreateLogsDir();
 #endif
 }
+
+/////////////////////////////////////////////////
+TEST_F(LogSystemTest, LogKeyframes)
+{
+  this->CreateLogsDir();
+
+  // World with moving entities, recording keyframes often
+  const auto recordSdfPath = common::joinPaths(
+    std::string(PROJECT_SOURCE_PATH), "test", "worlds",
+    "log_record_dbl_pendulum.sdf");
+  std::string recordSdf;
+  {
+    std::ifstream file(recordSdfPath);
+    recordSdf.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  const std::string recordPlugin{
+      "name=\"ignition::gazebo::systems::LogRecord\">"};
+  auto pluginPos = recordSdf.find(recordPlugin);
+  ASSERT_NE(std::string::npos, pluginPos);
+  recordSdf.insert(pluginPos + recordPlugin.size(),
+      "<record_path>" + this->logDir + "</record_path>"
+      "<keyframe_interval>0.2</keyframe_interval>");
+
+  // Record
+  {
+    ServerConfig recordServerConfig;
+    recordServerConfig.SetSdfString(recordSdf);
+
+    Server recordServer(recordServerConfig);
+    recordServer.Run(true, 1000, false);
+  }
+
+  // Keyframes are indexed by time
+  std::vector<int64_t> keyframeTimes;
+  {
+    std::ifstream index(common::joinPaths(this->logDir,
+        "state_keyframes.idx"));
+    int64_t nsec{0};
+    while (index >> nsec)
+      keyframeTimes.push_back(nsec);
+  }
+  EXPECT_GE(keyframeTimes.size(), 4u);
+  EXPECT_TRUE(std::is_sorted(keyframeTimes.begin(), keyframeTimes.end()));
+
+  // And recorded with the complete state
+  {
+    transport::log::Log log;
+    ASSERT_TRUE(log.Open(common::joinPaths(this->logDir, "state.tlog")));
+    auto batch = log.QueryMessages(transport::log::TopicPattern(
+        std::regex(".*/state_keyframe")));
+    auto iter = batch.begin();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ("ignition.msgs.SerializedStateMap", iter->Type());
+
+    msgs::SerializedStateMap stateMsg;
+    stateMsg.ParseFromString(iter->Data());
+    // entity size = 28 in dbl pendulum + 4 in nested model
+    EXPECT_EQ(32, stateMsg.entities_size());
+  }
+
+  // Play back with the keyframe index, and again once it's lost, in which
+  // case the keyframes are found in the log
+  for (bool withIndex : {true, false})
+  {
+    if (!withIndex)
+    {
+      EXPECT_TRUE(common::removeFile(common::joinPaths(this->logDir,
+          "state_keyframes.idx")));
+    }
+
+    // Play back, keeping the pose of a link at each time
+    ServerConfig playServerConfig;
+    playServerConfig.SetLogPlaybackPath(this->logDir);
+    Server playServer(playServerConfig);
+
+    std::map<std::chrono::steady_clock::duration, math::Pose3d> playedPoses;
+    bool sought{false};
+    int compared{0};
+    test::Relay playbackPoseTester;
+    playbackPoseTester.OnPostUpdate(
+        [&](const UpdateInfo &_info, const EntityComponentManager &_ecm)
+        {
+          auto entity = _ecm.EntityByComponents(components::Name("lower_link"));
+          ASSERT_NE(kNullEntity, entity);
+          auto poseComp = _ecm.Component<components::Pose>(entity);
+          ASSERT_NE(nullptr, poseComp);
+
+          if (!sought)
+          {
+            playedPoses[_info.simTime] = poseComp->Data();
+            return;
+          }
+
+          auto played = playedPoses.lower_bound(_info.simTime);
+          if (played == playedPoses.end() ||
+              played->first - _info.simTime > std::chrono::milliseconds(2))
+          {
+            return;
+          }
+          EXPECT_NEAR(played->second.Pos().X(), poseComp->Data().Pos().X(),
+              0.1);
+          EXPECT_NEAR(played->second.Pos().Y(), poseComp->Data().Pos().Y(),
+              0.1);
+          EXPECT_NEAR(played->second.Pos().Z(), poseComp->Data().Pos().Z(),
+              0.1);
+          ++compared;
+        });
+    playServer.AddSystem(playbackPoseTester.systemPtr);
+    playServer.Run(true, 900, false);
+
+    // Seek back past a keyframe
+    transport::Node node;
+    msgs::LogPlaybackControl req;
+    req.mutable_seek()->set_sec(0);
+    req.mutable_seek()->set_nsec(500000000);
+    msgs::Boolean res;
+    bool result{false};
+    EXPECT_TRUE(node.Request("/world/log_pendulum/playback/control", req, 1000,
+        res, result));
+    EXPECT_TRUE(result);
+    EXPECT_TRUE(res.data());
+
+    sought = true;
+    playServer.Run(true, 3, false);
+    EXPECT_GT(compared, 0);
+  }
+
+  this->RemoveLogsDir();
+}
@@ -16,13 +16,26 @@
 */
 
 #include <gtest/gtest.h>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
 
 #include "ignition/msgs/world_control.pb.h"
 #include "ignition/msgs/world_stats.pb.h"
 #include "ignition/transport/Node.hh"
+#include "ignition/gazebo/components/Component.hh"
+#include "ignition/gazebo/components/Factory.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/ParentEntity.hh"
+#include "ignition/gazebo/components/Performer.hh"
+#include "ignition/gazebo/components/PerformerAffinity.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/Serialization.hh"
 #include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/System.hh"
 #include "ignition/gazebo/test_config.hh"  // NOLINT(build/include)
 
 using namespace ignition;
@@ -228,3 +241,335 @@ TEST_F(NetworkHandshake, Updates)
   serverPrimary.reset();
   serverSecondary1.reset();
 }
+
+/////////////////////////////////////////////////
+/// \brief Data which is expensive to send to the primary.
+using Payload = components::Component<std::string, class PayloadTag,
+    serializers::StringSerializer>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.Payload", Payload)
+
+/////////////////////////////////////////////////
+/// \brief System which changes a large payload on heavy models every
+/// iteration, so they're costlier to simulate than light models with as many
+/// entities.
+class CostlyPerformers :
+  public System,
+  public ISystemPreUpdate
+{
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &,
+      EntityComponentManager &_ecm) override
+  {
+    _ecm.Each<components::Performer, components::ParentEntity>(
+      [&](const Entity &, const components::Performer *,
+          const components::ParentEntity *_parent) -> bool
+      {
+        auto name = _ecm.Component<components::Name>(_parent->Data());
+        if (nullptr == name || name->Data().find("heavy") != 0)
+          return true;
+
+        if (nullptr == _ecm.Component<Payload>(_parent->Data()))
+        {
+          _ecm.CreateComponent(_parent->Data(),
+              Payload(std::string(1000000, 'a')));
+        }
+        _ecm.SetChanged(_parent->Data(), Payload::typeId,
+            ComponentState::PeriodicChange);
+        return true;
+      });
+  }
+};
+
+/////////////////////////////////////////////////
+/// \brief System which keeps track of the secondary simulating each model.
+class AffinityChecker :
+  public System,
+  public ISystemPostUpdate
+{
+  // Documentation inherited
+  public: void PostUpdate(const UpdateInfo &,
+      const EntityComponentManager &_ecm) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    _ecm.Each<components::PerformerAffinity, components::ParentEntity>(
+      [&](const Entity &, const components::PerformerAffinity *_affinity,
+          const components::ParentEntity *_parent) -> bool
+      {
+        auto name = _ecm.Component<components::Name>(_parent->Data());
+        if (name)
+          this->affinities[name->Data()] = _affinity->Data();
+        return true;
+      });
+  }
+
+  /// \brief Get the secondary simulating a model.
+  /// \param[in] _model Model name.
+  /// \return Secondary prefix, empty if not assigned yet.
+  public: std::string Affinity(const std::string &_model)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->affinities[_model];
+  }
+
+  /// \brief Secondary prefix per model name.
+  private: std::map<std::string, std::string> affinities;
+
+  /// \brief Protects affinities.
+  private: std::mutex mutex;
+};
+
+/////////////////////////////////////////////////
+TEST_F(NetworkHandshake, LoadBalancing)
+{
+  // Performers are assigned round-robin, so both heavy models start on the
+  // same secondary, and both light models on the other. All models have as
+  // many entities, so only the measured costs tell them apart.
+  auto model = [](const std::string &_name, int _links)
+  {
+    std::string sdf = "<model name='" + _name + "'>";
+    for (int i = 0; i < _links; ++i)
+      sdf += "<link name='link_" + std::to_string(i) + "'/>";
+    return sdf + "</model>";
+  };
+  auto performer = [](const std::string &_model)
+  {
+    return "<performer name='perf_" + _model + "'><ref>" + _model +
+        "</ref><geometry><box><size>1 1 1</size></box></geometry>"
+        "</performer>";
+  };
+
+  const std::string world =
+      "<?xml version='1.0'?><sdf version='1.6'><world name='default'>" +
+      model("heavy_0", 4) + model("light_0", 4) +
+      model("heavy_1", 4) + model("light_1", 4) +
+      "<plugin name='ignition::gazebo' filename='dummy'>" +
+      performer("heavy_0") + performer("light_0") +
+      performer("heavy_1") + performer("light_1") +
+      "</plugin></world></sdf>";
+
+  ServerConfig configPrimary;
+  configPrimary.SetNetworkRole("primary");
+  configPrimary.SetNetworkSecondaries(2);
+  configPrimary.SetUseLevels(true);
+  configPrimary.SetSdfString(world);
+
+  auto serverPrimary = std::make_unique<Server>(configPrimary);
+  auto checker = std::make_shared<AffinityChecker>();
+  EXPECT_TRUE(*serverPrimary->AddSystem(checker));
+
+  ServerConfig configSecondary;
+  configSecondary.SetNetworkRole("secondary");
+  configSecondary.SetUseLevels(true);
+  configSecondary.SetSdfString(world);
+
+  auto serverSecondary1 = std::make_unique<Server>(configSecondary);
+  auto serverSecondary2 = std::make_unique<Server>(configSecondary);
+  EXPECT_TRUE(*serverSecondary1->AddSystem(
+      std::make_shared<CostlyPerformers>()));
+  EXPECT_TRUE(*serverSecondary2->AddSystem(
+      std::make_shared<CostlyPerformers>()));
+
+  // Run
+  std::atomic<bool> testRunning{true};
+  auto testFcn = [&](Server *_server)
+  {
+    _server->Run(false, 0, false);
+
+    while (testRunning)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  };
+
+  auto primaryThread = std::thread(testFcn, serverPrimary.get());
+  auto secondaryThread1 = std::thread(testFcn, serverSecondary1.get());
+  auto secondaryThread2 = std::thread(testFcn, serverSecondary2.get());
+
+  // Wait for the heavy models to be assigned
+  int maxSleep = 100;
+  int sleep = 0;
+  for (; sleep < maxSleep && checker->Affinity("heavy_0").empty(); ++sleep)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  EXPECT_FALSE(checker->Affinity("heavy_0").empty());
+  EXPECT_EQ(checker->Affinity("heavy_0"), checker->Affinity("heavy_1"));
+  EXPECT_NE(checker->Affinity("heavy_0"), checker->Affinity("light_0"));
+
+  // Wait for one of the heavy models to migrate to the other secondary
+  for (sleep = 0; sleep < maxSleep &&
+      checker->Affinity("heavy_0") == checker->Affinity("heavy_1"); ++sleep)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  // We don't assert because we still need to join the threads if the test fails
+  EXPECT_NE(checker->Affinity("heavy_0"), checker->Affinity("heavy_1"));
+
+  // Finish server threads
+  testRunning = false;
+
+  primaryThread.join();
+  secondaryThread1.join();
+  secondaryThread2.join();
+
+  serverPrimary.reset();
+  serverSecondary1.reset();
+  serverSecondary2.reset();
+}
+
+/////////////////////////////////////////////////
+/// \brief System which sets the height of performer models to the current
+/// iteration.
+class IterationWriter :
+  public System,
+  public ISystemPreUpdate
+{
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &_info,
+      EntityComponentManager &_ecm) override
+  {
+    _ecm.Each<components::Performer, components::ParentEntity>(
+      [&](const Entity &, const components::Performer *,
+          const components::ParentEntity *_parent) -> bool
+      {
+        auto pose = _ecm.Component<components::Pose>(_parent->Data());
+        if (nullptr == pose)
+          return true;
+        pose->Data().Pos().Z() = static_cast<double>(_info.iterations);
+        _ecm.SetChanged(_parent->Data(), components::Pose::typeId,
+            ComponentState::PeriodicChange);
+        return true;
+      });
+  }
+};
+
+/////////////////////////////////////////////////
+/// \brief System which records the height of a model at each iteration.
+class HeightRecorder :
+  public System,
+  public ISystemPostUpdate
+{
+  // Documentation inherited
+  public: void PostUpdate(const UpdateInfo &_info,
+      const EntityComponentManager &_ecm) override
+  {
+    auto entity = _ecm.EntityByComponents(components::Name("box"));
+    auto pose = _ecm.Component<components::Pose>(entity);
+    if (nullptr == pose)
+      return;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->heights[_info.iterations] = pose->Data().Pos().Z();
+  }
+
+  /// \brief Get the recorded heights.
+  /// \return Height of the model per iteration.
+  public: std::map<uint64_t, double> Heights()
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->heights;
+  }
+
+  /// \brief Height of the model per iteration.
+  private: std::map<uint64_t, double> heights;
+
+  /// \brief Protects heights.
+  private: std::mutex mutex;
+};
+
+/////////////////////////////////////////////////
+TEST_F(NetworkHandshake, Pipelined)
+{
+  const std::string world = R"(
+      <?xml version='1.0'?>
+      <sdf version='1.6'>
+        <world name='default'>
+          <model name='box'>
+            <static>true</static>
+            <link name='link'/>
+          </model>
+          <plugin name='ignition::gazebo' filename='dummy'>
+            <performer name='perf_box'>
+              <ref>box</ref>
+              <geometry><box><size>1 1 1</size></box></geometry>
+            </performer>
+          </plugin>
+        </world>
+      </sdf>)";
+
+  // Load a single system on each server, instead of the default ones, since
+  // running physics twice in the same process isn't supported, see
+  // https://github.com/ignitionrobotics/ign-gazebo/issues/18
+  auto pluginElem = std::make_shared<sdf::Element>();
+  pluginElem->SetName("plugin");
+  pluginElem->AddAttribute("name", "string", "required_but_ignored", true);
+  pluginElem->AddAttribute("filename", "string", "required_but_ignored", true);
+
+  ServerConfig::PluginInfo pluginInfo;
+  pluginInfo.SetEntityName("default");
+  pluginInfo.SetEntityType("world");
+  pluginInfo.SetFilename("libignition-gazebo-user-commands-system.so");
+  pluginInfo.SetName("ignition::gazebo::systems::UserCommands");
+  pluginInfo.SetSdf(pluginElem);
+
+  ServerConfig configPrimary;
+  configPrimary.SetNetworkRole("primary");
+  configPrimary.SetNetworkSecondaries(1);
+  configPrimary.SetNetworkPipelined(true);
+  configPrimary.SetUseLevels(true);
+  configPrimary.SetSdfString(world);
+  configPrimary.AddPlugin(pluginInfo);
+
+  auto serverPrimary = std::make_unique<Server>(configPrimary);
+  auto recorder = std::make_shared<HeightRecorder>();
+  EXPECT_TRUE(*serverPrimary->AddSystem(recorder));
+
+  ServerConfig configSecondary;
+  configSecondary.SetNetworkRole("secondary");
+  configSecondary.SetUseLevels(true);
+  configSecondary.SetSdfString(world);
+  configSecondary.AddPlugin(pluginInfo);
+
+  auto serverSecondary = std::make_unique<Server>(configSecondary);
+  EXPECT_TRUE(*serverSecondary->AddSystem(
+      std::make_shared<IterationWriter>()));
+
+  std::atomic<bool> primaryDone{false};
+  auto primaryThread = std::thread([&]
+      {
+        EXPECT_TRUE(serverPrimary->Run(true, 50, false));
+        primaryDone = true;
+      });
+
+  std::atomic<bool> testRunning{true};
+  auto secondaryThread = std::thread([&]
+      {
+        serverSecondary->Run(false, 0, false);
+        while (testRunning)
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      });
+
+  int maxSleep = 100;
+  for (int sleep = 0; sleep < maxSleep && !primaryDone; ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(primaryDone);
+
+  // The primary sees the state of each secondary step one step late
+  auto heights = recorder->Heights();
+  EXPECT_EQ(50u, heights.size());
+  for (const auto &[iteration, height] : heights)
+  {
+    if (iteration < 2)
+      continue;
+    EXPECT_DOUBLE_EQ(static_cast<double>(iteration - 1), height)
+        << iteration;
+  }
+
+  testRunning = false;
+
+  primaryThread.join();
+  secondaryThread.join();
+
+  serverPrimary.reset();
+  serverSecondary.reset();
+}
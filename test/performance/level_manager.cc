@@ -18,6 +18,8 @@
 
 #include <gtest/gtest.h>
 #include <array>
+#include <sstream>
+#include <string>
 
 #include <ignition/math/Stopwatch.hh>
 #include <ignition/common/Console.hh>
@@ -77,3 +79,116 @@ TEST(LevelManagerPerfrormance, LevelVsNoLevel)
 
   EXPECT_LE(levelsDuration.count(), nolevelsDuration.count());
 }
+
+/// \brief Generate a city-scale world, with a grid of levels, one tile
+/// model per level, and performers spread over the grid.
+/// \param[in] _levelsX Number of levels along X.
+/// \param[in] _levelsY Number of levels along Y.
+/// \param[in] _performerCount Number of performers.
+/// \return SDF string.
+static std::string cityWorld(int _levelsX, int _levelsY, int _performerCount)
+{
+  const double tileSize{20.0};
+
+  std::ostringstream models;
+  std::ostringstream plugin;
+  auto link = [](std::ostringstream &_out)
+  {
+    _out << "<link name='link'><collision name='collision'><geometry>"
+         << "<box><size>1 1 1</size></box></geometry></collision></link>";
+  };
+
+  for (int x = 0; x < _levelsX; ++x)
+  {
+    for (int y = 0; y < _levelsY; ++y)
+    {
+      const std::string name = "tile_" + std::to_string(x * _levelsY + y);
+      const std::string pose = std::to_string(x * tileSize) + " " +
+          std::to_string(y * tileSize) + " 0 0 0 0";
+
+      models << "<model name='" << name << "'><static>true</static><pose>"
+             << pose << "</pose>";
+      link(models);
+      models << "</model>";
+
+      plugin << "<level name='level_" << name << "'><pose>" << pose
+             << "</pose><geometry><box><size>" << tileSize << " "
+             << tileSize << " 100</size></box></geometry>"
+             << "<buffer>2</buffer><ref>" << name << "</ref></level>";
+    }
+  }
+
+  // Spread the performers over the grid
+  const int levelCount = _levelsX * _levelsY;
+  for (int i = 0; i < _performerCount; ++i)
+  {
+    const int tile = i * levelCount / _performerCount;
+    const std::string name = "performer_" + std::to_string(i);
+    models << "<model name='" << name << "'><pose>"
+           << (tile / _levelsY) * tileSize << " "
+           << (tile % _levelsY) * tileSize << " 0 0 0 0</pose>";
+    link(models);
+    models << "</model>";
+
+    plugin << "<performer name='perf_" << name << "'><ref>" << name
+           << "</ref><geometry><box><size>2 2 2</size></box></geometry>"
+           << "</performer>";
+  }
+
+  return "<?xml version='1.0'?><sdf version='1.6'><world name='city'>" +
+      models.str() + "<plugin name='ignition::gazebo' filename='dummy'>" +
+      plugin.str() + "</plugin></world></sdf>";
+}
+
+TEST(LevelManagerPerfrormance, CityScale)
+{
+  using namespace std::chrono;
+
+  common::Console::SetVerbosity(4);
+
+  // 2000 levels and 300 performers
+  ignition::gazebo::ServerConfig serverConfig;
+  serverConfig.SetSdfString(cityWorld(50, 40, 300));
+  math::Stopwatch watch;
+
+  const std::size_t iters = 1000;
+
+  // Server with levels
+  std::size_t levelsEntityCount{0};
+  {
+    serverConfig.SetUseLevels(true);
+    gazebo::Server server(serverConfig);
+    server.SetUpdatePeriod(1ns);
+
+    watch.Start(true);
+    server.Run(true, iters, false);
+    watch.Stop();
+    levelsEntityCount = *server.EntityCount();
+  }
+  const auto levelsDuration = watch.ElapsedRunTime();
+
+  // Server without levels
+  std::size_t noLevelsEntityCount{0};
+  {
+    serverConfig.SetUseLevels(false);
+    gazebo::Server serverNoLevels(serverConfig);
+    serverNoLevels.SetUpdatePeriod(1ns);
+
+    watch.Start(true);
+    serverNoLevels.Run(true, iters, false);
+    watch.Stop();
+    noLevelsEntityCount = *serverNoLevels.EntityCount();
+  }
+  const auto nolevelsDuration = watch.ElapsedRunTime();
+
+  igndbg << "\n2000 levels, 300 performers, " << iters << " iterations"
+         << "\nUsing levels = "
+         << duration_cast<milliseconds>(levelsDuration).count() << " ms ("
+         << levelsEntityCount << " entities)\n"
+         << "Without levels = "
+         << duration_cast<milliseconds>(nolevelsDuration).count() << " ms ("
+         << noLevelsEntityCount << " entities)\n";
+
+  // Only the tiles near performers are loaded
+  EXPECT_LT(levelsEntityCount, noLevelsEntityCount);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+#include <ignition/math/Stopwatch.hh>
+
+#include "ignition/gazebo/components/Factory.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/test_config.hh"  // NOLINT(build/include)
+
+#include "../helpers/Relay.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+using IntComponent = components::Component<int, class IntComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.IntComponent",
+    IntComponent)
+
+/////////////////////////////////////////////////
+/// Measure how PostUpdate wall time scales with the number of systems, which
+/// run concurrently on the system thread pool and read every component.
+TEST(PostUpdatePerformance, ThreadScaling)
+{
+  using namespace std::chrono;
+
+  common::Console::SetVerbosity(4);
+
+  const int entityCount = 10000;
+  const std::size_t iters = 100;
+
+  std::stringstream report;
+  report << "\nPostUpdate threads\tTotal [ms]\tPer iteration [us]\n";
+
+  for (const std::size_t threadCount : {1u, 2u, 4u, 8u})
+  {
+    Server server;
+    server.SetUpdatePeriod(0ns);
+
+    // Create the entities once, before any system reads them.
+    bool created{false};
+    test::Relay creator;
+    creator.OnPreUpdate(
+        [&](const UpdateInfo &, EntityComponentManager &_ecm)
+        {
+          if (created)
+            return;
+
+          for (int i = 0; i < entityCount; ++i)
+          {
+            Entity entity = _ecm.CreateEntity();
+            _ecm.CreateComponent(entity, IntComponent(i));
+            _ecm.CreateComponent(entity, components::Pose());
+          }
+          created = true;
+        });
+    server.AddSystem(creator.systemPtr);
+
+    // Each reader iterates a view and also looks up components by entity,
+    // which goes through the component storage.
+    std::atomic<std::size_t> matches{0};
+    std::vector<test::Relay> readers(threadCount);
+    for (auto &reader : readers)
+    {
+      reader.OnPostUpdate(
+          [&](const UpdateInfo &, const EntityComponentManager &_ecm)
+          {
+            std::size_t count{0};
+            _ecm.Each<IntComponent, components::Pose>(
+                [&](const Entity &_entity, const IntComponent *_int,
+                    const components::Pose *)
+                {
+                  if (_ecm.Component<IntComponent>(_entity) == _int)
+                    ++count;
+                  return true;
+                });
+            matches += count;
+          });
+      server.AddSystem(reader.systemPtr);
+    }
+
+    // Warm up, which creates the entities and the views.
+    server.Run(true, 1, false);
+    matches = 0;
+
+    math::Stopwatch watch;
+    watch.Start(true);
+    server.Run(true, iters, false);
+    watch.Stop();
+    const auto duration = watch.ElapsedRunTime();
+
+    EXPECT_EQ(threadCount * entityCount * iters, matches);
+
+    report << threadCount << "\t\t\t"
+           << duration_cast<milliseconds>(duration).count() << "\t\t"
+           << duration_cast<microseconds>(duration).count() / iters << "\n";
+  }
+
+  igndbg << report.str();
+}
+
+/////////////////////////////////////////////////
+/// Measure the PostUpdate overhead of many cheap systems, which are batched
+/// together onto a few threads.
+TEST(PostUpdatePerformance, ManyCheapSystems)
+{
+  using namespace std::chrono;
+
+  common::Console::SetVerbosity(4);
+
+  const std::size_t iters = 1000;
+
+  std::stringstream report;
+  report << "\nPostUpdate systems\tTotal [ms]\tPer iteration [us]\n";
+
+  for (const std::size_t systemCount : {10u, 100u, 200u})
+  {
+    Server server;
+    server.SetUpdatePeriod(0ns);
+
+    std::atomic<std::size_t> calls{0};
+    std::vector<test::Relay> systems(systemCount);
+    for (auto &system : systems)
+    {
+      system.OnPostUpdate(
+          [&](const UpdateInfo &, const EntityComponentManager &)
+          {
+            ++calls;
+          });
+      server.AddSystem(system.systemPtr);
+    }
+
+    // Warm up, which also measures each system once
+    server.Run(true, 1, false);
+    calls = 0;
+
+    math::Stopwatch watch;
+    watch.Start(true);
+    server.Run(true, iters, false);
+    watch.Stop();
+    const auto duration = watch.ElapsedRunTime();
+
+    EXPECT_EQ(systemCount * iters, calls);
+
+    report << systemCount << "\t\t\t"
+           << duration_cast<milliseconds>(duration).count() << "\t\t"
+           << duration_cast<microseconds>(duration).count() / iters << "\n";
+  }
+
+  igndbg << report.str();
+}
@@ -16,6 +16,7 @@
  */
 
 #include <array>
+#include <chrono>
 
 #include <ignition/msgs.hh>
 #include <ignition/math/Stopwatch.hh>
@@ -67,17 +68,30 @@ int main(int _argc, char** _argv)
   if (updateRate > 0.0)
     serverConfig.SetUpdateRate(updateRate);
 
+  // Time how long it takes to load the world and to run its first step,
+  // which creates the physics and rendering entities.
+  ignition::math::Stopwatch startupWatch;
+  startupWatch.Start();
+
   // Create the Gazebo server
   ignition::gazebo::Server server(serverConfig);
 
+  auto loadTime = startupWatch.ElapsedRunTime();
+  igndbg << "Load time: " << std::chrono::duration<double>(loadTime).count()
+         << " s" << std::endl;
+
   ignition::transport::Node node;
 
   std::vector<ignition::msgs::Clock> msgs;
   msgs.reserve(iterations);
 
+  std::chrono::steady_clock::duration firstStepTime{0};
+
   std::function<void(const ignition::msgs::Clock&)> cb =
     [&](const ignition::msgs::Clock &_msg)
     {
+      if (msgs.empty())
+        firstStepTime = startupWatch.ElapsedRunTime();
       msgs.push_back(_msg);
     };
 
@@ -101,11 +115,19 @@ int main(int _argc, char** _argv)
   // Run the server
   server.Run(true, iterations, false);
 
+  igndbg << "Time to first step: "
+         << std::chrono::duration<double>(firstStepTime).count() << " s"
+         << std::endl;
+
   std::ofstream ofs("data.csv", std::ofstream::out);
 
   ofs << "# Filename: " << sdfFile << std::endl;
   ofs << "# Iterations: " << iterations << std::endl;
   ofs << "# Rate: " << updateRate << std::endl;
+  ofs << "# Load time s: "
+      << std::chrono::duration<double>(loadTime).count() << std::endl;
+  ofs << "# Time to first step s: "
+      << std::chrono::duration<double>(firstStepTime).count() << std::endl;
   ofs << "# Real s, Real ns, sim s, sim ns" << std::endl;
 
   for (auto &msg : msgs)